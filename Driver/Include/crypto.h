@@ -1239,6 +1239,9 @@ typedef enum
 }
 E_ECC_CURVE;                            /*!< ECC curve                \hideinitializer */
 
+#define ECC_MAX_WORDS           18      /*!< Size of the ECC operand registers in words, enough for any curve  \hideinitializer */
+#define ECC_KEY_WORDS(bits)     (((bits) + 31) / 32)    /*!< Words of a word-array ECC operand for a key length in bits  \hideinitializer */
+
 
 #define RSA_MAX_KLEN            (2048)
 #define RSA_KBUF_HLEN           (RSA_MAX_KLEN/4 + 8)
@@ -1433,9 +1436,17 @@ int32_t  ECC_Mutiply(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char x1[], char y1[],
 int32_t  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_k, char public_k1[], char public_k2[], char secret_z[]);
 int32_t  ECC_GenerateSignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message, char *d, char *k, char *R, char *S);
 int32_t  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message, char *public_k1, char *public_k2, char *R, char *S);
+int32_t  ECC_PointMul_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t x1[], const uint32_t y1[], const uint32_t k[], uint32_t x2[], uint32_t y2[]);
+int32_t  ECC_PointMulStart_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t x1[], const uint32_t y1[], const uint32_t k[]);
+void ECC_PointMulRead_u32(CRPT_T *crpt, uint32_t x2[], uint32_t y2[]);
+int32_t  ECC_GenerateSignature_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t d[], const uint32_t k[], uint32_t r[], uint32_t s[]);
+int32_t  ECC_VerifySignature_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t qx[], const uint32_t qy[], const uint32_t r[], const uint32_t s[]);
 void RSA_Calculate_C(int rsa_len, char *n, char *C);
 int32_t  RSA_GenerateSignature(CRPT_T *crpt, int rsa_len, char *n, char *d, char *C, char *msg, char *sig);
 int32_t  RSA_VerifySignature(CRPT_T *crpt, int rsa_len, char *n, char *e, char *C, char *sig, char *msg);
+int32_t  RSA_ExpMod_u32(CRPT_T *crpt, uint32_t u32KeyLen, const uint32_t m[], const uint32_t e[], const uint32_t n[], const uint32_t c[], uint32_t x[]);
+int32_t  RSA_ExpModStart_u32(CRPT_T *crpt, uint32_t u32KeyLen, const uint32_t m[], const uint32_t e[], const uint32_t n[], const uint32_t c[]);
+void RSA_ExpModRead_u32(CRPT_T *crpt, uint32_t u32KeyLen, uint32_t x[]);
 
 
 /*@}*/ /* end of group CRYPTO_EXPORTED_FUNCTIONS */
@@ -0,0 +1,116 @@
+/**************************************************************************//**
+ * @file     qspi_flash.h
+ * @brief    NUC980 series QSPI NOR flash driver header file
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#ifndef __QSPI_FLASH_H__
+#define __QSPI_FLASH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "nuc980.h"
+#include "qspi.h"
+#include "pdma.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup QSPI_FLASH_Driver QSPI NOR Flash Driver
+  @{
+*/
+
+/** @addtogroup QSPI_FLASH_EXPORTED_CONSTANTS QSPI NOR Flash Exported Constants
+  @{
+*/
+
+#ifndef QSPI_FLASH_CACHE_LINES
+#define QSPI_FLASH_CACHE_LINES      4           /*!< Number of sectors kept in the LRU read cache, 0 to disable \hideinitializer */
+#endif
+#define QSPI_FLASH_CACHE_LINE_SIZE  4096        /*!< Size of one read cache line, equal to the smallest erase sector \hideinitializer */
+
+#define QSPI_FLASH_FLAG_QUAD        0x01ul      /*!< Use quad I/O fast read (EBh) if the flash supports it \hideinitializer */
+#define QSPI_FLASH_FLAG_NO_SFDP     0x02ul      /*!< Skip SFDP probing, use JEDEC ID and common defaults \hideinitializer */
+
+#define QSPI_FLASH_OK               0ul                         /*!< Operation success \hideinitializer */
+#define QSPI_FLASH_ERR_ID           0xFFFF0200ul                /*!< QSPI flash error ID \hideinitializer */
+#define QSPI_FLASH_ERR_NO_DEVICE    (QSPI_FLASH_ERR_ID|0x01ul)  /*!< No flash answers to JEDEC ID \hideinitializer */
+#define QSPI_FLASH_ERR_PARAM        (QSPI_FLASH_ERR_ID|0x02ul)  /*!< Address or length out of range \hideinitializer */
+#define QSPI_FLASH_ERR_ALIGN        (QSPI_FLASH_ERR_ID|0x03ul)  /*!< Erase address not sector aligned \hideinitializer */
+
+/*@}*/ /* end of group QSPI_FLASH_EXPORTED_CONSTANTS */
+
+/** @addtogroup QSPI_FLASH_EXPORTED_STRUCTS QSPI NOR Flash Exported Structs
+  @{
+*/
+
+/**
+  * @brief  QSPI NOR flash device. Filled by QSPI_FLASH_Open().
+  */
+typedef struct
+{
+    QSPI_T   *qspi;                 /*!< QSPI port the flash is connected to. Quad mode is only available on QSPI0. */
+    PDMA_T   *pdma;                 /*!< PDMA controller used for bulk data, NULL for PIO only. */
+    uint32_t u32TxCh;               /*!< PDMA channel for QSPI TX */
+    uint32_t u32RxCh;               /*!< PDMA channel for QSPI RX */
+    uint32_t u32JedecID;            /*!< Manufacturer ID, memory type and capacity from command 9Fh */
+    uint32_t u32Size;               /*!< Flash size in bytes */
+    uint32_t u32PageSize;           /*!< Program page size in bytes */
+    uint32_t u32SectorSize;         /*!< Smallest erase size in bytes */
+    uint32_t u32BlockSize;          /*!< Largest erase size not above 64 KB */
+    uint8_t  u8SectorEraseCmd;      /*!< Opcode erasing u32SectorSize */
+    uint8_t  u8BlockEraseCmd;       /*!< Opcode erasing u32BlockSize */
+    uint8_t  u8ReadCmd;             /*!< 0Bh (fast read) or EBh (quad I/O fast read) */
+    uint8_t  u8ReadDummy;           /*!< Mode and dummy bytes sent after the address of u8ReadCmd */
+    uint8_t  u8QEType;              /*!< Quad enable requirement, JESD216 basic parameter DWORD 15 [22:20] */
+    uint8_t  u8Quad;                /*!< 1 if quad I/O read is in use */
+    uint8_t  u8SFDP;                /*!< 1 if parameters come from the SFDP table */
+    uint8_t  u8Reserved;
+} QSPI_FLASH_T;
+
+/**
+  * @brief  Read cache statistics.
+  */
+typedef struct
+{
+    uint32_t u32Hit;                /*!< Sector reads served from the cache */
+    uint32_t u32Miss;               /*!< Sector reads that had to fill a cache line */
+    uint32_t u32Bypass;             /*!< Whole-sector reads transferred directly to the caller buffer */
+    uint32_t u32Evict;              /*!< Valid cache lines replaced */
+} QSPI_FLASH_CACHE_STATS_T;
+
+/*@}*/ /* end of group QSPI_FLASH_EXPORTED_STRUCTS */
+
+/** @addtogroup QSPI_FLASH_EXPORTED_FUNCTIONS QSPI NOR Flash Exported Functions
+  @{
+*/
+
+uint32_t QSPI_FLASH_Open(QSPI_FLASH_T *flash, QSPI_T *qspi, PDMA_T *pdma, uint32_t u32TxCh, uint32_t u32RxCh, uint32_t u32Flags);
+void QSPI_FLASH_Close(QSPI_FLASH_T *flash);
+uint32_t QSPI_FLASH_ReadJedecID(QSPI_FLASH_T *flash);
+uint8_t QSPI_FLASH_ReadStatus(QSPI_FLASH_T *flash);
+void QSPI_FLASH_WaitReady(QSPI_FLASH_T *flash);
+uint32_t QSPI_FLASH_Read(QSPI_FLASH_T *flash, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len);
+uint32_t QSPI_FLASH_Write(QSPI_FLASH_T *flash, uint32_t u32Addr, const uint8_t *pu8Buf, uint32_t u32Len);
+uint32_t QSPI_FLASH_Erase(QSPI_FLASH_T *flash, uint32_t u32Addr, uint32_t u32Len);
+uint32_t QSPI_FLASH_EraseChip(QSPI_FLASH_T *flash);
+void QSPI_FLASH_InvalidateCache(QSPI_FLASH_T *flash);
+void QSPI_FLASH_GetCacheStats(QSPI_FLASH_CACHE_STATS_T *stats);
+
+/*@}*/ /* end of group QSPI_FLASH_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group QSPI_FLASH_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__QSPI_FLASH_H__
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -601,6 +601,8 @@ typedef struct SDH_info_t
     unsigned int    totalSectorN;   /*!< Total sector number */
     unsigned int    diskSize;       /*!< Disk size in K bytes */
     int             sectorSize;     /*!< Sector size in bytes */
+    unsigned int    eraseGroup;     /*!< Erase group size in sectors */
+    unsigned int    eraseArg;       /*!< CMD38 argument, 1 to trim eMMC write blocks */
 } SDH_INFO_T;                       /*!< Structure holds SD card info */
 
 /*@}*/ /* end of group SDH_EXPORTED_TYPEDEF */
@@ -703,10 +705,12 @@ void SDH_Open(SDH_T *sdh, uint32_t u32CardDetSrc);
 uint32_t SDH_Probe(SDH_T *sdh);
 uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount);
 uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_t u32SecCount);
+uint32_t SDH_Erase(SDH_T *sdh, uint32_t u32StartSec, uint32_t u32SecCount);
 
 uint32_t SDH_CardDetection(SDH_T *sdh);
 void SDH_Open_Disk(SDH_T *sdh, uint32_t u32CardDetSrc);
 void SDH_Close_Disk(SDH_T *sdh);
+void SDH_SetWaitHook(void (*pfnHook)(void));
 
 
 /*@}*/ /* end of group SDH_EXPORTED_FUNCTIONS */
@@ -127,6 +127,7 @@ IRQn_Type;
 #define CACHE_WRITE_BACK        0     /*!< Cache Write-back mode  */
 #define CACHE_WRITE_THROUGH     1     /*!< Cache Write-through mode  */
 #define CACHE_DISABLE           -1    /*!< Cache Disable  */
+#define CACHE_LINE_SIZE         32    /*!< D-cache line size in bytes  */
 
 /** \brief  Structure type of clock source
  */
@@ -794,6 +795,7 @@ UINT32  sysGetInterruptEnableStatus(void);
 UINT32  sysGetInterruptEnableStatusH(void);
 PVOID   sysInstallExceptionHandler (INT32 nExceptType, PVOID pvNewHandler);
 PVOID   sysInstallFiqHandler (PVOID pvNewISR);
+PVOID   sysInstallFastFiq (IRQn_Type eIntNo, PVOID pvFiqHandler, const UINT32 *pu32Regs);
 PVOID   sysInstallIrqHandler (PVOID pvNewISR);
 PVOID   sysInstallISR (INT32 nIntTypeLevel, IRQn_Type eIntNo, PVOID pvNewISR);
 INT32   sysSetGlobalInterrupt (INT32 nIntState);
@@ -809,6 +811,8 @@ void    sysFlushCache(INT32 nCacheType);
 BOOL    sysGetCacheState(void);
 INT32   sysGetSdramSizebyMB(void);
 void    sysInvalidCache(void);
+void    sysCleanDCacheRange(UINT32 u32Addr, UINT32 u32Size);
+void    sysInvalidDCacheRange(UINT32 u32Addr, UINT32 u32Size);
 
 UINT32 sysGetClock(CLK_Type clk);
 
@@ -816,6 +820,65 @@ typedef void (*sys_pvFunPtr)();   /* function pointer */
 extern sys_pvFunPtr sysIrqHandlerTable[];
 extern UINT32 volatile _sys_bIsAICInitial;
 
+/* Define system library interrupt nesting and statistics functions */
+
+/**
+  * @brief  Timestamp source of the interrupt statistics, see \ref sysSetIrqStatTimer
+  */
+typedef UINT32 (*sys_pfnTimestamp)(void);
+
+/**
+  * @brief  Function called around IRQ handlers with the interrupt number, see \ref sysSetIrqHook
+  */
+typedef void (*sys_pfnIrqHook)(UINT32 u32IrqNum);
+
+/**
+  * @brief  Run time statistics of one interrupt source, see \ref sysGetIrqStat
+  */
+typedef struct
+{
+    UINT32 u32Count;        /*!< Number of times the handler was called */
+    UINT32 u32MaxTime;      /*!< Longest time spent in the handler, in timestamp counts */
+    UINT32 u32TotalTime;    /*!< Time spent in the handler since the statistics were cleared, wraps around */
+    UINT32 u32Preempted;    /*!< Number of times the handler was interrupted by a nested IRQ */
+} SYS_IRQ_STAT_T;
+
+void    sysEnableIrqNesting(void);
+void    sysDisableIrqNesting(void);
+void    sysIrqDispatch(UINT32 u32IrqNum, BOOL bNested);
+void    sysSetIrqStatTimer(sys_pfnTimestamp pfnTimestamp, UINT32 u32Mask);
+INT32   sysGetIrqStat(IRQn_Type eIntNo, SYS_IRQ_STAT_T *psStat);
+void    sysClearIrqStat(void);
+void    sysSetIrqHook(sys_pfnIrqHook pfnEnter, sys_pfnIrqHook pfnExit);
+
+/* Define system library stack usage functions */
+
+/* Mode stacks set up by the startup code from the top of DRAM down, in this
+   order. The sizes must match UND_Stack_Size ... SVC_Stack_Size there. */
+#define SYS_STACK_UND           0           /*!< Undefined instruction mode stack, 0x100 bytes */
+#define SYS_STACK_ABT           1           /*!< Abort mode stack, 0x100 bytes                 */
+#define SYS_STACK_IRQ           2           /*!< IRQ mode stack, 0x4000 bytes                  */
+#define SYS_STACK_FIQ           3           /*!< FIQ mode stack, 0x200 bytes                   */
+#define SYS_STACK_SYS           4           /*!< System/user mode stack, 0x4000 bytes          */
+#define SYS_STACK_SVC           5           /*!< Supervisor mode stack, 0xC00 bytes            */
+#define SYS_STACK_NUM           6           /*!< Number of mode stacks                         */
+
+#define SYS_STACK_FILL          0xA5A5A5A5  /*!< Word written to the whole stacks by the startup code */
+#define SYS_STACK_GUARD_WORDS   4           /*!< Lowest words of a stack checked by \ref sysCheckStackGuards */
+
+/**
+  * @brief  Usage of one mode stack, see \ref sysGetStackInfo
+  */
+typedef struct
+{
+    UINT32 u32Base;         /*!< Lowest address of the stack */
+    UINT32 u32Size;         /*!< Size of the stack in bytes */
+    UINT32 u32MaxUsed;      /*!< Deepest use since reset in bytes, the high-water mark */
+} SYS_STACK_INFO_T;
+
+INT32   sysGetStackInfo(UINT32 u32Stack, SYS_STACK_INFO_T *psInfo);
+UINT32  sysCheckStackGuards(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -368,6 +368,71 @@ void sysInvalidCache()
 #endif
 }
 
+/*
+ * Write the dirty lines of a buffer back to SDRAM, before a DMA reads it.
+ * Only the lines covering [u32Addr, u32Addr + u32Size) are touched, so this
+ * costs a few cycles per line instead of walking the whole D-cache.
+ */
+void sysCleanDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    UINT32 u32End = u32Addr + u32Size;
+    int temp = 0;
+
+    if (!_sys_IsCacheOn || (u32Addr & 0x80000000))
+        return;
+
+    for (u32Addr &= ~(CACHE_LINE_SIZE - 1); u32Addr < u32End; u32Addr += CACHE_LINE_SIZE)
+    {
+#if defined (__GNUC__) && !(__CC_ARM)
+        asm volatile("MCR p15, #0, %0, c7, c10, #1 \n\t" : : "r"(u32Addr) : "memory"); /* clean D line by MVA */
+#else
+        __asm
+        {
+            MCR p15, 0, u32Addr, c7, c10, 1 /* clean D line by MVA */
+        }
+#endif
+    }
+
+#if defined (__GNUC__) && !(__CC_ARM)
+    asm volatile("MCR p15, #0, %0, c7, c10, #4 \n\t" : : "r"(temp) : "memory"); /* drain write buffer */
+#else
+    __asm
+    {
+        MCR p15, 0, temp, c7, c10, 4 /* drain write buffer */
+    }
+#endif
+}
+
+/*
+ * Discard the lines of a buffer, after a DMA wrote it. A line only partly
+ * inside the buffer is cleaned first so that the data sharing it is not lost;
+ * buffers for DMA should start and end on a CACHE_LINE_SIZE boundary.
+ */
+void sysInvalidDCacheRange(UINT32 u32Addr, UINT32 u32Size)
+{
+    UINT32 u32End = u32Addr + u32Size;
+
+    if (!_sys_IsCacheOn || (u32Addr & 0x80000000) || (u32Size == 0))
+        return;
+
+    if (u32Addr & (CACHE_LINE_SIZE - 1))
+        sysCleanDCacheRange(u32Addr, 1);
+    if (u32End & (CACHE_LINE_SIZE - 1))
+        sysCleanDCacheRange(u32End - 1, 1);
+
+    for (u32Addr &= ~(CACHE_LINE_SIZE - 1); u32Addr < u32End; u32Addr += CACHE_LINE_SIZE)
+    {
+#if defined (__GNUC__) && !(__CC_ARM)
+        asm volatile("MCR p15, #0, %0, c7, c6, #1 \n\t" : : "r"(u32Addr) : "memory"); /* invalidate D line by MVA */
+#else
+        __asm
+        {
+            MCR p15, 0, u32Addr, c7, c6, 1 /* invalidate D line by MVA */
+        }
+#endif
+    }
+}
+
 BOOL sysGetCacheState()
 {
     return _sys_IsCacheOn;
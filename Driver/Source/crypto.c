@@ -756,9 +756,26 @@ const ECC_CURVE _Curve[] =
 static ECC_CURVE  *pCurve;
 static ECC_CURVE  Curve_Copy;
 
+/* Curve constants of the last used curve, converted to register words */
+typedef struct
+{
+    E_ECC_CURVE  curve_id;
+    uint32_t  Ea[ECC_MAX_WORDS];
+    uint32_t  Eb[ECC_MAX_WORDS];
+    uint32_t  Px[ECC_MAX_WORDS];
+    uint32_t  Py[ECC_MAX_WORDS];
+    uint32_t  Pn[ECC_MAX_WORDS];      /* prime modulus or irreducible polynomial */
+    uint32_t  Eorder[ECC_MAX_WORDS];
+}  ECC_CURVE_WORDS;
+
+static ECC_CURVE_WORDS  Curve_Words = { CURVE_UNDEF };
+
 static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve);
+static int32_t ecc_load_curve(E_ECC_CURVE ecc_curve);
 static int32_t ecc_init_curve(CRPT_T *crpt, E_ECC_CURVE ecc_curve);
-static void run_ecc_codec(CRPT_T *crpt, uint32_t mode);
+static void ecc_start_codec(CRPT_T *crpt, uint32_t mode);
+static int32_t ecc_wait_codec(CRPT_T *crpt);
+static int32_t run_ecc_codec(CRPT_T *crpt, uint32_t mode);
 
 static char  temp_hex_str[160];
 
@@ -886,6 +903,11 @@ static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve)
     uint32_t   i;
     ECC_CURVE  *ret = NULL;
 
+    if ((pCurve != NULL) && (pCurve->curve_id == ecc_curve))
+    {
+        return pCurve;
+    }
+
     for (i = 0UL; i < sizeof(_Curve) / sizeof(ECC_CURVE); i++)
     {
         if (ecc_curve == _Curve[i].curve_id)
@@ -901,56 +923,102 @@ static ECC_CURVE * get_curve(E_ECC_CURVE ecc_curve)
     return ret;
 }
 
-static int32_t ecc_init_curve(CRPT_T *crpt, E_ECC_CURVE ecc_curve)
+/*
+ *  Select the curve and convert its constants to words. The hex strings are
+ *  parsed only when the curve differs from the one used last time.
+ */
+static int32_t ecc_load_curve(E_ECC_CURVE ecc_curve)
 {
-    int32_t  i, ret = 0;
-
     pCurve = get_curve(ecc_curve);
     if (pCurve == NULL)
     {
         CRPT_DBGMSG("Cannot find curve %d!!\n", ecc_curve);
+        return -1;
+    }
+
+    if (Curve_Words.curve_id != ecc_curve)
+    {
+        memset(&Curve_Words, 0, sizeof(Curve_Words));
+
+        Hex2Reg(pCurve->Ea, Curve_Words.Ea);
+        Hex2Reg(pCurve->Eb, Curve_Words.Eb);
+        Hex2Reg(pCurve->Px, Curve_Words.Px);
+        Hex2Reg(pCurve->Py, Curve_Words.Py);
+        Hex2Reg(pCurve->Eorder, Curve_Words.Eorder);
+
+        if (pCurve->GF == (int)CURVE_GF_2M)
+        {
+            Curve_Words.Pn[0] = 0x1UL;
+            Curve_Words.Pn[(pCurve->key_len) / 32] |= (1UL << ((pCurve->key_len) % 32));
+            Curve_Words.Pn[(pCurve->irreducible_k1) / 32] |= (1UL << ((pCurve->irreducible_k1) % 32));
+            Curve_Words.Pn[(pCurve->irreducible_k2) / 32] |= (1UL << ((pCurve->irreducible_k2) % 32));
+            Curve_Words.Pn[(pCurve->irreducible_k3) / 32] |= (1UL << ((pCurve->irreducible_k3) % 32));
+        }
+        else
+        {
+            Hex2Reg(pCurve->Pp, Curve_Words.Pn);
+        }
+
+        /* set last, a zeroed curve_id is a valid curve */
+        Curve_Words.curve_id = ecc_curve;
+    }
+    return 0;
+}
+
+static int32_t ecc_init_curve(CRPT_T *crpt, E_ECC_CURVE ecc_curve)
+{
+    int32_t  i, ret = 0;
+
+    if (ecc_load_curve(ecc_curve) != 0)
+    {
         ret = -1;
     }
 
     if (ret == 0)
     {
-        for (i = 0; i < 18; i++)
+        for (i = 0; i < ECC_MAX_WORDS; i++)
         {
-            crpt->ECC_A[i] = 0UL;
-            crpt->ECC_B[i] = 0UL;
-            crpt->ECC_X1[i] = 0UL;
-            crpt->ECC_Y1[i] = 0UL;
-            crpt->ECC_N[i] = 0UL;
+            crpt->ECC_A[i] = Curve_Words.Ea[i];
+            crpt->ECC_B[i] = Curve_Words.Eb[i];
+            crpt->ECC_X1[i] = Curve_Words.Px[i];
+            crpt->ECC_Y1[i] = Curve_Words.Py[i];
+            crpt->ECC_N[i] = Curve_Words.Pn[i];
         }
 
-        Hex2Reg(pCurve->Ea, crpt->ECC_A);
-        Hex2Reg(pCurve->Eb, crpt->ECC_B);
-        Hex2Reg(pCurve->Px, crpt->ECC_X1);
-        Hex2Reg(pCurve->Py, crpt->ECC_Y1);
-
         CRPT_DBGMSG("Key length = %d\n", pCurve->key_len);
         dump_ecc_reg("CRPT_ECC_CURVE_A", crpt->ECC_A, 10);
         dump_ecc_reg("CRPT_ECC_CURVE_B", crpt->ECC_B, 10);
         dump_ecc_reg("CRPT_ECC_POINT_X1", crpt->ECC_X1, 10);
         dump_ecc_reg("CRPT_ECC_POINT_Y1", crpt->ECC_Y1, 10);
-
-        if (pCurve->GF == (int)CURVE_GF_2M)
-        {
-            crpt->ECC_N[0] = 0x1UL;
-            crpt->ECC_N[(pCurve->key_len) / 32] |= (1UL << ((pCurve->key_len) % 32));
-            crpt->ECC_N[(pCurve->irreducible_k1) / 32] |= (1UL << ((pCurve->irreducible_k1) % 32));
-            crpt->ECC_N[(pCurve->irreducible_k2) / 32] |= (1UL << ((pCurve->irreducible_k2) % 32));
-            crpt->ECC_N[(pCurve->irreducible_k3) / 32] |= (1UL << ((pCurve->irreducible_k3) % 32));
-        }
-        else
-        {
-            Hex2Reg(pCurve->Pp, crpt->ECC_N);
-        }
     }
     dump_ecc_reg("CRPT_ECC_CURVE_N", crpt->ECC_N, 10);
     return ret;
 }
 
+static void ecc_write_words(uint32_t volatile reg[], const uint32_t w[], int32_t count)
+{
+    int32_t  i;
+
+    for (i = 0; i < count; i++)
+    {
+        reg[i] = w[i];
+    }
+    for ( ; i < ECC_MAX_WORDS; i++)
+    {
+        reg[i] = 0UL;
+    }
+}
+
+static void ecc_read_words(uint32_t volatile reg[], uint32_t w[], int32_t count)
+{
+    int32_t  i;
+
+    for (i = 0; i < count; i++)
+    {
+        w[i] = reg[i];
+    }
+}
+
 static int  get_nibble_value(char c)
 {
     if ((c >= '0') && (c <= '9'))
@@ -1253,7 +1321,7 @@ int32_t  ECC_GenerateSecretZ(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *private_
 
 /** @cond HIDDEN_SYMBOLS */
 
-static void run_ecc_codec(CRPT_T *crpt, uint32_t mode)
+static void ecc_start_codec(CRPT_T *crpt, uint32_t mode)
 {
     if ((mode & CRPT_ECC_CTL_ECCOP_Msk) == ECCOP_MODULE)
     {
@@ -1275,13 +1343,49 @@ static void run_ecc_codec(CRPT_T *crpt, uint32_t mode)
 
     g_ECC_done = g_ECCERR_done = 0UL;
     crpt->ECC_CTL |= ((uint32_t)pCurve->key_len << CRPT_ECC_CTL_CURVEM_Pos) | mode | CRPT_ECC_CTL_START_Msk;
+}
+
+static int32_t ecc_wait_codec(CRPT_T *crpt)
+{
     while ((g_ECC_done | g_ECCERR_done) == 0UL)
     {
+        /* also completes when the application does not handle the ECC interrupt */
+        if (crpt->INTSTS & (CRPT_INTSTS_ECCIF_Msk | CRPT_INTSTS_ECCEIF_Msk))
+        {
+            ECC_Complete(crpt);
+        }
     }
 
     while (crpt->ECC_STS & CRPT_ECC_STS_BUSY_Msk)
     {
     }
+
+    return (g_ECCERR_done != 0UL) ? -1 : 0;
+}
+
+static int32_t run_ecc_codec(CRPT_T *crpt, uint32_t mode)
+{
+    ecc_start_codec(crpt, mode);
+    return ecc_wait_codec(crpt);
+}
+
+/*
+ *  z = x op y (mod n), n being the curve order. For MODOP_DIV, z = y / x (mod n).
+ */
+static int32_t ecc_mod_order(CRPT_T *crpt, uint32_t modop, const uint32_t x[], const uint32_t y[],
+                             uint32_t z[], int32_t count)
+{
+    ecc_write_words(crpt->ECC_N, Curve_Words.Eorder, ECC_MAX_WORDS);
+    ecc_write_words(crpt->ECC_X1, x, count);
+    ecc_write_words(crpt->ECC_Y1, y, count);
+
+    if (run_ecc_codec(crpt, ECCOP_MODULE | modop) != 0)
+    {
+        return -2;
+    }
+
+    ecc_read_words(crpt->ECC_X1, z, count);
+    return 0;
 }
 /** @endcond HIDDEN_SYMBOLS */
 
@@ -1854,6 +1958,267 @@ int32_t  ECC_VerifySignature(CRPT_T *crpt, E_ECC_CURVE ecc_curve, char *message,
     return ret;
 }
 
+/**
+  * @brief  ECC point multiplication on word arrays, (x2, y2) = k * (x1, y1).
+  *         All operands are ECC_KEY_WORDS(key length) words long, least significant word first.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  x1          x of the input point.
+  * @param[in]  y1          y of the input point.
+  * @param[in]  k           The scalar.
+  * @param[out] x2          x of the output point.
+  * @param[out] y2          y of the output point.
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @return  -2   ECC engine reported an error.
+  */
+int32_t  ECC_PointMul_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t x1[], const uint32_t y1[],
+                          const uint32_t k[], uint32_t x2[], uint32_t y2[])
+{
+    int32_t  ret = 0;
+
+    if (ECC_PointMulStart_u32(crpt, ecc_curve, x1, y1, k) != 0)
+    {
+        return -1;
+    }
+
+    if (ecc_wait_codec(crpt) != 0)
+    {
+        ret = -2;
+    }
+    ECC_PointMulRead_u32(crpt, (ret == 0) ? x2 : NULL, (ret == 0) ? y2 : NULL);
+    return ret;
+}
+
+/**
+  * @brief  Start an ECC point multiplication on word arrays and return without waiting.
+  *         The engine sets ECCIF, or ECCEIF on error, in CRPT_INTSTS when it is done,
+  *         and raises the CRYPTO interrupt if ECC_ENABLE_INT() was called. The result is
+  *         then read with ECC_PointMulRead_u32(). The engine must not be used in between.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  x1          x of the input point.
+  * @param[in]  y1          y of the input point.
+  * @param[in]  k           The scalar.
+  * @return  0    Started.
+  * @return  -1   "ecc_curve" value is invalid.
+  */
+int32_t  ECC_PointMulStart_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t x1[], const uint32_t y1[],
+                               const uint32_t k[])
+{
+    int32_t  count;
+
+    if (ecc_init_curve(crpt, ecc_curve) != 0)
+    {
+        return -1;
+    }
+    count = ECC_KEY_WORDS(pCurve->key_len);
+
+    ecc_write_words(crpt->ECC_X1, x1, count);
+    ecc_write_words(crpt->ECC_Y1, y1, count);
+    ecc_write_words(crpt->ECC_K, k, count);
+
+    ecc_start_codec(crpt, ECCOP_POINT_MUL);
+    return 0;
+}
+
+/**
+  * @brief  Read the result of a point multiplication started by ECC_PointMulStart_u32()
+  *         and clear the scalar from the engine.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[out] x2          x of the output point, or NULL to only clear the engine.
+  * @param[out] y2          y of the output point, or NULL to only clear the engine.
+  * @return None
+  */
+void ECC_PointMulRead_u32(CRPT_T *crpt, uint32_t x2[], uint32_t y2[])
+{
+    int32_t  count = ECC_KEY_WORDS(pCurve->key_len);
+
+    if ((x2 != NULL) && (y2 != NULL))
+    {
+        ecc_read_words(crpt->ECC_X1, x2, count);
+        ecc_read_words(crpt->ECC_Y1, y2, count);
+    }
+    ecc_write_words(crpt->ECC_K, NULL, 0);
+}
+
+/**
+  * @brief  ECDSA digital signature generation on word arrays.
+  *         All operands are ECC_KEY_WORDS(key length) words long, least significant word first.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  e           The hash value of source context, reduced to the bit length of the order.
+  * @param[in]  d           The private key.
+  * @param[in]  k           The selected random integer in [1, n-1].
+  * @param[out] r           R of the (R,S) pair digital signature
+  * @param[out] s           S of the (R,S) pair digital signature
+  * @return  0    Success. The caller must pick another k if r or s is zero.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @return  -2   ECC engine reported an error.
+  */
+int32_t  ECC_GenerateSignature_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t d[],
+                                   const uint32_t k[], uint32_t r[], uint32_t s[])
+{
+    uint32_t  kinv[ECC_MAX_WORDS], c[ECC_MAX_WORDS];
+    int32_t   count, ret = 0;
+
+    if (ecc_init_curve(crpt, ecc_curve) != 0)
+    {
+        return -1;
+    }
+    count = ECC_KEY_WORDS(pCurve->key_len);
+
+    /* (x1, y1) = k * G */
+    ecc_write_words(crpt->ECC_K, k, count);
+    if (run_ecc_codec(crpt, ECCOP_POINT_MUL) != 0)
+    {
+        ret = -2;
+    }
+    ecc_write_words(crpt->ECC_K, NULL, 0);
+
+    if (ret == 0)
+    {
+        /* r = x1 (mod n) */
+        ecc_read_words(crpt->ECC_X1, r, count);
+        memset(c, 0, sizeof(c));
+        ret = ecc_mod_order(crpt, MODOP_ADD, r, c, r, count);
+    }
+
+    if (ret == 0)
+    {
+        /* k^-1 (mod n) */
+        c[0] = 0x1UL;
+        ret = ecc_mod_order(crpt, MODOP_DIV, k, c, kinv, count);
+    }
+
+    /* s = k^-1 * (e + d * r) (mod n) */
+    if (ret == 0)
+    {
+        ret = ecc_mod_order(crpt, MODOP_MUL, r, d, s, count);
+    }
+    if (ret == 0)
+    {
+        ret = ecc_mod_order(crpt, MODOP_ADD, s, e, s, count);
+    }
+    if (ret == 0)
+    {
+        ret = ecc_mod_order(crpt, MODOP_MUL, s, kinv, s, count);
+    }
+
+    memset(kinv, 0, sizeof(kinv));
+    return ret;
+}
+
+/**
+  * @brief  ECDSA digital signature verification on word arrays.
+  *         All operands are ECC_KEY_WORDS(key length) words long, least significant word first.
+  *         r and s must already be checked to lie in [1, n-1].
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  ecc_curve   The pre-defined ECC curve.
+  * @param[in]  e           The hash value of source context, reduced to the bit length of the order.
+  * @param[in]  qx          x of the public key.
+  * @param[in]  qy          y of the public key.
+  * @param[in]  r           R of the (R,S) pair digital signature
+  * @param[in]  s           S of the (R,S) pair digital signature
+  * @return  0    Success.
+  * @return  -1   "ecc_curve" value is invalid.
+  * @return  -2   Verification failed.
+  */
+int32_t  ECC_VerifySignature_u32(CRPT_T *crpt, E_ECC_CURVE ecc_curve, const uint32_t e[], const uint32_t qx[],
+                                 const uint32_t qy[], const uint32_t r[], const uint32_t s[])
+{
+    uint32_t  w[ECC_MAX_WORDS], u1[ECC_MAX_WORDS], u2[ECC_MAX_WORDS];
+    uint32_t  px[ECC_MAX_WORDS], py[ECC_MAX_WORDS];
+    int32_t   i, count, ret = 0;
+
+    if (ecc_load_curve(ecc_curve) != 0)
+    {
+        return -1;
+    }
+    count = ECC_KEY_WORDS(pCurve->key_len);
+
+    /* w = s^-1 (mod n) */
+    memset(u2, 0, sizeof(u2));
+    u2[0] = 0x1UL;
+    ret = ecc_mod_order(crpt, MODOP_DIV, s, u2, w, count);
+
+    /* u1 = e * w (mod n), u2 = r * w (mod n) */
+    if (ret == 0)
+    {
+        ret = ecc_mod_order(crpt, MODOP_MUL, e, w, u1, count);
+    }
+    if (ret == 0)
+    {
+        ret = ecc_mod_order(crpt, MODOP_MUL, r, w, u2, count);
+    }
+
+    /* u1 * G */
+    if (ret == 0)
+    {
+        ecc_init_curve(crpt, ecc_curve);
+        ecc_write_words(crpt->ECC_K, u1, count);
+        if (run_ecc_codec(crpt, ECCOP_POINT_MUL) != 0)
+        {
+            ret = -2;
+        }
+        ecc_read_words(crpt->ECC_X1, px, count);
+        ecc_read_words(crpt->ECC_Y1, py, count);
+    }
+
+    /* u2 * Q */
+    if (ret == 0)
+    {
+        ecc_init_curve(crpt, ecc_curve);
+        ecc_write_words(crpt->ECC_X1, qx, count);
+        ecc_write_words(crpt->ECC_Y1, qy, count);
+        ecc_write_words(crpt->ECC_K, u2, count);
+        if (run_ecc_codec(crpt, ECCOP_POINT_MUL) != 0)
+        {
+            ret = -2;
+        }
+        ecc_read_words(crpt->ECC_X1, u1, count);
+        ecc_read_words(crpt->ECC_Y1, w, count);
+    }
+
+    /* (x1', y1') = u1 * G + u2 * Q */
+    if (ret == 0)
+    {
+        ecc_init_curve(crpt, ecc_curve);
+        ecc_write_words(crpt->ECC_X1, u1, count);
+        ecc_write_words(crpt->ECC_Y1, w, count);
+        ecc_write_words(crpt->ECC_X2, px, count);
+        ecc_write_words(crpt->ECC_Y2, py, count);
+        if (run_ecc_codec(crpt, ECCOP_POINT_ADD) != 0)
+        {
+            ret = -2;
+        }
+        ecc_read_words(crpt->ECC_X1, px, count);
+    }
+
+    /* x1' (mod n) */
+    if (ret == 0)
+    {
+        memset(u2, 0, sizeof(u2));
+        ret = ecc_mod_order(crpt, MODOP_ADD, px, u2, px, count);
+    }
+
+    /* The signature is valid if x1' (mod n) = r */
+    if (ret == 0)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (px[i] != r[i])
+            {
+                CRPT_DBGMSG("x1' (mod n) != R, verification failed!\n");
+                ret = -2;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
 
 /*-----------------------------------------------------------------------------------------------*/
 /*                                                                                               */
@@ -2646,7 +3011,7 @@ int32_t  RSA_VerifySignature(CRPT_T *crpt, int rsa_len, char *n, char *e, char *
 
     Reg2Hex(rsa_len/4, (uint32_t *)CRPT->RSA_M, output);
 
-    printf("RSA verify: %s\n", output);
+    CRPT_DBGMSG("RSA verify: %s\n", output);
 
     if (ecc_strcmp(output, msg) != 0)
     {
@@ -2656,6 +3021,100 @@ int32_t  RSA_VerifySignature(CRPT_T *crpt, int rsa_len, char *n, char *e, char *
     return 0;
 }
 
+/**
+  * @brief  RSA modular exponentiation on word arrays, x = m ^ e mod n.
+  *         All operands are u32KeyLen/32 words long, least significant word first.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32KeyLen   Operation length in bits, a multiple of 32 up to RSA_MAX_KLEN.
+  *                         n and e must fit in u32KeyLen bits.
+  * @param[in]  m           The base, smaller than n.
+  * @param[in]  e           The exponent.
+  * @param[in]  n           The modulus, an odd number.
+  * @param[in]  c           The constant value of Montgomery domain, 2 ^ (2 * (u32KeyLen + 2)) mod n.
+  *                         It depends on n and u32KeyLen only and can be kept with the key.
+  * @param[out] x           The result.
+  * @return  0     Success.
+  * @return  -1    u32KeyLen is not supported.
+  */
+int32_t  RSA_ExpMod_u32(CRPT_T *crpt, uint32_t u32KeyLen, const uint32_t m[], const uint32_t e[],
+                        const uint32_t n[], const uint32_t c[], uint32_t x[])
+{
+    if (RSA_ExpModStart_u32(crpt, u32KeyLen, m, e, n, c) != 0)
+    {
+        return -1;
+    }
+    while (crpt->RSA_STS & CRPT_RSA_STS_BUSY_Msk) ;
+
+    RSA_ExpModRead_u32(crpt, u32KeyLen, x);
+    return 0;
+}
+
+/**
+  * @brief  Start an RSA modular exponentiation on word arrays and return without waiting.
+  *         The RSA engine has no interrupt; the operation is done when CRPT_RSA_STS BUSY
+  *         reads 0, and the result is then read with RSA_ExpModRead_u32().
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32KeyLen   Operation length in bits, see RSA_ExpMod_u32().
+  * @param[in]  m           The base, smaller than n.
+  * @param[in]  e           The exponent.
+  * @param[in]  n           The modulus, an odd number.
+  * @param[in]  c           The constant value of Montgomery domain.
+  * @return  0     Started.
+  * @return  -1    u32KeyLen is not supported.
+  */
+int32_t  RSA_ExpModStart_u32(CRPT_T *crpt, uint32_t u32KeyLen, const uint32_t m[], const uint32_t e[],
+                             const uint32_t n[], const uint32_t c[])
+{
+    uint32_t  i, count;
+
+    if ((u32KeyLen == 0UL) || (u32KeyLen > RSA_MAX_KLEN) || (u32KeyLen % 32UL))
+    {
+        return -1;
+    }
+    count = u32KeyLen / 32UL;
+
+    for (i = 0UL; i < count; i++)
+    {
+        crpt->RSA_M[i] = m[i];
+        crpt->RSA_E[i] = e[i];
+        crpt->RSA_N[i] = n[i];
+        crpt->RSA_C[i] = c[i];
+    }
+    for ( ; i < RSA_MAX_KLEN / 32; i++)
+    {
+        crpt->RSA_M[i] = 0UL;
+        crpt->RSA_E[i] = 0UL;
+        crpt->RSA_N[i] = 0UL;
+        crpt->RSA_C[i] = 0UL;
+    }
+
+    crpt->RSA_CTL = (u32KeyLen << CRPT_RSA_CTL_KEYLEN_Pos) | CRPT_RSA_CTL_START_Msk;
+    return 0;
+}
+
+/**
+  * @brief  Read the result of an exponentiation started by RSA_ExpModStart_u32()
+  *         and clear the exponent from the engine.
+  * @param[in]  crpt        Reference to Crypto module.
+  * @param[in]  u32KeyLen   Operation length in bits, as passed to RSA_ExpModStart_u32().
+  * @param[out] x           The result, or NULL to only clear the engine.
+  * @return None
+  */
+void RSA_ExpModRead_u32(CRPT_T *crpt, uint32_t u32KeyLen, uint32_t x[])
+{
+    uint32_t  i, count = u32KeyLen / 32UL;
+
+    for (i = 0UL; (x != NULL) && (i < count); i++)
+    {
+        x[i] = crpt->RSA_M[i];
+    }
+
+    /* do not leave a private exponent in the engine */
+    for (i = 0UL; i < count; i++)
+    {
+        crpt->RSA_E[i] = 0UL;
+    }
+}
 
 
 /*@}*/ /* end of group CRYPTO_EXPORTED_FUNCTIONS */
@@ -0,0 +1,938 @@
+/**************************************************************************//**
+ * @file     qspi_flash.c
+ * @brief    NUC980 series QSPI NOR flash driver source file
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "qspi_flash.h"
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup QSPI_FLASH_Driver QSPI NOR Flash Driver
+  @{
+*/
+
+/// @cond HIDDEN_SYMBOLS
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* SPI NOR commands                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CMD_WRITE_ENABLE        0x06
+#define CMD_READ_STATUS1        0x05
+#define CMD_READ_STATUS2        0x35
+#define CMD_WRITE_STATUS1       0x01
+#define CMD_WRITE_STATUS2       0x31
+#define CMD_READ_STATUS_QE3     0x3F
+#define CMD_WRITE_STATUS_QE3    0x3E
+#define CMD_PAGE_PROGRAM        0x02
+#define CMD_FAST_READ           0x0B
+#define CMD_QUAD_IO_READ        0xEB
+#define CMD_SECTOR_ERASE_4K     0x20
+#define CMD_BLOCK_ERASE_64K     0xD8
+#define CMD_CHIP_ERASE          0xC7
+#define CMD_READ_JEDEC_ID       0x9F
+#define CMD_READ_SFDP           0x5A
+
+#define SR1_WIP                 0x01
+
+#define QSPI_FIFO_DEPTH         8           /* 8-bit entries kept in flight by PIO reads */
+#define PDMA_MAX_WORDS          0x10000     /* TXCNT is 16 bits */
+
+#define NONCACHE(addr)          ((uint32_t)(addr) | 0x80000000)
+#define PHYADDR(addr)           ((uint32_t)(addr) & 0x7FFFFFFF)
+
+typedef struct
+{
+    QSPI_FLASH_T *flash;                    /* owner, NULL if the line is free */
+    uint32_t u32Addr;                       /* sector aligned flash address */
+    uint32_t u32Age;                        /* LRU stamp, larger is more recent */
+} QSPI_FLASH_LINE_T;
+
+#if (QSPI_FLASH_CACHE_LINES > 0)
+static uint8_t s_au8CacheBuf[QSPI_FLASH_CACHE_LINES][QSPI_FLASH_CACHE_LINE_SIZE] __attribute__((aligned(32)));
+static QSPI_FLASH_LINE_T s_asCacheLine[QSPI_FLASH_CACHE_LINES];
+static uint32_t s_u32CacheAge;
+#endif
+static QSPI_FLASH_CACHE_STATS_T s_sCacheStats;
+
+/* TX source of the dummy clocks during PDMA reads */
+static uint32_t s_u32DummyWord __attribute__((aligned(32))) = 0;
+
+static void qf_select(QSPI_FLASH_T *flash)
+{
+    QSPI_SET_SS_LOW(flash->qspi);
+}
+
+static void qf_deselect(QSPI_FLASH_T *flash)
+{
+    QSPI_SET_SS_HIGH(flash->qspi);
+}
+
+/* Output bytes, RX data is discarded. Works for single and quad output mode. */
+static void qf_pio_write(QSPI_T *qspi, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    while(u32Len)
+    {
+        if(!QSPI_GET_TX_FIFO_FULL_FLAG(qspi))
+        {
+            QSPI_WRITE_TX(qspi, *pu8Buf++);
+            u32Len--;
+        }
+    }
+
+    while(QSPI_IS_BUSY(qspi));
+    QSPI_ClearRxFIFO(qspi);
+}
+
+/* Input bytes, keeping the TX FIFO ahead of RX so the bus clock never stops between bytes. */
+static void qf_pio_read(QSPI_T *qspi, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Tx = 0, u32Rx = 0;
+
+    QSPI_ClearRxFIFO(qspi);
+
+    while(u32Rx < u32Len)
+    {
+        if((u32Tx < u32Len) && ((u32Tx - u32Rx) < QSPI_FIFO_DEPTH) && !QSPI_GET_TX_FIFO_FULL_FLAG(qspi))
+        {
+            QSPI_WRITE_TX(qspi, 0x00);
+            u32Tx++;
+        }
+        if(!QSPI_GET_RX_FIFO_EMPTY_FLAG(qspi))
+            pu8Buf[u32Rx++] = (uint8_t)QSPI_READ_RX(qspi);
+    }
+}
+
+/* Switch the data phase to 32-bit words sent in memory byte order. */
+static void qf_word_mode(QSPI_T *qspi)
+{
+    while(QSPI_IS_BUSY(qspi));
+    QSPI_SET_SUSPEND_CYCLE(qspi, 0);
+    QSPI_SET_DATA_WIDTH(qspi, 32);
+    QSPI_ENABLE_BYTE_REORDER(qspi);
+}
+
+static void qf_byte_mode(QSPI_T *qspi)
+{
+    while(QSPI_IS_BUSY(qspi));
+    QSPI_DISABLE_BYTE_REORDER(qspi);
+    QSPI_SET_DATA_WIDTH(qspi, 8);
+}
+
+/* PDMA read of u32Len bytes into whole D-cache lines (start and length multiples of CACHE_LINE_SIZE).
+   The lines are discarded before the transfer, so no dirty copy is evicted over the new data, and again
+   after it, so that nothing read meanwhile hides the new data. */
+static void qf_dma_read(QSPI_FLASH_T *flash, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = flash->qspi;
+    PDMA_T *pdma = flash->pdma;
+    uint32_t u32Mask = (1 << flash->u32TxCh) | (1 << flash->u32RxCh);
+    uint32_t u32Words;
+    uint8_t *pu8Start = pu8Buf;
+    uint32_t u32Total = u32Len;
+
+    sysInvalidDCacheRange((uint32_t)pu8Start, u32Total);
+    qf_word_mode(qspi);
+
+    while(u32Len)
+    {
+        u32Words = u32Len / 4;
+        if(u32Words > PDMA_MAX_WORDS)
+            u32Words = PDMA_MAX_WORDS;
+
+        QSPI_ClearRxFIFO(qspi);
+
+        /* TX: the same dummy word over and over, only to generate bus clocks */
+        PDMA_SetTransferCnt(pdma, flash->u32TxCh, PDMA_WIDTH_32, u32Words);
+        PDMA_SetTransferAddr(pdma, flash->u32TxCh, PHYADDR(&s_u32DummyWord), PDMA_SAR_FIX, (uint32_t)&qspi->TX, PDMA_DAR_FIX);
+        PDMA_SetTransferMode(pdma, flash->u32TxCh, PDMA_QSPI0_TX, FALSE, 0);
+        PDMA_SetBurstType(pdma, flash->u32TxCh, PDMA_REQ_SINGLE, 0);
+        pdma->DSCT[flash->u32TxCh].CTL |= PDMA_DSCT_CTL_TBINTDIS_Msk;
+
+        PDMA_SetTransferCnt(pdma, flash->u32RxCh, PDMA_WIDTH_32, u32Words);
+        PDMA_SetTransferAddr(pdma, flash->u32RxCh, (uint32_t)&qspi->RX, PDMA_SAR_FIX, PHYADDR(pu8Buf), PDMA_DAR_INC);
+        PDMA_SetTransferMode(pdma, flash->u32RxCh, PDMA_QSPI0_RX, FALSE, 0);
+        PDMA_SetBurstType(pdma, flash->u32RxCh, PDMA_REQ_SINGLE, 0);
+        pdma->DSCT[flash->u32RxCh].CTL |= PDMA_DSCT_CTL_TBINTDIS_Msk;
+
+        /* RX PDMA must not be enabled before TX PDMA, enable both at once */
+        qspi->PDMACTL |= (QSPI_PDMACTL_TXPDMAEN_Msk | QSPI_PDMACTL_RXPDMAEN_Msk);
+
+        while((PDMA_GET_TD_STS(pdma) & u32Mask) != u32Mask);
+        PDMA_CLR_TD_FLAG(pdma, u32Mask);
+
+        QSPI_DISABLE_TX_PDMA(qspi);
+        QSPI_DISABLE_RX_PDMA(qspi);
+
+        pu8Buf += u32Words * 4;
+        u32Len -= u32Words * 4;
+    }
+
+    qf_byte_mode(qspi);
+    sysInvalidDCacheRange((uint32_t)pu8Start, u32Total);
+}
+
+/* PDMA write of u32Len bytes (multiple of 4) from a word aligned buffer. */
+static void qf_dma_write(QSPI_FLASH_T *flash, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = flash->qspi;
+    PDMA_T *pdma = flash->pdma;
+    uint32_t u32Mask = (1 << flash->u32TxCh);
+    uint32_t u32Words;
+
+    qf_word_mode(qspi);
+
+    while(u32Len)
+    {
+        u32Words = u32Len / 4;
+        if(u32Words > PDMA_MAX_WORDS)
+            u32Words = PDMA_MAX_WORDS;
+
+        PDMA_SetTransferCnt(pdma, flash->u32TxCh, PDMA_WIDTH_32, u32Words);
+        PDMA_SetTransferAddr(pdma, flash->u32TxCh, PHYADDR(pu8Buf), PDMA_SAR_INC, (uint32_t)&qspi->TX, PDMA_DAR_FIX);
+        PDMA_SetTransferMode(pdma, flash->u32TxCh, PDMA_QSPI0_TX, FALSE, 0);
+        PDMA_SetBurstType(pdma, flash->u32TxCh, PDMA_REQ_SINGLE, 0);
+        pdma->DSCT[flash->u32TxCh].CTL |= PDMA_DSCT_CTL_TBINTDIS_Msk;
+
+        QSPI_TRIGGER_TX_PDMA(qspi);
+
+        while((PDMA_GET_TD_STS(pdma) & u32Mask) != u32Mask);
+        PDMA_CLR_TD_FLAG(pdma, u32Mask);
+
+        while(QSPI_IS_BUSY(qspi));
+        QSPI_DISABLE_TX_PDMA(qspi);
+
+        pu8Buf += u32Words * 4;
+        u32Len -= u32Words * 4;
+    }
+
+    qf_byte_mode(qspi);
+    QSPI_ClearRxFIFO(qspi);
+}
+
+/* Data phase of a read. PDMA only fills the whole D-cache lines of the buffer, a line shared with other
+   data could be dirtied by the CPU during the transfer and written back over it later. The partial lines
+   at either end are read by PIO. */
+static void qf_read_data(QSPI_FLASH_T *flash, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Head, u32Body;
+
+    if(flash->pdma != NULL)
+    {
+        u32Head = (0 - (uint32_t)pu8Buf) & (CACHE_LINE_SIZE - 1);
+        u32Body = (u32Len > u32Head) ? ((u32Len - u32Head) & ~(CACHE_LINE_SIZE - 1)) : 0;
+        if(u32Body)
+        {
+            if(u32Head)
+            {
+                qf_pio_read(flash->qspi, pu8Buf, u32Head);
+                pu8Buf += u32Head;
+                u32Len -= u32Head;
+            }
+            qf_dma_read(flash, pu8Buf, u32Body);
+            pu8Buf += u32Body;
+            u32Len -= u32Body;
+        }
+    }
+
+    if(u32Len)
+        qf_pio_read(flash->qspi, pu8Buf, u32Len);
+}
+
+static void qf_write_data(QSPI_FLASH_T *flash, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Body;
+
+    if((flash->pdma != NULL) && (((uint32_t)pu8Buf & 0x3) == 0))
+    {
+        u32Body = u32Len & ~0x3;
+        if(u32Body)
+        {
+            qf_dma_write(flash, pu8Buf, u32Body);
+            pu8Buf += u32Body;
+            u32Len -= u32Body;
+        }
+    }
+
+    if(u32Len)
+        qf_pio_write(flash->qspi, pu8Buf, u32Len);
+}
+
+/* One single-wire command with optional 24-bit address, output and input phase. */
+static void qf_command(QSPI_FLASH_T *flash, uint8_t u8Cmd, int32_t i32Addr, uint32_t u32Dummy,
+                       const uint8_t *pu8Tx, uint32_t u32TxLen, uint8_t *pu8Rx, uint32_t u32RxLen)
+{
+    uint8_t au8Hdr[8];
+    uint32_t u32HdrLen = 0;
+
+    au8Hdr[u32HdrLen++] = u8Cmd;
+    if(i32Addr >= 0)
+    {
+        au8Hdr[u32HdrLen++] = (i32Addr >> 16) & 0xFF;
+        au8Hdr[u32HdrLen++] = (i32Addr >> 8) & 0xFF;
+        au8Hdr[u32HdrLen++] = i32Addr & 0xFF;
+    }
+    while(u32Dummy--)
+        au8Hdr[u32HdrLen++] = 0x00;
+
+    qf_select(flash);
+    qf_pio_write(flash->qspi, au8Hdr, u32HdrLen);
+    if(u32TxLen)
+        qf_write_data(flash, pu8Tx, u32TxLen);
+    if(u32RxLen)
+        qf_read_data(flash, pu8Rx, u32RxLen);
+    qf_deselect(flash);
+}
+
+static void qf_write_enable(QSPI_FLASH_T *flash)
+{
+    qf_command(flash, CMD_WRITE_ENABLE, -1, 0, NULL, 0, NULL, 0);
+}
+
+static uint8_t qf_read_reg(QSPI_FLASH_T *flash, uint8_t u8Cmd)
+{
+    uint8_t u8Val;
+
+    qf_command(flash, u8Cmd, -1, 0, NULL, 0, &u8Val, 1);
+    return u8Val;
+}
+
+static void qf_write_reg(QSPI_FLASH_T *flash, uint8_t u8Cmd, const uint8_t *pu8Val, uint32_t u32Len)
+{
+    qf_write_enable(flash);
+    qf_command(flash, u8Cmd, -1, 0, pu8Val, u32Len, NULL, 0);
+    QSPI_FLASH_WaitReady(flash);
+}
+
+/* Set the QE bit according to JESD216 basic parameter DWORD 15 [22:20]. */
+static int32_t qf_enable_quad(QSPI_FLASH_T *flash)
+{
+    uint8_t au8SR[2];
+
+    switch(flash->u8QEType)
+    {
+    case 0:     /* no QE bit, quad I/O always available */
+        return 0;
+
+    case 1:     /* QE is SR2 bit 1, write SR1 and SR2 with 01h */
+    case 4:
+    case 5:
+        au8SR[0] = qf_read_reg(flash, CMD_READ_STATUS1);
+        au8SR[1] = qf_read_reg(flash, CMD_READ_STATUS2);
+        if(au8SR[1] & 0x02)
+            return 0;
+        au8SR[1] |= 0x02;
+        qf_write_reg(flash, CMD_WRITE_STATUS1, au8SR, 2);
+        return (qf_read_reg(flash, CMD_READ_STATUS2) & 0x02) ? 0 : -1;
+
+    case 2:     /* QE is SR1 bit 6 */
+        au8SR[0] = qf_read_reg(flash, CMD_READ_STATUS1);
+        if(au8SR[0] & 0x40)
+            return 0;
+        au8SR[0] |= 0x40;
+        qf_write_reg(flash, CMD_WRITE_STATUS1, au8SR, 1);
+        return (qf_read_reg(flash, CMD_READ_STATUS1) & 0x40) ? 0 : -1;
+
+    case 3:     /* QE is SR2 bit 7, accessed with 3Fh/3Eh */
+        au8SR[0] = qf_read_reg(flash, CMD_READ_STATUS_QE3);
+        if(au8SR[0] & 0x80)
+            return 0;
+        au8SR[0] |= 0x80;
+        qf_write_reg(flash, CMD_WRITE_STATUS_QE3, au8SR, 1);
+        return (qf_read_reg(flash, CMD_READ_STATUS_QE3) & 0x80) ? 0 : -1;
+
+    case 6:     /* QE is SR2 bit 1, SR2 written alone with 31h */
+        au8SR[0] = qf_read_reg(flash, CMD_READ_STATUS2);
+        if(au8SR[0] & 0x02)
+            return 0;
+        au8SR[0] |= 0x02;
+        qf_write_reg(flash, CMD_WRITE_STATUS2, au8SR, 1);
+        return (qf_read_reg(flash, CMD_READ_STATUS2) & 0x02) ? 0 : -1;
+
+    default:
+        return -1;
+    }
+}
+
+/* SFDP is read by PIO. The buffers are on the stack and share cache lines with
+   live data, so they must not be the target of a PDMA transfer. */
+static void qf_read_sfdp(QSPI_FLASH_T *flash, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint8_t au8Hdr[5];
+
+    au8Hdr[0] = CMD_READ_SFDP;
+    au8Hdr[1] = (u32Addr >> 16) & 0xFF;
+    au8Hdr[2] = (u32Addr >> 8) & 0xFF;
+    au8Hdr[3] = u32Addr & 0xFF;
+    au8Hdr[4] = 0x00;                       /* 8 dummy clocks */
+
+    qf_select(flash);
+    qf_pio_write(flash->qspi, au8Hdr, sizeof(au8Hdr));
+    qf_pio_read(flash->qspi, pu8Buf, u32Len);
+    qf_deselect(flash);
+}
+
+static uint32_t qf_get_le32(const uint8_t *pu8)
+{
+    return pu8[0] | (pu8[1] << 8) | (pu8[2] << 16) | ((uint32_t)pu8[3] << 24);
+}
+
+/* Parse the JEDEC basic flash parameter table. Returns 0 if found. */
+static int32_t qf_probe_sfdp(QSPI_FLASH_T *flash)
+{
+    uint8_t au8Hdr[8], au8Param[8];
+    uint8_t au8Tbl[16 * 4];
+    uint32_t au32DW[16];
+    uint32_t i, u32Nph, u32Ptr = 0, u32Dwords = 0;
+    uint32_t u32Size, u32Opcode;
+
+    qf_read_sfdp(flash, 0, au8Hdr, sizeof(au8Hdr));
+    if((au8Hdr[0] != 'S') || (au8Hdr[1] != 'F') || (au8Hdr[2] != 'D') || (au8Hdr[3] != 'P'))
+        return -1;
+
+    u32Nph = au8Hdr[6] + 1;
+    for(i = 0; i < u32Nph; i++)
+    {
+        qf_read_sfdp(flash, 8 + i * 8, au8Param, sizeof(au8Param));
+        if((au8Param[0] == 0x00) && (au8Param[7] == 0xFF))
+        {
+            u32Dwords = au8Param[3];
+            u32Ptr = au8Param[4] | (au8Param[5] << 8) | (au8Param[6] << 16);
+            break;
+        }
+    }
+    if(u32Dwords < 9)
+        return -1;
+    if(u32Dwords > 16)
+        u32Dwords = 16;
+
+    qf_read_sfdp(flash, u32Ptr, au8Tbl, u32Dwords * 4);
+    for(i = 0; i < 16; i++)
+        au32DW[i] = (i < u32Dwords) ? qf_get_le32(&au8Tbl[i * 4]) : 0;
+
+    /* DWORD 2: density in bits */
+    if(au32DW[1] & 0x80000000)
+    {
+        if((au32DW[1] & 0x7FFFFFFF) > 34)
+            return -1;
+        flash->u32Size = 1ul << ((au32DW[1] & 0x7FFFFFFF) - 3);
+    }
+    else
+        flash->u32Size = (au32DW[1] + 1) / 8;
+
+    /* DWORD 8/9: erase types, the smallest is the sector, the largest up to 64 KB is the block */
+    flash->u32SectorSize = 0;
+    flash->u32BlockSize = 0;
+    for(i = 0; i < 4; i++)
+    {
+        uint32_t u32Type = au32DW[7 + i / 2] >> ((i & 1) * 16);
+
+        if((u32Type & 0xFF) == 0)
+            continue;
+        u32Size = 1ul << (u32Type & 0xFF);
+        u32Opcode = (u32Type >> 8) & 0xFF;
+        if((flash->u32SectorSize == 0) || (u32Size < flash->u32SectorSize))
+        {
+            flash->u32SectorSize = u32Size;
+            flash->u8SectorEraseCmd = u32Opcode;
+        }
+        if((u32Size <= 0x10000) && (u32Size > flash->u32BlockSize))
+        {
+            flash->u32BlockSize = u32Size;
+            flash->u8BlockEraseCmd = u32Opcode;
+        }
+    }
+    if(flash->u32SectorSize == 0)
+    {
+        /* DWORD 1: 4 KB erase opcode */
+        if((au32DW[0] & 0x3) != 0x1)
+            return -1;
+        flash->u32SectorSize = 0x1000;
+        flash->u8SectorEraseCmd = (au32DW[0] >> 8) & 0xFF;
+    }
+    if(flash->u32BlockSize == 0)
+    {
+        flash->u32BlockSize = flash->u32SectorSize;
+        flash->u8BlockEraseCmd = flash->u8SectorEraseCmd;
+    }
+
+    /* DWORD 1 [21] + DWORD 3 [15:0]: 1-4-4 fast read, mode and dummy clocks are 2 per byte in quad */
+    if(au32DW[0] & (1ul << 21))
+    {
+        flash->u8ReadCmd = (au32DW[2] >> 8) & 0xFF;
+        flash->u8ReadDummy = ((au32DW[2] & 0x1F) + ((au32DW[2] >> 5) & 0x7)) / 2;
+    }
+    else
+        flash->u8ReadCmd = 0;
+
+    /* DWORD 11 [7:4]: page size, JESD216A and later */
+    flash->u32PageSize = 256;
+    if((u32Dwords >= 11) && ((au32DW[10] >> 4) & 0xF))
+        flash->u32PageSize = 1ul << ((au32DW[10] >> 4) & 0xF);
+
+    /* DWORD 15 [22:20]: quad enable requirement */
+    flash->u8QEType = (u32Dwords >= 15) ? ((au32DW[14] >> 20) & 0x7) : 5;
+
+    return 0;
+}
+
+/* Defaults of common 3-byte address parts (W25Q/MX25/GD25) when there is no SFDP table. */
+static void qf_probe_default(QSPI_FLASH_T *flash)
+{
+    uint32_t u32Cap = flash->u32JedecID & 0xFF;
+
+    flash->u32Size = ((u32Cap >= 0x10) && (u32Cap <= 0x18)) ? (1ul << u32Cap) : 0x200000;
+    flash->u32PageSize = 256;
+    flash->u32SectorSize = 0x1000;
+    flash->u8SectorEraseCmd = CMD_SECTOR_ERASE_4K;
+    flash->u32BlockSize = 0x10000;
+    flash->u8BlockEraseCmd = CMD_BLOCK_ERASE_64K;
+    flash->u8ReadCmd = CMD_QUAD_IO_READ;
+    flash->u8ReadDummy = 3;                 /* mode byte + 4 dummy clocks */
+    flash->u8QEType = 5;
+}
+
+/* Read flash with the configured read command, no cache involved. */
+static void qf_read_raw(QSPI_FLASH_T *flash, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    QSPI_T *qspi = flash->qspi;
+    uint8_t au8Hdr[8];
+    uint32_t i;
+
+    if(!flash->u8Quad)
+    {
+        qf_command(flash, CMD_FAST_READ, (int32_t)u32Addr, 1, NULL, 0, pu8Buf, u32Len);
+        return;
+    }
+
+    au8Hdr[0] = (u32Addr >> 16) & 0xFF;
+    au8Hdr[1] = (u32Addr >> 8) & 0xFF;
+    au8Hdr[2] = u32Addr & 0xFF;
+    for(i = 0; i < flash->u8ReadDummy; i++)
+        au8Hdr[3 + i] = 0x00;               /* mode byte 00h, no continuous read */
+
+    qf_select(flash);
+    qf_pio_write(qspi, &flash->u8ReadCmd, 1);
+
+    QSPI_ENABLE_QUAD_OUTPUT_MODE(qspi);
+    qf_pio_write(qspi, au8Hdr, 3 + flash->u8ReadDummy);
+
+    QSPI_ENABLE_QUAD_INPUT_MODE(qspi);
+    qf_read_data(flash, pu8Buf, u32Len);
+
+    while(QSPI_IS_BUSY(qspi));
+    qf_deselect(flash);
+    QSPI_DISABLE_QUAD_MODE(qspi);
+}
+
+#if (QSPI_FLASH_CACHE_LINES > 0)
+static int32_t qf_cache_lookup(QSPI_FLASH_T *flash, uint32_t u32Addr)
+{
+    int32_t i;
+
+    for(i = 0; i < QSPI_FLASH_CACHE_LINES; i++)
+    {
+        if((s_asCacheLine[i].flash == flash) && (s_asCacheLine[i].u32Addr == u32Addr))
+            return i;
+    }
+    return -1;
+}
+
+static int32_t qf_cache_victim(void)
+{
+    int32_t i, i32Victim = 0;
+
+    for(i = 0; i < QSPI_FLASH_CACHE_LINES; i++)
+    {
+        if(s_asCacheLine[i].flash == NULL)
+            return i;
+        if(s_asCacheLine[i].u32Age < s_asCacheLine[i32Victim].u32Age)
+            i32Victim = i;
+    }
+    s_sCacheStats.u32Evict++;
+    return i32Victim;
+}
+
+static uint8_t *qf_cache_get(QSPI_FLASH_T *flash, uint32_t u32Addr)
+{
+    int32_t i = qf_cache_lookup(flash, u32Addr);
+
+    if(i >= 0)
+    {
+        s_sCacheStats.u32Hit++;
+    }
+    else
+    {
+        s_sCacheStats.u32Miss++;
+        i = qf_cache_victim();
+        s_asCacheLine[i].flash = NULL;
+        qf_read_raw(flash, u32Addr, s_au8CacheBuf[i], QSPI_FLASH_CACHE_LINE_SIZE);
+        s_asCacheLine[i].flash = flash;
+        s_asCacheLine[i].u32Addr = u32Addr;
+    }
+    s_asCacheLine[i].u32Age = ++s_u32CacheAge;
+
+    return s_au8CacheBuf[i];
+}
+#endif
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup QSPI_FLASH_EXPORTED_FUNCTIONS QSPI NOR Flash Exported Functions
+  @{
+*/
+
+/**
+  * @brief  Probe a NOR flash on a QSPI port and prepare it for use.
+  * @param[out] flash   Device structure to be filled.
+  * @param[in]  qspi    QSPI port, already opened by QSPI_Open() as 8-bit master with manual slave select.
+  * @param[in]  pdma    PDMA controller for bulk transfers, or NULL to use PIO only. PDMA clock must be enabled.
+  * @param[in]  u32TxCh PDMA channel used for QSPI TX.
+  * @param[in]  u32RxCh PDMA channel used for QSPI RX.
+  * @param[in]  u32Flags Combination of \ref QSPI_FLASH_FLAG_QUAD and \ref QSPI_FLASH_FLAG_NO_SFDP.
+  * @retval QSPI_FLASH_OK            Flash found and configured.
+  * @retval QSPI_FLASH_ERR_NO_DEVICE No flash answers on the port.
+  * @details Geometry, erase opcodes, 1-4-4 read command and quad enable method are taken from the SFDP
+  *          table, or from common defaults if the flash has none. When quad mode is requested the QE bit is
+  *          set once here, so QSPI0 D2/D3 must be configured as QSPI pins by the caller.
+  *          Only 3-byte addressing is supported, larger parts are limited to their first 16 MB.
+  */
+uint32_t QSPI_FLASH_Open(QSPI_FLASH_T *flash, QSPI_T *qspi, PDMA_T *pdma, uint32_t u32TxCh, uint32_t u32RxCh, uint32_t u32Flags)
+{
+    memset(flash, 0, sizeof(QSPI_FLASH_T));
+    flash->qspi = qspi;
+    flash->pdma = pdma;
+    flash->u32TxCh = u32TxCh;
+    flash->u32RxCh = u32RxCh;
+
+    qf_deselect(flash);
+    QSPI_DISABLE_QUAD_MODE(qspi);
+    qf_byte_mode(qspi);
+
+    if(pdma != NULL)
+        PDMA_Open(pdma, (1 << u32TxCh) | (1 << u32RxCh));
+
+    flash->u32JedecID = QSPI_FLASH_ReadJedecID(flash);
+    if((flash->u32JedecID == 0) || (flash->u32JedecID == 0xFFFFFF))
+        return QSPI_FLASH_ERR_NO_DEVICE;
+
+    if(!(u32Flags & QSPI_FLASH_FLAG_NO_SFDP) && (qf_probe_sfdp(flash) == 0))
+        flash->u8SFDP = 1;
+    else
+        qf_probe_default(flash);
+
+    if(flash->u32Size > 0x1000000)
+        flash->u32Size = 0x1000000;
+
+    if((u32Flags & QSPI_FLASH_FLAG_QUAD) && (qspi == QSPI0) && flash->u8ReadCmd &&
+            (flash->u8ReadDummy <= 5) && (qf_enable_quad(flash) == 0))
+        flash->u8Quad = 1;
+    else
+        flash->u8ReadCmd = CMD_FAST_READ;
+
+    QSPI_FLASH_InvalidateCache(flash);
+
+    return QSPI_FLASH_OK;
+}
+
+/**
+  * @brief  Stop using a flash device. Its cache lines are dropped.
+  * @param[in]  flash   Flash device.
+  * @return None
+  */
+void QSPI_FLASH_Close(QSPI_FLASH_T *flash)
+{
+    QSPI_FLASH_InvalidateCache(flash);
+    if(flash->pdma != NULL)
+        flash->pdma->CHCTL &= ~((1 << flash->u32TxCh) | (1 << flash->u32RxCh));
+}
+
+/**
+  * @brief  Read JEDEC manufacturer and device ID (command 9Fh).
+  * @param[in]  flash   Flash device.
+  * @return Manufacturer ID in bits [23:16], memory type in [15:8] and capacity in [7:0].
+  */
+uint32_t QSPI_FLASH_ReadJedecID(QSPI_FLASH_T *flash)
+{
+    uint8_t au8ID[3];
+
+    qf_command(flash, CMD_READ_JEDEC_ID, -1, 0, NULL, 0, au8ID, 3);
+    return (au8ID[0] << 16) | (au8ID[1] << 8) | au8ID[2];
+}
+
+/**
+  * @brief  Read status register 1 (command 05h).
+  * @param[in]  flash   Flash device.
+  * @return Status register 1.
+  */
+uint8_t QSPI_FLASH_ReadStatus(QSPI_FLASH_T *flash)
+{
+    return qf_read_reg(flash, CMD_READ_STATUS1);
+}
+
+/**
+  * @brief  Wait until the flash finishes program or erase.
+  * @param[in]  flash   Flash device.
+  * @return None
+  * @details The NUC980 QSPI controller has no hardware auto-poll of the status register, so the CPU polls
+  *          it. The read status command is issued once and the status register is clocked out continuously
+  *          under the same chip select until WIP clears, instead of re-sending the command for every poll.
+  */
+void QSPI_FLASH_WaitReady(QSPI_FLASH_T *flash)
+{
+    QSPI_T *qspi = flash->qspi;
+    uint8_t u8Cmd = CMD_READ_STATUS1;
+    uint8_t u8Status;
+
+    qf_select(flash);
+    qf_pio_write(qspi, &u8Cmd, 1);
+    do
+    {
+        QSPI_WRITE_TX(qspi, 0x00);
+        while(QSPI_GET_RX_FIFO_EMPTY_FLAG(qspi));
+        u8Status = (uint8_t)QSPI_READ_RX(qspi);
+    }
+    while(u8Status & SR1_WIP);
+    while(QSPI_IS_BUSY(qspi));
+    qf_deselect(flash);
+}
+
+/**
+  * @brief  Read data from flash.
+  * @param[in]  flash   Flash device.
+  * @param[in]  u32Addr Flash address.
+  * @param[out] pu8Buf  Destination buffer.
+  * @param[in]  u32Len  Number of bytes.
+  * @retval QSPI_FLASH_OK         Success.
+  * @retval QSPI_FLASH_ERR_PARAM  Range exceeds the flash size.
+  * @details Partial sectors go through the LRU sector cache. Whole sectors which are not cached are
+  *          transferred directly into the caller buffer and are not inserted into the cache, so a large
+  *          sequential read (e.g. a firmware image) does not flush it.
+  *          PDMA only fills the whole 32-byte D-cache lines of \p pu8Buf and the lines are invalidated
+  *          after the transfer; the partial lines at either end are read by PIO, so the buffer may share
+  *          them with other data. Start the buffer on a CACHE_LINE_SIZE boundary for full PDMA speed.
+  */
+uint32_t QSPI_FLASH_Read(QSPI_FLASH_T *flash, uint32_t u32Addr, uint8_t *pu8Buf, uint32_t u32Len)
+{
+#if (QSPI_FLASH_CACHE_LINES > 0)
+    uint32_t u32Sector, u32Offset, u32Run, u32Chunk;
+#endif
+
+    if((u32Addr >= flash->u32Size) || (u32Len > flash->u32Size - u32Addr))
+        return QSPI_FLASH_ERR_PARAM;
+
+#if (QSPI_FLASH_CACHE_LINES > 0)
+    while(u32Len)
+    {
+        u32Sector = u32Addr & ~(QSPI_FLASH_CACHE_LINE_SIZE - 1);
+        u32Offset = u32Addr - u32Sector;
+
+        if((u32Offset == 0) && (u32Len >= QSPI_FLASH_CACHE_LINE_SIZE) && (qf_cache_lookup(flash, u32Sector) < 0))
+        {
+            /* Collect the run of whole uncached sectors into one transfer */
+            u32Run = QSPI_FLASH_CACHE_LINE_SIZE;
+            while((u32Len - u32Run >= QSPI_FLASH_CACHE_LINE_SIZE) && (qf_cache_lookup(flash, u32Sector + u32Run) < 0))
+                u32Run += QSPI_FLASH_CACHE_LINE_SIZE;
+
+            qf_read_raw(flash, u32Addr, pu8Buf, u32Run);
+            s_sCacheStats.u32Bypass += u32Run / QSPI_FLASH_CACHE_LINE_SIZE;
+            u32Chunk = u32Run;
+        }
+        else
+        {
+            u32Chunk = QSPI_FLASH_CACHE_LINE_SIZE - u32Offset;
+            if(u32Chunk > u32Len)
+                u32Chunk = u32Len;
+            memcpy(pu8Buf, qf_cache_get(flash, u32Sector) + u32Offset, u32Chunk);
+        }
+
+        u32Addr += u32Chunk;
+        pu8Buf += u32Chunk;
+        u32Len -= u32Chunk;
+    }
+#else
+    qf_read_raw(flash, u32Addr, pu8Buf, u32Len);
+#endif
+
+    return QSPI_FLASH_OK;
+}
+
+/**
+  * @brief  Program data into erased flash.
+  * @param[in]  flash   Flash device.
+  * @param[in]  u32Addr Flash address.
+  * @param[in]  pu8Buf  Source buffer.
+  * @param[in]  u32Len  Number of bytes.
+  * @retval QSPI_FLASH_OK         Success.
+  * @retval QSPI_FLASH_ERR_PARAM  Range exceeds the flash size.
+  * @details Data is split on page boundaries. While one page is being programmed the cached copy of it is
+  *          updated, so the cache stays coherent without costing extra time.
+  */
+uint32_t QSPI_FLASH_Write(QSPI_FLASH_T *flash, uint32_t u32Addr, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Chunk;
+#if (QSPI_FLASH_CACHE_LINES > 0)
+    int32_t i;
+    uint32_t u32Sector;
+#endif
+
+    if((u32Addr >= flash->u32Size) || (u32Len > flash->u32Size - u32Addr))
+        return QSPI_FLASH_ERR_PARAM;
+
+    /* PDMA reads the source from SDRAM */
+    if(flash->pdma != NULL)
+        sysCleanDCacheRange((uint32_t)pu8Buf, u32Len);
+
+    while(u32Len)
+    {
+        u32Chunk = flash->u32PageSize - (u32Addr & (flash->u32PageSize - 1));
+        if(u32Chunk > u32Len)
+            u32Chunk = u32Len;
+
+        qf_write_enable(flash);
+        qf_command(flash, CMD_PAGE_PROGRAM, (int32_t)u32Addr, 0, pu8Buf, u32Chunk, NULL, 0);
+
+#if (QSPI_FLASH_CACHE_LINES > 0)
+        /* Program bits can only go 1 -> 0, mirror that on the cached copy */
+        u32Sector = u32Addr & ~(QSPI_FLASH_CACHE_LINE_SIZE - 1);
+        i = qf_cache_lookup(flash, u32Sector);
+        if(i >= 0)
+        {
+            uint8_t *pu8Line = s_au8CacheBuf[i] + (u32Addr - u32Sector);
+            uint32_t j;
+
+            for(j = 0; j < u32Chunk; j++)
+                pu8Line[j] &= pu8Buf[j];
+        }
+#endif
+
+        QSPI_FLASH_WaitReady(flash);
+
+        u32Addr += u32Chunk;
+        pu8Buf += u32Chunk;
+        u32Len -= u32Chunk;
+    }
+
+    return QSPI_FLASH_OK;
+}
+
+/**
+  * @brief  Erase a sector aligned range.
+  * @param[in]  flash   Flash device.
+  * @param[in]  u32Addr Flash address, multiple of u32SectorSize.
+  * @param[in]  u32Len  Number of bytes, multiple of u32SectorSize.
+  * @retval QSPI_FLASH_OK         Success.
+  * @retval QSPI_FLASH_ERR_PARAM  Range exceeds the flash size.
+  * @retval QSPI_FLASH_ERR_ALIGN  Range is not sector aligned.
+  * @details Block erase is used where the range covers a whole block. Cached copies are set to FFh.
+  */
+uint32_t QSPI_FLASH_Erase(QSPI_FLASH_T *flash, uint32_t u32Addr, uint32_t u32Len)
+{
+    uint32_t u32Chunk;
+    uint8_t u8Cmd;
+#if (QSPI_FLASH_CACHE_LINES > 0)
+    int32_t i;
+    uint32_t u32Start, u32End;
+#endif
+
+    if((u32Addr >= flash->u32Size) || (u32Len > flash->u32Size - u32Addr))
+        return QSPI_FLASH_ERR_PARAM;
+    if((u32Addr | u32Len) & (flash->u32SectorSize - 1))
+        return QSPI_FLASH_ERR_ALIGN;
+
+    while(u32Len)
+    {
+        if(((u32Addr & (flash->u32BlockSize - 1)) == 0) && (u32Len >= flash->u32BlockSize))
+        {
+            u32Chunk = flash->u32BlockSize;
+            u8Cmd = flash->u8BlockEraseCmd;
+        }
+        else
+        {
+            u32Chunk = flash->u32SectorSize;
+            u8Cmd = flash->u8SectorEraseCmd;
+        }
+
+        qf_write_enable(flash);
+        qf_command(flash, u8Cmd, (int32_t)u32Addr, 0, NULL, 0, NULL, 0);
+
+#if (QSPI_FLASH_CACHE_LINES > 0)
+        /* Blank the part of each cached sector the erase covers, a sector may be larger or smaller */
+        for(i = 0; i < QSPI_FLASH_CACHE_LINES; i++)
+        {
+            if(s_asCacheLine[i].flash != flash)
+                continue;
+            u32Start = (s_asCacheLine[i].u32Addr > u32Addr) ? s_asCacheLine[i].u32Addr : u32Addr;
+            u32End = s_asCacheLine[i].u32Addr + QSPI_FLASH_CACHE_LINE_SIZE;
+            if(u32End > u32Addr + u32Chunk)
+                u32End = u32Addr + u32Chunk;
+            if(u32Start < u32End)
+                memset(s_au8CacheBuf[i] + (u32Start - s_asCacheLine[i].u32Addr), 0xFF, u32End - u32Start);
+        }
+#endif
+
+        QSPI_FLASH_WaitReady(flash);
+
+        u32Addr += u32Chunk;
+        u32Len -= u32Chunk;
+    }
+
+    return QSPI_FLASH_OK;
+}
+
+/**
+  * @brief  Erase the whole flash.
+  * @param[in]  flash   Flash device.
+  * @return QSPI_FLASH_OK
+  */
+uint32_t QSPI_FLASH_EraseChip(QSPI_FLASH_T *flash)
+{
+    qf_write_enable(flash);
+    qf_command(flash, CMD_CHIP_ERASE, -1, 0, NULL, 0, NULL, 0);
+    QSPI_FLASH_InvalidateCache(flash);
+    QSPI_FLASH_WaitReady(flash);
+
+    return QSPI_FLASH_OK;
+}
+
+/**
+  * @brief  Drop all cached sectors of a flash device.
+  * @param[in]  flash   Flash device.
+  * @return None
+  * @details Must be called if the flash content is changed by another master.
+  */
+void QSPI_FLASH_InvalidateCache(QSPI_FLASH_T *flash)
+{
+#if (QSPI_FLASH_CACHE_LINES > 0)
+    int32_t i;
+
+    for(i = 0; i < QSPI_FLASH_CACHE_LINES; i++)
+    {
+        if(s_asCacheLine[i].flash == flash)
+            s_asCacheLine[i].flash = NULL;
+    }
+#endif
+}
+
+/**
+  * @brief  Get the read cache statistics.
+  * @param[out] stats   Copy of the counters since power on.
+  * @return None
+  */
+void QSPI_FLASH_GetCacheStats(QSPI_FLASH_CACHE_STATS_T *stats)
+{
+    memcpy(stats, &s_sCacheStats, sizeof(QSPI_FLASH_CACHE_STATS_T));
+}
+
+/*@}*/ /* end of group QSPI_FLASH_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group QSPI_FLASH_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
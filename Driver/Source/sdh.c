@@ -35,6 +35,7 @@ uint8_t volatile g_u8SDDataReadyFlag = FALSE;
 
 static uint32_t _SDH_uR7_CMD = 0ul;
 static uint32_t _SDH_ReferenceClock;
+static void (*_SDH_pfnWaitHook)(void) = NULL;
 
 #ifdef __ICCARM__
 #pragma data_alignment = 32
@@ -686,8 +687,9 @@ uint32_t SDH_SelectCardType(SDH_T *sdh)
 
 void SDH_Get_SD_info(SDH_T *sdh)
 {
-    unsigned int R_LEN, C_Size, MULT, size;
+    unsigned int R_LEN, C_Size, MULT, size, WBL_LEN;
     unsigned int Buffer[4];
+    unsigned int bCanTrim = 0;
     //unsigned char *ptr;
     SDH_INFO_T *pSD;
 
@@ -728,6 +730,7 @@ void SDH_Get_SD_info(SDH_T *sdh)
                 pSD->totalSectorN |= (uint32_t)_SDH_ucSDHCBuffer[213]<<8;
                 pSD->totalSectorN |= (uint32_t)_SDH_ucSDHCBuffer[212];
                 pSD->diskSize = pSD->totalSectorN / 2ul;
+                bCanTrim = (_SDH_ucSDHCBuffer[231] & 0x10ul) ? 1ul : 0ul;    /* SEC_FEATURE_SUPPORT.SEC_GB_CL_EN */
             }
         }
         else
@@ -764,6 +767,35 @@ void SDH_Get_SD_info(SDH_T *sdh)
         }
     }
     pSD->sectorSize = (int)512;
+
+    /* erase unit in write blocks, WRITE_BL_LEN [25:22] */
+    WBL_LEN = (Buffer[3] & 0x03c00000ul) >> 22;
+    if ((pSD->CardType == SDH_TYPE_MMC) || (pSD->CardType == SDH_TYPE_EMMC))
+    {
+        /* ERASE_GRP_SIZE [46:42], ERASE_GRP_MULT [41:37] */
+        pSD->eraseGroup = (((Buffer[2] & 0x00007c00ul) >> 10) + 1ul) * (((Buffer[2] & 0x000003e0ul) >> 5) + 1ul);
+    }
+    else if (Buffer[2] & 0x00004000ul)
+    {
+        /* ERASE_BLK_EN [46], single blocks can be erased */
+        pSD->eraseGroup = 1ul;
+    }
+    else
+    {
+        /* SECTOR_SIZE [45:39] */
+        pSD->eraseGroup = ((Buffer[2] & 0x00003f80ul) >> 7) + 1ul;
+    }
+    if (WBL_LEN > 9ul)
+    {
+        pSD->eraseGroup <<= (WBL_LEN - 9ul);
+    }
+    pSD->eraseArg = 0ul;
+    if (bCanTrim)
+    {
+        /* eMMC TRIM works on write blocks */
+        pSD->eraseGroup = 1ul;
+        pSD->eraseArg = 1ul;
+    }
 //    printf("The size is %d KB\n", pSD->diskSize);
 }
 
@@ -874,6 +906,22 @@ uint32_t SDH_Probe(SDH_T *sdh)
     return 0ul;
 }
 
+/**
+ *  @brief  Set a function called repeatedly while SDH_Read() and SDH_Write() wait for a data transfer.
+ *
+ *  @param[in]  pfnHook   Wait hook, or NULL to busy wait. A cooperative scheduler can run other work
+ *                        from it, as long as that work does not access the same SD port.
+ *
+ *  @return None
+ *
+ *  @details The hook is shared by SDH0 and SDH1. The transfer completes on the SDH interrupt
+ *           whether or not the hook returns at once.
+ */
+void SDH_SetWaitHook(void (*pfnHook)(void))
+{
+    _SDH_pfnWaitHook = pfnHook;
+}
+
 /**
  *  @brief  This function use to read data from SD card.
  *
@@ -937,15 +985,16 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
         {
             sdh->CTL = reg | SDH_CTL_DIEN_Msk;
         }
+        while(!g_u8SDDataReadyFlag)
         {
-            if(g_u8SDDataReadyFlag)
-            {
-                break;
-            }
             if (pSD->IsCardInsert == FALSE)
             {
                 return SDH_NO_SD_CARD;
             }
+            if (_SDH_pfnWaitHook != NULL)
+            {
+                _SDH_pfnWaitHook();
+            }
         }
         if ((sdh->INTSTS & SDH_INTSTS_CRC7_Msk) != SDH_INTSTS_CRC7_Msk)      /* check CRC7 */
         {
@@ -980,6 +1029,10 @@ uint32_t SDH_Read(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32_
             {
                 return SDH_NO_SD_CARD;
             }
+            if (_SDH_pfnWaitHook != NULL)
+            {
+                _SDH_pfnWaitHook();
+            }
         }
         if ((sdh->INTSTS & SDH_INTSTS_CRC7_Msk) != SDH_INTSTS_CRC7_Msk)      /* check CRC7 */
         {
@@ -1085,6 +1138,10 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
             {
                 return SDH_NO_SD_CARD;
             }
+            if (_SDH_pfnWaitHook != NULL)
+            {
+                _SDH_pfnWaitHook();
+            }
         }
 
         if ((sdh->INTSTS & SDH_INTSTS_CRCIF_Msk) != 0ul)
@@ -1115,6 +1172,10 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
             {
                 return SDH_NO_SD_CARD;
             }
+            if (_SDH_pfnWaitHook != NULL)
+            {
+                _SDH_pfnWaitHook();
+            }
         }
 
         if ((sdh->INTSTS & SDH_INTSTS_CRCIF_Msk) != 0ul)
@@ -1140,6 +1201,99 @@ uint32_t SDH_Write(SDH_T *sdh, uint8_t *pu8BufAddr, uint32_t u32StartSec, uint32
     return Successful;
 }
 
+/**
+ *  @brief  This function use to erase sectors of SD card.
+ *
+ *  @param[in]    sdh           Select SDH0 or SDH1.
+ *  @param[in]    u32StartSec   The start erase sector address.
+ *  @param[in]    u32SecCount   The erase sector number.
+ *
+ *  @return   \ref SDH_SELECT_ERROR : u32SecCount is zero. \n
+ *            \ref SDH_NO_SD_CARD : SD card be removed. \n
+ *            \ref SDH_CRC7_ERROR : CRC7 error happen. \n
+ *            \ref Successful : Erase success.
+ *
+ *  @details  Only the erase groups lying completely inside the range are erased, the sectors
+ *            at either end that share a group with data outside the range are left untouched.
+ *            Erased sectors read back as all 0 or all 1 depending on the card.
+ */
+uint32_t SDH_Erase(SDH_T *sdh, uint32_t u32StartSec, uint32_t u32SecCount)
+{
+    uint32_t volatile status;
+    uint32_t u32Group, u32First, u32End;
+    uint32_t u32CmdStart, u32CmdEnd;
+    SDH_INFO_T *pSD;
+
+    if (sdh == SDH0)
+    {
+        pSD = &SD0;
+    }
+    else
+    {
+        pSD = &SD1;
+    }
+
+    if (u32SecCount == 0ul)
+    {
+        return SDH_SELECT_ERROR;
+    }
+
+    u32Group = (pSD->eraseGroup != 0ul) ? pSD->eraseGroup : 1ul;
+    u32First = (u32StartSec + u32Group - 1ul) / u32Group * u32Group;
+    u32End = (u32StartSec + u32SecCount) / u32Group * u32Group;
+    if (u32First >= u32End)
+    {
+        return Successful;      /* no whole erase group in range */
+    }
+    u32End--;
+
+    if ((pSD->CardType == SDH_TYPE_MMC) || (pSD->CardType == SDH_TYPE_EMMC))
+    {
+        u32CmdStart = 35ul;     /* ERASE_GROUP_START */
+        u32CmdEnd = 36ul;       /* ERASE_GROUP_END */
+    }
+    else
+    {
+        u32CmdStart = 32ul;     /* ERASE_WR_BLK_START */
+        u32CmdEnd = 33ul;       /* ERASE_WR_BLK_END */
+    }
+
+    if ((pSD->CardType != SDH_TYPE_SD_HIGH) && (pSD->CardType != SDH_TYPE_EMMC))
+    {
+        u32First *= SDH_BLOCK_SIZE;     /* byte address */
+        u32End *= SDH_BLOCK_SIZE;
+    }
+
+    if ((status = SDH_SDCmdAndRsp(sdh, 7ul, pSD->RCA, 0ul)) != Successful)
+    {
+        return status;
+    }
+    SDH_CheckRB(sdh);
+
+    status = SDH_SDCmdAndRsp(sdh, u32CmdStart, u32First, 0ul);
+    if (status == Successful)
+    {
+        status = SDH_SDCmdAndRsp(sdh, u32CmdEnd, u32End, 0ul);
+    }
+    if (status == Successful)
+    {
+        status = SDH_SDCmdAndRsp(sdh, 38ul, pSD->eraseArg, 0ul);
+        if (status == Successful)
+        {
+            SDH_CheckRB(sdh);   /* card holds DAT0 low until the erase is done */
+        }
+    }
+
+    /* deselect the card also when a command failed */
+    SDH_SDCommand(sdh, 7ul, 0ul);
+    sdh->CTL |= SDH_CTL_CLK8OEN_Msk;
+    while ((sdh->CTL & SDH_CTL_CLK8OEN_Msk) == SDH_CTL_CLK8OEN_Msk)
+    {
+    }
+
+    return status;
+}
+
 /*@}*/ /* end of group SDH_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group SDH_Driver */
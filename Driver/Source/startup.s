@@ -74,6 +74,16 @@ DONE_DRAMSIZE
     LSL    R0,R1,#20
     ;LDR    R0, =RAM_Limit
 
+    ; Fill all mode stacks with 0xA5A5A5A5 so sysGetStackInfo() can find how
+    ; deep each one has been used
+    LDR    R1, =0xA5A5A5A5
+    LDR    R2, =(UND_Stack_Size+ABT_Stack_Size+IRQ_Stack_Size+FIQ_Stack_Size+USR_Stack_Size+SVC_Stack_Size)
+    SUB    R2, R0, R2
+LOOP_STACKFILL
+    STR    R1, [R2], #4
+    CMP    R2, R0
+    BLO    LOOP_STACKFILL
+
     ; Enter Undefined Instruction Mode and set Stack Pointer
     MSR    CPSR_c, #UDF_MODE:OR:I_BIT:OR:F_BIT
     MOV    SP, R0
@@ -5,6 +5,7 @@
  * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
  *****************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include "nuc980.h"
 #include "sys.h"
 
@@ -28,6 +29,19 @@
 
 /* Global variables */
 UINT32 volatile _sys_bIsAICInitial = 0x0;
+static BOOL _sys_bIsIrqNesting = FALSE;
+static PVOID _sys_pvFastFiq = NULL;     /* handler of sysInstallFastFiq(), NULL for sysFiqHandler */
+
+/* Interrupt statistics, collected by sysIrqDispatch() */
+static sys_pfnTimestamp _sys_pfnIrqTimestamp = NULL;
+static UINT32 _sys_u32IrqTimestampMask;
+static SYS_IRQ_STAT_T _sys_asIrqStat[SYS_MAX_INT_SOURCE + 1];
+static UINT32 volatile _sys_u32IrqCurrent;      /* IRQ whose handler is running, 0 if none */
+static UINT32 volatile _sys_u32IrqNestedTime;   /* time nested handlers took out of the running one */
+
+/* Trace hooks, called by sysIrqDispatch() around every handler */
+static sys_pfnIrqHook _sys_pfnIrqEnter = NULL;
+static sys_pfnIrqHook _sys_pfnIrqExit = NULL;
 
 /* declaration the function prototype */
 void SYS_IRQ_Shell(void);
@@ -167,6 +181,64 @@ sys_pvFunPtr sysFiqHandlerTable[] = { 0,
                                       SYS_FIQ_Shell    /* 63 */
                                     };
 
+/* Call the handler of one IRQ and collect its statistics. With bNested, the
+   caller is in system mode with IRQ masked and the AIC already holds off this
+   priority level and lower, so IRQ is enabled around the handler to let
+   higher levels in. Returns with IRQ masked. */
+void sysIrqDispatch(UINT32 u32IrqNum, BOOL bNested)
+{
+    sys_pfnTimestamp pfnTimestamp = _sys_pfnIrqTimestamp;
+    sys_pfnIrqHook pfnExit = _sys_pfnIrqExit;
+    SYS_IRQ_STAT_T *psStat;
+    UINT32 u32Outer, u32OuterNested, u32Start, u32Time;
+
+    if (u32IrqNum == 0)
+        return;
+
+    if (_sys_pfnIrqEnter != NULL)
+        _sys_pfnIrqEnter(u32IrqNum);
+
+    if (pfnTimestamp == NULL)
+    {
+        if (bNested)
+            sysSetLocalInterrupt(ENABLE_IRQ);
+        (*sysIrqHandlerTable[u32IrqNum])();
+        if (bNested)
+            sysSetLocalInterrupt(DISABLE_IRQ);
+        if (pfnExit != NULL)
+            pfnExit(u32IrqNum);
+        return;
+    }
+
+    /* Time spent in nested handlers is charged to them, not to this one */
+    u32Outer = _sys_u32IrqCurrent;
+    if (u32Outer != 0)
+        _sys_asIrqStat[u32Outer].u32Preempted++;
+    u32OuterNested = _sys_u32IrqNestedTime;
+    _sys_u32IrqNestedTime = 0;
+    _sys_u32IrqCurrent = u32IrqNum;
+    u32Start = pfnTimestamp();
+
+    if (bNested)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+    (*sysIrqHandlerTable[u32IrqNum])();
+    if (bNested)
+        sysSetLocalInterrupt(DISABLE_IRQ);
+
+    u32Time = (pfnTimestamp() - u32Start) & _sys_u32IrqTimestampMask;
+    psStat = &_sys_asIrqStat[u32IrqNum];
+    psStat->u32Count++;
+    psStat->u32TotalTime += u32Time - _sys_u32IrqNestedTime;
+    if (u32Time - _sys_u32IrqNestedTime > psStat->u32MaxTime)
+        psStat->u32MaxTime = u32Time - _sys_u32IrqNestedTime;
+
+    _sys_u32IrqNestedTime = u32OuterNested + u32Time;
+    _sys_u32IrqCurrent = u32Outer;
+
+    if (pfnExit != NULL)
+        pfnExit(u32IrqNum);
+}
+
 /* Interrupt Handler */
 #if defined (__GNUC__) && !(__CC_ARM)
 static void __attribute__ ((interrupt("IRQ"))) sysIrqHandler(void)
@@ -177,11 +249,77 @@ __irq void sysIrqHandler()
     UINT32 volatile num;
 
     num = inpw(REG_AIC_IRQNUM);
-    if (num != 0)
-        (*sysIrqHandlerTable[num])();
+    sysIrqDispatch(num, FALSE);
     outpw(REG_AIC_EOIS, 1);
 }
 
+/* Nested interrupt handler. Reading IRQNUM makes the AIC hold off this level
+   and lower until EOIS, so the handler runs in system mode with IRQ enabled
+   and only a higher priority level can interrupt it. LR and SPSR of IRQ mode
+   are kept on the IRQ stack; the handler itself runs on the system mode
+   stack, which nothing else uses outside of a RTOS. */
+#if defined (__GNUC__) && !(__CC_ARM)
+static void __attribute__ ((naked)) sysIrqNestedHandler(void)
+{
+    asm volatile
+    (
+        "SUB    lr, lr, #4              \n"
+        "STMFD  sp!, {r0-r3, r12, lr}   \n"
+        "MRS    r0, spsr                \n"
+        "STMFD  sp!, {r0, r4}           \n"
+        "LDR    r0, =0xB0042120         \n"    /* REG_AIC_IRQNUM */
+        "LDR    r0, [r0]                \n"
+        "MRS    r4, cpsr                \n"
+        "ORR    r1, r4, #0x1F           \n"    /* system mode, IRQ still masked */
+        "MSR    cpsr_c, r1              \n"
+        "MOV    r2, sp                  \n"    /* 8-byte align the stack for the call */
+        "BIC    sp, sp, #7              \n"
+        "STMFD  sp!, {r2, lr}           \n"
+        "MOV    r1, #1                  \n"
+        "BL     sysIrqDispatch          \n"
+        "LDMFD  sp!, {r2, lr}           \n"
+        "MOV    sp, r2                  \n"
+        "MSR    cpsr_c, r4              \n"    /* back to IRQ mode */
+        "LDR    r0, =0xB0042150         \n"    /* REG_AIC_EOIS */
+        "MOV    r1, #1                  \n"
+        "STR    r1, [r0]                \n"
+        "LDMFD  sp!, {r0, r4}           \n"
+        "MSR    spsr_cxsf, r0           \n"
+        "LDMFD  sp!, {r0-r3, r12, pc}^  \n"
+        ".ltorg                         \n"
+    );
+}
+#else
+__asm void sysIrqNestedHandler(void)
+{
+    PRESERVE8
+
+    SUB     lr, lr, #4
+    STMFD   sp!, {r0-r3, r12, lr}
+    MRS     r0, spsr
+    STMFD   sp!, {r0, r4}
+    LDR     r0, =0xB0042120         ; REG_AIC_IRQNUM
+    LDR     r0, [r0]
+    MRS     r4, cpsr
+    ORR     r1, r4, #0x1F           ; system mode, IRQ still masked
+    MSR     cpsr_c, r1
+    MOV     r2, sp                  ; 8-byte align the stack for the call
+    BIC     sp, sp, #7
+    STMFD   sp!, {r2, lr}
+    MOV     r1, #1
+    BL      __cpp(sysIrqDispatch)
+    LDMFD   sp!, {r2, lr}
+    MOV     sp, r2
+    MSR     cpsr_c, r4              ; back to IRQ mode
+    LDR     r0, =0xB0042150         ; REG_AIC_EOIS
+    MOV     r1, #1
+    STR     r1, [r0]
+    LDMFD   sp!, {r0, r4}
+    MSR     spsr_cxsf, r0
+    LDMFD   sp!, {r0-r3, r12, pc}^
+}
+#endif
+
 #if defined (__GNUC__) && !(__CC_ARM)
 static void __attribute__ ((interrupt("FIQ"))) sysFiqHandler(void)
 #else
@@ -192,7 +330,7 @@ __irq void sysFiqHandler()
 
     num = inpw(REG_AIC_FIQNUM);
     if (num != 0)
-        (*sysIrqHandlerTable[num])();
+        (*sysFiqHandlerTable[num])();
     outpw(REG_AIC_EOFS, 1);
 }
 
@@ -209,15 +347,57 @@ void SYS_FIQ_Shell(void)
 void sysInitializeAIC()
 {
 #if defined (__GNUC__) && !(__CC_ARM)
-    *(unsigned int volatile *)0x34 = (unsigned int volatile)sysIrqHandler;
+    if (_sys_bIsIrqNesting)
+        *(unsigned int volatile *)0x34 = (unsigned int volatile)sysIrqNestedHandler;
+    else
+        *(unsigned int volatile *)0x34 = (unsigned int volatile)sysIrqHandler;
 
-    *(unsigned int volatile *)0x38 = (unsigned int volatile)sysFiqHandler;
+    if (_sys_pvFastFiq != NULL)
+        *(unsigned int volatile *)0x38 = (unsigned int volatile)_sys_pvFastFiq;
+    else
+        *(unsigned int volatile *)0x38 = (unsigned int volatile)sysFiqHandler;
 #else
-    *(unsigned int volatile *)0x38 = (unsigned int)sysIrqHandler;
+    if (_sys_bIsIrqNesting)
+        *(unsigned int volatile *)0x38 = (unsigned int)sysIrqNestedHandler;
+    else
+        *(unsigned int volatile *)0x38 = (unsigned int)sysIrqHandler;
 
-    *(unsigned int volatile *)0x3C = (unsigned int)sysFiqHandler;
+    if (_sys_pvFastFiq != NULL)
+        *(unsigned int volatile *)0x3C = (unsigned int)_sys_pvFastFiq;
+    else
+        *(unsigned int volatile *)0x3C = (unsigned int)sysFiqHandler;
 #endif
 }
+
+/* Load R8 to R12 of FIQ mode from pu32Regs[0] to pu32Regs[4] */
+#if defined (__GNUC__) && !(__CC_ARM)
+static void __attribute__ ((naked)) sysLoadFiqRegisters(const UINT32 *pu32Regs)
+{
+    asm volatile
+    (
+        "MRS    r1, cpsr            \n"
+        "ORR    r2, r1, #0xC0       \n"
+        "BIC    r2, r2, #0x1F       \n"
+        "ORR    r2, r2, #0x11       \n"    /* FIQ mode, IRQ and FIQ masked */
+        "MSR    cpsr_c, r2          \n"
+        "LDMIA  r0, {r8-r12}        \n"
+        "MSR    cpsr_c, r1          \n"
+        "BX     lr                  \n"
+    );
+}
+#else
+static __asm void sysLoadFiqRegisters(const UINT32 *pu32Regs)
+{
+    MRS     r1, CPSR
+    ORR     r2, r1, #0xC0
+    BIC     r2, r2, #0x1F
+    ORR     r2, r2, #0x11           ; FIQ mode, IRQ and FIQ masked
+    MSR     CPSR_c, r2
+    LDMIA   r0, {r8-r12}
+    MSR     CPSR_c, r1
+    BX      lr
+}
+#endif
 /// @endcond HIDDEN_SYMBOLS
 
 /*@}*/ /* end of group SYS_EXPORTED_CONSTANTS */
@@ -327,6 +507,53 @@ PVOID sysInstallFiqHandler(PVOID pvNewISR)
     return _mOldVect;
 }
 
+/**
+ *  @brief  system AIC - Bind one interrupt source to a dedicated FIQ handler
+ *
+ *  @param[in]  eIntNo        Interrupt number. \ref IRQn_Type
+ *  @param[in]  pvFiqHandler  Handler entered straight from the FIQ vector. NULL restores the
+ *                            table dispatch of \ref sysInstallISR with \ref FIQ_LEVEL_0.
+ *  @param[in]  pu32Regs      Five words loaded into the banked R8 to R12 of FIQ mode, or NULL
+ *
+ *  @return   old FIQ handler
+ *
+ *  @details  eIntNo is set to \ref FIQ_LEVEL_0 and should be the only FIQ source. The handler
+ *            does not go through the AIC handler table, it only waits for the handlers or
+ *            critical sections that mask FIQ, which neither the IRQ handlers of this driver nor
+ *            the FreeRTOS port do. It must be written in assembly, or as a naked function:
+ *            - R8 to R12 and SP are banked in FIQ mode and keep their value from one FIQ to the
+ *              next, so they can hold the peripheral addresses and state the handler needs.
+ *              Any other register must be saved on the FIQ stack before use.
+ *            - Clear the interrupt flag of the source, then write 1 to REG_AIC_EOFS.
+ *            - Return with SUBS PC, LR, #4.
+ *            The handler must not call the FreeRTOS API nor any driver function. Call this
+ *            function before the source is enabled and enable FIQ with \ref sysSetLocalInterrupt.
+ */
+PVOID sysInstallFastFiq(IRQn_Type eIntNo, PVOID pvFiqHandler, const UINT32 *pu32Regs)
+{
+    PVOID _mOldVect;
+
+    if (!_sys_bIsAICInitial)
+    {
+        sysInitializeAIC();
+        _sys_bIsAICInitial = TRUE;
+    }
+
+    if (pu32Regs != NULL)
+        sysLoadFiqRegisters(pu32Regs);
+
+    sysSetInterruptPriorityLevel(eIntNo, FIQ_LEVEL_0);
+
+#if defined (__GNUC__) && !(__CC_ARM)
+    _mOldVect = *(PVOID volatile *)0x38;
+#else
+    _mOldVect = *(PVOID volatile *)0x3C;
+#endif
+    _sys_pvFastFiq = pvFiqHandler;
+    sysInitializeAIC();
+    return _mOldVect;
+}
+
 /**
  *  @brief  system AIC - install IRQ handler
  *
@@ -432,6 +659,219 @@ INT32 sysSetInterruptPriorityLevel(IRQn_Type eIntNo, UINT32 uIntLevel)
 }
 
 
+/**
+ *  @brief  system AIC - Enable interrupt nesting
+ *
+ *  @return   None
+ *
+ *  @details  The IRQ handler enables IRQ again once it has read the interrupt number, so the
+ *            handler of an IRQ can be interrupted by any IRQ of a higher priority level, see
+ *            \ref sysSetInterruptPriorityLevel. Level 1 is the highest IRQ priority. Handlers
+ *            run in system mode on the system mode stack, which must be large enough for the
+ *            handlers of all levels in use at once.
+ *  @note     Not for use under FreeRTOS, which installs its own IRQ handler. The NUC980 port
+ *            nests interrupts when configNUC980_NESTED_IRQ is set.
+ */
+void sysEnableIrqNesting(void)
+{
+    _sys_bIsIrqNesting = TRUE;
+    sysInitializeAIC();
+    _sys_bIsAICInitial = TRUE;
+}
+
+/**
+ *  @brief  system AIC - Disable interrupt nesting
+ *
+ *  @return   None
+ *
+ *  @details  Handlers run with IRQ masked until they return, which is the default.
+ */
+void sysDisableIrqNesting(void)
+{
+    _sys_bIsIrqNesting = FALSE;
+    sysInitializeAIC();
+    _sys_bIsAICInitial = TRUE;
+}
+
+/**
+ *  @brief  system AIC - Start collecting interrupt statistics
+ *
+ *  @param[in]  pfnTimestamp  Function returning a free running count, such as an ETIMER
+ *                            counter in continuous mode. NULL stops collecting statistics.
+ *  @param[in]  u32Mask       Valid bits of the count, for example 0xFFFFFF for a 24-bit counter.
+ *
+ *  @return   None
+ *
+ *  @details  The count is read before and after each IRQ handler and the statistics are
+ *            cleared. Time spent in nested handlers is charged to them, not to the handler
+ *            they interrupted. A handler that runs longer than the counter period is not
+ *            measured correctly.
+ */
+void sysSetIrqStatTimer(sys_pfnTimestamp pfnTimestamp, UINT32 u32Mask)
+{
+    BOOL bIBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    _sys_pfnIrqTimestamp = pfnTimestamp;
+    _sys_u32IrqTimestampMask = u32Mask;
+    sysClearIrqStat();
+    if (bIBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/**
+ *  @brief  system AIC - Get the statistics of one interrupt source
+ *
+ *  @param[in]  eIntNo  Interrupt number. \ref IRQn_Type
+ *  @param[out] psStat  Statistics since the last \ref sysClearIrqStat
+ *
+ *  @return   0 on success, 1 if eIntNo is out of range
+ *
+ *  @details  The worst case latency of an IRQ is bounded by the longest handler time of the
+ *            IRQs at its own or a lower priority level, plus the longest time IRQ is masked
+ *            by the application.
+ */
+INT32 sysGetIrqStat(IRQn_Type eIntNo, SYS_IRQ_STAT_T *psStat)
+{
+    BOOL bIBit;
+
+    if ((eIntNo > SYS_MAX_INT_SOURCE) || (eIntNo < SYS_MIN_INT_SOURCE))
+        return 1;
+
+    bIBit = sysGetIBitState();
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    *psStat = _sys_asIrqStat[eIntNo];
+    if (bIBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+
+    return 0;
+}
+
+/**
+ *  @brief  system AIC - Clear the interrupt statistics of all sources
+ *
+ *  @return   None
+ */
+void sysClearIrqStat(void)
+{
+    BOOL bIBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    memset(_sys_asIrqStat, 0, sizeof(_sys_asIrqStat));
+    if (bIBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/**
+ *  @brief  system AIC - Install functions called around every IRQ handler
+ *
+ *  @param[in]  pfnEnter  Called with the interrupt number before the handler, or NULL
+ *  @param[in]  pfnExit   Called with the interrupt number after the handler, or NULL
+ *
+ *  @return   None
+ *
+ *  @details  Both are called with IRQ masked, also when handlers nest, and are meant for
+ *            trace tools. The FreeRTOS tick and the handler of \ref sysInstallFastFiq do
+ *            not go through them.
+ */
+void sysSetIrqHook(sys_pfnIrqHook pfnEnter, sys_pfnIrqHook pfnExit)
+{
+    BOOL bIBit = sysGetIBitState();
+
+    sysSetLocalInterrupt(DISABLE_IRQ);
+    _sys_pfnIrqEnter = pfnEnter;
+    _sys_pfnIrqExit = pfnExit;
+    if (bIBit)
+        sysSetLocalInterrupt(ENABLE_IRQ);
+}
+
+/// @cond HIDDEN_SYMBOLS
+/* Sizes of the mode stacks of the startup code, in SYS_STACK_xxx order */
+static const UINT32 _sys_au32StackSize[SYS_STACK_NUM] =
+{
+    0x100, 0x100, 0x4000, 0x200, 0x4000, 0xC00
+};
+
+/* Base of a mode stack. The startup code places the stacks below the end of
+   the first DRAM bank, so the second bank is not counted here. */
+static UINT32 _sysGetStackBase(UINT32 u32Stack)
+{
+    UINT32 u32Top, i;
+
+    u32Top = 1UL << ((inpw(SDIC_BA+0x10) & 0x07) + 20);
+    for (i = 0; i <= u32Stack; i++)
+        u32Top -= _sys_au32StackSize[i];
+
+    return u32Top;
+}
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+ *  @brief  system stack - Get the size and the deepest use of a mode stack
+ *
+ *  @param[in]  u32Stack  Mode stack. ( \ref SYS_STACK_UND / \ref SYS_STACK_ABT / \ref SYS_STACK_IRQ /
+ *                                      \ref SYS_STACK_FIQ / \ref SYS_STACK_SYS / \ref SYS_STACK_SVC )
+ *  @param[out] psInfo    Base, size and high-water mark of the stack
+ *
+ *  @return   0 on success, 1 if u32Stack is out of range
+ *
+ *  @details  The startup code fills the stacks with \ref SYS_STACK_FILL. The high-water mark is
+ *            found by scanning up from the base for the first word that was overwritten, so it
+ *            takes time in proportion to the free space and is meant for diagnostics.
+ */
+INT32 sysGetStackInfo(UINT32 u32Stack, SYS_STACK_INFO_T *psInfo)
+{
+    UINT32 *pu32Word, *pu32End;
+
+    if (u32Stack >= SYS_STACK_NUM)
+        return 1;
+
+    psInfo->u32Base = _sysGetStackBase(u32Stack);
+    psInfo->u32Size = _sys_au32StackSize[u32Stack];
+
+    pu32Word = (UINT32 *)psInfo->u32Base;
+    pu32End = (UINT32 *)(psInfo->u32Base + psInfo->u32Size);
+    while ((pu32Word < pu32End) && (*pu32Word == SYS_STACK_FILL))
+        pu32Word++;
+    psInfo->u32MaxUsed = (UINT32)pu32End - (UINT32)pu32Word;
+
+    return 0;
+}
+
+/**
+ *  @brief  system stack - Check the guard words at the bottom of all mode stacks
+ *
+ *  @return   Bit n is set if stack n ( \ref SYS_STACK_UND ... \ref SYS_STACK_SVC ) has grown into
+ *            its lowest \ref SYS_STACK_GUARD_WORDS words, 0 if none has
+ *
+ *  @details  There is no MPU, so an overflow is only seen after the fact. The check is short
+ *            enough to call on every task switch or from a periodic timer. An overflowed stack
+ *            has corrupted the one below it, so the application should stop rather than go on.
+ */
+UINT32 sysCheckStackGuards(void)
+{
+    UINT32 *pu32Word;
+    UINT32 u32Base, u32Failed = 0, i, j;
+
+    u32Base = 1UL << ((inpw(SDIC_BA+0x10) & 0x07) + 20);
+    for (i = 0; i < SYS_STACK_NUM; i++)
+    {
+        u32Base -= _sys_au32StackSize[i];
+        pu32Word = (UINT32 *)u32Base;
+        for (j = 0; j < SYS_STACK_GUARD_WORDS; j++)
+        {
+            if (pu32Word[j] != SYS_STACK_FILL)
+            {
+                u32Failed |= 1UL << i;
+                break;
+            }
+        }
+    }
+
+    return u32Failed;
+}
+
+
 /**
  *  @brief  system AIC - Set CP15 Interrupt Type
  *
@@ -454,11 +894,12 @@ INT32 sysSetLocalInterrupt(INT32 nIntState)
     case ENABLE_FIQ:
     case ENABLE_FIQ_IRQ:
 #if defined (__GNUC__) && !(__CC_ARM)
-    asm
+    asm volatile
         (
             "mrs    r0, CPSR  \n"
-            "bic    r0, r0, #0x80  \n"
+            "and    r0, r0, %0  \n"
             "msr    CPSR_c, r0  \n"
+            : : "r" (nIntState) : "r0"
         );
 #else
         __asm
@@ -474,11 +915,12 @@ INT32 sysSetLocalInterrupt(INT32 nIntState)
     case DISABLE_FIQ:
     case DISABLE_FIQ_IRQ:
 #if defined ( __GNUC__ ) && !(__CC_ARM)
-    asm
+    asm volatile
         (
             "MRS    r0, CPSR  \n"
-            "ORR    r0, r0, #0x80  \n"
+            "ORR    r0, r0, %0  \n"
             "MSR    CPSR_c, r0  \n"
+            : : "r" (nIntState) : "r0"
         );
 #else
         __asm
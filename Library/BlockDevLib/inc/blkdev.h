@@ -0,0 +1,158 @@
+/**************************************************************************//**
+ * @file     blkdev.h
+ * @brief    Block device layer with a shared LRU sector cache.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _BLKDEV_H_
+#define  _BLKDEV_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup BLKDEV_Library Block Device Library
+  @{
+*/
+
+/** @addtogroup BLKDEV_EXPORTED_CONSTANTS Block Device Exported Constants
+  @{
+*/
+
+#ifndef BLKDEV_MAX_DRIVES
+#define BLKDEV_MAX_DRIVES           10     /*!< Drive numbers 0 to BLKDEV_MAX_DRIVES-1, same as FatFs physical drives */
+#endif
+#ifndef BLKDEV_CACHE_SECTORS
+#define BLKDEV_CACHE_SECTORS        32     /*!< Sectors in the cache shared by all drives, 0 to disable  */
+#endif
+#ifndef BLKDEV_BOUNCE_SECTORS
+#define BLKDEV_BOUNCE_SECTORS       8      /*!< Size of the non-cacheable bounce buffer in sectors       */
+#endif
+#ifndef BLKDEV_READ_AHEAD
+#define BLKDEV_READ_AHEAD           4      /*!< Sectors prefetched when a read continues the previous one */
+#endif
+#ifndef BLKDEV_BYPASS_SECTORS
+#define BLKDEV_BYPASS_SECTORS       8      /*!< Transfers this long go to the device without caching     */
+#endif
+#define BLKDEV_SECTOR_SIZE          512    /*!< Supported sector size                                    */
+
+#define BLKDEV_FLAG_WRITE_THROUGH   0x01   /*!< Write to the device at once, for removable media         */
+#define BLKDEV_FLAG_NO_CACHE        0x02   /*!< Do not cache this drive                                  */
+
+#define BLKDEV_OK                   0      /*!< No error.                                                */
+#define BLKDEV_ERR_PARAM            -1     /*!< Invalid drive number or sector range.                    */
+#define BLKDEV_ERR_NO_MEDIA         -2     /*!< Drive not registered or no media present.                */
+#define BLKDEV_ERR_IO               -3     /*!< Device read or write failed.                             */
+#define BLKDEV_ERR_NOT_SUPPORTED    -4     /*!< Operation not implemented by the device.                 */
+
+/*@}*/ /* end of group BLKDEV_EXPORTED_CONSTANTS */
+
+/** @addtogroup BLKDEV_EXPORTED_STRUCTS Block Device Exported Structs
+  @{
+*/
+
+/**
+  * @brief  Device geometry.
+  */
+typedef struct
+{
+    uint32_t u32SectorCount;        /*!< Number of sectors                          */
+    uint32_t u32SectorSize;         /*!< Sector size in bytes                       */
+    uint32_t u32EraseBlock;         /*!< Erase block size in sectors, 1 if unknown  */
+} BLKDEV_GEOMETRY_T;
+
+/**
+  * @brief  Device operations. Functions return BLKDEV_OK or a negative BLKDEV_ERR_xxx code.
+  *         Buffers passed to read() and write() are either non-cacheable or 32-byte aligned
+  *         with the D-cache already cleaned, so they can be used for DMA directly.
+  */
+typedef struct
+{
+    int32_t (*status)(void *pvCtx);                                                     /*!< BLKDEV_OK if media is present */
+    int32_t (*geometry)(void *pvCtx, BLKDEV_GEOMETRY_T *psGeo);
+    int32_t (*read)(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, uint8_t *pu8Buf);
+    int32_t (*write)(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, const uint8_t *pu8Buf);
+    int32_t (*flush)(void *pvCtx);                                                      /*!< Optional, may be NULL */
+    int32_t (*trim)(void *pvCtx, uint32_t u32Sector, uint32_t u32Count);                /*!< Optional, may be NULL */
+} BLKDEV_OPS_T;
+
+/**
+  * @brief  Per drive statistics, counted in sectors.
+  */
+typedef struct
+{
+    uint32_t u32ReadHit;            /*!< Sectors read from the cache                */
+    uint32_t u32ReadMiss;           /*!< Sectors that had to be read from the device */
+    uint32_t u32ReadAhead;          /*!< Sectors prefetched beyond the request      */
+    uint32_t u32WriteCached;        /*!< Sectors written into the cache             */
+    uint32_t u32WriteBack;          /*!< Dirty sectors written to the device        */
+    uint32_t u32Bypass;             /*!< Sectors transferred without the cache      */
+    uint32_t u32Evict;              /*!< Cache lines taken over from this drive     */
+    uint32_t u32DevRead;            /*!< Read calls to the device                   */
+    uint32_t u32DevWrite;           /*!< Write calls to the device                  */
+} BLKDEV_STATS_T;
+
+/**
+  * @brief  Registered drive. Fields are private to the library.
+  */
+typedef struct
+{
+    const BLKDEV_OPS_T *psOps;
+    void     *pvCtx;
+    uint32_t u32Flags;
+    uint32_t u32Ready;
+    uint32_t u32NextSector;         /* sector following the last read, for read-ahead */
+    BLKDEV_GEOMETRY_T sGeo;
+    BLKDEV_STATS_T sStats;
+} BLKDEV_T;
+
+/*@}*/ /* end of group BLKDEV_EXPORTED_STRUCTS */
+
+/** @addtogroup BLKDEV_EXPORTED_FUNCTIONS Block Device Exported Functions
+  @{
+*/
+
+int32_t BLKDEV_Register(uint32_t u32Drive, BLKDEV_T *dev, const BLKDEV_OPS_T *ops, void *pvCtx, uint32_t u32Flags);
+void    BLKDEV_Unregister(uint32_t u32Drive);
+int32_t BLKDEV_Initialize(uint32_t u32Drive);
+int32_t BLKDEV_Status(uint32_t u32Drive);
+int32_t BLKDEV_Read(uint32_t u32Drive, uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count);
+int32_t BLKDEV_Write(uint32_t u32Drive, const uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count);
+int32_t BLKDEV_Sync(uint32_t u32Drive);
+int32_t BLKDEV_Trim(uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count);
+int32_t BLKDEV_GetGeometry(uint32_t u32Drive, BLKDEV_GEOMETRY_T *psGeo);
+int32_t BLKDEV_GetStats(uint32_t u32Drive, BLKDEV_STATS_T *psStats);
+void    BLKDEV_ClearStats(uint32_t u32Drive);
+
+/*@}*/ /* end of group BLKDEV_EXPORTED_FUNCTIONS */
+
+/** @addtogroup BLKDEV_BACKENDS Block Device Backends
+  Operations for the storage drivers of this BSP. The context passed to BLKDEV_Register()
+  is the SDH port (SDH0/SDH1) for SD cards and the USB host drive number for USB disks.
+  @{
+*/
+
+extern const BLKDEV_OPS_T g_sBlkDevSdOps;       /*!< SD/eMMC card on SDH0 or SDH1, see blkdev_sd.c  */
+extern const BLKDEV_OPS_T g_sBlkDevUmasOps;     /*!< USB mass storage disk, see blkdev_umas.c       */
+
+/*@}*/ /* end of group BLKDEV_BACKENDS */
+
+/*@}*/ /* end of group BLKDEV_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLKDEV_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
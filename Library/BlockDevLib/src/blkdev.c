@@ -0,0 +1,682 @@
+/**************************************************************************//**
+ * @file     blkdev.c
+ * @brief    Block device layer with a shared LRU sector cache.
+ *
+ *           Storage drivers register their operations under a drive number.
+ *           Small transfers go through a write-back sector cache shared by all
+ *           drives; dirty sectors are written back in contiguous runs on sync
+ *           or eviction. A read that continues the previous one prefetches
+ *           BLKDEV_READ_AHEAD more sectors. Long transfers bypass the cache and
+ *           use DMA on the caller buffer when it is aligned.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "blkdev.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#if (BLKDEV_CACHE_SECTORS > 0) && (BLKDEV_CACHE_SECTORS < 2 * BLKDEV_BOUNCE_SECTORS)
+#error "BLKDEV_CACHE_SECTORS must be at least twice BLKDEV_BOUNCE_SECTORS"
+#endif
+
+#define CACHE_LINES         ((BLKDEV_CACHE_SECTORS > 0) ? BLKDEV_CACHE_SECTORS : 1)
+
+#define LINE_VALID          0x01
+#define LINE_DIRTY          0x02
+
+#define NONCACHE(addr)      ((uint8_t *)((uint32_t)(addr) | 0x80000000))
+
+typedef struct
+{
+    uint32_t u32Sector;
+    uint32_t u32Stamp;              /* LRU time of the last access */
+    uint8_t  u8Drive;
+    uint8_t  u8Flags;
+} CACHE_LINE_T;
+
+static BLKDEV_T *s_apsDev[BLKDEV_MAX_DRIVES];
+static CACHE_LINE_T s_asLine[CACHE_LINES];
+static uint32_t s_u32Stamp;
+
+/* Cache lines and the bounce buffer are only accessed through the non-cacheable alias. */
+#if defined (__GNUC__) && !(__CC_ARM)
+static __attribute__((aligned(32))) uint8_t s_au8Pool[CACHE_LINES * BLKDEV_SECTOR_SIZE];
+static __attribute__((aligned(32))) uint8_t s_au8Bounce[BLKDEV_BOUNCE_SECTORS * BLKDEV_SECTOR_SIZE];
+#else
+static __align(32) uint8_t s_au8Pool[CACHE_LINES * BLKDEV_SECTOR_SIZE];
+static __align(32) uint8_t s_au8Bounce[BLKDEV_BOUNCE_SECTORS * BLKDEV_SECTOR_SIZE];
+#endif
+
+static BLKDEV_T *blk_get(uint32_t u32Drive)
+{
+    return (u32Drive < BLKDEV_MAX_DRIVES) ? s_apsDev[u32Drive] : NULL;
+}
+
+static BLKDEV_T *blk_get_ready(uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count, int32_t *pi32Ret)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    *pi32Ret = BLKDEV_OK;
+    if((dev == NULL) || !dev->u32Ready)
+    {
+        *pi32Ret = BLKDEV_ERR_NO_MEDIA;
+        return NULL;
+    }
+    if((u32Count == 0) || (u32Sector >= dev->sGeo.u32SectorCount) || (u32Count > dev->sGeo.u32SectorCount - u32Sector))
+    {
+        *pi32Ret = BLKDEV_ERR_PARAM;
+        return NULL;
+    }
+    return dev;
+}
+
+static uint8_t *blk_line_data(int32_t i32Line)
+{
+    return NONCACHE(&s_au8Pool[i32Line * BLKDEV_SECTOR_SIZE]);
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Device access                                                                                           */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* A non-cacheable word aligned buffer, or a cacheable one on whole cache lines, can be used by DMA. */
+static int32_t blk_dma_capable(const void *pvBuf)
+{
+    if((uint32_t)pvBuf & 0x80000000)
+        return ((uint32_t)pvBuf & 0x3) == 0;
+    return ((uint32_t)pvBuf & 0x1F) == 0;
+}
+
+static void blk_dma_sync(const void *pvBuf)
+{
+    if(!((uint32_t)pvBuf & 0x80000000) && sysGetCacheState())
+        sysFlushCache(D_CACHE);
+}
+
+static int32_t blk_dev_read(BLKDEV_T *dev, uint32_t u32Sector, uint32_t u32Count, uint8_t *pu8Buf)
+{
+    uint32_t u32Len;
+    int32_t i32Ret;
+
+    if(blk_dma_capable(pu8Buf))
+    {
+        blk_dma_sync(pu8Buf);
+        dev->sStats.u32DevRead++;
+        return dev->psOps->read(dev->pvCtx, u32Sector, u32Count, pu8Buf);
+    }
+
+    while(u32Count)
+    {
+        u32Len = (u32Count > BLKDEV_BOUNCE_SECTORS) ? BLKDEV_BOUNCE_SECTORS : u32Count;
+        dev->sStats.u32DevRead++;
+        if((i32Ret = dev->psOps->read(dev->pvCtx, u32Sector, u32Len, NONCACHE(s_au8Bounce))) != BLKDEV_OK)
+            return i32Ret;
+        memcpy(pu8Buf, NONCACHE(s_au8Bounce), u32Len * BLKDEV_SECTOR_SIZE);
+        pu8Buf += u32Len * BLKDEV_SECTOR_SIZE;
+        u32Sector += u32Len;
+        u32Count -= u32Len;
+    }
+    return BLKDEV_OK;
+}
+
+static int32_t blk_dev_write(BLKDEV_T *dev, uint32_t u32Sector, uint32_t u32Count, const uint8_t *pu8Buf)
+{
+    uint32_t u32Len;
+    int32_t i32Ret;
+
+    if(blk_dma_capable(pu8Buf))
+    {
+        blk_dma_sync(pu8Buf);
+        dev->sStats.u32DevWrite++;
+        return dev->psOps->write(dev->pvCtx, u32Sector, u32Count, pu8Buf);
+    }
+
+    while(u32Count)
+    {
+        u32Len = (u32Count > BLKDEV_BOUNCE_SECTORS) ? BLKDEV_BOUNCE_SECTORS : u32Count;
+        memcpy(NONCACHE(s_au8Bounce), pu8Buf, u32Len * BLKDEV_SECTOR_SIZE);
+        dev->sStats.u32DevWrite++;
+        if((i32Ret = dev->psOps->write(dev->pvCtx, u32Sector, u32Len, NONCACHE(s_au8Bounce))) != BLKDEV_OK)
+            return i32Ret;
+        pu8Buf += u32Len * BLKDEV_SECTOR_SIZE;
+        u32Sector += u32Len;
+        u32Count -= u32Len;
+    }
+    return BLKDEV_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Sector cache                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+
+static int32_t blk_find(uint32_t u32Drive, uint32_t u32Sector)
+{
+    int32_t i;
+
+    for(i = 0; i < BLKDEV_CACHE_SECTORS; i++)
+    {
+        if((s_asLine[i].u8Flags & LINE_VALID) && (s_asLine[i].u8Drive == u32Drive) && (s_asLine[i].u32Sector == u32Sector))
+            return i;
+    }
+    return -1;
+}
+
+static void blk_touch(int32_t i32Line)
+{
+    s_asLine[i32Line].u32Stamp = ++s_u32Stamp;
+}
+
+/* Write a dirty line back together with the dirty lines of the sectors following it. */
+static int32_t blk_write_back(int32_t i32Line)
+{
+    uint32_t u32Drive = s_asLine[i32Line].u8Drive;
+    uint32_t u32Sector = s_asLine[i32Line].u32Sector;
+    BLKDEV_T *dev = s_apsDev[u32Drive];
+    int32_t ai32Run[BLKDEV_BOUNCE_SECTORS];
+    uint32_t i, u32Len = 0;
+    int32_t i32Next, i32Ret;
+
+    ai32Run[u32Len++] = i32Line;
+    while(u32Len < BLKDEV_BOUNCE_SECTORS)
+    {
+        i32Next = blk_find(u32Drive, u32Sector + u32Len);
+        if((i32Next < 0) || !(s_asLine[i32Next].u8Flags & LINE_DIRTY))
+            break;
+        ai32Run[u32Len++] = i32Next;
+    }
+
+    dev->sStats.u32DevWrite++;
+    if(u32Len == 1)
+    {
+        i32Ret = dev->psOps->write(dev->pvCtx, u32Sector, 1, blk_line_data(i32Line));
+    }
+    else
+    {
+        for(i = 0; i < u32Len; i++)
+            memcpy(NONCACHE(&s_au8Bounce[i * BLKDEV_SECTOR_SIZE]), blk_line_data(ai32Run[i]), BLKDEV_SECTOR_SIZE);
+        i32Ret = dev->psOps->write(dev->pvCtx, u32Sector, u32Len, NONCACHE(s_au8Bounce));
+    }
+    if(i32Ret != BLKDEV_OK)
+        return i32Ret;
+
+    for(i = 0; i < u32Len; i++)
+        s_asLine[ai32Run[i]].u8Flags &= ~LINE_DIRTY;
+    dev->sStats.u32WriteBack += u32Len;
+
+    return BLKDEV_OK;
+}
+
+/* Write back the dirty sectors of a drive in a sector range, in ascending order. */
+static int32_t blk_sync_range(uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count)
+{
+    int32_t i, i32Best, i32Ret;
+
+    for(;;)
+    {
+        i32Best = -1;
+        for(i = 0; i < BLKDEV_CACHE_SECTORS; i++)
+        {
+            if((s_asLine[i].u8Flags & LINE_DIRTY) && (s_asLine[i].u8Drive == u32Drive) &&
+                    (s_asLine[i].u32Sector - u32Sector < u32Count) &&
+                    ((i32Best < 0) || (s_asLine[i].u32Sector < s_asLine[i32Best].u32Sector)))
+                i32Best = i;
+        }
+        if(i32Best < 0)
+            return BLKDEV_OK;
+        if((i32Ret = blk_write_back(i32Best)) != BLKDEV_OK)
+            return i32Ret;
+    }
+}
+
+/* Forget the cached sectors of a drive in a sector range, dirty or not. */
+static void blk_drop(uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count)
+{
+    int32_t i;
+
+    for(i = 0; i < BLKDEV_CACHE_SECTORS; i++)
+    {
+        if((s_asLine[i].u8Flags & LINE_VALID) && (s_asLine[i].u8Drive == u32Drive) &&
+                (s_asLine[i].u32Sector - u32Sector < u32Count))
+            s_asLine[i].u8Flags = 0;
+    }
+}
+
+/* Take the least recently used line for a sector. Returns the line or a negative error. */
+static int32_t blk_alloc(uint32_t u32Drive, uint32_t u32Sector)
+{
+    uint32_t u32Age, u32MaxAge = 0;
+    int32_t i, i32Line = 0, i32Ret;
+
+    for(i = 0; i < BLKDEV_CACHE_SECTORS; i++)
+    {
+        if(!(s_asLine[i].u8Flags & LINE_VALID))
+        {
+            i32Line = i;
+            break;
+        }
+        u32Age = s_u32Stamp - s_asLine[i].u32Stamp;
+        if(u32Age >= u32MaxAge)
+        {
+            u32MaxAge = u32Age;
+            i32Line = i;
+        }
+    }
+
+    if(s_asLine[i32Line].u8Flags & LINE_VALID)
+    {
+        s_apsDev[s_asLine[i32Line].u8Drive]->sStats.u32Evict++;
+        if(s_asLine[i32Line].u8Flags & LINE_DIRTY)
+        {
+            if((i32Ret = blk_write_back(i32Line)) != BLKDEV_OK)
+                return i32Ret;
+        }
+    }
+
+    s_asLine[i32Line].u8Drive = (uint8_t)u32Drive;
+    s_asLine[i32Line].u32Sector = u32Sector;
+    s_asLine[i32Line].u8Flags = LINE_VALID;
+    blk_touch(i32Line);
+
+    return i32Line;
+}
+
+/*
+ * Read up to u32Count sectors starting at an uncached sector into the cache, stopping at
+ * the first sector already cached. Returns the number of sectors read or a negative error.
+ */
+static int32_t blk_fill(BLKDEV_T *dev, uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count)
+{
+    int32_t ai32Line[BLKDEV_BOUNCE_SECTORS];
+    uint32_t i, u32Len = 1;
+    int32_t i32Ret;
+
+    while((u32Len < u32Count) && (u32Len < BLKDEV_BOUNCE_SECTORS) && (blk_find(u32Drive, u32Sector + u32Len) < 0))
+        u32Len++;
+
+    /* Allocate first, evictions may need the bounce buffer */
+    for(i = 0; i < u32Len; i++)
+    {
+        if((ai32Line[i] = blk_alloc(u32Drive, u32Sector + i)) < 0)
+        {
+            i32Ret = ai32Line[i];
+            while(i--)
+                s_asLine[ai32Line[i]].u8Flags = 0;
+            return i32Ret;
+        }
+    }
+
+    dev->sStats.u32DevRead++;
+    if(u32Len == 1)
+    {
+        i32Ret = dev->psOps->read(dev->pvCtx, u32Sector, 1, blk_line_data(ai32Line[0]));
+    }
+    else
+    {
+        i32Ret = dev->psOps->read(dev->pvCtx, u32Sector, u32Len, NONCACHE(s_au8Bounce));
+        if(i32Ret == BLKDEV_OK)
+        {
+            for(i = 0; i < u32Len; i++)
+                memcpy(blk_line_data(ai32Line[i]), NONCACHE(&s_au8Bounce[i * BLKDEV_SECTOR_SIZE]), BLKDEV_SECTOR_SIZE);
+        }
+    }
+
+    if(i32Ret != BLKDEV_OK)
+    {
+        for(i = 0; i < u32Len; i++)
+            s_asLine[ai32Line[i]].u8Flags = 0;
+        return i32Ret;
+    }
+    return (int32_t)u32Len;
+}
+
+static int32_t blk_cached(BLKDEV_T *dev, uint32_t u32Count)
+{
+    return (BLKDEV_CACHE_SECTORS > 0) && !(dev->u32Flags & BLKDEV_FLAG_NO_CACHE) && (u32Count < BLKDEV_BYPASS_SECTORS);
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup BLKDEV_Library Block Device Library
+  @{
+*/
+
+/** @addtogroup BLKDEV_EXPORTED_FUNCTIONS Block Device Exported Functions
+  @{
+*/
+
+/**
+  * @brief    Register a device under a drive number.
+  * @param[in]  u32Drive  Drive number, also the FatFs physical drive number.
+  * @param[in]  dev       Drive instance, must stay valid until BLKDEV_Unregister().
+  * @param[in]  ops       Device operations.
+  * @param[in]  pvCtx     Context passed to the operations.
+  * @param[in]  u32Flags  BLKDEV_FLAG_WRITE_THROUGH, BLKDEV_FLAG_NO_CACHE or 0.
+  * @return   BLKDEV_OK or BLKDEV_ERR_PARAM.
+  * @details  The media is probed by the first BLKDEV_Initialize() or BLKDEV_Status() call.
+  *           A device already registered under the drive number is unregistered first.
+  */
+int32_t BLKDEV_Register(uint32_t u32Drive, BLKDEV_T *dev, const BLKDEV_OPS_T *ops, void *pvCtx, uint32_t u32Flags)
+{
+    if((u32Drive >= BLKDEV_MAX_DRIVES) || (dev == NULL) || (ops == NULL))
+        return BLKDEV_ERR_PARAM;
+
+    BLKDEV_Unregister(u32Drive);
+
+    memset(dev, 0, sizeof(BLKDEV_T));
+    dev->psOps = ops;
+    dev->pvCtx = pvCtx;
+    dev->u32Flags = u32Flags;
+    s_apsDev[u32Drive] = dev;
+
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Write back the cached data of a drive and remove it.
+  * @param[in]  u32Drive  Drive number.
+  * @return   None
+  * @details  Nothing is written if the device already reports its media removed, so this can be
+  *           called from a card removal handler once the driver state is cleared.
+  */
+void BLKDEV_Unregister(uint32_t u32Drive)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    if(dev == NULL)
+        return;
+
+    if(dev->u32Ready && (dev->psOps->status(dev->pvCtx) == BLKDEV_OK))
+        blk_sync_range(u32Drive, 0, 0xFFFFFFFF);
+    blk_drop(u32Drive, 0, 0xFFFFFFFF);
+    s_apsDev[u32Drive] = NULL;
+}
+
+/**
+  * @brief    (Re)initialize a drive after media insertion or before mounting.
+  * @param[in]  u32Drive  Drive number.
+  * @return   BLKDEV_OK if media is present, otherwise a negative BLKDEV_ERR_xxx code.
+  * @details  Pending writes are flushed if the previous media is still there, then the cached
+  *           sectors of the drive are dropped and the geometry is read again.
+  */
+int32_t BLKDEV_Initialize(uint32_t u32Drive)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    if(dev == NULL)
+        return BLKDEV_ERR_NO_MEDIA;
+
+    if(dev->u32Ready && (dev->psOps->status(dev->pvCtx) == BLKDEV_OK))
+        blk_sync_range(u32Drive, 0, 0xFFFFFFFF);
+    blk_drop(u32Drive, 0, 0xFFFFFFFF);
+    dev->u32Ready = 0;
+
+    return BLKDEV_Status(u32Drive);
+}
+
+/**
+  * @brief    Check for media presence.
+  * @param[in]  u32Drive  Drive number.
+  * @return   BLKDEV_OK if media is present, otherwise a negative BLKDEV_ERR_xxx code.
+  * @details  When the media is found removed its cached sectors are dropped, including unwritten ones.
+  */
+int32_t BLKDEV_Status(uint32_t u32Drive)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+    int32_t i32Ret;
+
+    if(dev == NULL)
+        return BLKDEV_ERR_NO_MEDIA;
+
+    if((i32Ret = dev->psOps->status(dev->pvCtx)) != BLKDEV_OK)
+    {
+        if(dev->u32Ready)
+            blk_drop(u32Drive, 0, 0xFFFFFFFF);
+        dev->u32Ready = 0;
+        return i32Ret;
+    }
+
+    if(!dev->u32Ready)
+    {
+        if((i32Ret = dev->psOps->geometry(dev->pvCtx, &dev->sGeo)) != BLKDEV_OK)
+            return i32Ret;
+        if(dev->sGeo.u32SectorSize != BLKDEV_SECTOR_SIZE)
+            return BLKDEV_ERR_NOT_SUPPORTED;
+        if(dev->sGeo.u32EraseBlock == 0)
+            dev->sGeo.u32EraseBlock = 1;
+        dev->u32NextSector = 0xFFFFFFFF;
+        dev->u32Ready = 1;
+    }
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Read sectors.
+  * @param[in]  u32Drive   Drive number.
+  * @param[out] pu8Buf     Destination buffer, any alignment.
+  * @param[in]  u32Sector  First sector.
+  * @param[in]  u32Count   Number of sectors.
+  * @return   BLKDEV_OK or a negative BLKDEV_ERR_xxx code.
+  */
+int32_t BLKDEV_Read(uint32_t u32Drive, uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count)
+{
+    uint32_t i, u32Want, u32Pending = 0;
+    int32_t i32Line, i32Ret;
+    BLKDEV_T *dev;
+
+    if((dev = blk_get_ready(u32Drive, u32Sector, u32Count, &i32Ret)) == NULL)
+        return i32Ret;
+
+    if(!blk_cached(dev, u32Count))
+    {
+        dev->sStats.u32Bypass += u32Count;
+        dev->u32NextSector = u32Sector + u32Count;
+        if((i32Ret = blk_dev_read(dev, u32Sector, u32Count, pu8Buf)) != BLKDEV_OK)
+            return i32Ret;
+
+        /* Sectors not written back yet are newer than the device content */
+        for(i = 0; i < BLKDEV_CACHE_SECTORS; i++)
+        {
+            if((s_asLine[i].u8Flags & LINE_DIRTY) && (s_asLine[i].u8Drive == u32Drive) && (s_asLine[i].u32Sector - u32Sector < u32Count))
+                memcpy(&pu8Buf[(s_asLine[i].u32Sector - u32Sector) * BLKDEV_SECTOR_SIZE], blk_line_data(i), BLKDEV_SECTOR_SIZE);
+        }
+        return BLKDEV_OK;
+    }
+
+    for(i = 0; i < u32Count; i++)
+    {
+        i32Line = blk_find(u32Drive, u32Sector + i);
+        if(i32Line < 0)
+        {
+            u32Want = u32Count - i;
+            if(u32Sector == dev->u32NextSector)
+                u32Want += BLKDEV_READ_AHEAD;
+            if(u32Want > dev->sGeo.u32SectorCount - (u32Sector + i))
+                u32Want = dev->sGeo.u32SectorCount - (u32Sector + i);
+
+            if((i32Ret = blk_fill(dev, u32Drive, u32Sector + i, u32Want)) < 0)
+                return i32Ret;
+            if((uint32_t)i32Ret > u32Count - i)
+                dev->sStats.u32ReadAhead += i32Ret - (u32Count - i);
+            u32Pending = i32Ret;
+            i32Line = blk_find(u32Drive, u32Sector + i);
+        }
+
+        if(u32Pending)
+        {
+            u32Pending--;
+            dev->sStats.u32ReadMiss++;
+        }
+        else
+        {
+            dev->sStats.u32ReadHit++;
+        }
+        memcpy(&pu8Buf[i * BLKDEV_SECTOR_SIZE], blk_line_data(i32Line), BLKDEV_SECTOR_SIZE);
+        blk_touch(i32Line);
+    }
+
+    dev->u32NextSector = u32Sector + u32Count;
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Write sectors.
+  * @param[in]  u32Drive   Drive number.
+  * @param[in]  pu8Buf     Source buffer, any alignment.
+  * @param[in]  u32Sector  First sector.
+  * @param[in]  u32Count   Number of sectors.
+  * @return   BLKDEV_OK or a negative BLKDEV_ERR_xxx code.
+  * @details  Short writes stay in the cache until BLKDEV_Sync() or eviction unless the drive was
+  *           registered with BLKDEV_FLAG_WRITE_THROUGH.
+  */
+int32_t BLKDEV_Write(uint32_t u32Drive, const uint8_t *pu8Buf, uint32_t u32Sector, uint32_t u32Count)
+{
+    int32_t i32Line, i32Ret;
+    BLKDEV_T *dev;
+    uint32_t i;
+
+    if((dev = blk_get_ready(u32Drive, u32Sector, u32Count, &i32Ret)) == NULL)
+        return i32Ret;
+
+    if(!blk_cached(dev, u32Count))
+    {
+        /* The written data supersedes whatever is cached */
+        blk_drop(u32Drive, u32Sector, u32Count);
+        dev->sStats.u32Bypass += u32Count;
+        return blk_dev_write(dev, u32Sector, u32Count, pu8Buf);
+    }
+
+    if(dev->u32Flags & BLKDEV_FLAG_WRITE_THROUGH)
+    {
+        if((i32Ret = blk_dev_write(dev, u32Sector, u32Count, pu8Buf)) != BLKDEV_OK)
+        {
+            blk_drop(u32Drive, u32Sector, u32Count);
+            return i32Ret;
+        }
+        for(i = 0; i < u32Count; i++)
+        {
+            if((i32Line = blk_find(u32Drive, u32Sector + i)) >= 0)
+                memcpy(blk_line_data(i32Line), &pu8Buf[i * BLKDEV_SECTOR_SIZE], BLKDEV_SECTOR_SIZE);
+        }
+        return BLKDEV_OK;
+    }
+
+    for(i = 0; i < u32Count; i++)
+    {
+        if((i32Line = blk_find(u32Drive, u32Sector + i)) < 0)
+        {
+            if((i32Line = blk_alloc(u32Drive, u32Sector + i)) < 0)
+                return i32Line;
+        }
+        memcpy(blk_line_data(i32Line), &pu8Buf[i * BLKDEV_SECTOR_SIZE], BLKDEV_SECTOR_SIZE);
+        s_asLine[i32Line].u8Flags |= LINE_DIRTY;
+        blk_touch(i32Line);
+        dev->sStats.u32WriteCached++;
+    }
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Write back all cached sectors of a drive and flush the device.
+  * @param[in]  u32Drive  Drive number.
+  * @return   BLKDEV_OK or a negative BLKDEV_ERR_xxx code.
+  */
+int32_t BLKDEV_Sync(uint32_t u32Drive)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+    int32_t i32Ret;
+
+    if((dev == NULL) || !dev->u32Ready)
+        return BLKDEV_ERR_NO_MEDIA;
+
+    if((i32Ret = blk_sync_range(u32Drive, 0, 0xFFFFFFFF)) != BLKDEV_OK)
+        return i32Ret;
+    if(dev->psOps->flush)
+        return dev->psOps->flush(dev->pvCtx);
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Tell the device a sector range no longer holds data.
+  * @param[in]  u32Drive   Drive number.
+  * @param[in]  u32Sector  First sector.
+  * @param[in]  u32Count   Number of sectors.
+  * @return   BLKDEV_OK, BLKDEV_ERR_NOT_SUPPORTED if the device has no trim operation,
+  *           or another BLKDEV_ERR_xxx code.
+  * @details  Cached sectors in the range are dropped without being written back.
+  */
+int32_t BLKDEV_Trim(uint32_t u32Drive, uint32_t u32Sector, uint32_t u32Count)
+{
+    BLKDEV_T *dev;
+    int32_t i32Ret;
+
+    if((dev = blk_get_ready(u32Drive, u32Sector, u32Count, &i32Ret)) == NULL)
+        return i32Ret;
+
+    blk_drop(u32Drive, u32Sector, u32Count);
+    if(dev->psOps->trim == NULL)
+        return BLKDEV_ERR_NOT_SUPPORTED;
+    return dev->psOps->trim(dev->pvCtx, u32Sector, u32Count);
+}
+
+/**
+  * @brief    Get the geometry of a ready drive.
+  * @param[in]  u32Drive  Drive number.
+  * @param[out] psGeo     Geometry.
+  * @return   BLKDEV_OK or BLKDEV_ERR_NO_MEDIA.
+  */
+int32_t BLKDEV_GetGeometry(uint32_t u32Drive, BLKDEV_GEOMETRY_T *psGeo)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    if((dev == NULL) || !dev->u32Ready)
+        return BLKDEV_ERR_NO_MEDIA;
+
+    memcpy(psGeo, &dev->sGeo, sizeof(BLKDEV_GEOMETRY_T));
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Get the cache and transfer statistics of a drive.
+  * @param[in]  u32Drive  Drive number.
+  * @param[out] psStats   Statistics.
+  * @return   BLKDEV_OK or BLKDEV_ERR_NO_MEDIA if the drive is not registered.
+  */
+int32_t BLKDEV_GetStats(uint32_t u32Drive, BLKDEV_STATS_T *psStats)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    if(dev == NULL)
+        return BLKDEV_ERR_NO_MEDIA;
+
+    memcpy(psStats, &dev->sStats, sizeof(BLKDEV_STATS_T));
+    return BLKDEV_OK;
+}
+
+/**
+  * @brief    Clear the statistics of a drive.
+  * @param[in]  u32Drive  Drive number.
+  * @return   None
+  */
+void BLKDEV_ClearStats(uint32_t u32Drive)
+{
+    BLKDEV_T *dev = blk_get(u32Drive);
+
+    if(dev != NULL)
+        memset(&dev->sStats, 0, sizeof(BLKDEV_STATS_T));
+}
+
+/*@}*/ /* end of group BLKDEV_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group BLKDEV_Library */
+
+/*@}*/ /* end of group Library */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,135 @@
+/**************************************************************************//**
+ * @file     blkdev_diskio.c
+ * @brief    FatFs disk I/O glue on top of the block device layer.
+ *
+ *           The FatFs physical drive number is the block device drive number,
+ *           so any storage registered with BLKDEV_Register() can be mounted.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include "ff.h"
+#include "diskio.h"
+#include "blkdev.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+static DSTATUS blk_to_status(int32_t i32Ret)
+{
+    if(i32Ret == BLKDEV_OK)
+        return 0;
+    if(i32Ret == BLKDEV_ERR_NO_MEDIA)
+        return STA_NOINIT | STA_NODISK;
+    return STA_NOINIT;
+}
+
+static DRESULT blk_to_result(int32_t i32Ret)
+{
+    switch(i32Ret)
+    {
+    case BLKDEV_OK:
+        return RES_OK;
+    case BLKDEV_ERR_NO_MEDIA:
+        return RES_NOTRDY;
+    case BLKDEV_ERR_PARAM:
+        return RES_PARERR;
+    default:
+        return RES_ERROR;
+    }
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/*-----------------------------------------------------------------------*/
+/* Initialize a Drive                                                    */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    return blk_to_status(BLKDEV_Initialize(pdrv));
+}
+
+/*-----------------------------------------------------------------------*/
+/* Get Disk Status                                                       */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_status (BYTE pdrv)       /* Physical drive number (0..) */
+{
+    return blk_to_status(BLKDEV_Status(pdrv));
+}
+
+/*-----------------------------------------------------------------------*/
+/* Read Sector(s)                                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_read (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE *buff,     /* Data buffer to store read data */
+    DWORD sector,   /* Sector address (LBA) */
+    UINT count      /* Number of sectors to read (1..128) */
+)
+{
+    return blk_to_result(BLKDEV_Read(pdrv, buff, sector, count));
+}
+
+/*-----------------------------------------------------------------------*/
+/* Write Sector(s)                                                       */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_write (
+    BYTE pdrv,          /* Physical drive number (0..) */
+    const BYTE *buff,   /* Data to be written */
+    DWORD sector,       /* Sector address (LBA) */
+    UINT count          /* Number of sectors to write (1..128) */
+)
+{
+    return blk_to_result(BLKDEV_Write(pdrv, buff, sector, count));
+}
+
+/*-----------------------------------------------------------------------*/
+/* Miscellaneous Functions                                               */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_ioctl (
+    BYTE pdrv,      /* Physical drive number (0..) */
+    BYTE cmd,       /* Control code */
+    void *buff      /* Buffer to send/receive control data */
+)
+{
+    BLKDEV_GEOMETRY_T sGeo;
+    DWORD *pdwRange;
+    int32_t i32Ret;
+
+    if(cmd == CTRL_SYNC)
+        return blk_to_result(BLKDEV_Sync(pdrv));
+
+    if(cmd == CTRL_TRIM)
+    {
+        /* buff holds the first and the last sector of the freed range */
+        pdwRange = (DWORD *)buff;
+        if(pdwRange[1] < pdwRange[0])
+            return RES_PARERR;
+        return blk_to_result(BLKDEV_Trim(pdrv, pdwRange[0], pdwRange[1] - pdwRange[0] + 1));
+    }
+
+    if((i32Ret = BLKDEV_GetGeometry(pdrv, &sGeo)) != BLKDEV_OK)
+        return blk_to_result(i32Ret);
+
+    switch(cmd)
+    {
+    case GET_SECTOR_COUNT:
+        *(DWORD *)buff = sGeo.u32SectorCount;
+        break;
+    case GET_SECTOR_SIZE:
+        *(WORD *)buff = (WORD)sGeo.u32SectorSize;
+        break;
+    case GET_BLOCK_SIZE:
+        *(DWORD *)buff = sGeo.u32EraseBlock;
+        break;
+    default:
+        return RES_PARERR;
+    }
+    return RES_OK;
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,88 @@
+/**************************************************************************//**
+ * @file     blkdev_sd.c
+ * @brief    Block device operations for SD/eMMC cards on SDH0 and SDH1.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include "nuc980.h"
+#include "sys.h"
+#include "sdh.h"
+#include "blkdev.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+static SDH_INFO_T *sd_info(SDH_T *sdh)
+{
+    return (sdh == SDH0) ? &SD0 : &SD1;
+}
+
+static int32_t sd_status(void *pvCtx)
+{
+    SDH_T *sdh = (SDH_T *)pvCtx;
+
+    if(SDH_GET_CARD_CAPACITY(sdh) == 0)
+        return BLKDEV_ERR_NO_MEDIA;
+    return BLKDEV_OK;
+}
+
+static int32_t sd_geometry(void *pvCtx, BLKDEV_GEOMETRY_T *psGeo)
+{
+    SDH_INFO_T *pSD = sd_info((SDH_T *)pvCtx);
+
+    psGeo->u32SectorCount = pSD->totalSectorN;
+    psGeo->u32SectorSize = pSD->sectorSize;
+    psGeo->u32EraseBlock = (pSD->eraseGroup != 0) ? pSD->eraseGroup : 1;
+    return BLKDEV_OK;
+}
+
+static int32_t sd_error(SDH_T *sdh, uint32_t u32Ret)
+{
+    if(u32Ret == Successful)
+        return BLKDEV_OK;
+    if((u32Ret == SDH_NO_SD_CARD) || !SDH_IS_CARD_PRESENT(sdh))
+        return BLKDEV_ERR_NO_MEDIA;
+    return BLKDEV_ERR_IO;
+}
+
+static int32_t sd_read(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, uint8_t *pu8Buf)
+{
+    SDH_T *sdh = (SDH_T *)pvCtx;
+
+    /* SDH0 shares the FMI with the NAND controller */
+    sdh->GCTL = SDH_GCTL_SDEN_Msk;
+    return sd_error(sdh, SDH_Read(sdh, pu8Buf, u32Sector, u32Count));
+}
+
+static int32_t sd_write(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, const uint8_t *pu8Buf)
+{
+    SDH_T *sdh = (SDH_T *)pvCtx;
+
+    sdh->GCTL = SDH_GCTL_SDEN_Msk;
+    return sd_error(sdh, SDH_Write(sdh, (uint8_t *)pu8Buf, u32Sector, u32Count));
+}
+
+static int32_t sd_trim(void *pvCtx, uint32_t u32Sector, uint32_t u32Count)
+{
+    SDH_T *sdh = (SDH_T *)pvCtx;
+
+    sdh->GCTL = SDH_GCTL_SDEN_Msk;
+    return sd_error(sdh, SDH_Erase(sdh, u32Sector, u32Count));
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief  SD card operations, register with SDH0 or SDH1 as context after SDH_Probe().
+  */
+const BLKDEV_OPS_T g_sBlkDevSdOps =
+{
+    sd_status,
+    sd_geometry,
+    sd_read,
+    sd_write,
+    NULL,
+    sd_trim
+};
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
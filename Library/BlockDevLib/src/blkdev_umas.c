@@ -0,0 +1,85 @@
+/**************************************************************************//**
+ * @file     blkdev_umas.c
+ * @brief    Block device operations for USB mass storage disks.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include "nuc980.h"
+#include "sys.h"
+#include "usbh_lib.h"
+#include "ff.h"
+#include "diskio.h"
+#include "blkdev.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+static int32_t umas_error(int ret)
+{
+    if(ret == UMAS_OK)
+        return BLKDEV_OK;
+    if((ret == UMAS_ERR_NO_DEVICE) || (ret == UMAS_ERR_DRIVE_NOT_FOUND))
+        return BLKDEV_ERR_NO_MEDIA;
+    if(ret == UMAS_ERR_IVALID_PARM)
+        return BLKDEV_ERR_PARAM;
+    if(ret == UMAS_ERR_NOT_SUPPORTED)
+        return BLKDEV_ERR_NOT_SUPPORTED;
+    return BLKDEV_ERR_IO;
+}
+
+static int32_t umas_status(void *pvCtx)
+{
+    usbh_pooling_hubs();
+    if(usbh_umas_disk_status((int)pvCtx) != 0)
+        return BLKDEV_ERR_NO_MEDIA;
+    return BLKDEV_OK;
+}
+
+static int32_t umas_geometry(void *pvCtx, BLKDEV_GEOMETRY_T *psGeo)
+{
+    int ret;
+
+    if((ret = usbh_umas_ioctl((int)pvCtx, GET_SECTOR_COUNT, &psGeo->u32SectorCount)) != UMAS_OK)
+        return umas_error(ret);
+    if((ret = usbh_umas_ioctl((int)pvCtx, GET_SECTOR_SIZE, &psGeo->u32SectorSize)) != UMAS_OK)
+        return umas_error(ret);
+    psGeo->u32EraseBlock = 1;
+    return BLKDEV_OK;
+}
+
+static int32_t umas_read(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, uint8_t *pu8Buf)
+{
+    return umas_error(usbh_umas_read((int)pvCtx, u32Sector, u32Count, pu8Buf));
+}
+
+static int32_t umas_write(void *pvCtx, uint32_t u32Sector, uint32_t u32Count, const uint8_t *pu8Buf)
+{
+    return umas_error(usbh_umas_write((int)pvCtx, u32Sector, u32Count, (uint8_t *)pu8Buf));
+}
+
+static int32_t umas_trim(void *pvCtx, uint32_t u32Sector, uint32_t u32Count)
+{
+    DWORD rt[2];
+
+    rt[0] = u32Sector;
+    rt[1] = u32Sector + u32Count - 1;
+    return umas_error(usbh_umas_ioctl((int)pvCtx, CTRL_TRIM, rt));
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief  USB disk operations, register with the USB host drive number (USBDRV_0 and up) as context.
+  *         Sticks can be pulled at any time, so register them with BLKDEV_FLAG_WRITE_THROUGH.
+  */
+const BLKDEV_OPS_T g_sBlkDevUmasOps =
+{
+    umas_status,
+    umas_geometry,
+    umas_read,
+    umas_write,
+    NULL,
+    umas_trim
+};
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
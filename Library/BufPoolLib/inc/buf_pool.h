@@ -0,0 +1,122 @@
+/**************************************************************************//**
+ * @file     buf_pool.h
+ * @brief    Fixed-block buffer pools and buffer pointer queues under FreeRTOS.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _BUF_POOL_H_
+#define  _BUF_POOL_H_
+
+#include <stdint.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup BUFPOOL_Library Buffer Pool Library
+  @{
+*/
+
+/** @addtogroup BUFPOOL_EXPORTED_CONSTANTS Buffer Pool Exported Constants
+  @{
+*/
+
+#define BUFPOOL_FLAG_NONCACHED      0x1    /*!< Blocks are used through the non-cacheable alias      */
+
+#define BUFPOOL_OK                  0      /*!< Success.                                             */
+#define BUFPOOL_ERR_PARAM           -1     /*!< Invalid pool or parameters.                          */
+#define BUFPOOL_ERR_NO_MEM          -2     /*!< Out of FreeRTOS heap.                                */
+#define BUFPOOL_ERR_BUSY            -3     /*!< Buffers of the pool are still in use.                */
+
+/*@}*/ /* end of group BUFPOOL_EXPORTED_CONSTANTS */
+
+/** @addtogroup BUFPOOL_EXPORTED_STRUCTS Buffer Pool Exported Structs
+  @{
+*/
+
+struct BUFPOOL;
+
+/**
+  * @brief  Buffer descriptor. The data block is CACHE_LINE_SIZE aligned and its size is a
+  *         multiple of CACHE_LINE_SIZE, so a block never shares a cache line with other data
+  *         and can be given to a DMA engine. The descriptor itself lives outside the block.
+  */
+typedef struct BUFPOOL_BUF
+{
+    uint8_t  *pu8Data;              /*!< Data block, read only                      */
+    uint32_t  u32Size;              /*!< Block size in bytes, read only             */
+    uint32_t  u32Length;            /*!< Valid bytes, set by the producer           */
+    uint32_t  u32User;              /*!< Free for the owner, e.g. a channel or time */
+
+    /* private to the library */
+    struct BUFPOOL *psPool;
+    struct BUFPOOL_BUF *psNext;
+    volatile uint32_t u32RefCount;
+} BUFPOOL_BUF_T;
+
+/**
+  * @brief  Buffer pool. The caller owns the structure, the blocks and descriptors are taken
+  *         from the FreeRTOS heap by BUFPOOL_Create().
+  */
+typedef struct BUFPOOL
+{
+    /* private to the library */
+    BUFPOOL_BUF_T *psFree;
+    BUFPOOL_BUF_T *psBufs;
+    void     *pvMem;
+    uint32_t  u32Count;
+    uint32_t  u32BlockSize;
+    uint32_t  u32Flags;
+    volatile uint32_t u32Free;
+    uint32_t  u32MinFree;
+    SemaphoreHandle_t xFreeCount;
+} BUFPOOL_T;
+
+/*@}*/ /* end of group BUFPOOL_EXPORTED_STRUCTS */
+
+/** @addtogroup BUFPOOL_EXPORTED_FUNCTIONS Buffer Pool Exported Functions
+  @{
+*/
+
+int32_t BUFPOOL_Create(BUFPOOL_T *psPool, uint32_t u32BlockSize, uint32_t u32Count, uint32_t u32Flags);
+int32_t BUFPOOL_Delete(BUFPOOL_T *psPool);
+BUFPOOL_BUF_T *BUFPOOL_Alloc(BUFPOOL_T *psPool, TickType_t xTicksToWait);
+BUFPOOL_BUF_T *BUFPOOL_AllocFromISR(BUFPOOL_T *psPool, BaseType_t *pxHigherPriorityTaskWoken);
+void    BUFPOOL_Ref(BUFPOOL_BUF_T *psBuf);
+void    BUFPOOL_Release(BUFPOOL_BUF_T *psBuf);
+void    BUFPOOL_ReleaseFromISR(BUFPOOL_BUF_T *psBuf, BaseType_t *pxHigherPriorityTaskWoken);
+void    BUFPOOL_DmaToDevice(BUFPOOL_BUF_T *psBuf);
+void    BUFPOOL_DmaFromDevice(BUFPOOL_BUF_T *psBuf);
+uint32_t BUFPOOL_GetFree(BUFPOOL_T *psPool);
+uint32_t BUFPOOL_GetMinFree(BUFPOOL_T *psPool);
+
+QueueHandle_t BUFQ_Create(UBaseType_t uxLength);
+BaseType_t BUFQ_Send(QueueHandle_t xQueue, BUFPOOL_BUF_T *psBuf, TickType_t xTicksToWait);
+BaseType_t BUFQ_SendFromISR(QueueHandle_t xQueue, BUFPOOL_BUF_T *psBuf, BaseType_t *pxHigherPriorityTaskWoken);
+BUFPOOL_BUF_T *BUFQ_Receive(QueueHandle_t xQueue, TickType_t xTicksToWait);
+BUFPOOL_BUF_T *BUFQ_ReceiveFromISR(QueueHandle_t xQueue, BaseType_t *pxHigherPriorityTaskWoken);
+
+/*@}*/ /* end of group BUFPOOL_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group BUFPOOL_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BUF_POOL_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
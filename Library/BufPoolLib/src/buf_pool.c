@@ -0,0 +1,349 @@
+/**************************************************************************//**
+ * @file     buf_pool.c
+ * @brief    Fixed-block buffer pools and buffer pointer queues under FreeRTOS.
+ *
+ *           A pool hands out blocks of one size with a reference count. Data
+ *           moves between an ISR, a driver and the application tasks by
+ *           sending the descriptor pointer through a BUFQ queue, so a message
+ *           of any size costs a 4-byte queue copy instead of a copy of the
+ *           data. Whoever holds the last reference releases the buffer, which
+ *           lets one producer hand the same block to several consumers with
+ *           BUFPOOL_Ref().
+ *
+ *           The free list is kept under the interrupt mask for a few
+ *           instructions, the ARM926EJ-S has no exclusive load and store, and
+ *           a counting semaphore holds the number of free blocks so that tasks
+ *           can wait for one.
+ *
+ *           Blocks are cache line aligned and padded to whole lines. A pool
+ *           created with BUFPOOL_FLAG_NONCACHED returns them through the
+ *           non-cacheable alias and needs no cache maintenance. Otherwise the
+ *           owner calls BUFPOOL_DmaToDevice() or BUFPOOL_DmaFromDevice()
+ *           before starting a transfer, which only touch the lines of the
+ *           block.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "buf_pool.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#if configUSE_COUNTING_SEMAPHORES != 1
+#error buf_pool.c needs configUSE_COUNTING_SEMAPHORES
+#endif
+
+#define BUFPOOL_NONCACHE_BIT    0x80000000
+
+static BUFPOOL_BUF_T *bp_pop(BUFPOOL_T *psPool)
+{
+    BUFPOOL_BUF_T *psBuf;
+    UBaseType_t uxSaved;
+
+    uxSaved = uxPortSetInterruptMask();
+    psBuf = psPool->psFree;
+    psPool->psFree = psBuf->psNext;
+    psPool->u32Free--;
+    if (psPool->u32Free < psPool->u32MinFree)
+        psPool->u32MinFree = psPool->u32Free;
+    vPortClearInterruptMask(uxSaved);
+
+    psBuf->psNext = NULL;
+    psBuf->u32RefCount = 1;
+    psBuf->u32Length = 0;
+    return psBuf;
+}
+
+/*
+ *  Drop one reference, and put the buffer back on the free list with the last one.
+ *  Returns TRUE if the buffer was freed and the semaphore must be given.
+ */
+static BOOL bp_put(BUFPOOL_BUF_T *psBuf)
+{
+    BUFPOOL_T *psPool = psBuf->psPool;
+    UBaseType_t uxSaved;
+    BOOL bFreed = FALSE;
+
+    uxSaved = uxPortSetInterruptMask();
+    configASSERT(psBuf->u32RefCount != 0);
+    if (--psBuf->u32RefCount == 0)
+    {
+        psBuf->psNext = psPool->psFree;
+        psPool->psFree = psBuf;
+        psPool->u32Free++;
+        bFreed = TRUE;
+    }
+    vPortClearInterruptMask(uxSaved);
+
+    return bFreed;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief  Create a pool of fixed-size blocks from the FreeRTOS heap.
+  * @param[in]  psPool        Pool structure, owned by the caller.
+  * @param[in]  u32BlockSize  Block size in bytes. It is rounded up to a multiple of CACHE_LINE_SIZE.
+  * @param[in]  u32Count      Number of blocks.
+  * @param[in]  u32Flags      0, or BUFPOOL_FLAG_NONCACHED to use the blocks through the
+  *                           non-cacheable alias, for buffers mostly touched by DMA.
+  * @return BUFPOOL_OK, BUFPOOL_ERR_PARAM or BUFPOOL_ERR_NO_MEM.
+  */
+int32_t BUFPOOL_Create(BUFPOOL_T *psPool, uint32_t u32BlockSize, uint32_t u32Count, uint32_t u32Flags)
+{
+    uint32_t u32Blocks, i;
+
+    if ((psPool == NULL) || (u32BlockSize == 0) || (u32Count == 0))
+        return BUFPOOL_ERR_PARAM;
+
+    memset(psPool, 0, sizeof(BUFPOOL_T));
+    u32BlockSize = (u32BlockSize + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+
+    psPool->pvMem = pvPortMalloc(u32BlockSize * u32Count + CACHE_LINE_SIZE - 1);
+    psPool->psBufs = pvPortMalloc(sizeof(BUFPOOL_BUF_T) * u32Count);
+    psPool->xFreeCount = xSemaphoreCreateCounting(u32Count, u32Count);
+    if ((psPool->pvMem == NULL) || (psPool->psBufs == NULL) || (psPool->xFreeCount == NULL))
+    {
+        if (psPool->xFreeCount != NULL)
+            vSemaphoreDelete(psPool->xFreeCount);
+        vPortFree(psPool->psBufs);
+        vPortFree(psPool->pvMem);
+        memset(psPool, 0, sizeof(BUFPOOL_T));
+        return BUFPOOL_ERR_NO_MEM;
+    }
+
+    u32Blocks = ((uint32_t)psPool->pvMem + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    if (u32Flags & BUFPOOL_FLAG_NONCACHED)
+    {
+        /* no dirty line of the heap may be written back over the blocks later */
+        sysInvalidDCacheRange(u32Blocks, u32BlockSize * u32Count);
+        u32Blocks |= BUFPOOL_NONCACHE_BIT;
+    }
+
+    psPool->u32Count = u32Count;
+    psPool->u32BlockSize = u32BlockSize;
+    psPool->u32Flags = u32Flags;
+    psPool->u32Free = u32Count;
+    psPool->u32MinFree = u32Count;
+
+    for (i = 0; i < u32Count; i++)
+    {
+        BUFPOOL_BUF_T *psBuf = &psPool->psBufs[i];
+
+        psBuf->pu8Data = (uint8_t *)(u32Blocks + i * u32BlockSize);
+        psBuf->u32Size = u32BlockSize;
+        psBuf->u32Length = 0;
+        psBuf->u32User = 0;
+        psBuf->psPool = psPool;
+        psBuf->u32RefCount = 0;
+        psBuf->psNext = (i + 1 < u32Count) ? &psPool->psBufs[i + 1] : NULL;
+    }
+    psPool->psFree = &psPool->psBufs[0];
+
+    return BUFPOOL_OK;
+}
+
+/**
+  * @brief  Delete a pool and give its memory back to the FreeRTOS heap.
+  * @param[in]  psPool  The pool. Every buffer must have been released.
+  * @return BUFPOOL_OK, BUFPOOL_ERR_PARAM or BUFPOOL_ERR_BUSY.
+  */
+int32_t BUFPOOL_Delete(BUFPOOL_T *psPool)
+{
+    if ((psPool == NULL) || (psPool->xFreeCount == NULL))
+        return BUFPOOL_ERR_PARAM;
+    if (psPool->u32Free != psPool->u32Count)
+        return BUFPOOL_ERR_BUSY;
+
+    vSemaphoreDelete(psPool->xFreeCount);
+    vPortFree(psPool->psBufs);
+    vPortFree(psPool->pvMem);
+    memset(psPool, 0, sizeof(BUFPOOL_T));
+    return BUFPOOL_OK;
+}
+
+/**
+  * @brief  Take a buffer from the pool, with a reference count of 1 and u32Length 0.
+  * @param[in]  psPool        The pool.
+  * @param[in]  xTicksToWait  Time to wait for a buffer to be released when none is free.
+  * @return The buffer, or NULL if none became free in time.
+  */
+BUFPOOL_BUF_T *BUFPOOL_Alloc(BUFPOOL_T *psPool, TickType_t xTicksToWait)
+{
+    if (xSemaphoreTake(psPool->xFreeCount, xTicksToWait) != pdTRUE)
+        return NULL;
+    return bp_pop(psPool);
+}
+
+/**
+  * @brief  Take a buffer from the pool in an interrupt handler. See \ref BUFPOOL_Alloc.
+  * @param[in]  psPool                     The pool.
+  * @param[out] pxHigherPriorityTaskWoken  Set to pdTRUE if a context switch is needed, may be NULL.
+  * @return The buffer, or NULL if none is free.
+  */
+BUFPOOL_BUF_T *BUFPOOL_AllocFromISR(BUFPOOL_T *psPool, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (xSemaphoreTakeFromISR(psPool->xFreeCount, pxHigherPriorityTaskWoken) != pdTRUE)
+        return NULL;
+    return bp_pop(psPool);
+}
+
+/**
+  * @brief  Add a reference to a buffer, before handing it to one more owner. Each owner
+  *         releases it once. May be called from an interrupt handler.
+  * @param[in]  psBuf  A buffer taken from a pool.
+  * @return None
+  */
+void BUFPOOL_Ref(BUFPOOL_BUF_T *psBuf)
+{
+    UBaseType_t uxSaved;
+
+    uxSaved = uxPortSetInterruptMask();
+    configASSERT(psBuf->u32RefCount != 0);
+    psBuf->u32RefCount++;
+    vPortClearInterruptMask(uxSaved);
+}
+
+/**
+  * @brief  Drop a reference to a buffer. The last one returns it to its pool.
+  * @param[in]  psBuf  A buffer taken from a pool, or NULL.
+  * @return None
+  */
+void BUFPOOL_Release(BUFPOOL_BUF_T *psBuf)
+{
+    if (psBuf == NULL)
+        return;
+    if (bp_put(psBuf))
+        xSemaphoreGive(psBuf->psPool->xFreeCount);
+}
+
+/**
+  * @brief  Drop a reference to a buffer in an interrupt handler. See \ref BUFPOOL_Release.
+  * @param[in]  psBuf                      A buffer taken from a pool, or NULL.
+  * @param[out] pxHigherPriorityTaskWoken  Set to pdTRUE if a task waiting for a buffer was
+  *                                        woken and a context switch is needed, may be NULL.
+  * @return None
+  */
+void BUFPOOL_ReleaseFromISR(BUFPOOL_BUF_T *psBuf, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (psBuf == NULL)
+        return;
+    if (bp_put(psBuf))
+        xSemaphoreGiveFromISR(psBuf->psPool->xFreeCount, pxHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  Make the first u32Length bytes of a buffer visible to a DMA engine that reads it.
+  *         Call after filling the buffer and before starting the transfer. Nothing to do for
+  *         a non-cacheable pool.
+  * @param[in]  psBuf  The buffer.
+  * @return None
+  */
+void BUFPOOL_DmaToDevice(BUFPOOL_BUF_T *psBuf)
+{
+    if ((psBuf->u32Length != 0) && !(psBuf->psPool->u32Flags & BUFPOOL_FLAG_NONCACHED))
+        sysCleanDCacheRange((uint32_t)psBuf->pu8Data, psBuf->u32Length);
+}
+
+/**
+  * @brief  Prepare a buffer for a DMA engine that writes it. Call before starting the
+  *         transfer and do not touch the block until it completes; the ARM926EJ-S does not
+  *         fill cache lines speculatively, so the data is then read from SDRAM. Nothing to
+  *         do for a non-cacheable pool.
+  * @param[in]  psBuf  The buffer.
+  * @return None
+  */
+void BUFPOOL_DmaFromDevice(BUFPOOL_BUF_T *psBuf)
+{
+    if (!(psBuf->psPool->u32Flags & BUFPOOL_FLAG_NONCACHED))
+        sysInvalidDCacheRange((uint32_t)psBuf->pu8Data, psBuf->u32Size);
+}
+
+/**
+  * @brief  Get the number of free buffers of a pool.
+  * @param[in]  psPool  The pool.
+  * @return Free buffers now.
+  */
+uint32_t BUFPOOL_GetFree(BUFPOOL_T *psPool)
+{
+    return psPool->u32Free;
+}
+
+/**
+  * @brief  Get the lowest number of free buffers since the pool was created, to size it.
+  * @param[in]  psPool  The pool.
+  * @return Low-water mark of the free buffers.
+  */
+uint32_t BUFPOOL_GetMinFree(BUFPOOL_T *psPool)
+{
+    return psPool->u32MinFree;
+}
+
+/**
+  * @brief  Create a queue that passes buffer pointers. The buffer and the reference that
+  *         goes with it change hands, the data is not copied.
+  * @param[in]  uxLength  Number of buffers the queue holds.
+  * @return The queue, or NULL if out of FreeRTOS heap.
+  */
+QueueHandle_t BUFQ_Create(UBaseType_t uxLength)
+{
+    return xQueueCreate(uxLength, sizeof(BUFPOOL_BUF_T *));
+}
+
+/**
+  * @brief  Send a buffer, and its reference, to a buffer queue.
+  * @param[in]  xQueue        A queue made by \ref BUFQ_Create.
+  * @param[in]  psBuf         The buffer.
+  * @param[in]  xTicksToWait  Time to wait for room in the queue.
+  * @return pdPASS, or errQUEUE_FULL in which case the caller still owns the buffer.
+  */
+BaseType_t BUFQ_Send(QueueHandle_t xQueue, BUFPOOL_BUF_T *psBuf, TickType_t xTicksToWait)
+{
+    return xQueueSend(xQueue, &psBuf, xTicksToWait);
+}
+
+/**
+  * @brief  Send a buffer to a buffer queue in an interrupt handler. See \ref BUFQ_Send.
+  * @param[in]  xQueue                     A queue made by \ref BUFQ_Create.
+  * @param[in]  psBuf                      The buffer.
+  * @param[out] pxHigherPriorityTaskWoken  Set to pdTRUE if a context switch is needed, may be NULL.
+  * @return pdPASS, or errQUEUE_FULL in which case the caller still owns the buffer.
+  */
+BaseType_t BUFQ_SendFromISR(QueueHandle_t xQueue, BUFPOOL_BUF_T *psBuf, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    return xQueueSendFromISR(xQueue, &psBuf, pxHigherPriorityTaskWoken);
+}
+
+/**
+  * @brief  Receive a buffer from a buffer queue. The caller owns the reference that came with
+  *         it and releases it when done.
+  * @param[in]  xQueue        A queue made by \ref BUFQ_Create.
+  * @param[in]  xTicksToWait  Time to wait for a buffer.
+  * @return The buffer, or NULL if none arrived in time.
+  */
+BUFPOOL_BUF_T *BUFQ_Receive(QueueHandle_t xQueue, TickType_t xTicksToWait)
+{
+    BUFPOOL_BUF_T *psBuf;
+
+    if (xQueueReceive(xQueue, &psBuf, xTicksToWait) != pdPASS)
+        return NULL;
+    return psBuf;
+}
+
+/**
+  * @brief  Receive a buffer from a buffer queue in an interrupt handler. See \ref BUFQ_Receive.
+  * @param[in]  xQueue                     A queue made by \ref BUFQ_Create.
+  * @param[out] pxHigherPriorityTaskWoken  Set to pdTRUE if a context switch is needed, may be NULL.
+  * @return The buffer, or NULL if the queue is empty.
+  */
+BUFPOOL_BUF_T *BUFQ_ReceiveFromISR(QueueHandle_t xQueue, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    BUFPOOL_BUF_T *psBuf;
+
+    if (xQueueReceiveFromISR(xQueue, &psBuf, pxHigherPriorityTaskWoken) != pdPASS)
+        return NULL;
+    return psBuf;
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
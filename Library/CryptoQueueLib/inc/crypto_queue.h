@@ -0,0 +1,178 @@
+/**************************************************************************//**
+ * @file     crypto_queue.h
+ * @brief    Interrupt driven job queue for the crypto engine under FreeRTOS.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _CRYPTO_QUEUE_H_
+#define  _CRYPTO_QUEUE_H_
+
+#include <stdint.h>
+#include "nuc980.h"
+#include "crypto.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup CRYPTOQ_Library Crypto Job Queue Library
+  @{
+*/
+
+/** @addtogroup CRYPTOQ_EXPORTED_CONSTANTS Crypto Job Queue Exported Constants
+  @{
+*/
+
+#ifndef CRYPTOQ_QUEUE_LENGTH
+#define CRYPTOQ_QUEUE_LENGTH        8      /*!< Jobs that can be queued behind the running one          */
+#endif
+#ifndef CRYPTOQ_STACK_SIZE
+#define CRYPTOQ_STACK_SIZE          (configMINIMAL_STACK_SIZE * 2)  /*!< Worker task stack, in words */
+#endif
+#ifndef CRYPTOQ_JOB_TIMEOUT_MS
+#define CRYPTOQ_JOB_TIMEOUT_MS      1000   /*!< Engine watchdog; a job running longer is stopped          */
+#endif
+
+#define CRYPTOQ_JOB_AES             1      /*!< AES DMA transfer, one shot                              */
+#define CRYPTOQ_JOB_SHA             2      /*!< SHA digest of one buffer                                */
+#define CRYPTOQ_JOB_ECC_MUL         3      /*!< ECC point multiplication on word arrays                 */
+#define CRYPTOQ_JOB_RSA_EXP         4      /*!< RSA modular exponentiation on word arrays               */
+
+#define CRYPTOQ_OK                  0      /*!< Job completed.                                          */
+#define CRYPTOQ_PENDING             1      /*!< Job queued or running.                                  */
+#define CRYPTOQ_ERR_PARAM           -1     /*!< Invalid job type or parameters.                         */
+#define CRYPTOQ_ERR_ENGINE          -2     /*!< Engine reported a DMA or operation error.               */
+#define CRYPTOQ_ERR_TIMEOUT         -3     /*!< Engine did not finish, or the wait timed out.           */
+#define CRYPTOQ_ERR_FULL            -4     /*!< The queue is full.                                      */
+#define CRYPTOQ_ERR_NOT_INIT        -5     /*!< CRYPTOQ_Init() was not called.                          */
+#define CRYPTOQ_ERR_NO_MEM          -6     /*!< Out of FreeRTOS heap.                                   */
+
+/*@}*/ /* end of group CRYPTOQ_EXPORTED_CONSTANTS */
+
+/** @addtogroup CRYPTOQ_EXPORTED_STRUCTS Crypto Job Queue Exported Structs
+  @{
+*/
+
+struct CRYPTOQ_JOB;
+
+/**
+  * @brief  Completion callback. Runs in the worker task before the job is marked complete
+  *         and a task blocked in CRYPTOQ_Wait() is released, so it may still use the job.
+  *         It must not wait for another job.
+  */
+typedef void (*CRYPTOQ_CALLBACK_T)(struct CRYPTOQ_JOB *psJob, int32_t i32Status, void *pvArg);
+
+/**
+  * @brief  AES job. Buffers are DMA sources and destinations: non-cacheable, or 32-byte
+  *         aligned with a length that covers whole cache lines and left untouched until the
+  *         job completes. The worker cleans and invalidates the D-cache before starting.
+  */
+typedef struct
+{
+    uint32_t u32OpMode;             /*!< AES_MODE_xxx                               */
+    uint32_t u32EncDec;             /*!< 1 to encrypt, 0 to decrypt                 */
+    uint32_t u32KeySize;            /*!< AES_KEY_SIZE_xxx                           */
+    uint32_t u32SwapType;           /*!< AES_NO_SWAP ... AES_IN_OUT_SWAP            */
+    uint32_t au32Key[8];            /*!< Key words, as for AES_SetKey()             */
+    uint32_t au32IV[4];             /*!< Initial vector, as for AES_SetInitVect()   */
+    uint32_t u32SrcAddr;            /*!< Source buffer                              */
+    uint32_t u32DstAddr;            /*!< Destination buffer, may equal the source   */
+    uint32_t u32Length;             /*!< Byte count, a multiple of 16 for block modes */
+} CRYPTOQ_AES_T;
+
+/**
+  * @brief  SHA job. The source buffer follows the same rules as for AES.
+  */
+typedef struct
+{
+    uint32_t u32OpMode;             /*!< SHA_MODE_xxx                               */
+    uint32_t u32SwapType;           /*!< SHA_NO_SWAP ... SHA_IN_OUT_SWAP            */
+    uint32_t u32SrcAddr;            /*!< Message                                    */
+    uint32_t u32Length;             /*!< Message byte count                         */
+    uint32_t *pu32Digest;           /*!< Output, up to 16 words as for SHA_Read()   */
+} CRYPTOQ_SHA_T;
+
+/**
+  * @brief  ECC point multiplication job, (x2, y2) = k * (x1, y1). See ECC_PointMul_u32().
+  */
+typedef struct
+{
+    E_ECC_CURVE eCurve;
+    const uint32_t *pu32X1;
+    const uint32_t *pu32Y1;
+    const uint32_t *pu32K;
+    uint32_t *pu32X2;
+    uint32_t *pu32Y2;
+} CRYPTOQ_ECC_T;
+
+/**
+  * @brief  RSA modular exponentiation job, x = m ^ e mod n. See RSA_ExpMod_u32().
+  */
+typedef struct
+{
+    uint32_t u32KeyLen;
+    const uint32_t *pu32M;
+    const uint32_t *pu32E;
+    const uint32_t *pu32N;
+    const uint32_t *pu32C;
+    uint32_t *pu32X;
+} CRYPTOQ_RSA_T;
+
+/**
+  * @brief  Crypto job. The caller owns the memory and must keep it, and every buffer it
+  *         points to, valid until the job has completed.
+  */
+typedef struct CRYPTOQ_JOB
+{
+    uint32_t u32Type;               /*!< CRYPTOQ_JOB_xxx                            */
+    union
+    {
+        CRYPTOQ_AES_T sAES;
+        CRYPTOQ_SHA_T sSHA;
+        CRYPTOQ_ECC_T sECC;
+        CRYPTOQ_RSA_T sRSA;
+    } u;                            /*!< Parameters of u32Type                      */
+    CRYPTOQ_CALLBACK_T pfnCallback; /*!< Optional, may be NULL                      */
+    void     *pvArg;                /*!< Passed to pfnCallback                      */
+
+    /* private to the library */
+    volatile int32_t i32Status;
+    TaskHandle_t xWaiter;
+} CRYPTOQ_JOB_T;
+
+/*@}*/ /* end of group CRYPTOQ_EXPORTED_STRUCTS */
+
+/** @addtogroup CRYPTOQ_EXPORTED_FUNCTIONS Crypto Job Queue Exported Functions
+  @{
+*/
+
+int32_t CRYPTOQ_Init(UBaseType_t uxPriority);
+int32_t CRYPTOQ_Submit(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait);
+int32_t CRYPTOQ_Wait(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait);
+int32_t CRYPTOQ_Run(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait);
+int32_t CRYPTOQ_Status(const CRYPTOQ_JOB_T *psJob);
+int32_t CRYPTOQ_Lock(TickType_t xTicksToWait);
+void    CRYPTOQ_Unlock(void);
+void    CRYPTOQ_IRQHandler(void);
+
+/*@}*/ /* end of group CRYPTOQ_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group CRYPTOQ_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CRYPTO_QUEUE_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,409 @@
+/**************************************************************************//**
+ * @file     crypto_queue.c
+ * @brief    Interrupt driven job queue for the crypto engine under FreeRTOS.
+ *
+ *           Jobs are queued by pointer and run one at a time by a worker task.
+ *           The worker programs the engine, enables the interrupt of the unit
+ *           in use and sleeps on its task notification until the CRYPTO ISR
+ *           wakes it, so other tasks run while the engine works. The RSA unit
+ *           has no interrupt and is polled once per tick instead.
+ *
+ *           The engine lock is held by the worker for each job. Code that uses
+ *           the engine directly, such as the mbedtls hooks, takes the same lock
+ *           with CRYPTOQ_Lock(). Interrupts are enabled only while a queued job
+ *           runs, so direct users keep polling CRPT_INTSTS as before. The lock is
+ *           a recursive mutex: a low priority holder inherits the priority of a
+ *           waiter, and one task may nest the hooks, e.g. AES while it streams a
+ *           hash through the engine.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include "crypto_queue.h"
+#include "sys.h"
+#include "queue.h"
+#include "semphr.h"
+
+#if (configUSE_MUTEXES != 1) || (configUSE_RECURSIVE_MUTEXES != 1)
+#error "CryptoQueueLib needs configUSE_MUTEXES and configUSE_RECURSIVE_MUTEXES set to 1"
+#endif
+
+/// @cond HIDDEN_SYMBOLS
+
+#define CRYPTOQ_INT_MASK    (CRPT_INTEN_AESIEN_Msk | CRPT_INTEN_AESEIEN_Msk | \
+                             CRPT_INTEN_HMACIEN_Msk | CRPT_INTEN_HMACEIEN_Msk | \
+                             CRPT_INTEN_ECCIEN_Msk | CRPT_INTEN_ECCEIEN_Msk)
+
+static QueueHandle_t     s_xJobQueue;
+static SemaphoreHandle_t s_xEngineLock;
+static TaskHandle_t      s_xWorker;
+static volatile uint32_t s_u32IntSts;      /* flags taken by the ISR for the running job */
+
+/*
+ *  Clean and invalidate the D-cache if a DMA buffer is cacheable. The owner must
+ *  not touch the buffers until the job completes, so no line is reloaded early.
+ */
+static void crq_dma_prepare(uint32_t u32Src, uint32_t u32Dst)
+{
+    if ((((u32Src & u32Dst) & 0x80000000) == 0) && sysGetCacheState())
+        sysFlushCache(D_CACHE);
+}
+
+/*
+ *  Enable the interrupts of the unit about to be started. Stale flags are
+ *  cleared first, a poller may have left them.
+ */
+static void crq_arm(uint32_t u32Mask)
+{
+    s_u32IntSts = 0;
+    CRPT->INTSTS = u32Mask;
+    (void)ulTaskNotifyTake(pdTRUE, 0);
+    CRPT->INTEN |= u32Mask;
+}
+
+/*
+ *  Sleep until the ISR reports the done or the error flag of the unit.
+ */
+static int32_t crq_wait_int(uint32_t u32Done, uint32_t u32Err)
+{
+    TimeOut_t  xTimeOut;
+    TickType_t xTicks = pdMS_TO_TICKS(CRYPTOQ_JOB_TIMEOUT_MS);
+
+    vTaskSetTimeOutState(&xTimeOut);
+    while ((s_u32IntSts & (u32Done | u32Err)) == 0)
+    {
+        if (xTaskCheckForTimeOut(&xTimeOut, &xTicks) != pdFALSE)
+        {
+            CRPT->INTEN &= ~(u32Done | u32Err);
+            return CRYPTOQ_ERR_TIMEOUT;
+        }
+        (void)ulTaskNotifyTake(pdTRUE, xTicks);
+    }
+    return (s_u32IntSts & u32Err) ? CRYPTOQ_ERR_ENGINE : CRYPTOQ_OK;
+}
+
+static int32_t crq_run_aes(CRYPTOQ_AES_T *p)
+{
+    int32_t  ret;
+
+    if (p->u32Length == 0)
+        return CRYPTOQ_ERR_PARAM;
+
+    crq_dma_prepare(p->u32SrcAddr, p->u32DstAddr);
+
+    AES_Open(CRPT, p->u32EncDec, p->u32OpMode, p->u32KeySize, p->u32SwapType);
+    AES_SetKey(CRPT, p->au32Key, p->u32KeySize);
+    AES_SetInitVect(CRPT, p->au32IV);
+    AES_SetDMATransfer(CRPT, p->u32SrcAddr, p->u32DstAddr, p->u32Length);
+
+    crq_arm(CRPT_INTEN_AESIEN_Msk | CRPT_INTEN_AESEIEN_Msk);
+    AES_Start(CRPT, CRYPTO_DMA_ONE_SHOT);
+
+    ret = crq_wait_int(CRPT_INTSTS_AESIF_Msk, CRPT_INTSTS_AESEIF_Msk);
+    if (ret == CRYPTOQ_ERR_TIMEOUT)
+        CRPT->AES_CTL = CRPT_AES_CTL_STOP_Msk;
+    return ret;
+}
+
+static int32_t crq_run_sha(CRYPTOQ_SHA_T *p)
+{
+    int32_t  ret;
+
+    if (p->pu32Digest == NULL)
+        return CRYPTOQ_ERR_PARAM;
+
+    crq_dma_prepare(p->u32SrcAddr, p->u32SrcAddr);
+
+    SHA_Open(CRPT, p->u32OpMode, p->u32SwapType, 0);
+    SHA_SetDMATransfer(CRPT, p->u32SrcAddr, p->u32Length);
+
+    crq_arm(CRPT_INTEN_HMACIEN_Msk | CRPT_INTEN_HMACEIEN_Msk);
+    SHA_Start(CRPT, CRYPTO_DMA_ONE_SHOT);
+
+    ret = crq_wait_int(CRPT_INTSTS_HMACIF_Msk, CRPT_INTSTS_HMACEIF_Msk);
+    if (ret == CRYPTOQ_OK)
+        SHA_Read(CRPT, p->pu32Digest);
+    else if (ret == CRYPTOQ_ERR_TIMEOUT)
+        CRPT->HMAC_CTL = CRPT_HMAC_CTL_STOP_Msk;
+    return ret;
+}
+
+static int32_t crq_run_ecc(CRYPTOQ_ECC_T *p)
+{
+    int32_t  ret;
+
+    crq_arm(CRPT_INTEN_ECCIEN_Msk | CRPT_INTEN_ECCEIEN_Msk);
+    if (ECC_PointMulStart_u32(CRPT, p->eCurve, p->pu32X1, p->pu32Y1, p->pu32K) != 0)
+    {
+        CRPT->INTEN &= ~(CRPT_INTEN_ECCIEN_Msk | CRPT_INTEN_ECCEIEN_Msk);
+        return CRYPTOQ_ERR_PARAM;
+    }
+
+    ret = crq_wait_int(CRPT_INTSTS_ECCIF_Msk, CRPT_INTSTS_ECCEIF_Msk);
+    if (ret == CRYPTOQ_ERR_TIMEOUT)
+        CRPT->ECC_CTL = CRPT_ECC_CTL_STOP_Msk;
+    while (CRPT->ECC_STS & CRPT_ECC_STS_BUSY_Msk) ;
+
+    ECC_PointMulRead_u32(CRPT, (ret == CRYPTOQ_OK) ? p->pu32X2 : NULL,
+                         (ret == CRYPTOQ_OK) ? p->pu32Y2 : NULL);
+    return ret;
+}
+
+static int32_t crq_run_rsa(CRYPTOQ_RSA_T *p)
+{
+    TimeOut_t  xTimeOut;
+    TickType_t xTicks = pdMS_TO_TICKS(CRYPTOQ_JOB_TIMEOUT_MS);
+    int32_t    ret = CRYPTOQ_OK;
+
+    if (RSA_ExpModStart_u32(CRPT, p->u32KeyLen, p->pu32M, p->pu32E, p->pu32N, p->pu32C) != 0)
+        return CRYPTOQ_ERR_PARAM;
+
+    /* no RSA interrupt; a 2048-bit private key operation takes several ticks */
+    vTaskSetTimeOutState(&xTimeOut);
+    while (CRPT->RSA_STS & CRPT_RSA_STS_BUSY_Msk)
+    {
+        if (xTaskCheckForTimeOut(&xTimeOut, &xTicks) != pdFALSE)
+        {
+            CRPT->RSA_CTL = CRPT_RSA_CTL_STOP_Msk;
+            ret = CRYPTOQ_ERR_TIMEOUT;
+            break;
+        }
+        vTaskDelay(1);
+    }
+
+    RSA_ExpModRead_u32(CRPT, p->u32KeyLen, (ret == CRYPTOQ_OK) ? p->pu32X : NULL);
+    return ret;
+}
+
+static void crq_complete(CRYPTOQ_JOB_T *psJob, int32_t i32Status)
+{
+    TaskHandle_t xWaiter;
+
+    if (psJob->pfnCallback != NULL)
+        psJob->pfnCallback(psJob, i32Status, psJob->pvArg);
+
+    /* the owner may reuse the job as soon as the status is set */
+    taskENTER_CRITICAL();
+    xWaiter = psJob->xWaiter;
+    psJob->xWaiter = NULL;
+    psJob->i32Status = i32Status;
+    taskEXIT_CRITICAL();
+
+    if (xWaiter != NULL)
+        xTaskNotifyGive(xWaiter);
+}
+
+static void crq_worker(void *pvParameters)
+{
+    CRYPTOQ_JOB_T *psJob;
+    int32_t  ret;
+
+    (void)pvParameters;
+
+    for (;;)
+    {
+        if (xQueueReceive(s_xJobQueue, &psJob, portMAX_DELAY) != pdPASS)
+            continue;
+
+        xSemaphoreTakeRecursive(s_xEngineLock, portMAX_DELAY);
+        switch (psJob->u32Type)
+        {
+        case CRYPTOQ_JOB_AES:
+            ret = crq_run_aes(&psJob->u.sAES);
+            break;
+        case CRYPTOQ_JOB_SHA:
+            ret = crq_run_sha(&psJob->u.sSHA);
+            break;
+        case CRYPTOQ_JOB_ECC_MUL:
+            ret = crq_run_ecc(&psJob->u.sECC);
+            break;
+        case CRYPTOQ_JOB_RSA_EXP:
+            ret = crq_run_rsa(&psJob->u.sRSA);
+            break;
+        default:
+            ret = CRYPTOQ_ERR_PARAM;
+            break;
+        }
+        xSemaphoreGiveRecursive(s_xEngineLock);
+
+        crq_complete(psJob, ret);
+    }
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief  Create the job queue and its worker task and install CRYPTOQ_IRQHandler() as the
+  *         CRYPTO interrupt handler. The crypto engine clock must be enabled.
+  * @param[in]  uxPriority  Priority of the worker task. It only runs to start and finish
+  *                         jobs, so it is usually above the tasks that submit them.
+  * @return CRYPTOQ_OK, or CRYPTOQ_ERR_NO_MEM.
+  */
+int32_t CRYPTOQ_Init(UBaseType_t uxPriority)
+{
+    if (s_xJobQueue != NULL)
+        return CRYPTOQ_OK;
+
+    s_xJobQueue = xQueueCreate(CRYPTOQ_QUEUE_LENGTH, sizeof(CRYPTOQ_JOB_T *));
+    s_xEngineLock = xSemaphoreCreateRecursiveMutex();
+    if ((s_xJobQueue == NULL) || (s_xEngineLock == NULL))
+        goto err_out;
+
+    CRPT->INTEN &= ~CRYPTOQ_INT_MASK;
+    if (xTaskCreate(crq_worker, "CryptoQ", CRYPTOQ_STACK_SIZE, NULL, uxPriority, &s_xWorker) != pdPASS)
+        goto err_out;
+
+    sysInstallISR(IRQ_LEVEL_1, IRQ_CRYPTO, (PVOID)CRYPTOQ_IRQHandler);
+    sysEnableInterrupt(IRQ_CRYPTO);
+    return CRYPTOQ_OK;
+
+err_out:
+    if (s_xJobQueue != NULL)
+        vQueueDelete(s_xJobQueue);
+    if (s_xEngineLock != NULL)
+        vSemaphoreDelete(s_xEngineLock);
+    s_xJobQueue = NULL;
+    s_xEngineLock = NULL;
+    return CRYPTOQ_ERR_NO_MEM;
+}
+
+/**
+  * @brief  Queue a job and return. Completion is reported through the callback, CRYPTOQ_Wait()
+  *         or CRYPTOQ_Status(). Jobs run in submission order.
+  * @param[in]  psJob         The job. Must stay valid until it completes.
+  * @param[in]  xTicksToWait  Time to wait for room in the queue.
+  * @return CRYPTOQ_OK if queued, CRYPTOQ_ERR_FULL, CRYPTOQ_ERR_PARAM or CRYPTOQ_ERR_NOT_INIT.
+  */
+int32_t CRYPTOQ_Submit(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait)
+{
+    if (s_xJobQueue == NULL)
+        return CRYPTOQ_ERR_NOT_INIT;
+    if ((psJob == NULL) || (psJob->u32Type < CRYPTOQ_JOB_AES) || (psJob->u32Type > CRYPTOQ_JOB_RSA_EXP))
+        return CRYPTOQ_ERR_PARAM;
+
+    psJob->xWaiter = NULL;
+    psJob->i32Status = CRYPTOQ_PENDING;
+    if (xQueueSend(s_xJobQueue, &psJob, xTicksToWait) != pdPASS)
+    {
+        psJob->i32Status = CRYPTOQ_ERR_FULL;
+        return CRYPTOQ_ERR_FULL;
+    }
+    return CRYPTOQ_OK;
+}
+
+/**
+  * @brief  Block the calling task until a submitted job completes. Uses the task notification
+  *         of the calling task. Only one task may wait for a given job.
+  * @param[in]  psJob         A submitted job.
+  * @param[in]  xTicksToWait  Maximum time to wait.
+  * @return The job status, or CRYPTOQ_ERR_TIMEOUT if it is still pending. A job that timed out
+  *         here is still queued and must be waited for again before it is reused.
+  */
+int32_t CRYPTOQ_Wait(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait)
+{
+    TimeOut_t  xTimeOut;
+    int32_t    ret;
+
+    vTaskSetTimeOutState(&xTimeOut);
+    for (;;)
+    {
+        taskENTER_CRITICAL();
+        ret = psJob->i32Status;
+        psJob->xWaiter = (ret == CRYPTOQ_PENDING) ? xTaskGetCurrentTaskHandle() : NULL;
+        taskEXIT_CRITICAL();
+
+        if (ret != CRYPTOQ_PENDING)
+            return ret;
+
+        if (xTaskCheckForTimeOut(&xTimeOut, &xTicksToWait) != pdFALSE)
+        {
+            taskENTER_CRITICAL();
+            psJob->xWaiter = NULL;
+            ret = psJob->i32Status;
+            taskEXIT_CRITICAL();
+            return (ret == CRYPTOQ_PENDING) ? CRYPTOQ_ERR_TIMEOUT : ret;
+        }
+        (void)ulTaskNotifyTake(pdTRUE, xTicksToWait);
+    }
+}
+
+/**
+  * @brief  Submit a job and wait for it.
+  * @param[in]  psJob         The job.
+  * @param[in]  xTicksToWait  Time allowed for queueing, and again for completion.
+  * @return The job status, or an error of CRYPTOQ_Submit() or CRYPTOQ_Wait().
+  */
+int32_t CRYPTOQ_Run(CRYPTOQ_JOB_T *psJob, TickType_t xTicksToWait)
+{
+    int32_t  ret;
+
+    ret = CRYPTOQ_Submit(psJob, xTicksToWait);
+    if (ret != CRYPTOQ_OK)
+        return ret;
+    return CRYPTOQ_Wait(psJob, xTicksToWait);
+}
+
+/**
+  * @brief  Get the status of a submitted job without blocking.
+  * @param[in]  psJob   A submitted job.
+  * @return CRYPTOQ_PENDING, CRYPTOQ_OK or a negative CRYPTOQ_ERR_xxx code.
+  */
+int32_t CRYPTOQ_Status(const CRYPTOQ_JOB_T *psJob)
+{
+    return psJob->i32Status;
+}
+
+/**
+  * @brief  Take the engine for direct use by the calling task, between queued jobs.
+  *         The engine interrupts are disabled while it is held; poll CRPT_INTSTS.
+  *         Calls may nest in one task, each one matched by CRYPTOQ_Unlock(). A task
+  *         holding the lock must not wait for a queued job, the worker needs the lock.
+  *         Task context only.
+  * @param[in]  xTicksToWait  Maximum time to wait for the running job.
+  * @return CRYPTOQ_OK, CRYPTOQ_ERR_TIMEOUT or CRYPTOQ_ERR_NOT_INIT.
+  */
+int32_t CRYPTOQ_Lock(TickType_t xTicksToWait)
+{
+    if (s_xEngineLock == NULL)
+        return CRYPTOQ_ERR_NOT_INIT;
+    return (xSemaphoreTakeRecursive(s_xEngineLock, xTicksToWait) == pdPASS) ? CRYPTOQ_OK : CRYPTOQ_ERR_TIMEOUT;
+}
+
+/**
+  * @brief  Release the engine taken with CRYPTOQ_Lock().
+  * @return None
+  */
+void CRYPTOQ_Unlock(void)
+{
+    if (s_xEngineLock != NULL)
+        xSemaphoreGiveRecursive(s_xEngineLock);
+}
+
+/**
+  * @brief  CRYPTO interrupt handler, installed by CRYPTOQ_Init(). An application that has its
+  *         own CRYPTO handler must call this function from it instead.
+  * @return None
+  */
+void CRYPTOQ_IRQHandler(void)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t   u32Sts;
+
+    u32Sts = CRPT->INTSTS & CRPT->INTEN & CRYPTOQ_INT_MASK;
+    if (u32Sts == 0)
+        return;
+
+    /* one shot: the unit is idle until the worker arms it again */
+    CRPT->INTEN &= ~CRYPTOQ_INT_MASK;
+    CRPT->INTSTS = u32Sts;
+    s_u32IntSts |= u32Sts;
+
+    vTaskNotifyGiveFromISR(s_xWorker, &xWoken);
+#ifdef portYIELD_FROM_ISR
+    portYIELD_FROM_ISR(xWoken);
+#else
+    (void)xWoken;
+#endif
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
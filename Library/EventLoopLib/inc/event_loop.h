@@ -0,0 +1,161 @@
+/**************************************************************************//**
+ * @file     event_loop.h
+ * @brief    Cooperative event loop with timers and work queues for applications
+ *           running without an RTOS.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _EVENT_LOOP_H_
+#define  _EVENT_LOOP_H_
+
+#include <stdint.h>
+#include "nuc980.h"
+#include "sys.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup EVL_Library Event Loop Library
+  @{
+*/
+
+/** @addtogroup EVL_EXPORTED_CONSTANTS Event Loop Exported Constants
+  @{
+*/
+
+#define EVL_PRIORITIES              8      /*!< Event priorities, 0 is the lowest                       */
+#define EVL_PRIORITY_MAX            (EVL_PRIORITIES - 1)  /*!< Highest priority, used by the timers   */
+#ifndef EVL_WHEEL_SLOTS
+#define EVL_WHEEL_SLOTS             32     /*!< Timer wheel slots, a power of 2                         */
+#endif
+
+#define EVL_OK                      0      /*!< Success.                                                */
+#define EVL_ERR_PARAM               -1     /*!< Invalid event, timer or parameters.                     */
+#define EVL_ERR_FULL                -2     /*!< The work queue is full.                                 */
+
+/*@}*/ /* end of group EVL_EXPORTED_CONSTANTS */
+
+/** @addtogroup EVL_EXPORTED_STRUCTS Event Loop Exported Structs
+  @{
+*/
+
+struct EVL_EVENT;
+struct EVL_TIMER;
+
+/**
+  * @brief  Event handler. u32Posts is the number of times the event was posted since the
+  *         handler last ran; posts made while the event is pending are merged into one run.
+  */
+typedef void (*EVL_HANDLER_T)(struct EVL_EVENT *psEvent, uint32_t u32Posts);
+
+/**
+  * @brief  Timer function, called from the event loop when the timer expires.
+  */
+typedef void (*EVL_TIMER_FUNC_T)(struct EVL_TIMER *psTimer, void *pvArg);
+
+/**
+  * @brief  Deferred work function, called from the event loop.
+  */
+typedef void (*EVL_WORK_FUNC_T)(void *pvArg);
+
+/**
+  * @brief  Event. The caller owns the structure, which must stay valid while it is posted.
+  */
+typedef struct EVL_EVENT
+{
+    EVL_HANDLER_T pfnHandler;       /*!< Handler, set by EVL_InitEvent()            */
+    void     *pvArg;                /*!< Free for the handler                       */
+    uint8_t   u8Priority;           /*!< 0 to EVL_PRIORITY_MAX                      */
+
+    /* private to the library */
+    volatile uint8_t u8Queued;
+    volatile uint32_t u32Posts;
+    struct EVL_EVENT *psNext;
+} EVL_EVENT_T;
+
+/**
+  * @brief  Timer. Timers are kept in a wheel of EVL_WHEEL_SLOTS lists indexed by the expiry
+  *         tick, so starting, stopping and expiring a timer does not depend on how many
+  *         timers are running.
+  */
+typedef struct EVL_TIMER
+{
+    EVL_TIMER_FUNC_T pfnFunc;       /*!< Timer function, set by EVL_InitTimer()     */
+    void     *pvArg;                /*!< Argument of the timer function             */
+
+    /* private to the library */
+    uint32_t  u32Expire;
+    uint32_t  u32Period;
+    uint8_t   u8Active;
+    struct EVL_TIMER *psNext;
+} EVL_TIMER_T;
+
+/**
+  * @brief  Deferred work item of a work queue.
+  */
+typedef struct
+{
+    EVL_WORK_FUNC_T pfnFunc;        /*!< Work function                              */
+    void     *pvArg;                /*!< Argument of the work function              */
+} EVL_WORK_T;
+
+/**
+  * @brief  Work queue. Work put from interrupt handlers runs in the event loop, in order,
+  *         at the priority of the queue. The caller provides the item storage.
+  */
+typedef struct
+{
+    /* private to the library */
+    EVL_EVENT_T sEvent;
+    EVL_WORK_T *psItems;
+    uint32_t  u32Length;
+    volatile uint32_t u32Head;
+    volatile uint32_t u32Tail;
+    volatile uint32_t u32Count;
+    uint32_t  u32MaxCount;
+} EVL_WORKQ_T;
+
+/*@}*/ /* end of group EVL_EXPORTED_STRUCTS */
+
+/** @addtogroup EVL_EXPORTED_FUNCTIONS Event Loop Exported Functions
+  @{
+*/
+
+void     EVL_Init(void);
+void     EVL_Run(void);
+int32_t  EVL_Dispatch(void);
+void     EVL_SetIdleHook(void (*pfnHook)(void));
+
+int32_t  EVL_InitEvent(EVL_EVENT_T *psEvent, EVL_HANDLER_T pfnHandler, void *pvArg, uint32_t u32Priority);
+void     EVL_Post(EVL_EVENT_T *psEvent);
+
+void     EVL_Tick(void);
+uint32_t EVL_GetTicks(void);
+void     EVL_InitTimer(EVL_TIMER_T *psTimer, EVL_TIMER_FUNC_T pfnFunc, void *pvArg);
+int32_t  EVL_StartTimer(EVL_TIMER_T *psTimer, uint32_t u32Ticks, uint32_t u32Period);
+void     EVL_StopTimer(EVL_TIMER_T *psTimer);
+
+int32_t  EVL_WorkQInit(EVL_WORKQ_T *psQ, EVL_WORK_T *psItems, uint32_t u32Length, uint32_t u32Priority);
+int32_t  EVL_WorkQPut(EVL_WORKQ_T *psQ, EVL_WORK_FUNC_T pfnFunc, void *pvArg);
+uint32_t EVL_WorkQGetMaxCount(EVL_WORKQ_T *psQ);
+
+/*@}*/ /* end of group EVL_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group EVL_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EVENT_LOOP_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,491 @@
+/**************************************************************************//**
+ * @file     event_loop.c
+ * @brief    Cooperative event loop with timers and work queues for applications
+ *           running without an RTOS.
+ *
+ *           Interrupt handlers only acknowledge the hardware and post an
+ *           event; the handler of the event runs later in the main loop, in
+ *           priority order and to completion. An event posted again before
+ *           its handler runs is not queued twice, the handler gets the number
+ *           of posts instead, so an interrupt storm costs one run.
+ *
+ *           Each priority has a FIFO of ready events and a bit in a ready
+ *           mask, so picking the next event is one count leading zeros. The
+ *           lists are changed with IRQ and FIQ masked for a few instructions,
+ *           the ARM926EJ-S has no exclusive load and store.
+ *
+ *           Drivers that busy wait for a transfer call EVL_Dispatch() from
+ *           their wait hook. It runs the events of higher priority than the
+ *           handler being waited in, so a long SD or USB transfer does not
+ *           hold off the network or the timers.
+ *
+ *           EVL_Tick() is called from the timer interrupt of the application
+ *           and posts the timer event at EVL_PRIORITY_MAX; its handler catches
+ *           up on every tick since it last ran. EVL_Run() waits for interrupt
+ *           when no event is ready.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "event_loop.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#if (EVL_WHEEL_SLOTS & (EVL_WHEEL_SLOTS - 1)) != 0
+#error EVL_WHEEL_SLOTS must be a power of 2
+#endif
+
+#define EVL_IDLE_LEVEL      -1
+
+typedef struct
+{
+    EVL_EVENT_T *psHead;
+    EVL_EVENT_T *psTail;
+} EVL_LIST_T;
+
+static EVL_LIST_T s_asReady[EVL_PRIORITIES];
+static volatile uint32_t s_u32ReadyMask;
+static int32_t s_i32Level = EVL_IDLE_LEVEL;    /* priority of the running handler */
+static void (*s_pfnIdleHook)(void);
+
+static EVL_TIMER_T *s_apsWheel[EVL_WHEEL_SLOTS];
+static volatile uint32_t s_u32Ticks;           /* ticks counted by EVL_Tick()     */
+static uint32_t s_u32TimerNow;                 /* ticks handled by the wheel      */
+static EVL_EVENT_T s_sTickEvent;
+
+static uint32_t evl_lock(void)
+{
+    uint32_t u32Old, u32New;
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" mrs %0, cpsr" : "=r" (u32Old) :  );
+    u32New = u32Old | DISABLE_FIQ_IRQ;
+    asm volatile (" msr cpsr_c, %0" :  : "r" (u32New) : "memory");
+
+#else
+    __asm
+    {
+        MRS    u32Old, CPSR
+        ORR    u32New, u32Old, DISABLE_FIQ_IRQ
+        MSR    CPSR_c, u32New
+    }
+#endif
+    return u32Old;
+}
+
+static void evl_unlock(uint32_t u32Old)
+{
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" msr cpsr_c, %0" :  : "r" (u32Old) : "memory");
+
+#else
+    __asm
+    {
+        MSR    CPSR_c, u32Old
+    }
+#endif
+}
+
+/* Stop the core clock until an interrupt is pending, which wakes it even when masked. */
+static void evl_wait_for_interrupt(void)
+{
+    uint32_t u32Zero = 0;
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" mcr p15, 0, %0, c7, c0, 4" :  : "r" (u32Zero) : "memory");
+
+#else
+    __asm
+    {
+        MCR    p15, 0, u32Zero, c7, c0, 4
+    }
+#endif
+}
+
+static uint32_t evl_highest(uint32_t u32Mask)
+{
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+    return 31 - __builtin_clz(u32Mask);
+#else
+    return 31 - __clz(u32Mask);
+#endif
+}
+
+static void evl_wheel_insert(EVL_TIMER_T *psTimer)
+{
+    EVL_TIMER_T **ppsSlot = &s_apsWheel[psTimer->u32Expire & (EVL_WHEEL_SLOTS - 1)];
+
+    psTimer->psNext = *ppsSlot;
+    *ppsSlot = psTimer;
+    psTimer->u8Active = 1;
+}
+
+static void evl_wheel_remove(EVL_TIMER_T *psTimer)
+{
+    EVL_TIMER_T **ppsLink = &s_apsWheel[psTimer->u32Expire & (EVL_WHEEL_SLOTS - 1)];
+
+    while (*ppsLink != NULL)
+    {
+        if (*ppsLink == psTimer)
+        {
+            *ppsLink = psTimer->psNext;
+            break;
+        }
+        ppsLink = &(*ppsLink)->psNext;
+    }
+    psTimer->psNext = NULL;
+    psTimer->u8Active = 0;
+}
+
+/*
+ *  Run the timers of every tick counted since the last run. A slot holds the timers of
+ *  all expiry ticks equal modulo EVL_WHEEL_SLOTS, so only those due now are taken, one at
+ *  a time, since a timer function may start or stop any timer.
+ */
+static void evl_tick_handler(EVL_EVENT_T *psEvent, uint32_t u32Posts)
+{
+    EVL_TIMER_T *psTimer;
+
+    (void)psEvent;
+    (void)u32Posts;
+
+    while (s_u32TimerNow != s_u32Ticks)
+    {
+        s_u32TimerNow++;
+        for (;;)
+        {
+            psTimer = s_apsWheel[s_u32TimerNow & (EVL_WHEEL_SLOTS - 1)];
+            while ((psTimer != NULL) && (psTimer->u32Expire != s_u32TimerNow))
+                psTimer = psTimer->psNext;
+            if (psTimer == NULL)
+                break;
+
+            evl_wheel_remove(psTimer);
+            if (psTimer->u32Period != 0)
+            {
+                psTimer->u32Expire = s_u32TimerNow + psTimer->u32Period;
+                evl_wheel_insert(psTimer);
+            }
+            psTimer->pfnFunc(psTimer, psTimer->pvArg);
+        }
+    }
+}
+
+static void evl_workq_handler(EVL_EVENT_T *psEvent, uint32_t u32Posts)
+{
+    EVL_WORKQ_T *psQ = (EVL_WORKQ_T *)psEvent->pvArg;
+    EVL_WORK_T sWork;
+    uint32_t u32Old;
+
+    (void)u32Posts;
+
+    for (;;)
+    {
+        u32Old = evl_lock();
+        if (psQ->u32Count == 0)
+        {
+            evl_unlock(u32Old);
+            break;
+        }
+        sWork = psQ->psItems[psQ->u32Tail];
+        if (++psQ->u32Tail == psQ->u32Length)
+            psQ->u32Tail = 0;
+        psQ->u32Count--;
+        evl_unlock(u32Old);
+
+        sWork.pfnFunc(sWork.pvArg);
+    }
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Initialize the event loop, dropping all pending events and timers.
+  * @return     None.
+  */
+void EVL_Init(void)
+{
+    uint32_t u32Old;
+
+    u32Old = evl_lock();
+    memset(s_asReady, 0, sizeof(s_asReady));
+    memset(s_apsWheel, 0, sizeof(s_apsWheel));
+    s_u32ReadyMask = 0;
+    s_u32Ticks = 0;
+    s_u32TimerNow = 0;
+    s_i32Level = EVL_IDLE_LEVEL;
+    evl_unlock(u32Old);
+
+    EVL_InitEvent(&s_sTickEvent, evl_tick_handler, NULL, EVL_PRIORITY_MAX);
+}
+
+/**
+  * @brief      Initialize an event.
+  * @param[in]  psEvent     Event to initialize.
+  * @param[in]  pfnHandler  Handler run from the event loop when the event is posted.
+  * @param[in]  pvArg       Free for the handler, kept in psEvent->pvArg.
+  * @param[in]  u32Priority 0 to EVL_PRIORITY_MAX, higher runs first.
+  * @return     EVL_OK, or EVL_ERR_PARAM.
+  */
+int32_t EVL_InitEvent(EVL_EVENT_T *psEvent, EVL_HANDLER_T pfnHandler, void *pvArg, uint32_t u32Priority)
+{
+    if ((psEvent == NULL) || (pfnHandler == NULL) || (u32Priority > EVL_PRIORITY_MAX))
+        return EVL_ERR_PARAM;
+
+    psEvent->pfnHandler = pfnHandler;
+    psEvent->pvArg = pvArg;
+    psEvent->u8Priority = (uint8_t)u32Priority;
+    psEvent->u8Queued = 0;
+    psEvent->u32Posts = 0;
+    psEvent->psNext = NULL;
+    return EVL_OK;
+}
+
+/**
+  * @brief      Post an event. Can be called from interrupt handlers and event handlers.
+  *             Posting an event that is already pending only counts the post.
+  * @param[in]  psEvent     Event to post.
+  * @return     None.
+  */
+void EVL_Post(EVL_EVENT_T *psEvent)
+{
+    EVL_LIST_T *psList;
+    uint32_t u32Old;
+
+    u32Old = evl_lock();
+    psEvent->u32Posts++;
+    if (!psEvent->u8Queued)
+    {
+        psEvent->u8Queued = 1;
+        psEvent->psNext = NULL;
+        psList = &s_asReady[psEvent->u8Priority];
+        if (psList->psHead == NULL)
+            psList->psHead = psEvent;
+        else
+            psList->psTail->psNext = psEvent;
+        psList->psTail = psEvent;
+        s_u32ReadyMask |= (1ul << psEvent->u8Priority);
+    }
+    evl_unlock(u32Old);
+}
+
+/**
+  * @brief      Run the ready events of higher priority than the running handler, or all
+  *             ready events when called outside a handler, until none is left.
+  * @return     Number of handlers run.
+  * @details    A driver wait hook may call this function so that other work goes on while
+  *             the driver waits. A handler run that way must not use the waiting driver.
+  */
+int32_t EVL_Dispatch(void)
+{
+    EVL_LIST_T *psList;
+    EVL_EVENT_T *psEvent;
+    uint32_t u32Old, u32Prio, u32Posts;
+    int32_t i32Saved = s_i32Level;
+    int32_t i32Count = 0;
+
+    for (;;)
+    {
+        u32Old = evl_lock();
+        if (s_u32ReadyMask == 0)
+        {
+            evl_unlock(u32Old);
+            break;
+        }
+        u32Prio = evl_highest(s_u32ReadyMask);
+        if ((int32_t)u32Prio <= i32Saved)
+        {
+            evl_unlock(u32Old);
+            break;
+        }
+
+        psList = &s_asReady[u32Prio];
+        psEvent = psList->psHead;
+        psList->psHead = psEvent->psNext;
+        if (psList->psHead == NULL)
+        {
+            psList->psTail = NULL;
+            s_u32ReadyMask &= ~(1ul << u32Prio);
+        }
+        u32Posts = psEvent->u32Posts;
+        psEvent->u32Posts = 0;
+        psEvent->u8Queued = 0;
+        psEvent->psNext = NULL;
+        s_i32Level = (int32_t)u32Prio;
+        evl_unlock(u32Old);
+
+        psEvent->pfnHandler(psEvent, u32Posts);
+        i32Count++;
+    }
+
+    s_i32Level = i32Saved;
+    return i32Count;
+}
+
+/**
+  * @brief      Set the function called instead of the wait for interrupt instruction when
+  *             no event is ready.
+  * @param[in]  pfnHook     Idle hook, or NULL to wait for interrupt. It is called with IRQ
+  *                         and FIQ masked and must not unmask them.
+  * @return     None.
+  */
+void EVL_SetIdleHook(void (*pfnHook)(void))
+{
+    s_pfnIdleHook = pfnHook;
+}
+
+/**
+  * @brief      Run the event loop. Never returns.
+  * @return     None.
+  * @details    The ready mask is checked with interrupts masked and the core sleeps before
+  *             they are unmasked, so an event posted between the check and the sleep still
+  *             wakes it.
+  */
+void EVL_Run(void)
+{
+    uint32_t u32Old;
+
+    for (;;)
+    {
+        EVL_Dispatch();
+
+        u32Old = evl_lock();
+        if (s_u32ReadyMask == 0)
+        {
+            if (s_pfnIdleHook != NULL)
+                s_pfnIdleHook();
+            else
+                evl_wait_for_interrupt();
+        }
+        evl_unlock(u32Old);
+    }
+}
+
+/**
+  * @brief      Count one timer tick. Call it from the periodic timer interrupt handler.
+  * @return     None.
+  */
+void EVL_Tick(void)
+{
+    s_u32Ticks++;
+    EVL_Post(&s_sTickEvent);
+}
+
+/**
+  * @brief      Get the number of ticks counted by EVL_Tick().
+  * @return     Tick count.
+  */
+uint32_t EVL_GetTicks(void)
+{
+    return s_u32Ticks;
+}
+
+/**
+  * @brief      Initialize a stopped timer.
+  * @param[in]  psTimer     Timer to initialize.
+  * @param[in]  pfnFunc     Function called from the event loop when the timer expires.
+  * @param[in]  pvArg       Argument of the timer function.
+  * @return     None.
+  */
+void EVL_InitTimer(EVL_TIMER_T *psTimer, EVL_TIMER_FUNC_T pfnFunc, void *pvArg)
+{
+    memset(psTimer, 0, sizeof(EVL_TIMER_T));
+    psTimer->pfnFunc = pfnFunc;
+    psTimer->pvArg = pvArg;
+}
+
+/**
+  * @brief      Start or restart a timer. Call it from the event loop, not from interrupt handlers.
+  * @param[in]  psTimer     Timer initialized by EVL_InitTimer().
+  * @param[in]  u32Ticks    Ticks to the first expiry, at least 1.
+  * @param[in]  u32Period   Ticks between later expiries, or 0 for a one-shot timer.
+  * @return     EVL_OK, or EVL_ERR_PARAM.
+  */
+int32_t EVL_StartTimer(EVL_TIMER_T *psTimer, uint32_t u32Ticks, uint32_t u32Period)
+{
+    if ((psTimer == NULL) || (psTimer->pfnFunc == NULL) || (u32Ticks == 0))
+        return EVL_ERR_PARAM;
+
+    if (psTimer->u8Active)
+        evl_wheel_remove(psTimer);
+    psTimer->u32Expire = s_u32TimerNow + u32Ticks;
+    psTimer->u32Period = u32Period;
+    evl_wheel_insert(psTimer);
+    return EVL_OK;
+}
+
+/**
+  * @brief      Stop a timer. Stopping a stopped timer does nothing.
+  * @param[in]  psTimer     Timer to stop.
+  * @return     None.
+  */
+void EVL_StopTimer(EVL_TIMER_T *psTimer)
+{
+    if (psTimer->u8Active)
+        evl_wheel_remove(psTimer);
+}
+
+/**
+  * @brief      Initialize a work queue.
+  * @param[in]  psQ         Work queue to initialize.
+  * @param[in]  psItems     Storage for u32Length work items.
+  * @param[in]  u32Length   Number of items the queue can hold.
+  * @param[in]  u32Priority Priority of the queued work, 0 to EVL_PRIORITY_MAX.
+  * @return     EVL_OK, or EVL_ERR_PARAM.
+  */
+int32_t EVL_WorkQInit(EVL_WORKQ_T *psQ, EVL_WORK_T *psItems, uint32_t u32Length, uint32_t u32Priority)
+{
+    if ((psQ == NULL) || (psItems == NULL) || (u32Length == 0))
+        return EVL_ERR_PARAM;
+
+    psQ->psItems = psItems;
+    psQ->u32Length = u32Length;
+    psQ->u32Head = 0;
+    psQ->u32Tail = 0;
+    psQ->u32Count = 0;
+    psQ->u32MaxCount = 0;
+    return EVL_InitEvent(&psQ->sEvent, evl_workq_handler, psQ, u32Priority);
+}
+
+/**
+  * @brief      Queue a work item. Can be called from interrupt handlers and event handlers.
+  * @param[in]  psQ         Work queue.
+  * @param[in]  pfnFunc     Work function.
+  * @param[in]  pvArg       Argument of the work function.
+  * @return     EVL_OK, or EVL_ERR_FULL when the queue holds u32Length items.
+  */
+int32_t EVL_WorkQPut(EVL_WORKQ_T *psQ, EVL_WORK_FUNC_T pfnFunc, void *pvArg)
+{
+    uint32_t u32Old;
+
+    u32Old = evl_lock();
+    if (psQ->u32Count == psQ->u32Length)
+    {
+        evl_unlock(u32Old);
+        return EVL_ERR_FULL;
+    }
+    psQ->psItems[psQ->u32Head].pfnFunc = pfnFunc;
+    psQ->psItems[psQ->u32Head].pvArg = pvArg;
+    if (++psQ->u32Head == psQ->u32Length)
+        psQ->u32Head = 0;
+    if (++psQ->u32Count > psQ->u32MaxCount)
+        psQ->u32MaxCount = psQ->u32Count;
+    evl_unlock(u32Old);
+
+    EVL_Post(&psQ->sEvent);
+    return EVL_OK;
+}
+
+/**
+  * @brief      Get the highest number of items the work queue has held, to size it.
+  * @param[in]  psQ         Work queue.
+  * @return     Highest item count.
+  */
+uint32_t EVL_WorkQGetMaxCount(EVL_WORKQ_T *psQ)
+{
+    return psQ->u32MaxCount;
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
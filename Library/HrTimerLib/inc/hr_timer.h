@@ -0,0 +1,111 @@
+/**************************************************************************//**
+ * @file     hr_timer.h
+ * @brief    Microsecond software timers multiplexed onto one ETIMER channel.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _HR_TIMER_H_
+#define  _HR_TIMER_H_
+
+#include <stdint.h>
+#include "nuc980.h"
+#include "sys.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup HRT_Library High Resolution Timer Library
+  @{
+*/
+
+/** @addtogroup HRT_EXPORTED_CONSTANTS High Resolution Timer Exported Constants
+  @{
+*/
+
+#ifndef HRT_MAX_TIMERS
+#define HRT_MAX_TIMERS              256    /*!< Timers that can run at the same time                    */
+#endif
+
+#define HRT_FLAG_DEFERRED           0x1    /*!< Call the timer function from HRT_RunDeferred()          */
+
+#define HRT_OK                      0      /*!< Success.                                                */
+#define HRT_ERR_PARAM               -1     /*!< Invalid ETIMER, timer or parameters.                    */
+#define HRT_ERR_FULL                -2     /*!< HRT_MAX_TIMERS timers are already running.              */
+#define HRT_ERR_NOT_INIT            -3     /*!< HRT_Init() was not called.                              */
+
+/*@}*/ /* end of group HRT_EXPORTED_CONSTANTS */
+
+/** @addtogroup HRT_EXPORTED_STRUCTS High Resolution Timer Exported Structs
+  @{
+*/
+
+struct HRT_TIMER;
+
+/**
+  * @brief  Timer function. Called from the ETIMER interrupt handler, or from HRT_RunDeferred()
+  *         for a timer with HRT_FLAG_DEFERRED. It may start and stop any timer.
+  */
+typedef void (*HRT_FUNC_T)(struct HRT_TIMER *psTimer, void *pvArg);
+
+/**
+  * @brief  Software timer. The caller owns the structure, which must stay valid while the
+  *         timer runs.
+  */
+typedef struct HRT_TIMER
+{
+    HRT_FUNC_T pfnFunc;             /*!< Timer function, set by HRT_InitTimer()       */
+    void     *pvArg;                /*!< Argument of the timer function               */
+    uint32_t  u32Flags;             /*!< HRT_FLAG_xxx                                 */
+    uint32_t  u32Overruns;          /*!< Expiries merged into a pending deferred call  */
+
+    /* private to the library */
+    uint64_t  u64Expire;
+    uint32_t  u32Period;
+    uint32_t  u32Index;
+    uint8_t   u8Pending;
+    struct HRT_TIMER *psNextPending;
+} HRT_TIMER_T;
+
+/*@}*/ /* end of group HRT_EXPORTED_STRUCTS */
+
+/** @addtogroup HRT_EXPORTED_FUNCTIONS High Resolution Timer Exported Functions
+  @{
+*/
+
+int32_t  HRT_Init(uint32_t u32Timer);
+void     HRT_Close(void);
+uint64_t HRT_GetTime(void);
+void     HRT_Delay(uint32_t u32Us);
+
+void     HRT_InitTimer(HRT_TIMER_T *psTimer, HRT_FUNC_T pfnFunc, void *pvArg, uint32_t u32Flags);
+int32_t  HRT_Start(HRT_TIMER_T *psTimer, uint32_t u32DelayUs, uint32_t u32PeriodUs);
+int32_t  HRT_StartAt(HRT_TIMER_T *psTimer, uint64_t u64Time, uint32_t u32PeriodUs);
+void     HRT_Stop(HRT_TIMER_T *psTimer);
+int32_t  HRT_IsActive(HRT_TIMER_T *psTimer);
+
+void     HRT_SetDeferHook(void (*pfnHook)(void));
+uint32_t HRT_RunDeferred(void);
+
+uint32_t HRT_GetActiveCount(void);
+uint32_t HRT_GetMaxLateness(void);
+
+/*@}*/ /* end of group HRT_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group HRT_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HR_TIMER_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
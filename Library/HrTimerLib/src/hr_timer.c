@@ -0,0 +1,544 @@
+/**************************************************************************//**
+ * @file     hr_timer.c
+ * @brief    Microsecond software timers multiplexed onto one ETIMER channel.
+ *
+ *           One ETIMER runs in continuous mode at 1 MHz from the 12 MHz
+ *           crystal. Its 24-bit counter never restarts, so it is both the
+ *           time base, extended to 64 bits in software, and, through the
+ *           compare register, the alarm for the earliest running timer. The
+ *           counter wraps every 16.7 s; the alarm is never set more than half
+ *           of that ahead, so the extension sees every wrap.
+ *
+ *           Running timers are kept in a binary min-heap ordered by expiry
+ *           time, each timer holding its own heap index, so starting,
+ *           stopping and expiring a timer costs O(log n) whatever the number
+ *           of timers.
+ *
+ *           Timer functions run in the interrupt handler, or, with
+ *           HRT_FLAG_DEFERRED, are queued for HRT_RunDeferred(), which the
+ *           application calls from a task or event loop woken by the hook set
+ *           with HRT_SetDeferHook().
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "hr_timer.h"
+#include "etimer.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#define HRT_TIMER_NUM       6
+#define HRT_COUNTER_MASK    0xFFFFFFul
+#define HRT_MAX_SLEEP       0x800000ul      /* half the counter range, in us */
+#define HRT_MIN_DELTA       3ul             /* us from now the alarm is set at least */
+#define HRT_PRESCALE        11ul            /* 12 MHz / (11 + 1) = 1 MHz */
+
+/* Register offsets from the base of an ETIMER */
+#define HRT_CTL             0x00
+#define HRT_PRECNT          0x04
+#define HRT_CMPR            0x08
+#define HRT_IER             0x0C
+#define HRT_ISR             0x10
+#define HRT_DR              0x14
+
+static const uint32_t s_au32Base[HRT_TIMER_NUM] = { ETMR0_BA, ETMR1_BA, ETMR2_BA, ETMR3_BA, ETMR4_BA, ETMR5_BA };
+static const IRQn_Type s_aeIrq[HRT_TIMER_NUM] = { IRQ_TIMER0, IRQ_TIMER1, IRQ_TIMER2, IRQ_TIMER3, IRQ_TIMER4, IRQ_TIMER5 };
+
+static int32_t s_i32Timer = -1;
+static uint32_t s_u32Base;
+static uint64_t s_u64Now;               /* time of s_u32LastCount, in us */
+static uint32_t s_u32LastCount;
+
+static HRT_TIMER_T *s_apsHeap[HRT_MAX_TIMERS];
+static uint32_t s_u32Count;
+
+static HRT_TIMER_T *s_psPendingHead, *s_psPendingTail;
+static void (*s_pfnDeferHook)(void);
+static uint32_t s_u32MaxLateness;
+
+static uint32_t hrt_lock(void)
+{
+    uint32_t u32Old, u32New;
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" mrs %0, cpsr" : "=r" (u32Old) :  );
+    u32New = u32Old | DISABLE_FIQ_IRQ;
+    asm volatile (" msr cpsr_c, %0" :  : "r" (u32New) : "memory");
+
+#else
+    __asm
+    {
+        MRS    u32Old, CPSR
+        ORR    u32New, u32Old, DISABLE_FIQ_IRQ
+        MSR    CPSR_c, u32New
+    }
+#endif
+    return u32Old;
+}
+
+static void hrt_unlock(uint32_t u32Old)
+{
+#if defined ( __GNUC__ ) && !(__CC_ARM)
+
+    asm volatile (" msr cpsr_c, %0" :  : "r" (u32Old) : "memory");
+
+#else
+    __asm
+    {
+        MSR    CPSR_c, u32Old
+    }
+#endif
+}
+
+/* Extend the counter to 64 bits. Called locked, at least once per counter wrap. */
+static uint64_t hrt_now(void)
+{
+    uint32_t u32Count = inpw(s_u32Base + HRT_DR) & HRT_COUNTER_MASK;
+
+    s_u64Now += (u32Count - s_u32LastCount) & HRT_COUNTER_MASK;
+    s_u32LastCount = u32Count;
+    return s_u64Now;
+}
+
+static void hrt_heap_set(uint32_t u32Pos, HRT_TIMER_T *psTimer)
+{
+    s_apsHeap[u32Pos] = psTimer;
+    psTimer->u32Index = u32Pos + 1;
+}
+
+static void hrt_heap_up(uint32_t u32Pos)
+{
+    HRT_TIMER_T *psTimer = s_apsHeap[u32Pos];
+    uint32_t u32Parent;
+
+    while (u32Pos > 0)
+    {
+        u32Parent = (u32Pos - 1) / 2;
+        if (s_apsHeap[u32Parent]->u64Expire <= psTimer->u64Expire)
+            break;
+        hrt_heap_set(u32Pos, s_apsHeap[u32Parent]);
+        u32Pos = u32Parent;
+    }
+    hrt_heap_set(u32Pos, psTimer);
+}
+
+static void hrt_heap_down(uint32_t u32Pos)
+{
+    HRT_TIMER_T *psTimer = s_apsHeap[u32Pos];
+    uint32_t u32Child;
+
+    for (;;)
+    {
+        u32Child = u32Pos * 2 + 1;
+        if (u32Child >= s_u32Count)
+            break;
+        if ((u32Child + 1 < s_u32Count) && (s_apsHeap[u32Child + 1]->u64Expire < s_apsHeap[u32Child]->u64Expire))
+            u32Child++;
+        if (psTimer->u64Expire <= s_apsHeap[u32Child]->u64Expire)
+            break;
+        hrt_heap_set(u32Pos, s_apsHeap[u32Child]);
+        u32Pos = u32Child;
+    }
+    hrt_heap_set(u32Pos, psTimer);
+}
+
+static void hrt_heap_insert(HRT_TIMER_T *psTimer)
+{
+    hrt_heap_set(s_u32Count, psTimer);
+    hrt_heap_up(s_u32Count++);
+}
+
+static void hrt_heap_remove(HRT_TIMER_T *psTimer)
+{
+    uint32_t u32Pos = psTimer->u32Index - 1;
+    HRT_TIMER_T *psLast = s_apsHeap[--s_u32Count];
+
+    psTimer->u32Index = 0;
+    if (psLast == psTimer)
+        return;
+
+    hrt_heap_set(u32Pos, psLast);
+    if ((u32Pos > 0) && (psLast->u64Expire < s_apsHeap[(u32Pos - 1) / 2]->u64Expire))
+        hrt_heap_up(u32Pos);
+    else
+        hrt_heap_down(u32Pos);
+}
+
+/*
+ *  Set the compare register to the expiry of the first timer, at least HRT_MIN_DELTA and at
+ *  most HRT_MAX_SLEEP from now. The counter is read back: if it already went past the value
+ *  written the match was missed and a later one is set, so the interrupt always comes.
+ *  Called locked.
+ */
+static void hrt_program(void)
+{
+    uint64_t u64Now, u64Target, u64Delta;
+    uint32_t u32Cmp;
+
+    u64Now = hrt_now();
+    for (;;)
+    {
+        u64Delta = HRT_MAX_SLEEP;
+        if (s_u32Count != 0)
+        {
+            if (s_apsHeap[0]->u64Expire <= u64Now + HRT_MIN_DELTA)
+                u64Delta = HRT_MIN_DELTA;
+            else if (s_apsHeap[0]->u64Expire - u64Now < HRT_MAX_SLEEP)
+                u64Delta = s_apsHeap[0]->u64Expire - u64Now;
+        }
+        u64Target = u64Now + u64Delta;
+
+        /* The compare register takes 2 to 0xFFFFFF; a match at 0 or 1 comes at 2 instead. */
+        u32Cmp = (uint32_t)u64Target & HRT_COUNTER_MASK;
+        if (u32Cmp < 2)
+        {
+            u64Target += 2 - u32Cmp;
+            u32Cmp = 2;
+        }
+        outpw(s_u32Base + HRT_CMPR, u32Cmp);
+
+        u64Now = hrt_now();
+        if (u64Now < u64Target)
+            break;
+    }
+}
+
+static void hrt_pending_remove(HRT_TIMER_T *psTimer)
+{
+    HRT_TIMER_T **ppsLink = &s_psPendingHead;
+    HRT_TIMER_T *psPrev = NULL;
+
+    while (*ppsLink != NULL)
+    {
+        if (*ppsLink == psTimer)
+        {
+            *ppsLink = psTimer->psNextPending;
+            if (s_psPendingTail == psTimer)
+                s_psPendingTail = psPrev;
+            break;
+        }
+        psPrev = *ppsLink;
+        ppsLink = &psPrev->psNextPending;
+    }
+    psTimer->psNextPending = NULL;
+    psTimer->u8Pending = 0;
+}
+
+static void hrt_isr(void)
+{
+    HRT_TIMER_T *psTimer;
+    uint64_t u64Now;
+    uint32_t u32Old, u32Late;
+    BOOL bDeferred = FALSE;
+
+    outpw(s_u32Base + HRT_ISR, 0x1);
+
+    u32Old = hrt_lock();
+    u64Now = hrt_now();
+    while ((s_u32Count != 0) && (s_apsHeap[0]->u64Expire <= u64Now))
+    {
+        psTimer = s_apsHeap[0];
+        u32Late = (uint32_t)(u64Now - psTimer->u64Expire);
+        if (u32Late > s_u32MaxLateness)
+            s_u32MaxLateness = u32Late;
+
+        hrt_heap_remove(psTimer);
+        if (psTimer->u32Period != 0)
+        {
+            /* Keep the period phase, but skip the expiries missed by a long lateness. */
+            psTimer->u64Expire += psTimer->u32Period;
+            if (psTimer->u64Expire <= u64Now)
+                psTimer->u64Expire = u64Now + psTimer->u32Period;
+            hrt_heap_insert(psTimer);
+        }
+
+        if (psTimer->u32Flags & HRT_FLAG_DEFERRED)
+        {
+            if (psTimer->u8Pending)
+            {
+                psTimer->u32Overruns++;
+            }
+            else
+            {
+                psTimer->u8Pending = 1;
+                psTimer->psNextPending = NULL;
+                if (s_psPendingHead == NULL)
+                    s_psPendingHead = psTimer;
+                else
+                    s_psPendingTail->psNextPending = psTimer;
+                s_psPendingTail = psTimer;
+            }
+            bDeferred = TRUE;
+        }
+        else
+        {
+            hrt_unlock(u32Old);
+            psTimer->pfnFunc(psTimer, psTimer->pvArg);
+            u32Old = hrt_lock();
+            u64Now = hrt_now();
+        }
+    }
+    hrt_program();
+    hrt_unlock(u32Old);
+
+    if (bDeferred && (s_pfnDeferHook != NULL))
+        s_pfnDeferHook();
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/**
+  * @brief      Start the timer service on an ETIMER. All running timers are dropped.
+  * @param[in]  u32Timer    ETIMER number, 0 to 5. Its clock source is set to the 12 MHz crystal,
+  *                         its interrupt handler is installed and enabled.
+  * @return     HRT_OK, or HRT_ERR_PARAM.
+  */
+int32_t HRT_Init(uint32_t u32Timer)
+{
+    uint32_t u32Old;
+
+    if (u32Timer >= HRT_TIMER_NUM)
+        return HRT_ERR_PARAM;
+
+    if (s_i32Timer >= 0)
+        HRT_Close();
+
+    u32Old = hrt_lock();
+    s_i32Timer = (int32_t)u32Timer;
+    s_u32Base = s_au32Base[u32Timer];
+    s_u64Now = 0;
+    s_u32LastCount = 0;
+    memset(s_apsHeap, 0, sizeof(s_apsHeap));
+    s_u32Count = 0;
+    s_psPendingHead = s_psPendingTail = NULL;
+    s_u32MaxLateness = 0;
+
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << (8 + u32Timer)));
+    outpw(REG_CLK_DIVCTL8, inpw(REG_CLK_DIVCTL8) & ~(0x3 << (16 + u32Timer * 2)));
+
+    outpw(s_u32Base + HRT_CTL, 0);
+    outpw(s_u32Base + HRT_PRECNT, HRT_PRESCALE);
+    outpw(s_u32Base + HRT_CMPR, HRT_MAX_SLEEP);
+    outpw(s_u32Base + HRT_ISR, 0x1);
+    outpw(s_u32Base + HRT_IER, 0x1);
+    outpw(s_u32Base + HRT_CTL, ETIMER_CONTINUOUS_MODE | 0x1);
+    s_u32LastCount = inpw(s_u32Base + HRT_DR) & HRT_COUNTER_MASK;
+    hrt_unlock(u32Old);
+
+    sysInstallISR(IRQ_LEVEL_1, s_aeIrq[u32Timer], (PVOID)hrt_isr);
+    sysEnableInterrupt(s_aeIrq[u32Timer]);
+    return HRT_OK;
+}
+
+/**
+  * @brief      Stop the timer service and its ETIMER. Running timers are dropped.
+  * @return     None.
+  */
+void HRT_Close(void)
+{
+    uint32_t u32Old;
+
+    if (s_i32Timer < 0)
+        return;
+
+    sysDisableInterrupt(s_aeIrq[s_i32Timer]);
+    u32Old = hrt_lock();
+    outpw(s_u32Base + HRT_CTL, 0);
+    outpw(s_u32Base + HRT_IER, 0);
+    outpw(s_u32Base + HRT_ISR, 0x1);
+    while (s_u32Count != 0)
+        hrt_heap_remove(s_apsHeap[0]);
+    while (s_psPendingHead != NULL)
+        hrt_pending_remove(s_psPendingHead);
+    s_i32Timer = -1;
+    hrt_unlock(u32Old);
+}
+
+/**
+  * @brief      Get the time since HRT_Init().
+  * @return     Time in microseconds.
+  */
+uint64_t HRT_GetTime(void)
+{
+    uint64_t u64Now;
+    uint32_t u32Old;
+
+    if (s_i32Timer < 0)
+        return 0;
+
+    u32Old = hrt_lock();
+    u64Now = hrt_now();
+    hrt_unlock(u32Old);
+    return u64Now;
+}
+
+/**
+  * @brief      Busy wait.
+  * @param[in]  u32Us       Microseconds to wait.
+  * @return     None.
+  */
+void HRT_Delay(uint32_t u32Us)
+{
+    uint64_t u64End = HRT_GetTime() + u32Us;
+
+    while (HRT_GetTime() < u64End);
+}
+
+/**
+  * @brief      Initialize a stopped timer.
+  * @param[in]  psTimer     Timer to initialize.
+  * @param[in]  pfnFunc     Timer function.
+  * @param[in]  pvArg       Argument of the timer function.
+  * @param[in]  u32Flags    0, or \ref HRT_FLAG_DEFERRED.
+  * @return     None.
+  */
+void HRT_InitTimer(HRT_TIMER_T *psTimer, HRT_FUNC_T pfnFunc, void *pvArg, uint32_t u32Flags)
+{
+    memset(psTimer, 0, sizeof(HRT_TIMER_T));
+    psTimer->pfnFunc = pfnFunc;
+    psTimer->pvArg = pvArg;
+    psTimer->u32Flags = u32Flags;
+}
+
+/**
+  * @brief      Start or restart a timer at an absolute time. A deferred call still pending from
+  *             the previous run is dropped.
+  * @param[in]  psTimer     Timer initialized by HRT_InitTimer().
+  * @param[in]  u64Time     Time of the first expiry, as returned by HRT_GetTime(). A time in the
+  *                         past expires at once.
+  * @param[in]  u32PeriodUs Microseconds between later expiries, or 0 for a one-shot timer.
+  * @return     HRT_OK, HRT_ERR_PARAM, HRT_ERR_FULL or HRT_ERR_NOT_INIT.
+  */
+int32_t HRT_StartAt(HRT_TIMER_T *psTimer, uint64_t u64Time, uint32_t u32PeriodUs)
+{
+    uint32_t u32Old;
+
+    if ((psTimer == NULL) || (psTimer->pfnFunc == NULL))
+        return HRT_ERR_PARAM;
+    if (s_i32Timer < 0)
+        return HRT_ERR_NOT_INIT;
+
+    u32Old = hrt_lock();
+    if (psTimer->u32Index != 0)
+    {
+        hrt_heap_remove(psTimer);
+    }
+    else if (s_u32Count == HRT_MAX_TIMERS)
+    {
+        hrt_unlock(u32Old);
+        return HRT_ERR_FULL;
+    }
+
+    if (psTimer->u8Pending)
+        hrt_pending_remove(psTimer);
+
+    psTimer->u64Expire = u64Time;
+    psTimer->u32Period = u32PeriodUs;
+    hrt_heap_insert(psTimer);
+    if (s_apsHeap[0] == psTimer)
+        hrt_program();
+    hrt_unlock(u32Old);
+    return HRT_OK;
+}
+
+/**
+  * @brief      Start or restart a timer.
+  * @param[in]  psTimer     Timer initialized by HRT_InitTimer().
+  * @param[in]  u32DelayUs  Microseconds to the first expiry.
+  * @param[in]  u32PeriodUs Microseconds between later expiries, or 0 for a one-shot timer.
+  * @return     HRT_OK, HRT_ERR_PARAM, HRT_ERR_FULL or HRT_ERR_NOT_INIT.
+  */
+int32_t HRT_Start(HRT_TIMER_T *psTimer, uint32_t u32DelayUs, uint32_t u32PeriodUs)
+{
+    return HRT_StartAt(psTimer, HRT_GetTime() + u32DelayUs, u32PeriodUs);
+}
+
+/**
+  * @brief      Stop a timer, and drop its deferred call if one is pending.
+  * @param[in]  psTimer     Timer to stop. Stopping a stopped timer does nothing.
+  * @return     None.
+  */
+void HRT_Stop(HRT_TIMER_T *psTimer)
+{
+    uint32_t u32Old;
+
+    u32Old = hrt_lock();
+    if (psTimer->u32Index != 0)
+        hrt_heap_remove(psTimer);
+    if (psTimer->u8Pending)
+        hrt_pending_remove(psTimer);
+    hrt_unlock(u32Old);
+}
+
+/**
+  * @brief      Check if a timer is running.
+  * @param[in]  psTimer     Timer.
+  * @return     1 if the timer is running, otherwise 0.
+  */
+int32_t HRT_IsActive(HRT_TIMER_T *psTimer)
+{
+    return (psTimer->u32Index != 0) ? 1 : 0;
+}
+
+/**
+  * @brief      Set the function the interrupt handler calls after it queued deferred timer calls.
+  * @param[in]  pfnHook     Hook, e.g. posting an event or giving a task notification, or NULL.
+  * @return     None.
+  */
+void HRT_SetDeferHook(void (*pfnHook)(void))
+{
+    s_pfnDeferHook = pfnHook;
+}
+
+/**
+  * @brief      Call the functions of the expired timers with \ref HRT_FLAG_DEFERRED, in expiry order.
+  * @return     Number of timer functions called.
+  */
+uint32_t HRT_RunDeferred(void)
+{
+    HRT_TIMER_T *psTimer;
+    uint32_t u32Old, u32Count = 0;
+
+    for (;;)
+    {
+        u32Old = hrt_lock();
+        psTimer = s_psPendingHead;
+        if (psTimer == NULL)
+        {
+            hrt_unlock(u32Old);
+            break;
+        }
+        s_psPendingHead = psTimer->psNextPending;
+        if (s_psPendingHead == NULL)
+            s_psPendingTail = NULL;
+        psTimer->psNextPending = NULL;
+        psTimer->u8Pending = 0;
+        hrt_unlock(u32Old);
+
+        psTimer->pfnFunc(psTimer, psTimer->pvArg);
+        u32Count++;
+    }
+    return u32Count;
+}
+
+/**
+  * @brief      Get the number of running timers.
+  * @return     Running timers.
+  */
+uint32_t HRT_GetActiveCount(void)
+{
+    return s_u32Count;
+}
+
+/**
+  * @brief      Get the longest time from the expiry of a timer to the interrupt handler taking it,
+  *             deferred calls excluded.
+  * @return     Lateness in microseconds.
+  */
+uint32_t HRT_GetMaxLateness(void)
+{
+    return s_u32MaxLateness;
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
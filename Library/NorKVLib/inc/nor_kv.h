@@ -0,0 +1,161 @@
+/**************************************************************************//**
+ * @file     nor_kv.h
+ * @brief    Log-structured key-value store on NOR flash sectors.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef  _NOR_KV_H_
+#define  _NOR_KV_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup NORKV_Library NOR Key-Value Store Library
+  @{
+*/
+
+/** @addtogroup NORKV_EXPORTED_CONSTANTS NOR Key-Value Store Exported Constants
+  @{
+*/
+
+#define NORKV_OK                    0      /*!< No error.                                       */
+#define NORKV_ERR_NOT_FOUND         -1     /*!< Key does not exist.                             */
+#define NORKV_ERR_PARAM             -2     /*!< Invalid key, value length or geometry.          */
+#define NORKV_ERR_NO_SPACE          -3     /*!< All sectors hold live data, nothing to compact. */
+#define NORKV_ERR_INDEX_FULL        -4     /*!< RAM index has no free entry.                    */
+#define NORKV_ERR_BUF_SMALL         -5     /*!< Value does not fit in the caller buffer.        */
+#define NORKV_ERR_IO                -6     /*!< Flash read, program or erase failed.            */
+
+#define NORKV_MAX_KEY_LEN           32     /*!< Maximum key length in bytes.                    */
+#define NORKV_MAX_RECORD            512    /*!< Maximum record size (header + key + value).     */
+
+/*@}*/ /* end of group NORKV_EXPORTED_CONSTANTS */
+
+/** @addtogroup NORKV_EXPORTED_STRUCTS NOR Key-Value Store Exported Structs
+  @{
+*/
+
+/**
+  * @brief  Flash region the store lives in. All callbacks return 0 on success.
+  *         prog() is only called on erased (FFh) bytes, erase() with a sector address.
+  */
+typedef struct
+{
+    int32_t (*read)(void *pvCtx, uint32_t u32Addr, void *pvBuf, uint32_t u32Len);
+    int32_t (*prog)(void *pvCtx, uint32_t u32Addr, const void *pvBuf, uint32_t u32Len);
+    int32_t (*erase)(void *pvCtx, uint32_t u32Addr);
+    void     *pvCtx;                /*!< Passed to the callbacks                    */
+    uint32_t u32Base;               /*!< First flash address, sector aligned        */
+    uint32_t u32SectorSize;         /*!< Erase sector size                          */
+    uint32_t u32SectorCount;        /*!< Number of sectors, at least 2              */
+} NORKV_FLASH_T;
+
+/**
+  * @brief  One entry of the RAM hash index.
+  */
+typedef struct
+{
+    uint32_t u32Hash;
+    uint32_t u32Addr;               /*!< Record offset, bit 31 set for a deletion marker */
+    uint32_t u32Seq;                /*!< Write sequence of the record               */
+} NORKV_INDEX_T;
+
+/**
+  * @brief  Store statistics.
+  */
+typedef struct
+{
+    uint32_t u32Keys;               /*!< Live keys                                  */
+    uint32_t u32FreeSectors;        /*!< Erased sectors                             */
+    uint32_t u32LiveBytes;          /*!< Bytes of records still referenced          */
+    uint32_t u32UsedBytes;          /*!< Bytes written since the sectors were erased */
+    uint32_t u32Compactions;        /*!< Sectors reclaimed since mount              */
+    uint32_t u32Erases;             /*!< Sector erases since mount                  */
+} NORKV_STATS_T;
+
+/**
+  * @brief  Store instance. Fields are private to the library.
+  */
+typedef struct
+{
+    NORKV_FLASH_T sFlash;
+    NORKV_INDEX_T *psIndex;
+    uint32_t u32IndexSize;          /* power of 2 */
+    uint32_t u32Seq;                /* next record sequence */
+    uint32_t u32SectorSeq;          /* next sector sequence */
+    uint32_t u32Head;               /* sector being appended, or u32SectorCount if none */
+    uint32_t u32HeadOffset;         /* next free byte in the head sector */
+    uint32_t u32Tail;               /* oldest used sector */
+    uint32_t u32UsedSectors;
+    uint32_t u32GcSector;           /* sector being compacted, or u32SectorCount */
+    uint32_t u32GcOffset;
+    NORKV_STATS_T sStats;
+    uint8_t  au8Rec[NORKV_MAX_RECORD] __attribute__((aligned(4)));
+} NORKV_T;
+
+/*@}*/ /* end of group NORKV_EXPORTED_STRUCTS */
+
+/** @addtogroup NORKV_EXPORTED_FUNCTIONS NOR Key-Value Store Exported Functions
+  @{
+*/
+
+int32_t NORKV_Mount(NORKV_T *kv, const NORKV_FLASH_T *flash, NORKV_INDEX_T *index, uint32_t u32IndexSize);
+int32_t NORKV_Format(NORKV_T *kv, const NORKV_FLASH_T *flash, NORKV_INDEX_T *index, uint32_t u32IndexSize);
+int32_t NORKV_Set(NORKV_T *kv, const char *key, const void *value, uint32_t u32Len);
+int32_t NORKV_Get(NORKV_T *kv, const char *key, void *value, uint32_t u32BufSize, uint32_t *pu32Len);
+int32_t NORKV_Delete(NORKV_T *kv, const char *key);
+int32_t NORKV_Compact(NORKV_T *kv, uint32_t u32MaxRecords);
+int32_t NORKV_NeedCompact(NORKV_T *kv);
+void    NORKV_GetStats(NORKV_T *kv, NORKV_STATS_T *stats);
+
+/*@}*/ /* end of group NORKV_EXPORTED_FUNCTIONS */
+
+/** @addtogroup NORKV_SIM NOR Flash Simulator
+  RAM backed NOR flash with NOR program semantics (bits only go 1 to 0) and
+  operation counters. It has no hardware dependency and also builds on a host PC.
+  @{
+*/
+
+/**
+  * @brief  Simulated NOR flash.
+  */
+typedef struct
+{
+    uint8_t  *pu8Mem;
+    uint32_t u32Size;
+    uint32_t u32SectorSize;
+    uint32_t u32ReadBytes;          /*!< Bytes read                                 */
+    uint32_t u32ProgBytes;          /*!< Bytes programmed                           */
+    uint32_t u32ProgOps;            /*!< Program calls                              */
+    uint32_t u32EraseOps;           /*!< Sector erases                              */
+    uint32_t u32MaxSectorErase;     /*!< Highest erase count of one sector          */
+    uint32_t u32PowerFail;          /*!< If non zero, bytes left before a simulated power loss */
+    uint32_t u32Violations;         /*!< Programs of bytes that were not erased     */
+    uint32_t *pu32EraseCount;       /*!< Optional per-sector erase counters         */
+} NORKV_SIM_T;
+
+void NORKV_SimInit(NORKV_SIM_T *sim, uint8_t *pu8Mem, uint32_t u32Size, uint32_t u32SectorSize, uint32_t *pu32EraseCount);
+void NORKV_SimBind(NORKV_SIM_T *sim, NORKV_FLASH_T *flash);
+
+/*@}*/ /* end of group NORKV_SIM */
+
+/*@}*/ /* end of group NORKV_Library */
+
+/*@}*/ /* end of group Library */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NOR_KV_H_ */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
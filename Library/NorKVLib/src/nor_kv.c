@@ -0,0 +1,714 @@
+/**************************************************************************//**
+ * @file     nor_kv.c
+ * @brief    Log-structured key-value store on NOR flash sectors.
+ *
+ *           Records are appended to the head sector of a ring of sectors and
+ *           never rewritten in place. A RAM hash index maps each key to its
+ *           latest record and is rebuilt by scanning the sectors at mount.
+ *           Compaction reclaims the oldest (tail) sector by copying its live
+ *           records to the head and erasing it, so every sector is erased in
+ *           turn and wear is spread over the whole region.
+ *
+ *           Sector layout:  | magic | sector seq | record | record | ... | FFh |
+ *           Record layout:  | crc32 | seq | key len | flags | value len | key | value | pad |
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "nor_kv.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+#define SECTOR_MAGIC        0x31564B4EUL        /* "NKV1" */
+#define SECTOR_HDR_SIZE     8
+#define REC_HDR_SIZE        12
+#define REC_FLAG_DELETED    0x01
+
+#define SLOT_EMPTY          0xFFFFFFFFUL
+#define SLOT_DELETED        0xFFFFFFFEUL
+#define ADDR_TOMB           0x80000000UL        /* index entry of a deletion marker */
+#define ADDR_MASK           0x7FFFFFFFUL
+
+#define ALIGN4(x)           (((x) + 3) & ~3UL)
+
+typedef struct
+{
+    uint32_t u32Crc;
+    uint32_t u32Seq;
+    uint8_t  u8KeyLen;
+    uint8_t  u8Flags;
+    uint16_t u16ValLen;
+} REC_HDR_T;
+
+static const uint32_t s_au32Crc32Nibble[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t kv_crc32(const uint8_t *pu8, uint32_t u32Len)
+{
+    uint32_t u32Crc = 0xFFFFFFFF;
+
+    while(u32Len--)
+    {
+        u32Crc ^= *pu8++;
+        u32Crc = (u32Crc >> 4) ^ s_au32Crc32Nibble[u32Crc & 0xF];
+        u32Crc = (u32Crc >> 4) ^ s_au32Crc32Nibble[u32Crc & 0xF];
+    }
+    return ~u32Crc;
+}
+
+/* FNV-1a */
+static uint32_t kv_hash(const char *key, uint32_t u32KeyLen)
+{
+    uint32_t u32Hash = 0x811C9DC5;
+
+    while(u32KeyLen--)
+        u32Hash = (u32Hash ^ (uint8_t)*key++) * 0x01000193;
+    return u32Hash;
+}
+
+static int32_t kv_read(NORKV_T *kv, uint32_t u32Off, void *pvBuf, uint32_t u32Len)
+{
+    return kv->sFlash.read(kv->sFlash.pvCtx, kv->sFlash.u32Base + u32Off, pvBuf, u32Len) ? NORKV_ERR_IO : NORKV_OK;
+}
+
+static int32_t kv_prog(NORKV_T *kv, uint32_t u32Off, const void *pvBuf, uint32_t u32Len)
+{
+    return kv->sFlash.prog(kv->sFlash.pvCtx, kv->sFlash.u32Base + u32Off, pvBuf, u32Len) ? NORKV_ERR_IO : NORKV_OK;
+}
+
+static int32_t kv_erase(NORKV_T *kv, uint32_t u32Sector)
+{
+    kv->sStats.u32Erases++;
+    return kv->sFlash.erase(kv->sFlash.pvCtx, kv->sFlash.u32Base + u32Sector * kv->sFlash.u32SectorSize) ? NORKV_ERR_IO : NORKV_OK;
+}
+
+static uint32_t kv_rec_size(const REC_HDR_T *psHdr)
+{
+    return ALIGN4(REC_HDR_SIZE + psHdr->u8KeyLen + psHdr->u16ValLen);
+}
+
+static int32_t kv_is_blank(const uint8_t *pu8, uint32_t u32Len)
+{
+    while(u32Len--)
+    {
+        if(*pu8++ != 0xFF)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Read and validate the record at u32Off into au8Rec.
+ * Returns its size, 0 at the end of the written area, or -1 if the record is torn.
+ */
+static int32_t kv_load_record(NORKV_T *kv, uint32_t u32Off, uint32_t u32End)
+{
+    REC_HDR_T *psHdr = (REC_HDR_T *)kv->au8Rec;
+    uint32_t u32Size;
+
+    if(u32Off + REC_HDR_SIZE > u32End)
+        return 0;
+    if(kv_read(kv, u32Off, psHdr, REC_HDR_SIZE) != NORKV_OK)
+        return -1;
+    if(kv_is_blank(kv->au8Rec, REC_HDR_SIZE))
+        return 0;
+
+    u32Size = kv_rec_size(psHdr);
+    if((psHdr->u8KeyLen == 0) || (psHdr->u8KeyLen > NORKV_MAX_KEY_LEN) ||
+            (u32Size > NORKV_MAX_RECORD) || (u32Off + u32Size > u32End))
+        return -1;
+
+    if(kv_read(kv, u32Off + REC_HDR_SIZE, &kv->au8Rec[REC_HDR_SIZE], u32Size - REC_HDR_SIZE) != NORKV_OK)
+        return -1;
+    if(kv_crc32(&kv->au8Rec[4], REC_HDR_SIZE - 4 + psHdr->u8KeyLen + psHdr->u16ValLen) != psHdr->u32Crc)
+        return -1;
+
+    return (int32_t)u32Size;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* RAM hash index, linear probing                                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Compare the key with the key of the record at u32Addr. */
+static int32_t kv_key_equal(NORKV_T *kv, uint32_t u32Addr, const char *key, uint32_t u32KeyLen)
+{
+    uint8_t au8Buf[4 + NORKV_MAX_KEY_LEN];
+
+    if(kv_read(kv, u32Addr + 8, au8Buf, 4 + u32KeyLen) != NORKV_OK)
+        return 0;
+    return (au8Buf[0] == u32KeyLen) && (memcmp(&au8Buf[4], key, u32KeyLen) == 0);
+}
+
+/* Returns the slot holding key, or -1. *pi32Free receives the first reusable slot of the probe. */
+static int32_t kv_index_find(NORKV_T *kv, const char *key, uint32_t u32KeyLen, uint32_t u32Hash, int32_t *pi32Free)
+{
+    uint32_t u32Mask = kv->u32IndexSize - 1;
+    uint32_t i, u32Slot;
+    NORKV_INDEX_T *psEnt;
+
+    if(pi32Free)
+        *pi32Free = -1;
+
+    for(i = 0; i < kv->u32IndexSize; i++)
+    {
+        u32Slot = (u32Hash + i) & u32Mask;
+        psEnt = &kv->psIndex[u32Slot];
+
+        if(psEnt->u32Addr == SLOT_EMPTY)
+        {
+            if(pi32Free && (*pi32Free < 0))
+                *pi32Free = (int32_t)u32Slot;
+            return -1;
+        }
+        if(psEnt->u32Addr == SLOT_DELETED)
+        {
+            if(pi32Free && (*pi32Free < 0))
+                *pi32Free = (int32_t)u32Slot;
+            continue;
+        }
+        if((psEnt->u32Hash == u32Hash) && kv_key_equal(kv, psEnt->u32Addr & ADDR_MASK, key, u32KeyLen))
+            return (int32_t)u32Slot;
+    }
+    return -1;
+}
+
+static uint32_t kv_live_size(NORKV_T *kv, const NORKV_INDEX_T *psEnt)
+{
+    REC_HDR_T sHdr;
+
+    if(psEnt->u32Addr & ADDR_TOMB)
+        return 0;
+    if(kv_read(kv, psEnt->u32Addr, &sHdr, REC_HDR_SIZE) != NORKV_OK)
+        return 0;
+    return kv_rec_size(&sHdr);
+}
+
+/* Point key to the record at u32Addr unless the index already holds a newer one. */
+static int32_t kv_index_update(NORKV_T *kv, const REC_HDR_T *psHdr, const char *key, uint32_t u32Addr)
+{
+    uint32_t u32Hash = kv_hash(key, psHdr->u8KeyLen);
+    NORKV_INDEX_T *psEnt;
+    int32_t i32Slot, i32Free;
+
+    i32Slot = kv_index_find(kv, key, psHdr->u8KeyLen, u32Hash, &i32Free);
+    if(i32Slot >= 0)
+    {
+        psEnt = &kv->psIndex[i32Slot];
+        if(psEnt->u32Seq > psHdr->u32Seq)
+            return NORKV_OK;
+        kv->sStats.u32LiveBytes -= kv_live_size(kv, psEnt);
+        if(!(psEnt->u32Addr & ADDR_TOMB))
+            kv->sStats.u32Keys--;
+    }
+    else
+    {
+        if(i32Free < 0)
+            return NORKV_ERR_INDEX_FULL;
+        psEnt = &kv->psIndex[i32Free];
+        psEnt->u32Hash = u32Hash;
+    }
+
+    psEnt->u32Seq = psHdr->u32Seq;
+    if(psHdr->u8Flags & REC_FLAG_DELETED)
+    {
+        psEnt->u32Addr = u32Addr | ADDR_TOMB;
+    }
+    else
+    {
+        psEnt->u32Addr = u32Addr;
+        kv->sStats.u32Keys++;
+        kv->sStats.u32LiveBytes += kv_rec_size(psHdr);
+    }
+    return NORKV_OK;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* Sector ring                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+
+/* Check that a sector is erased from u32Off to its end. Returns 1 if blank, 0 if not, or an error. */
+static int32_t kv_sector_blank(NORKV_T *kv, uint32_t u32Sector, uint32_t u32Off)
+{
+    uint32_t u32SectorSize = kv->sFlash.u32SectorSize;
+    uint32_t u32Len, au32Buf[16];
+    int32_t i32Ret;
+
+    for(; u32Off < u32SectorSize; u32Off += u32Len)
+    {
+        u32Len = u32SectorSize - u32Off;
+        if(u32Len > sizeof(au32Buf))
+            u32Len = sizeof(au32Buf);
+        if((i32Ret = kv_read(kv, u32Sector * u32SectorSize + u32Off, au32Buf, u32Len)) != NORKV_OK)
+            return i32Ret;
+        if(!kv_is_blank((uint8_t *)au32Buf, u32Len))
+            return 0;
+    }
+    return 1;
+}
+
+/* Start a new head sector after the current one, erasing it first if it is not blank. */
+static int32_t kv_open_sector(NORKV_T *kv)
+{
+    uint32_t u32Sector, au32Hdr[2];
+    int32_t i32Ret;
+
+    if(kv->u32UsedSectors >= kv->sFlash.u32SectorCount)
+        return NORKV_ERR_NO_SPACE;
+
+    if(kv->u32UsedSectors == 0)
+        u32Sector = kv->u32Tail;
+    else
+        u32Sector = (kv->u32Head + 1) % kv->sFlash.u32SectorCount;
+
+    /* A sector whose erase was interrupted can read back as neither data nor blank */
+    if((i32Ret = kv_sector_blank(kv, u32Sector, 0)) < 0)
+        return i32Ret;
+    if((i32Ret == 0) && ((i32Ret = kv_erase(kv, u32Sector)) != NORKV_OK))
+        return i32Ret;
+
+    au32Hdr[0] = SECTOR_MAGIC;
+    au32Hdr[1] = kv->u32SectorSeq++;
+    if((i32Ret = kv_prog(kv, u32Sector * kv->sFlash.u32SectorSize, au32Hdr, SECTOR_HDR_SIZE)) != NORKV_OK)
+        return i32Ret;
+
+    if(kv->u32UsedSectors == 0)
+        kv->u32Tail = u32Sector;
+    kv->u32Head = u32Sector;
+    kv->u32HeadOffset = SECTOR_HDR_SIZE;
+    kv->u32UsedSectors++;
+    kv->sStats.u32FreeSectors--;
+
+    return NORKV_OK;
+}
+
+/*
+ * Make room for u32Size bytes in the head sector. User writes always leave one
+ * erased sector in reserve so that compaction can make progress.
+ */
+static int32_t kv_reserve(NORKV_T *kv, uint32_t u32Size, int32_t i32FromGc)
+{
+    uint32_t u32Tries = kv->sFlash.u32SectorCount;
+    int32_t i32Ret;
+
+    while((kv->u32UsedSectors == 0) || (kv->u32HeadOffset + u32Size > kv->sFlash.u32SectorSize))
+    {
+        if(!i32FromGc && (kv->sFlash.u32SectorCount - kv->u32UsedSectors <= 1))
+        {
+            if(u32Tries-- == 0)
+                return NORKV_ERR_NO_SPACE;
+            if((i32Ret = NORKV_Compact(kv, 0xFFFFFFFF)) < 0)
+                return i32Ret;
+            continue;
+        }
+        if((i32Ret = kv_open_sector(kv)) != NORKV_OK)
+            return i32Ret;
+    }
+    return NORKV_OK;
+}
+
+/* Append the record assembled in au8Rec. Returns its address in *pu32Addr. */
+static int32_t kv_append(NORKV_T *kv, uint32_t *pu32Addr)
+{
+    REC_HDR_T *psHdr = (REC_HDR_T *)kv->au8Rec;
+    uint32_t u32Size = kv_rec_size(psHdr);
+    uint32_t u32Addr = kv->u32Head * kv->sFlash.u32SectorSize + kv->u32HeadOffset;
+    int32_t i32Ret;
+
+    /* Program without the padding, it stays erased */
+    i32Ret = kv_prog(kv, u32Addr, kv->au8Rec, REC_HDR_SIZE + psHdr->u8KeyLen + psHdr->u16ValLen);
+    kv->u32HeadOffset += u32Size;
+    kv->sStats.u32UsedBytes += u32Size;
+    if(i32Ret != NORKV_OK)
+        return i32Ret;
+
+    *pu32Addr = u32Addr;
+    return NORKV_OK;
+}
+
+/* Build a new record in au8Rec, append it and index it. */
+static int32_t kv_write(NORKV_T *kv, const char *key, uint32_t u32KeyLen, const void *value, uint32_t u32Len, uint8_t u8Flags)
+{
+    REC_HDR_T *psHdr = (REC_HDR_T *)kv->au8Rec;
+    uint32_t u32Size = ALIGN4(REC_HDR_SIZE + u32KeyLen + u32Len);
+    uint32_t u32Addr;
+    int32_t i32Ret;
+
+    /* Compaction inside kv_reserve() uses au8Rec, build the record afterwards */
+    if((i32Ret = kv_reserve(kv, u32Size, 0)) != NORKV_OK)
+        return i32Ret;
+
+    psHdr->u32Seq = kv->u32Seq++;
+    psHdr->u8KeyLen = (uint8_t)u32KeyLen;
+    psHdr->u8Flags = u8Flags;
+    psHdr->u16ValLen = (uint16_t)u32Len;
+    memcpy(&kv->au8Rec[REC_HDR_SIZE], key, u32KeyLen);
+    if(u32Len)
+        memcpy(&kv->au8Rec[REC_HDR_SIZE + u32KeyLen], value, u32Len);
+    psHdr->u32Crc = kv_crc32(&kv->au8Rec[4], REC_HDR_SIZE - 4 + u32KeyLen + u32Len);
+
+    if((i32Ret = kv_append(kv, &u32Addr)) != NORKV_OK)
+        return i32Ret;
+
+    return kv_index_update(kv, psHdr, key, u32Addr);
+}
+
+static int32_t kv_check_key(const char *key, uint32_t *pu32KeyLen)
+{
+    uint32_t u32KeyLen;
+
+    if(key == NULL)
+        return NORKV_ERR_PARAM;
+    u32KeyLen = strlen(key);
+    if((u32KeyLen == 0) || (u32KeyLen > NORKV_MAX_KEY_LEN))
+        return NORKV_ERR_PARAM;
+    *pu32KeyLen = u32KeyLen;
+    return NORKV_OK;
+}
+
+static int32_t kv_init(NORKV_T *kv, const NORKV_FLASH_T *flash, NORKV_INDEX_T *index, uint32_t u32IndexSize)
+{
+    uint32_t i;
+
+    if((flash->u32SectorCount < 2) || (flash->u32SectorSize < SECTOR_HDR_SIZE + NORKV_MAX_RECORD) ||
+            (flash->u32SectorSize & 0x3F) || (u32IndexSize == 0) || (u32IndexSize & (u32IndexSize - 1)))
+        return NORKV_ERR_PARAM;
+
+    memset(kv, 0, sizeof(NORKV_T));
+    memcpy(&kv->sFlash, flash, sizeof(NORKV_FLASH_T));
+    kv->psIndex = index;
+    kv->u32IndexSize = u32IndexSize;
+    kv->u32GcSector = flash->u32SectorCount;
+    kv->u32Head = flash->u32SectorCount;
+    kv->sStats.u32FreeSectors = flash->u32SectorCount;
+
+    for(i = 0; i < u32IndexSize; i++)
+        index[i].u32Addr = SLOT_EMPTY;
+
+    return NORKV_OK;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup NORKV_Library NOR Key-Value Store Library
+  @{
+*/
+
+/** @addtogroup NORKV_EXPORTED_FUNCTIONS NOR Key-Value Store Exported Functions
+  @{
+*/
+
+/**
+  * @brief    Mount a store, rebuilding the RAM index from the flash content.
+  * @param[out] kv           Store instance.
+  * @param[in]  flash        Flash region and access callbacks.
+  * @param[in]  index        RAM index storage.
+  * @param[in]  u32IndexSize Number of index entries, a power of 2 larger than the expected number of keys.
+  * @return   NORKV_OK or a negative NORKV_ERR_xxx code.
+  * @details  Sectors without a valid header are treated as free. A torn record (power loss while
+  *           programming) ends the scan of its sector; if that is the newest sector, appending continues
+  *           in a fresh sector.
+  */
+int32_t NORKV_Mount(NORKV_T *kv, const NORKV_FLASH_T *flash, NORKV_INDEX_T *index, uint32_t u32IndexSize)
+{
+    uint32_t u32SectorSize = flash->u32SectorSize;
+    uint32_t u32Sector, u32Off, au32Hdr[2];
+    uint32_t u32MinSeq = 0xFFFFFFFF, u32MaxSeq = 0, u32HeadOffset = 0;
+    REC_HDR_T *psHdr;
+    int32_t i32Ret, i32Size, i32HeadTorn = 0, i32Torn;
+
+    if((i32Ret = kv_init(kv, flash, index, u32IndexSize)) != NORKV_OK)
+        return i32Ret;
+    psHdr = (REC_HDR_T *)kv->au8Rec;
+
+    for(u32Sector = 0; u32Sector < flash->u32SectorCount; u32Sector++)
+    {
+        if((i32Ret = kv_read(kv, u32Sector * u32SectorSize, au32Hdr, SECTOR_HDR_SIZE)) != NORKV_OK)
+            return i32Ret;
+        if(au32Hdr[0] != SECTOR_MAGIC)
+            continue;
+
+        i32Torn = 0;
+        u32Off = SECTOR_HDR_SIZE;
+        while((i32Size = kv_load_record(kv, u32Sector * u32SectorSize + u32Off, (u32Sector + 1) * u32SectorSize)) != 0)
+        {
+            if(i32Size < 0)
+            {
+                i32Torn = 1;
+                break;
+            }
+            if(psHdr->u32Seq >= kv->u32Seq)
+                kv->u32Seq = psHdr->u32Seq + 1;
+            if((i32Ret = kv_index_update(kv, psHdr, (const char *)&kv->au8Rec[REC_HDR_SIZE], u32Sector * u32SectorSize + u32Off)) != NORKV_OK)
+                return i32Ret;
+            u32Off += i32Size;
+        }
+        kv->sStats.u32UsedBytes += u32Off - SECTOR_HDR_SIZE;
+
+        kv->u32UsedSectors++;
+        kv->sStats.u32FreeSectors--;
+        if(au32Hdr[1] <= u32MinSeq)
+        {
+            u32MinSeq = au32Hdr[1];
+            kv->u32Tail = u32Sector;
+        }
+        if(au32Hdr[1] >= u32MaxSeq)
+        {
+            u32MaxSeq = au32Hdr[1];
+            kv->u32Head = u32Sector;
+            u32HeadOffset = u32Off;
+            i32HeadTorn = i32Torn;
+        }
+    }
+
+    if(kv->u32UsedSectors == 0)
+        return NORKV_OK;
+
+    kv->u32SectorSeq = u32MaxSeq + 1;
+    kv->u32HeadOffset = u32HeadOffset;
+
+    /* Appending is only safe on erased bytes, otherwise continue in a new sector */
+    if(i32HeadTorn)
+        kv->u32HeadOffset = u32SectorSize;
+    if((i32Ret = kv_sector_blank(kv, kv->u32Head, kv->u32HeadOffset)) < 0)
+        return i32Ret;
+    if(i32Ret == 0)
+        kv->u32HeadOffset = u32SectorSize;
+
+    return NORKV_OK;
+}
+
+/**
+  * @brief    Erase the whole region and mount an empty store.
+  * @param[out] kv           Store instance.
+  * @param[in]  flash        Flash region and access callbacks.
+  * @param[in]  index        RAM index storage.
+  * @param[in]  u32IndexSize Number of index entries, a power of 2.
+  * @return   NORKV_OK or a negative NORKV_ERR_xxx code.
+  */
+int32_t NORKV_Format(NORKV_T *kv, const NORKV_FLASH_T *flash, NORKV_INDEX_T *index, uint32_t u32IndexSize)
+{
+    uint32_t u32Sector;
+    int32_t i32Ret;
+
+    if((i32Ret = kv_init(kv, flash, index, u32IndexSize)) != NORKV_OK)
+        return i32Ret;
+
+    for(u32Sector = 0; u32Sector < flash->u32SectorCount; u32Sector++)
+    {
+        if((i32Ret = kv_erase(kv, u32Sector)) != NORKV_OK)
+            return i32Ret;
+    }
+
+    return NORKV_Mount(kv, flash, index, u32IndexSize);
+}
+
+/**
+  * @brief    Store a value.
+  * @param[in]  kv      Store instance.
+  * @param[in]  key     NUL terminated key, 1 to NORKV_MAX_KEY_LEN characters.
+  * @param[in]  value   Value data.
+  * @param[in]  u32Len  Value length, the record must fit in NORKV_MAX_RECORD.
+  * @return   NORKV_OK or a negative NORKV_ERR_xxx code.
+  * @details  Only one record is appended, nothing is erased unless the ring is full, in which case the
+  *           oldest sector is compacted first. Writing the value already stored is a no-op.
+  */
+int32_t NORKV_Set(NORKV_T *kv, const char *key, const void *value, uint32_t u32Len)
+{
+    uint32_t u32KeyLen, u32Hash;
+    REC_HDR_T sHdr;
+    int32_t i32Slot, i32Ret;
+
+    if((i32Ret = kv_check_key(key, &u32KeyLen)) != NORKV_OK)
+        return i32Ret;
+    if(ALIGN4(REC_HDR_SIZE + u32KeyLen + u32Len) > NORKV_MAX_RECORD)
+        return NORKV_ERR_PARAM;
+
+    /* Skip rewriting an unchanged value, counters and calibration data often are */
+    u32Hash = kv_hash(key, u32KeyLen);
+    i32Slot = kv_index_find(kv, key, u32KeyLen, u32Hash, NULL);
+    if((i32Slot >= 0) && !(kv->psIndex[i32Slot].u32Addr & ADDR_TOMB))
+    {
+        uint32_t u32Addr = kv->psIndex[i32Slot].u32Addr;
+
+        if((kv_read(kv, u32Addr, &sHdr, REC_HDR_SIZE) == NORKV_OK) && (sHdr.u16ValLen == u32Len) &&
+                (kv_read(kv, u32Addr + REC_HDR_SIZE + u32KeyLen, kv->au8Rec, u32Len) == NORKV_OK) &&
+                (memcmp(kv->au8Rec, value, u32Len) == 0))
+            return NORKV_OK;
+    }
+
+    return kv_write(kv, key, u32KeyLen, value, u32Len, 0);
+}
+
+/**
+  * @brief    Read a value.
+  * @param[in]  kv         Store instance.
+  * @param[in]  key        NUL terminated key.
+  * @param[out] value      Destination buffer.
+  * @param[in]  u32BufSize Size of the destination buffer.
+  * @param[out] pu32Len    Value length, may be NULL. Also set when NORKV_ERR_BUF_SMALL is returned.
+  * @return   NORKV_OK, NORKV_ERR_NOT_FOUND, NORKV_ERR_BUF_SMALL or another NORKV_ERR_xxx code.
+  */
+int32_t NORKV_Get(NORKV_T *kv, const char *key, void *value, uint32_t u32BufSize, uint32_t *pu32Len)
+{
+    uint32_t u32KeyLen, u32Addr;
+    REC_HDR_T sHdr;
+    int32_t i32Slot, i32Ret;
+
+    if((i32Ret = kv_check_key(key, &u32KeyLen)) != NORKV_OK)
+        return i32Ret;
+
+    i32Slot = kv_index_find(kv, key, u32KeyLen, kv_hash(key, u32KeyLen), NULL);
+    if((i32Slot < 0) || (kv->psIndex[i32Slot].u32Addr & ADDR_TOMB))
+        return NORKV_ERR_NOT_FOUND;
+
+    u32Addr = kv->psIndex[i32Slot].u32Addr;
+    if((i32Ret = kv_read(kv, u32Addr, &sHdr, REC_HDR_SIZE)) != NORKV_OK)
+        return i32Ret;
+    if(pu32Len)
+        *pu32Len = sHdr.u16ValLen;
+    if(sHdr.u16ValLen > u32BufSize)
+        return NORKV_ERR_BUF_SMALL;
+
+    return kv_read(kv, u32Addr + REC_HDR_SIZE + u32KeyLen, value, sHdr.u16ValLen);
+}
+
+/**
+  * @brief    Delete a key by appending a deletion marker.
+  * @param[in]  kv   Store instance.
+  * @param[in]  key  NUL terminated key.
+  * @return   NORKV_OK, NORKV_ERR_NOT_FOUND or another NORKV_ERR_xxx code.
+  */
+int32_t NORKV_Delete(NORKV_T *kv, const char *key)
+{
+    uint32_t u32KeyLen;
+    int32_t i32Slot, i32Ret;
+
+    if((i32Ret = kv_check_key(key, &u32KeyLen)) != NORKV_OK)
+        return i32Ret;
+
+    i32Slot = kv_index_find(kv, key, u32KeyLen, kv_hash(key, u32KeyLen), NULL);
+    if((i32Slot < 0) || (kv->psIndex[i32Slot].u32Addr & ADDR_TOMB))
+        return NORKV_ERR_NOT_FOUND;
+
+    return kv_write(kv, key, u32KeyLen, NULL, 0, REC_FLAG_DELETED);
+}
+
+/**
+  * @brief    Run a step of compaction on the oldest sector.
+  * @param[in]  kv             Store instance.
+  * @param[in]  u32MaxRecords  Maximum number of records to examine in this call.
+  * @return   1 if a sector was reclaimed, 0 if work remains or there is nothing to compact,
+  *           or a negative NORKV_ERR_xxx code.
+  * @details  Meant to be called from an idle loop or a low priority task so that writes rarely have to
+  *           compact synchronously. Live records are copied to the head keeping their sequence number,
+  *           so an interrupted compaction only leaves harmless duplicates. Deletion markers in the oldest
+  *           sector shadow nothing anymore and are dropped.
+  */
+int32_t NORKV_Compact(NORKV_T *kv, uint32_t u32MaxRecords)
+{
+    uint32_t u32SectorSize = kv->sFlash.u32SectorSize;
+    REC_HDR_T *psHdr = (REC_HDR_T *)kv->au8Rec;
+    uint32_t u32Base, u32Addr, u32NewAddr;
+    int32_t i32Size, i32Slot, i32Ret;
+    const char *key;
+
+    if(kv->u32GcSector == kv->sFlash.u32SectorCount)
+    {
+        /* The head is only compacted when it is the only sector that can be reclaimed */
+        if((kv->u32UsedSectors == 0) || ((kv->u32UsedSectors == 1) && (kv->sStats.u32FreeSectors > 1)))
+            return 0;
+        kv->u32GcSector = kv->u32Tail;
+        kv->u32GcOffset = SECTOR_HDR_SIZE;
+        if(kv->u32Tail == kv->u32Head)
+            kv->u32HeadOffset = u32SectorSize;
+    }
+    u32Base = kv->u32GcSector * u32SectorSize;
+
+    for(;;)
+    {
+        i32Size = kv_load_record(kv, u32Base + kv->u32GcOffset, u32Base + u32SectorSize);
+        if(i32Size <= 0)
+            break;
+        if(u32MaxRecords-- == 0)
+            return 0;
+
+        u32Addr = u32Base + kv->u32GcOffset;
+        key = (const char *)&kv->au8Rec[REC_HDR_SIZE];
+        i32Slot = kv_index_find(kv, key, psHdr->u8KeyLen, kv_hash(key, psHdr->u8KeyLen), NULL);
+
+        if((i32Slot >= 0) && ((kv->psIndex[i32Slot].u32Addr & ADDR_MASK) == u32Addr))
+        {
+            if(kv->psIndex[i32Slot].u32Addr & ADDR_TOMB)
+            {
+                kv->psIndex[i32Slot].u32Addr = SLOT_DELETED;
+            }
+            else
+            {
+                if((i32Ret = kv_reserve(kv, (uint32_t)i32Size, 1)) != NORKV_OK)
+                    return i32Ret;
+                if((i32Ret = kv_append(kv, &u32NewAddr)) != NORKV_OK)
+                    return i32Ret;
+                kv->psIndex[i32Slot].u32Addr = u32NewAddr;
+            }
+        }
+        kv->u32GcOffset += i32Size;
+    }
+
+    /* Whole sector examined, the rest is erased or torn */
+    if((i32Ret = kv_erase(kv, kv->u32GcSector)) != NORKV_OK)
+        return i32Ret;
+
+    kv->sStats.u32UsedBytes -= kv->u32GcOffset - SECTOR_HDR_SIZE;
+    kv->sStats.u32FreeSectors++;
+    kv->sStats.u32Compactions++;
+    kv->u32UsedSectors--;
+    kv->u32Tail = (kv->u32GcSector + 1) % kv->sFlash.u32SectorCount;
+    kv->u32GcSector = kv->sFlash.u32SectorCount;
+
+    return 1;
+}
+
+/**
+  * @brief    Check whether background compaction is worth running.
+  * @param[in]  kv   Store instance.
+  * @return   1 if a compaction is in progress, fewer than two sectors are free, or the stale data
+  *           exceeds one sector; 0 otherwise.
+  */
+int32_t NORKV_NeedCompact(NORKV_T *kv)
+{
+    if(kv->u32GcSector != kv->sFlash.u32SectorCount)
+        return 1;
+    if(kv->u32UsedSectors < 2)
+        return 0;
+    if(kv->sStats.u32FreeSectors < 2)
+        return 1;
+    return (kv->sStats.u32UsedBytes - kv->sStats.u32LiveBytes) > kv->sFlash.u32SectorSize;
+}
+
+/**
+  * @brief    Get store statistics.
+  * @param[in]  kv     Store instance.
+  * @param[out] stats  Copy of the statistics.
+  * @return   None
+  */
+void NORKV_GetStats(NORKV_T *kv, NORKV_STATS_T *stats)
+{
+    memcpy(stats, &kv->sStats, sizeof(NORKV_STATS_T));
+}
+
+/*@}*/ /* end of group NORKV_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group NORKV_Library */
+
+/*@}*/ /* end of group Library */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,132 @@
+/**************************************************************************//**
+ * @file     nor_kv_sim.c
+ * @brief    RAM backed NOR flash simulator for the key-value store.
+ *
+ *           Programming ANDs data into the array like a real NOR cell, so a
+ *           program over bytes that were not erased is detected and counted.
+ *           A power loss can be injected after a given number of programmed
+ *           bytes to exercise the mount recovery path.
+ *
+ * @note
+ * Copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+#include "nor_kv.h"
+
+/// @cond HIDDEN_SYMBOLS
+
+static int32_t sim_read(void *pvCtx, uint32_t u32Addr, void *pvBuf, uint32_t u32Len)
+{
+    NORKV_SIM_T *sim = (NORKV_SIM_T *)pvCtx;
+
+    if((u32Addr > sim->u32Size) || (u32Len > sim->u32Size - u32Addr))
+        return -1;
+
+    memcpy(pvBuf, &sim->pu8Mem[u32Addr], u32Len);
+    sim->u32ReadBytes += u32Len;
+    return 0;
+}
+
+static int32_t sim_prog(void *pvCtx, uint32_t u32Addr, const void *pvBuf, uint32_t u32Len)
+{
+    NORKV_SIM_T *sim = (NORKV_SIM_T *)pvCtx;
+    const uint8_t *pu8Src = (const uint8_t *)pvBuf;
+    uint32_t i;
+
+    if((u32Addr > sim->u32Size) || (u32Len > sim->u32Size - u32Addr))
+        return -1;
+
+    sim->u32ProgOps++;
+    for(i = 0; i < u32Len; i++)
+    {
+        if(sim->u32PowerFail)
+        {
+            if(--sim->u32PowerFail == 0)
+                return -1;
+        }
+        if(sim->pu8Mem[u32Addr + i] != 0xFF)
+            sim->u32Violations++;
+        sim->pu8Mem[u32Addr + i] &= pu8Src[i];
+        sim->u32ProgBytes++;
+    }
+    return 0;
+}
+
+static int32_t sim_erase(void *pvCtx, uint32_t u32Addr)
+{
+    NORKV_SIM_T *sim = (NORKV_SIM_T *)pvCtx;
+    uint32_t u32Sector = u32Addr / sim->u32SectorSize;
+
+    if((u32Addr % sim->u32SectorSize) || (u32Addr >= sim->u32Size))
+        return -1;
+
+    memset(&sim->pu8Mem[u32Addr], 0xFF, sim->u32SectorSize);
+    sim->u32EraseOps++;
+    if(sim->pu32EraseCount)
+    {
+        if(++sim->pu32EraseCount[u32Sector] > sim->u32MaxSectorErase)
+            sim->u32MaxSectorErase = sim->pu32EraseCount[u32Sector];
+    }
+    return 0;
+}
+
+/// @endcond HIDDEN_SYMBOLS
+
+/** @addtogroup Library Library
+  @{
+*/
+
+/** @addtogroup NORKV_Library NOR Key-Value Store Library
+  @{
+*/
+
+/** @addtogroup NORKV_SIM NOR Flash Simulator
+  @{
+*/
+
+/**
+  * @brief    Initialize a simulated flash. The memory starts erased.
+  * @param[out] sim            Simulator instance.
+  * @param[in]  pu8Mem         Backing memory of u32Size bytes.
+  * @param[in]  u32Size        Flash size, a multiple of u32SectorSize.
+  * @param[in]  u32SectorSize  Erase sector size.
+  * @param[in]  pu32EraseCount Array of u32Size / u32SectorSize erase counters, or NULL.
+  * @return   None
+  */
+void NORKV_SimInit(NORKV_SIM_T *sim, uint8_t *pu8Mem, uint32_t u32Size, uint32_t u32SectorSize, uint32_t *pu32EraseCount)
+{
+    memset(sim, 0, sizeof(NORKV_SIM_T));
+    sim->pu8Mem = pu8Mem;
+    sim->u32Size = u32Size;
+    sim->u32SectorSize = u32SectorSize;
+    sim->pu32EraseCount = pu32EraseCount;
+
+    memset(pu8Mem, 0xFF, u32Size);
+    if(pu32EraseCount)
+        memset(pu32EraseCount, 0, (u32Size / u32SectorSize) * sizeof(uint32_t));
+}
+
+/**
+  * @brief    Fill a flash descriptor covering the whole simulated flash.
+  * @param[in]  sim    Simulator instance.
+  * @param[out] flash  Flash descriptor for NORKV_Mount() or NORKV_Format().
+  * @return   None
+  */
+void NORKV_SimBind(NORKV_SIM_T *sim, NORKV_FLASH_T *flash)
+{
+    flash->read = sim_read;
+    flash->prog = sim_prog;
+    flash->erase = sim_erase;
+    flash->pvCtx = sim;
+    flash->u32Base = 0;
+    flash->u32SectorSize = sim->u32SectorSize;
+    flash->u32SectorCount = sim->u32Size / sim->u32SectorSize;
+}
+
+/*@}*/ /* end of group NORKV_SIM */
+
+/*@}*/ /* end of group NORKV_Library */
+
+/*@}*/ /* end of group Library */
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
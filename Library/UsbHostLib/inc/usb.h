@@ -325,6 +325,8 @@ extern UDEV_T * g_udev_list;
 
 extern volatile int _IsInUsbInterrupt;
 
+extern WAIT_FUNC   *g_wait_func;
+
 /*----------------------------------------------------------------------------------*/
 /*  USB stack exported functions                                                    */
 /*----------------------------------------------------------------------------------*/
@@ -83,6 +83,7 @@ extern "C"
 #define UMAS_ERR_CMD_STATUS         -1037  /*!< SCSI command status failed                      */
 #define UMAS_ERR_IVALID_PARM        -1038  /*!< Invalid parameter.                              */
 #define UMAS_ERR_DRIVE_NOT_FOUND    -1039  /*!< drive not found                                 */
+#define UMAS_ERR_NOT_SUPPORTED      -1040  /*!< Command not supported by the device.            */
 
 #define HID_RET_OK                  0      /*!< Return with no errors.                          */
 #define HID_RET_DEV_NOT_FOUND       -1081  /*!< HID device not found or removed.                */
@@ -126,6 +127,7 @@ extern "C"
 */
 struct udev_t;
 typedef void (CONN_FUNC)(struct udev_t *udev, int param);  /*!< device connect/disconnect callback function \hideinitializer */
+typedef void (WAIT_FUNC)(void);                            /*!< called while waiting for a transfer to complete \hideinitializer */
 
 struct line_coding_t;
 struct cdc_dev_t;
@@ -168,6 +170,7 @@ typedef enum image_format_e
 extern void usbh_core_init(void);
 extern int  usbh_pooling_hubs(void);
 extern void usbh_install_conn_callback(CONN_FUNC *conn_func, CONN_FUNC *disconn_func);
+extern void usbh_install_wait_callback(WAIT_FUNC *wait_func);
 extern void usbh_suspend(void);
 extern void usbh_resume(void);
 extern struct udev_t * usbh_find_device(char *hub_id, int port);
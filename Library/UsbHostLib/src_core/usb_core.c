@@ -25,6 +25,7 @@ HSUSBH_T   *_ehci;
 static UDEV_DRV_T *  _drivers[MAX_UDEV_DRIVER];
 
 static CONN_FUNC  *g_conn_func, *g_disconn_func;
+WAIT_FUNC  *g_wait_func;
 
 
 extern void EHCI_IRQHandler(void);
@@ -51,6 +52,7 @@ void  usbh_core_init()
 
     g_conn_func = NULL;
     g_disconn_func = NULL;
+    g_wait_func = NULL;
 
     usbh_hub_init();
 
@@ -91,6 +93,20 @@ void usbh_install_conn_callback(CONN_FUNC *conn_func, CONN_FUNC *disconn_func)
     g_disconn_func = disconn_func;
 }
 
+/**
+  * @brief    Install a function called over and over while a control or mass storage
+  *           transfer is waited for, instead of only polling the completion flag. A
+  *           cooperative scheduler can run other work from it, but that work must not
+  *           start another transfer on the same device.
+  *
+  * @param[in]  wait_func       Wait callback function, or NULL to just poll.
+  * @return      None.
+  */
+void usbh_install_wait_callback(WAIT_FUNC *wait_func)
+{
+    g_wait_func = wait_func;
+}
+
 static int  reset_device(UDEV_T *udev)
 {
     if (udev->parent == NULL)
@@ -300,6 +316,8 @@ int usbh_ctrl_xfer(UDEV_T *udev, uint8_t bmRequestType, uint8_t bRequest, uint16
             udev->ep0.hw_pipe = NULL;
             return USBH_ERR_TIMEOUT;
         }
+        if (g_wait_func)
+            g_wait_func();
     }
 
     status = utr->status;
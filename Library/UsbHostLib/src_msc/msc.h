@@ -78,7 +78,15 @@ struct bulk_cs_wrap
 #define READ_CAPACITY             0x25
 #define READ_10                   0x28
 #define WRITE_10                  0x2a
+#define UNMAP                     0x42
 #define MODE_SENSE_10             0x5a
+#define SERVICE_ACTION_IN_16      0x9e
+#define SAI_READ_CAPACITY_16      0x10   /* service action of SERVICE_ACTION_IN_16 */
+
+#define VPD_BLOCK_LIMITS          0xb0
+#define VPD_LBP                   0xb2   /* logical block provisioning    */
+
+#define SENSE_ILLEGAL_REQUEST     0x5
 
 #define SCSI_BUFF_LEN             36
 
@@ -97,6 +105,8 @@ typedef struct msc_t
     uint32_t    uTotalSectorN;
     uint32_t    nSectorSize;
     uint32_t    uDiskSize;
+    uint8_t     no_unmap;                /* device does not support UNMAP, do not send it */
+    uint32_t    max_unmap_lba;           /* most sectors in one UNMAP command             */
     int         drv_no;                  /* Logical drive number associated with this instance */
     FATFS       fatfs_vol;               /* FATFS volumn                                  */
     struct msc_t  *next;                 /* point to next MSC device                      */
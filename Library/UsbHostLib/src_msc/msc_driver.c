@@ -184,7 +184,8 @@ static int  msc_inquiry(MSC_T *msc)
     return ret;
 }
 
-static int  msc_request_sense(MSC_T *msc)
+/* Issue REQUEST SENSE. Returns the sense key, or a negative error code. */
+static int  msc_read_sense(MSC_T *msc)
 {
     struct bulk_cb_wrap  *cmd_blk = &msc->cmd_blk;
     uint8_t   *scsi_buff;
@@ -208,16 +209,24 @@ static int  msc_request_sense(MSC_T *msc)
             msc_reset(msc);
         return ret;
     }
-    else
+    msc_debug_msg("REQUEST_SENSE command success.\n");
+    return scsi_buff[2] & 0x0F;
+}
+
+static int  msc_request_sense(MSC_T *msc)
+{
+    int       ret;
+
+    ret = msc_read_sense(msc);
+    if (ret < 0)
+        return ret;
+
+    if (ret != 0x6)
     {
-        msc_debug_msg("REQUEST_SENSE command success.\n");
-        if (scsi_buff[2] != 0x6)
-        {
-            msc_debug_msg("Device is still not attention. 0x%x\n", scsi_buff[2]);
-            return -1;
-        }
+        msc_debug_msg("Device is still not attention. 0x%x\n", ret);
+        return -1;
     }
-    return ret;
+    return 0;
 }
 
 static int  msc_test_unit_ready(MSC_T *msc)
@@ -247,6 +256,145 @@ static int  msc_test_unit_ready(MSC_T *msc)
     return ret;
 }
 
+/* Run a command with data in, clearing the error state of the device if it fails. */
+static int  msc_data_in_command(MSC_T *msc, uint8_t *scsi_buff, uint32_t len)
+{
+    int       ret;
+
+    ret = run_scsi_command(msc, scsi_buff, len, 1, 100);
+    if (ret < 0)
+    {
+        if (ret == USBH_ERR_STALL)
+            msc_reset(msc);
+        msc_read_sense(msc);
+    }
+    return ret;
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/*
+ *  Decide once whether UNMAP may be sent. The device must report thin provisioning
+ *  (LBPME in READ CAPACITY(16)), UNMAP support (LBPU in the logical block provisioning
+ *  VPD page) and a non-zero UNMAP limit in the block limits VPD page.
+ */
+static void msc_probe_unmap(MSC_T *msc)
+{
+    struct bulk_cb_wrap  *cmd_blk = &msc->cmd_blk;
+    uint8_t   *scsi_buff;
+
+    msc->no_unmap = 1;
+    msc->max_unmap_lba = 0;
+    scsi_buff = (uint8_t *)((uint32_t)msc->scsi_buff | NON_CACHE_MASK);
+
+    memset(cmd_blk, 0, sizeof(*cmd_blk));
+    cmd_blk->Flags   = 0x80;
+    cmd_blk->Length  = 16;
+    cmd_blk->CDB[0]  = SERVICE_ACTION_IN_16;
+    cmd_blk->CDB[1]  = SAI_READ_CAPACITY_16;
+    cmd_blk->CDB[13] = 32;              /* allocation length          */
+    if (msc_data_in_command(msc, scsi_buff, 32) < 0)
+        return;
+    if ((scsi_buff[14] & 0x80) == 0)    /* LBPME                      */
+        return;
+
+    memset(cmd_blk, 0, sizeof(*cmd_blk));
+    cmd_blk->Flags   = 0x80;
+    cmd_blk->Length  = 6;
+    cmd_blk->CDB[0]  = INQUIRY;
+    cmd_blk->CDB[1]  = (msc->lun << 5) | 0x01;  /* EVPD               */
+    cmd_blk->CDB[2]  = VPD_LBP;
+    cmd_blk->CDB[4]  = 8;
+    if (msc_data_in_command(msc, scsi_buff, 8) < 0)
+        return;
+    if ((scsi_buff[1] != VPD_LBP) || ((scsi_buff[5] & 0x80) == 0))    /* LBPU */
+        return;
+
+    memset(cmd_blk, 0, sizeof(*cmd_blk));
+    cmd_blk->Flags   = 0x80;
+    cmd_blk->Length  = 6;
+    cmd_blk->CDB[0]  = INQUIRY;
+    cmd_blk->CDB[1]  = (msc->lun << 5) | 0x01;
+    cmd_blk->CDB[2]  = VPD_BLOCK_LIMITS;
+    cmd_blk->CDB[4]  = 28;
+    if (msc_data_in_command(msc, scsi_buff, 28) < 0)
+        return;
+    if (scsi_buff[1] != VPD_BLOCK_LIMITS)
+        return;
+
+    /* Zero in either field means UNMAP is not implemented, all ones means no limit. */
+    msc->max_unmap_lba = get_be32(&scsi_buff[20]);
+    if ((msc->max_unmap_lba == 0) || (get_be32(&scsi_buff[24]) == 0))
+        return;
+
+    msc->no_unmap = 0;
+    msc_debug_msg("UNMAP supported, %d sectors per command.\n", msc->max_unmap_lba);
+}
+
+static int  msc_unmap(MSC_T *msc, uint32_t sec_no, uint32_t sec_cnt)
+{
+    struct bulk_cb_wrap  *cmd_blk = &msc->cmd_blk;
+    uint8_t   *scsi_buff;
+    uint32_t  cnt;
+    int       ret;
+
+    if (msc->no_unmap)
+        return UMAS_ERR_NOT_SUPPORTED;
+
+    while (sec_cnt > 0)
+    {
+        cnt = (sec_cnt > msc->max_unmap_lba) ? msc->max_unmap_lba : sec_cnt;
+
+        msc_debug_msg("UNMAP %d, %d...\n", sec_no, cnt);
+        memset(cmd_blk, 0, sizeof(*cmd_blk));
+
+        cmd_blk->Flags   = 0;
+        cmd_blk->Length  = 10;
+        cmd_blk->CDB[0]  = UNMAP;
+        cmd_blk->CDB[8]  = 24;          /* parameter list length      */
+
+        /* UNMAP parameter list with a single block descriptor */
+        scsi_buff = (uint8_t *)((uint32_t)msc->scsi_buff | NON_CACHE_MASK);
+        memset(scsi_buff, 0, 24);
+        scsi_buff[1]  = 22;             /* UNMAP data length          */
+        scsi_buff[3]  = 16;             /* block descriptor length    */
+        scsi_buff[12] = (sec_no >> 24) & 0xFF;
+        scsi_buff[13] = (sec_no >> 16) & 0xFF;
+        scsi_buff[14] = (sec_no >> 8) & 0xFF;
+        scsi_buff[15] = sec_no & 0xFF;
+        scsi_buff[16] = (cnt >> 24) & 0xFF;
+        scsi_buff[17] = (cnt >> 16) & 0xFF;
+        scsi_buff[18] = (cnt >> 8) & 0xFF;
+        scsi_buff[19] = cnt & 0xFF;
+
+        ret = run_scsi_command(msc, scsi_buff, 24, 0, 500);
+        if (ret < 0)
+        {
+            msc_debug_msg("UNMAP command failed. [%d]\n", ret);
+            if (ret == USBH_ERR_STALL)
+                msc_reset(msc);
+            if ((ret == UMAS_ERR_CMD_STATUS) || (ret == USBH_ERR_STALL))
+            {
+                /* Stop sending UNMAP only if the device says it does not know it;
+                   other failures may be transient. */
+                if (msc_read_sense(msc) == SENSE_ILLEGAL_REQUEST)
+                {
+                    msc->no_unmap = 1;
+                    return UMAS_ERR_NOT_SUPPORTED;
+                }
+            }
+            return UMAS_ERR_IO;
+        }
+
+        sec_no += cnt;
+        sec_cnt -= cnt;
+    }
+    return 0;
+}
+
 /**
   * @brief       Read a number of contiguous sectors from mass storage device.
   *
@@ -353,6 +501,9 @@ int  usbh_umas_write(int drv_no, uint32_t sec_no, int sec_cnt, uint8_t *buff)
   * @retval      - \ref UMAS_OK              Mass storage device is ready.
   * @retval      - \ref UMAS_ERR_DRIVE_NOT_FOUND   There's no mass storage device mounted to this volume.
   * @retval      - \ref UMAS_ERR_IVALID_PARM       Failed to write disk.
+  * @retval      - \ref UMAS_ERR_NOT_SUPPORTED     CTRL_TRIM on a device without SCSI UNMAP support.
+  *
+  * @details     CTRL_TRIM takes the first and last sector of the range in buff[0] and buff[1].
   */
 int  usbh_umas_ioctl(int drv_no, int cmd, void *buff)
 {
@@ -379,8 +530,10 @@ int  usbh_umas_ioctl(int drv_no, int cmd, void *buff)
         *(uint32_t *)buff = msc->nSectorSize;
         return RES_OK;
 
-        //case CTRL_ERASE_SECTOR:
-        //    return RES_OK;
+    case CTRL_TRIM:
+        if (((DWORD *)buff)[1] < ((DWORD *)buff)[0])
+            return UMAS_ERR_IVALID_PARM;
+        return msc_unmap(msc, ((DWORD *)buff)[0], ((DWORD *)buff)[1] - ((DWORD *)buff)[0] + 1);
     }
     return UMAS_ERR_IVALID_PARM;
 }
@@ -499,6 +652,8 @@ disk_found:
         try_msc->nSectorSize = (scsi_buff[4] << 24) | (scsi_buff[5] << 16) |
                                (scsi_buff[6] << 8) | scsi_buff[7];
 
+        msc_probe_unmap(try_msc);
+
         try_msc->drv_no = fatfs_drive_alloc();
         if (try_msc->drv_no < 0)        /* should be failed, unless drive free slot is empty    */
         {
@@ -56,6 +56,8 @@ int msc_bulk_transfer(MSC_T *msc, EP_INFO_T *ep, uint8_t *data_buff, int data_le
             free_utr(utr);
             return USBH_ERR_TIMEOUT;
         }
+        if (g_wait_func)
+            g_wait_func();
     }
     ret = utr->status;
     free_utr(utr);
@@ -0,0 +1,489 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    mbedtls crypto throughput benchmark.
+ *
+ *           Times AES-128 ECB/CBC/CTR/GCM, SHA-1/256/512 and HMAC-SHA256 over
+ *           buffers of 16 bytes to 64 KB, and ECDSA sign/verify, ECDH and
+ *           RSA-2048 public/private operations on P-256 and a fixed key. Every
+ *           case runs for at least BENCH_MIN_USEC and the results are printed
+ *           as one CSV table. The engine column tells whether mbedtls was
+ *           built with the NUVOTON_ENABLE_xxx hook of that algorithm, and
+ *           sw-ct and ghash-ct mark the constant-time software AES and GHASH
+ *           of NUVOTON_AES_CT and NUVOTON_GCM_CT.
+ *
+ *           On the NUC980 ETIMER0 counts at 1 MHz and the CPU clock converts
+ *           the time to cycles. The benchmark_sw Keil target defines
+ *           NUVOTON_CRYPTO_SW_ONLY to get the software numbers and the
+ *           benchmark_ct target adds NUVOTON_AES_CT and NUVOTON_GCM_CT to
+ *           compare the constant-time code with the stock tables; with GCC,
+ *           add the defines to the project settings.
+ *
+ *           The same file builds on a Linux host for a software baseline:
+ *
+ *           gcc -O2 -DBENCH_CPU_MHZ=<host MHz> -I. -I../../../ThirdParty/mbedtls-2.13.0/include \
+ *               -DMBEDTLS_CONFIG_FILE='"mbedtls_host_config.h"' main.c \
+ *               ../../../ThirdParty/mbedtls-2.13.0/library/{aes,asn1parse,asn1write,bignum,cipher,cipher_wrap,ecdh,ecdsa,ecp,ecp_curves,gcm,md,md_wrap,oid,platform_util,rsa,rsa_internal,sha1,sha256,sha512,nvt_aes_ct}.c \
+ *               -o crypto_bench
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+#include "mbedtls/md.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/rsa.h"
+
+#if defined(__linux__)
+#include <time.h>
+#else
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#endif
+
+/*----------------------------------------------------------------------------*/
+/* Configuration */
+
+#ifndef BENCH_MIN_USEC
+#define BENCH_MIN_USEC      500000      /* shortest measuring window of a case */
+#endif
+#define BENCH_MAX_SIZE      65536
+
+#if defined(__linux__)
+#define BENCH_PLATFORM      "host"
+#define BENCH_TICK_MASK     0xFFFFFFFFUL
+#else
+#define BENCH_PLATFORM      "nuc980"
+#define BENCH_TICK_MASK     0x00FFFFFFUL    /* 24-bit ETIMER counter, wraps every 16 s */
+#endif
+
+#if defined(NUVOTON_ENABLE_AES)
+#define ENGINE_AES          "hw"
+#elif defined(NUVOTON_AES_CT)
+#define ENGINE_AES          "sw-ct"
+#else
+#define ENGINE_AES          "sw"
+#endif
+#if defined(NUVOTON_GCM_CT)
+#define ENGINE_GCM          ENGINE_AES "/ghash-ct"
+#else
+#define ENGINE_GCM          ENGINE_AES
+#endif
+#if defined(NUVOTON_ENABLE_SHA)
+#define ENGINE_SHA          "hw"
+#else
+#define ENGINE_SHA          "sw"
+#endif
+#if defined(NUVOTON_ENABLE_ECC)
+#define ENGINE_ECC          "hw"
+#else
+#define ENGINE_ECC          "sw"
+#endif
+#if defined(NUVOTON_ENABLE_RSA)
+#define ENGINE_RSA          "hw"
+#else
+#define ENGINE_RSA          "sw"
+#endif
+
+/*----------------------------------------------------------------------------*/
+/* Test key and buffers */
+
+#define RSA_N   \
+    "E4E0B2278E97FAF79149EB5D4CC81CC01DE946CC6A6338E6A39FB52ABA37CD5B" \
+    "FBBE739B89C5ECF4F252DDDE3A1E02580EBD998CDCCD5D8493E20E5F8578D40E" \
+    "E8524D3105687C8D23C394B753201F50316CA6FE34ABCAC60FC2A19D8A90EEE5" \
+    "6251CDD5910C210B372AF5DFFC72669642737E1C169F1239933D9E8539A67CBD" \
+    "C89CA88FF41598C918A7E3714B4C817B200DCEB24147124619A200F58FE7495D" \
+    "DFDDB64952AB1E56C6347046079D26518FF29D848A5E3A167C9CAF3EB5BEFF7D" \
+    "D2C59C552C9A5E15F070FA3025A7CBA1E44667E162CD09B196E7CBFE8058DAE7" \
+    "C55E3FE701301DB13F743A8A5887A0C24502899040F4AFFD2DBD99FE8CBF868B"
+
+#define RSA_D   \
+    "33E24DF092AE1839D3E93E5E35A02D884D9F8AA99F3A63F540C55D13D507FE59" \
+    "2A3DD7C63C1AAEA72E61A3A31368A71E602511F071436ABE39A9E69937D016BE" \
+    "546307D5A384B6AB661E99915F5A2A4F0B0D36E3EC7BBF295BFC4297CC882367" \
+    "C37C88DD2F96E0CCC2924E0F9B1231F841131E54EEB9DBAF4A960EDFE39C3EAD" \
+    "774AC9B8989A9BD930DD6C297D14B9B99355D1B1E653C4C64B66765145508A73" \
+    "36D8DEA510F6083DB39FDAD0E991796C306AD0437398B851324CEFDAA6B328F2" \
+    "DA78FAE9E4D852A5586A6BCB0D5ECCF7A07A1CB9CDACB87807C6366FAF9957D8" \
+    "57EB47D2541852C6808A78F5F806A0BC37A77708147C7C0EB1B8932574546A95"
+
+#define RSA_P   \
+    "F86B4BF1CCB28126C7B918320F27AFB9DF80A6FBF3F1269935401699AF0EBF7C" \
+    "0713D09D3D67E12BE767B73ACE10A01FF397511B6602471DAC783FE6187B449F" \
+    "A02EDE2E4BF3D29BA8065F2EE6564075A4E732AD3BC392C289B561461DF3D429" \
+    "11EEBC8FB24C288734E673567747E4F1D8E04481946F52875E513D3F6D379E9D"
+
+#define RSA_Q   \
+    "EBDCBCD2C5F716048A6C7D1EF05B1E841F5048C68F44E4E4C78EF00A91B2360E" \
+    "1C064B338E2EE05CF4BE393977B242E9183E18B85FFC6276158A3A3A7E2166F7" \
+    "ACFEEAF924013C052F5FDBA87120F651D497BB791F93479ECF0E502F7AB7670E" \
+    "A8C22F8AD4F2F389F24669EDF22D60A97F916017C12E30A9EE47C197F069DD47"
+
+#define RSA_E   "10001"
+
+static const size_t s_au32Sizes[] = { 16, 64, 256, 1024, 4096, 16384, 65536 };
+
+/* 32-byte aligned so that the AES and SHA hooks can DMA them directly */
+static uint8_t s_au8In[BENCH_MAX_SIZE] __attribute__((aligned (32)));
+static uint8_t s_au8Out[BENCH_MAX_SIZE + 32] __attribute__((aligned (32)));
+
+static mbedtls_aes_context  s_aes;
+static mbedtls_gcm_context  s_gcm;
+static mbedtls_ecp_group    s_grp;
+static mbedtls_mpi          s_d, s_r, s_s, s_z;
+static mbedtls_ecp_point    s_Q;
+static mbedtls_rsa_context  s_rsa;
+static const mbedtls_md_info_t *s_psMdSha256;
+
+static uint32_t s_u32CpuMHz;
+
+#if !defined(__linux__)
+volatile int  g_Crypto_Int_done = 0;
+#endif
+
+/*----------------------------------------------------------------------------*/
+/* Platform */
+
+#if defined(__linux__)
+
+static void bench_timer_init(void)
+{
+#ifdef BENCH_CPU_MHZ
+    s_u32CpuMHz = BENCH_CPU_MHZ;
+#endif
+}
+
+static uint32_t bench_timer_read(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+#else
+
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+static void bench_timer_init(void)
+{
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Free running 24-bit counter at 12 MHz / 12
+    ETIMER_Open(0, ETIMER_CONTINUOUS_MODE, 1000000);
+    ETIMER_SET_PRESCALE_VALUE(0, 11);
+    ETIMER_SET_CMP_VALUE(0, 0xFFFFFF);
+    ETIMER_Start(0);
+
+    s_u32CpuMHz = sysGetClock(SYS_CPU);
+}
+
+static uint32_t bench_timer_read(void)
+{
+    return ETIMER_GetCounter(0);
+}
+
+#endif
+
+/*
+ *  Not a secure generator. The benchmark only needs blinding and nonce
+ *  values, and must not depend on an entropy source.
+ */
+static int bench_rng(void *pvCtx, unsigned char *pu8Out, size_t len)
+{
+    static uint32_t x = 0x12345678;
+
+    (void)pvCtx;
+    while (len--)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *pu8Out++ = (unsigned char)x;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Cases. Each runs one operation on len bytes and returns 0 on success. */
+
+static int bench_aes_ecb(size_t len)
+{
+    size_t  i;
+    int     ret = 0;
+
+    for (i = 0; (i < len) && (ret == 0); i += 16)
+        ret = mbedtls_aes_crypt_ecb(&s_aes, MBEDTLS_AES_ENCRYPT, s_au8In + i, s_au8Out + i);
+    return ret;
+}
+
+static int bench_aes_cbc(size_t len)
+{
+    unsigned char iv[16] = { 0 };
+
+    return mbedtls_aes_crypt_cbc(&s_aes, MBEDTLS_AES_ENCRYPT, len, iv, s_au8In, s_au8Out);
+}
+
+static int bench_aes_ctr(size_t len)
+{
+    unsigned char nonce[16] = { 0 }, stream[16];
+    size_t  off = 0;
+
+    return mbedtls_aes_crypt_ctr(&s_aes, len, &off, nonce, stream, s_au8In, s_au8Out);
+}
+
+static int bench_aes_gcm(size_t len)
+{
+    unsigned char iv[12] = { 0 }, tag[16];
+
+    return mbedtls_gcm_crypt_and_tag(&s_gcm, MBEDTLS_GCM_ENCRYPT, len, iv, sizeof(iv),
+                                     NULL, 0, s_au8In, s_au8Out, sizeof(tag), tag);
+}
+
+static int bench_sha1(size_t len)
+{
+    return mbedtls_sha1_ret(s_au8In, len, s_au8Out);
+}
+
+static int bench_sha256(size_t len)
+{
+    return mbedtls_sha256_ret(s_au8In, len, s_au8Out, 0);
+}
+
+static int bench_sha512(size_t len)
+{
+    return mbedtls_sha512_ret(s_au8In, len, s_au8Out, 0);
+}
+
+static int bench_hmac_sha256(size_t len)
+{
+    return mbedtls_md_hmac(s_psMdSha256, s_au8In, 32, s_au8In, len, s_au8Out);
+}
+
+static int bench_ecdsa_sign(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdsa_sign(&s_grp, &s_r, &s_s, &s_d, s_au8In, 32, bench_rng, NULL);
+}
+
+static int bench_ecdsa_verify(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdsa_verify(&s_grp, s_au8In, 32, &s_Q, &s_r, &s_s);
+}
+
+static int bench_ecdh(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdh_compute_shared(&s_grp, &s_z, &s_Q, &s_d, bench_rng, NULL);
+}
+
+static int bench_rsa_public(size_t len)
+{
+    (void)len;
+    return mbedtls_rsa_public(&s_rsa, s_au8In, s_au8Out);
+}
+
+static int bench_rsa_private(size_t len)
+{
+    (void)len;
+    return mbedtls_rsa_private(&s_rsa, bench_rng, NULL, s_au8In, s_au8Out);
+}
+
+typedef struct
+{
+    const char *pcName;
+    const char *pcEngine;
+    int (*pfnRun)(size_t len);
+    int sized;                      /* run over s_au32Sizes, else once per operation */
+} BENCH_CASE_T;
+
+static const BENCH_CASE_T s_asCases[] =
+{
+    { "AES-128-ECB",    ENGINE_AES, bench_aes_ecb,      1 },
+    { "AES-128-CBC",    ENGINE_AES, bench_aes_cbc,      1 },
+    { "AES-128-CTR",    ENGINE_AES, bench_aes_ctr,      1 },
+    { "AES-128-GCM",    ENGINE_GCM, bench_aes_gcm,      1 },
+    { "SHA-1",          ENGINE_SHA, bench_sha1,         1 },
+    { "SHA-256",        ENGINE_SHA, bench_sha256,       1 },
+    { "SHA-512",        ENGINE_SHA, bench_sha512,       1 },
+    { "HMAC-SHA256",    ENGINE_SHA, bench_hmac_sha256,  1 },
+    { "ECDSA-P256-sign",   ENGINE_ECC, bench_ecdsa_sign,   0 },
+    { "ECDSA-P256-verify", ENGINE_ECC, bench_ecdsa_verify, 0 },
+    { "ECDH-P256",      ENGINE_ECC, bench_ecdh,         0 },
+    { "RSA-2048-public",   ENGINE_RSA, bench_rsa_public,   0 },
+    { "RSA-2048-private",  ENGINE_RSA, bench_rsa_private,  0 },
+};
+
+/*----------------------------------------------------------------------------*/
+
+static int bench_setup(void)
+{
+    static const unsigned char key[16] = "0123456789abcde";
+    mbedtls_mpi N, P, Q, D, E;
+    int  ret;
+
+    memset(s_au8In, 0x5A, sizeof(s_au8In));
+    s_au8In[0] = 0;                 /* RSA input below the modulus */
+
+    mbedtls_aes_init(&s_aes);
+    mbedtls_gcm_init(&s_gcm);
+    mbedtls_ecp_group_init(&s_grp);
+    mbedtls_ecp_point_init(&s_Q);
+    mbedtls_mpi_init(&s_d);
+    mbedtls_mpi_init(&s_r);
+    mbedtls_mpi_init(&s_s);
+    mbedtls_mpi_init(&s_z);
+    mbedtls_rsa_init(&s_rsa, MBEDTLS_RSA_PKCS_V15, 0);
+
+    s_psMdSha256 = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+
+    if ((ret = mbedtls_aes_setkey_enc(&s_aes, key, 128)) != 0 ||
+        (ret = mbedtls_gcm_setkey(&s_gcm, MBEDTLS_CIPHER_ID_AES, key, 128)) != 0 ||
+        (ret = mbedtls_ecp_group_load(&s_grp, MBEDTLS_ECP_DP_SECP256R1)) != 0 ||
+        (ret = mbedtls_ecp_gen_keypair(&s_grp, &s_d, &s_Q, bench_rng, NULL)) != 0 ||
+        (ret = mbedtls_ecdsa_sign(&s_grp, &s_r, &s_s, &s_d, s_au8In, 32, bench_rng, NULL)) != 0)
+        return ret;
+
+    mbedtls_mpi_init(&N);
+    mbedtls_mpi_init(&P);
+    mbedtls_mpi_init(&Q);
+    mbedtls_mpi_init(&D);
+    mbedtls_mpi_init(&E);
+    if ((ret = mbedtls_mpi_read_string(&N, 16, RSA_N)) == 0 &&
+        (ret = mbedtls_mpi_read_string(&P, 16, RSA_P)) == 0 &&
+        (ret = mbedtls_mpi_read_string(&Q, 16, RSA_Q)) == 0 &&
+        (ret = mbedtls_mpi_read_string(&D, 16, RSA_D)) == 0 &&
+        (ret = mbedtls_mpi_read_string(&E, 16, RSA_E)) == 0 &&
+        (ret = mbedtls_rsa_import(&s_rsa, &N, &P, &Q, &D, &E)) == 0 &&
+        (ret = mbedtls_rsa_complete(&s_rsa)) == 0)
+        ret = mbedtls_rsa_check_privkey(&s_rsa);
+    mbedtls_mpi_free(&N);
+    mbedtls_mpi_free(&P);
+    mbedtls_mpi_free(&Q);
+    mbedtls_mpi_free(&D);
+    mbedtls_mpi_free(&E);
+    return ret;
+}
+
+/*
+ *  Run one case until BENCH_MIN_USEC has passed and print its CSV row.
+ *  The counter is read after every operation, so a slow operation only
+ *  has to be shorter than one counter wrap.
+ */
+static void bench_run(const BENCH_CASE_T *psCase, size_t len)
+{
+    uint32_t  u32Last, u32Now, u32Ops = 0;
+    uint64_t  u64Usec = 0, u64Cycles;
+    int       ret;
+
+    u32Last = bench_timer_read();
+    do
+    {
+        ret = psCase->pfnRun(len);
+        if (ret != 0)
+        {
+            printf("%s,%s,%s,%u,error -0x%04X\n", BENCH_PLATFORM, psCase->pcEngine,
+                   psCase->pcName, (unsigned)len, (unsigned)-ret);
+            return;
+        }
+        u32Ops++;
+        u32Now = bench_timer_read();
+        u64Usec += (u32Now - u32Last) & BENCH_TICK_MASK;
+        u32Last = u32Now;
+    }
+    while (u64Usec < BENCH_MIN_USEC);
+
+    u64Cycles = u64Usec * s_u32CpuMHz;
+
+    printf("%s,%s,%s,%u,%u,%u,%u,%u,%u,", BENCH_PLATFORM, psCase->pcEngine, psCase->pcName,
+           (unsigned)len, (unsigned)u32Ops, (unsigned)u64Usec,
+           (unsigned)((uint64_t)u32Ops * 1000000 / u64Usec),
+           (unsigned)((uint64_t)u32Ops * len * 1000000 / 1024 / u64Usec),
+           (unsigned)(u64Cycles / u32Ops));
+    if (len != 0 && s_u32CpuMHz != 0)
+    {
+        u64Cycles = u64Cycles * 100 / ((uint64_t)u32Ops * len);
+        printf("%u.%02u\n", (unsigned)(u64Cycles / 100), (unsigned)(u64Cycles % 100));
+    }
+    else
+    {
+        printf("\n");
+    }
+}
+
+int main(void)
+{
+    unsigned  i, j;
+    int       ret;
+
+#if !defined(__linux__)
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (1<<23));   /* Enable Crypto clock */
+#endif
+
+    printf("+----------------------------------------+\n");
+    printf("|  Crypto mbedtls throughput benchmark   |\n");
+    printf("+----------------------------------------+\n");
+
+    bench_timer_init();
+
+    ret = bench_setup();
+    if (ret != 0)
+    {
+        printf("Setup failed, -0x%04X\n", (unsigned)-ret);
+        while (1);
+    }
+
+    printf("platform,engine,algorithm,bytes,ops,usec,ops_per_sec,kbytes_per_sec,cycles_per_op,cycles_per_byte\n");
+    for (i = 0; i < sizeof(s_asCases) / sizeof(s_asCases[0]); i++)
+    {
+        if (!s_asCases[i].sized)
+        {
+            bench_run(&s_asCases[i], 0);
+            continue;
+        }
+        for (j = 0; j < sizeof(s_au32Sizes) / sizeof(s_au32Sizes[0]); j++)
+            bench_run(&s_asCases[i], s_au32Sizes[j]);
+    }
+    printf("Done.\n");
+
+#if defined(__linux__)
+    return 0;
+#else
+    while (1);
+#endif
+}
+
+/*** (C) COPYRIGHT 2018 Nuvoton Technology Corp. ***/
@@ -0,0 +1,37 @@
+/**************************************************************************//**
+ * @file     mbedtls_host_config.h
+ * @brief    mbedtls configuration for building the benchmark on a Linux host.
+ *           Only the modules the benchmark uses, all in software.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef MBEDTLS_HOST_CONFIG_H
+#define MBEDTLS_HOST_CONFIG_H
+
+#define MBEDTLS_HAVE_ASM
+
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_CIPHER_MODE_CTR
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_PKCS1_V15
+
+#define MBEDTLS_AES_C
+#define MBEDTLS_ASN1_PARSE_C
+#define MBEDTLS_ASN1_WRITE_C
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_OID_C
+#define MBEDTLS_RSA_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SHA512_C
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_HOST_CONFIG_H */
@@ -428,6 +428,113 @@ exit:
 }
 
 
+/*
+ * Clone a context in the middle of a message, continue the original and the
+ * clone with different data and compare both with one-shot digests. The
+ * first update is large enough to move a context to the crypto engine.
+ */
+#define CLONE_MSG_LEN       2000
+#define CLONE_SPLIT_LEN     1000
+
+static unsigned char clone_msg[CLONE_MSG_LEN];
+
+void test_suite_sha_clone()
+{
+    mbedtls_sha1_context   sha1_a, sha1_b;
+    mbedtls_sha256_context sha256_a, sha256_b;
+    mbedtls_sha512_context sha512_a, sha512_b;
+    unsigned char out_a[64], out_b[64], ref_a[64], ref_b[64];
+    int i;
+
+    for( i = 0; i < CLONE_MSG_LEN; i++ )
+        clone_msg[i] = (unsigned char)( i * 7 + ( i >> 8 ) );
+
+    /* SHA-1 */
+    mbedtls_sha1_ret( clone_msg, CLONE_MSG_LEN, ref_a );
+    mbedtls_sha1_ret( clone_msg, CLONE_SPLIT_LEN + 100, ref_b );
+
+    mbedtls_sha1_init( &sha1_a );
+    mbedtls_sha1_init( &sha1_b );
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_keep_sw( &sha1_a.nvt );
+#endif
+    TEST_ASSERT( mbedtls_sha1_starts_ret( &sha1_a ) == 0 );
+    TEST_ASSERT( mbedtls_sha1_update_ret( &sha1_a, clone_msg, CLONE_SPLIT_LEN ) == 0 );
+    mbedtls_sha1_clone( &sha1_b, &sha1_a );
+    TEST_ASSERT( mbedtls_sha1_update_ret( &sha1_a, clone_msg + CLONE_SPLIT_LEN, CLONE_MSG_LEN - CLONE_SPLIT_LEN ) == 0 );
+    TEST_ASSERT( mbedtls_sha1_update_ret( &sha1_b, clone_msg + CLONE_SPLIT_LEN, 100 ) == 0 );
+    TEST_ASSERT( mbedtls_sha1_finish_ret( &sha1_a, out_a ) == 0 );
+    TEST_ASSERT( mbedtls_sha1_finish_ret( &sha1_b, out_b ) == 0 );
+    TEST_ASSERT( memcmp( out_a, ref_a, 20 ) == 0 );
+    TEST_ASSERT( memcmp( out_b, ref_b, 20 ) == 0 );
+    mbedtls_sha1_free( &sha1_a );
+    mbedtls_sha1_free( &sha1_b );
+
+    /* SHA-256 */
+    mbedtls_sha256_ret( clone_msg, CLONE_MSG_LEN, ref_a, 0 );
+    mbedtls_sha256_ret( clone_msg, CLONE_SPLIT_LEN + 100, ref_b, 0 );
+
+    mbedtls_sha256_init( &sha256_a );
+    mbedtls_sha256_init( &sha256_b );
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_keep_sw( &sha256_a.nvt );
+#endif
+    TEST_ASSERT( mbedtls_sha256_starts_ret( &sha256_a, 0 ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_a, clone_msg, CLONE_SPLIT_LEN ) == 0 );
+    mbedtls_sha256_clone( &sha256_b, &sha256_a );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_a, clone_msg + CLONE_SPLIT_LEN, CLONE_MSG_LEN - CLONE_SPLIT_LEN ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_b, clone_msg + CLONE_SPLIT_LEN, 100 ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_finish_ret( &sha256_a, out_a ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_finish_ret( &sha256_b, out_b ) == 0 );
+    TEST_ASSERT( memcmp( out_a, ref_a, 32 ) == 0 );
+    TEST_ASSERT( memcmp( out_b, ref_b, 32 ) == 0 );
+
+#ifdef NUVOTON_ENABLE_SHA
+    /* A clone of an engine context must fail, not give a wrong digest, and
+       the original must still be right */
+    mbedtls_sha256_free( &sha256_a );
+    mbedtls_sha256_init( &sha256_a );
+    TEST_ASSERT( mbedtls_sha256_starts_ret( &sha256_a, 0 ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_a, clone_msg, CLONE_SPLIT_LEN ) == 0 );
+    TEST_ASSERT( sha256_a.nvt.hw == 1 );
+    mbedtls_sha256_clone( &sha256_b, &sha256_a );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_b, clone_msg + CLONE_SPLIT_LEN, 100 ) ==
+                 MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED );
+    TEST_ASSERT( mbedtls_sha256_update_ret( &sha256_a, clone_msg + CLONE_SPLIT_LEN, CLONE_MSG_LEN - CLONE_SPLIT_LEN ) == 0 );
+    TEST_ASSERT( mbedtls_sha256_finish_ret( &sha256_a, out_a ) == 0 );
+    TEST_ASSERT( memcmp( out_a, ref_a, 32 ) == 0 );
+#endif
+    mbedtls_sha256_free( &sha256_a );
+    mbedtls_sha256_free( &sha256_b );
+
+    /* SHA-512 */
+    mbedtls_sha512_ret( clone_msg, CLONE_MSG_LEN, ref_a, 0 );
+    mbedtls_sha512_ret( clone_msg, CLONE_SPLIT_LEN + 100, ref_b, 0 );
+
+    mbedtls_sha512_init( &sha512_a );
+    mbedtls_sha512_init( &sha512_b );
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_keep_sw( &sha512_a.nvt );
+#endif
+    TEST_ASSERT( mbedtls_sha512_starts_ret( &sha512_a, 0 ) == 0 );
+    TEST_ASSERT( mbedtls_sha512_update_ret( &sha512_a, clone_msg, CLONE_SPLIT_LEN ) == 0 );
+    mbedtls_sha512_clone( &sha512_b, &sha512_a );
+    TEST_ASSERT( mbedtls_sha512_update_ret( &sha512_a, clone_msg + CLONE_SPLIT_LEN, CLONE_MSG_LEN - CLONE_SPLIT_LEN ) == 0 );
+    TEST_ASSERT( mbedtls_sha512_update_ret( &sha512_b, clone_msg + CLONE_SPLIT_LEN, 100 ) == 0 );
+    TEST_ASSERT( mbedtls_sha512_finish_ret( &sha512_a, out_a ) == 0 );
+    TEST_ASSERT( mbedtls_sha512_finish_ret( &sha512_b, out_b ) == 0 );
+    TEST_ASSERT( memcmp( out_a, ref_a, 64 ) == 0 );
+    TEST_ASSERT( memcmp( out_b, ref_b, 64 ) == 0 );
+    mbedtls_sha512_free( &sha512_a );
+    mbedtls_sha512_free( &sha512_b );
+
+    printf("Clone in the middle of a message: PASS\n");
+
+exit:
+    return;
+}
+
+
 /*----------------------------------------------------------------------------*/
 /* Test dispatch code */
 
@@ -725,6 +832,8 @@ int main(void)
 
     SHA_ENABLE_INT(CRPT);
 
+    test_suite_sha_clone();
+
     for (vector_no = 1; ; vector_no++)
     {
         if (open_test_vector(vector_no) != 0)
@@ -77,6 +77,8 @@
 
 #define CONFIG_PHY_ADDR     1
 
+#define ETH_RX_EVENT_PRIORITY   4       // Event loop priority of the received frame handler
+
 
 // Frame Descriptor's Owner bit
 #define OWNERSHIP_EMAC 0x80000000  // 1 = EMAC
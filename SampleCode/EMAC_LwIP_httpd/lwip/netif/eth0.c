@@ -10,6 +10,7 @@
 #include "lwip/opt.h"
 #include "lwip/def.h"
 #include "lwip/timeouts.h"
+#include "event_loop.h"
 
 #define ETH0_TRIGGER_RX()    outpw(REG_EMAC0_RSDR, 0)
 #define ETH0_TRIGGER_TX()    outpw(REG_EMAC0_TSDR, 0)
@@ -27,6 +28,7 @@ static struct eth_descriptor volatile *cur_tx_desc_ptr, *cur_rx_desc_ptr, *fin_t
 static u8_t rx_buf[RX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
 static u8_t tx_buf[TX_DESCRIPTOR_NUM][PACKET_BUFFER_SIZE];
 static int plugged = 0;
+static EVL_EVENT_T rx_event;
 
 extern void ethernetif_input0(u16_t len, u8_t *buf);
 
@@ -195,6 +197,17 @@ void ETH0_RX_IRQHandler(void)
         // Shouldn't goes here, unless descriptor corrupted
     }
 
+    // Frames are passed to lwIP from the event loop, lwIP is not called in interrupt context
+    EVL_Post(&rx_event);
+}
+
+static void ETH0_rx_handler(EVL_EVENT_T *event, u32_t posts)
+{
+    unsigned int status;
+
+    LWIP_UNUSED_ARG(event);
+    LWIP_UNUSED_ARG(posts);
+
     do
     {
         status = cur_rx_desc_ptr->status1;
@@ -288,6 +301,7 @@ void ETH0_init(u8_t *mac_addr)
 
     outpw(REG_EMAC0_MCMDR, inpw(REG_EMAC0_MCMDR) | 0x121); // strip CRC, TX on, Rx on
     outpw(REG_EMAC0_MIEN, inpw(REG_EMAC0_MIEN) | 0x01250C11);  // Except tx/rx ok, enable rdu, txabt, tx/rx bus error.
+    EVL_InitEvent(&rx_event, ETH0_rx_handler, NULL, ETH_RX_EVENT_PRIORITY);
     sysInstallISR(IRQ_LEVEL_1, IRQ_EMC0_TX, (PVOID)ETH0_TX_IRQHandler);
     sysInstallISR(IRQ_LEVEL_1, IRQ_EMC0_RX, (PVOID)ETH0_RX_IRQHandler);
     sysEnableInterrupt(IRQ_EMC0_TX);
@@ -20,6 +20,7 @@
 #include "lwip/tcpip.h"
 #include "lwip/netif.h"
 #include "lwip/timeouts.h"
+#include "event_loop.h"
 
 //#include "lwip/timers.h"
 
@@ -148,6 +149,7 @@ uint32_t sysTick = 0;
 void ETMR0_IRQHandler(void)
 {
     sysTick++;
+    EVL_Tick();
     // clear timer interrupt flag
     ETIMER_ClearIntFlag(0);
 }
@@ -222,6 +224,16 @@ void TIMER_Init(void)
 }
 
 
+/* lwIP timeouts run from the event loop every tick, like the frames received */
+static EVL_TIMER_T lwip_timer;
+static void lwip_timer_func(EVL_TIMER_T *timer, void *arg)
+{
+    LWIP_UNUSED_ARG(timer);
+    LWIP_UNUSED_ARG(arg);
+    sys_check_timeouts();
+}
+
+
 extern void chk_link0(void *arg);
 extern void chk_link1(void *arg);
 int main(void)
@@ -235,13 +247,16 @@ int main(void)
 
     UART_Init();
     printf("lwIP httpd demo\n");
+    EVL_Init();
     TIMER_Init();
 
     net_init();
     httpd_init();
     sys_timeout(2000, chk_link0, NULL);
     sys_timeout(2000, chk_link1, NULL);
-    while (1)
-        sys_check_timeouts();  // All network traffic is handled in interrupt handler
+    EVL_InitTimer(&lwip_timer, lwip_timer_func, NULL);
+    EVL_StartTimer(&lwip_timer, 1, 1);
+
+    EVL_Run();  // Interrupt handlers post events, the CPU sleeps when there is nothing to do
 }
 
@@ -0,0 +1,901 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    LwIP HTTPS server sample code with mbed TLS. TLS sessions are
+ *           resumed from a bounded LRU session cache or from session tickets
+ *           keyed from the DRBG. At start-up, full and resumed handshakes are
+ *           timed between a client and a server in memory, on a DRBG with a
+ *           fixed test-only seed and the certs.c test key. The server's DRBG
+ *           needs seed material that the sample does not have, see
+ *           https_seed_read().
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "netif/ethernetif.h"
+#include "netif/etharp.h"
+#include "lwip/init.h"
+#include "lwip/tcp.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "lwip/sys.h"
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ticket.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/nvt_entropy.h"
+#include "session_cache.h"
+
+//#define USE_DHCP
+#ifdef USE_DHCP
+#include "lwip/dhcp.h"
+#endif
+
+#define HTTPS_PORT              443
+#define HTTPS_MAX_CONN          4       /* each holds about 36 KB of TLS buffers */
+#define HTTPS_CONN_TIMEOUT_MS   10000
+#define HTTPS_SESSION_TIMEOUT_S 3600    /* session cache entries             */
+#define HTTPS_TICKET_LIFETIME_S 3600    /* ticket key rotation period        */
+
+#define BENCH_ROUNDS            10
+#define BENCH_PIPE_SIZE         (8 * 1024)
+
+typedef enum
+{
+    CONN_FREE = 0,
+    CONN_NEW,
+    CONN_HANDSHAKE,
+    CONN_REQUEST,
+    CONN_RESPONSE,
+    CONN_CLOSE
+} CONN_STATE_E;
+
+typedef struct
+{
+    volatile CONN_STATE_E eState;
+    struct tcp_pcb * volatile pcb;      /* NULL once lwIP dropped the connection */
+    struct pbuf *rx;                    /* received and not yet read by TLS      */
+    u16_t rx_off;
+    volatile int rx_eof;
+    mbedtls_ssl_context ssl;
+    uint32_t u32Start;
+    uint32_t u32HandshakeMs;
+    int resumed;                        /* 0 full, 1 session cache, 2 ticket     */
+    int req_len;
+    int resp_len;
+    int resp_off;
+    char req[512];
+    char resp[768];
+} HTTPS_CONN_T;
+
+unsigned char my_mac_addr0[6] = {0x00, 0x00, 0x00, 0x55, 0x66, 0x77};
+unsigned char my_mac_addr1[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+volatile int  g_Crypto_Int_done = 0;
+
+static const int s_ai32Ciphersuites[] =
+{
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    0
+};
+
+/* The curve the ECC engine accelerates */
+static const mbedtls_ecp_group_id s_aeCurves[] =
+{
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_NONE
+};
+
+static mbedtls_entropy_context  s_entropy;
+static mbedtls_ctr_drbg_context s_drbg;
+static mbedtls_x509_crt         s_srvcert;
+static mbedtls_pk_context       s_pkey;
+static mbedtls_ssl_config       s_conf;
+static mbedtls_ssl_ticket_context s_ticket;
+static SESSION_CACHE_T          s_cache;
+static uint32_t                 s_u32TicketKeyTime;
+
+static HTTPS_CONN_T s_asConn[HTTPS_MAX_CONN];
+static HTTPS_CONN_T *s_psCurConn;       /* connection the main loop is serving */
+static uint32_t s_u32Full, s_u32CacheHits, s_u32TicketHits;
+
+extern uint32_t sysTick;
+
+/*----------------------------------------------------------------------------*/
+/* TLS configuration */
+
+static int tls_want(int ret)
+{
+    return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+static int https_cache_get(void *data, mbedtls_ssl_session *session)
+{
+    int ret = session_cache_get(data, session);
+
+    if (ret == 0)
+    {
+        s_u32CacheHits++;
+        if (s_psCurConn != NULL)
+            s_psCurConn->resumed = 1;
+    }
+    return ret;
+}
+
+static int https_ticket_parse(void *p_ticket, mbedtls_ssl_session *session,
+                              unsigned char *buf, size_t len)
+{
+    int ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+
+    if (ret == 0)
+    {
+        s_u32TicketHits++;
+        if (s_psCurConn != NULL)
+            s_psCurConn->resumed = 2;
+    }
+    return ret;
+}
+
+/*
+ * mbed TLS is built without MBEDTLS_HAVE_TIME, so the ticket module never
+ * rotates its key by itself. A new key invalidates the tickets out there;
+ * their clients fall back to the session cache or a full handshake.
+ */
+static int https_ticket_rekey(void)
+{
+    mbedtls_ssl_ticket_free(&s_ticket);
+    mbedtls_ssl_ticket_init(&s_ticket);
+    s_u32TicketKeyTime = sys_now();
+    return mbedtls_ssl_ticket_setup(&s_ticket, mbedtls_ctr_drbg_random, &s_drbg,
+                                    MBEDTLS_CIPHER_AES_128_GCM, HTTPS_TICKET_LIFETIME_S);
+}
+
+/*
+ * Seed material for the DRBG. The NUC980 has no true random number
+ * generator, so a product must fill this in, e.g. from an external noise
+ * source, or from a per-device secret provisioned at production hashed with
+ * a boot counter kept in flash. Each call must return len bytes an attacker
+ * cannot predict, and 0. The sample has none, so TLS setup stops here
+ * rather than run on a seed that can be guessed.
+ */
+static int https_seed_read(unsigned char *buf, size_t len)
+{
+    (void)buf;
+    (void)len;
+    return -1;
+}
+
+/* Strong entropy source on top of https_seed_read() */
+static int https_seed_poll(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    (void)data;
+
+    if (https_seed_read(output, len) != 0)
+    {
+        *olen = 0;
+        return MBEDTLS_ERR_ENTROPY_SOURCE_FAILED;
+    }
+    *olen = len;
+    return 0;
+}
+
+/* Server configuration on a DRBG, a ticket key set up on it and a cache */
+static int tls_conf_server(mbedtls_ssl_config *conf, mbedtls_ctr_drbg_context *drbg,
+                           mbedtls_ssl_ticket_context *ticket, SESSION_CACHE_T *cache,
+                           mbedtls_x509_crt *crt, mbedtls_pk_context *pkey)
+{
+    int ret;
+
+    if ((ret = mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+        return ret;
+
+    mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, drbg);
+    mbedtls_ssl_conf_ciphersuites(conf, s_ai32Ciphersuites);
+    mbedtls_ssl_conf_curves(conf, s_aeCurves);
+    mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    if ((ret = mbedtls_ssl_conf_own_cert(conf, crt, pkey)) != 0)
+        return ret;
+
+    mbedtls_ssl_conf_session_cache(conf, cache, https_cache_get, session_cache_set);
+    mbedtls_ssl_conf_session_tickets_cb(conf, mbedtls_ssl_ticket_write, https_ticket_parse, ticket);
+
+    return 0;
+}
+
+static int tls_init(void)
+{
+    static const char pers[] = "nuc980_https";
+    int ret;
+#ifdef NUVOTON_ENABLE_PRNG
+    uint32_t seed;
+
+    /* Without a seed the PRNG pool, a weak source, fails every poll */
+    if (https_seed_read((unsigned char *)&seed, sizeof(seed)) == 0)
+        nvt_entropy_init(seed, 0);
+    seed = 0;
+#endif
+
+    mbedtls_entropy_init(&s_entropy);
+    if ((ret = mbedtls_entropy_add_source(&s_entropy, https_seed_poll, NULL, 32,
+                                          MBEDTLS_ENTROPY_SOURCE_STRONG)) != 0)
+        return ret;
+    mbedtls_ctr_drbg_init(&s_drbg);
+    mbedtls_x509_crt_init(&s_srvcert);
+    mbedtls_pk_init(&s_pkey);
+    mbedtls_ssl_config_init(&s_conf);
+    mbedtls_ssl_ticket_init(&s_ticket);
+    session_cache_init(&s_cache, HTTPS_SESSION_TIMEOUT_S);
+
+    if ((ret = mbedtls_ctr_drbg_seed(&s_drbg, mbedtls_entropy_func, &s_entropy,
+                                     (const unsigned char *)pers, sizeof(pers) - 1)) != 0)
+        return ret;
+
+    /* Test certificate and key from certs.c, replace them with the device's own */
+    if ((ret = mbedtls_x509_crt_parse(&s_srvcert, (const unsigned char *)mbedtls_test_srv_crt_ec,
+                                      mbedtls_test_srv_crt_ec_len)) != 0)
+        return ret;
+    if ((ret = mbedtls_pk_parse_key(&s_pkey, (const unsigned char *)mbedtls_test_srv_key_ec,
+                                    mbedtls_test_srv_key_ec_len, NULL, 0)) != 0)
+        return ret;
+
+    if ((ret = https_ticket_rekey()) != 0)
+        return ret;
+
+    return tls_conf_server(&s_conf, &s_drbg, &s_ticket, &s_cache, &s_srvcert, &s_pkey);
+}
+
+/*----------------------------------------------------------------------------*/
+/* Handshake benchmark, client and server talking through memory */
+
+typedef struct
+{
+    size_t len;
+    unsigned char buf[BENCH_PIPE_SIZE];
+} BENCH_PIPE_T;
+
+static BENCH_PIPE_T s_sToServer, s_sToClient;
+static mbedtls_ssl_config  s_cli_conf, s_bench_conf;
+static mbedtls_ssl_context s_bench_cli, s_bench_srv;
+static mbedtls_ctr_drbg_context   s_bench_drbg;
+static mbedtls_ssl_ticket_context s_bench_ticket;
+static SESSION_CACHE_T            s_bench_cache;
+static mbedtls_x509_crt           s_bench_crt;
+static mbedtls_pk_context         s_bench_pkey;
+
+/*
+ * TEST ONLY. A fixed DRBG input, so the benchmark runs on a device that has
+ * no seed material yet. Every nonce, ephemeral key and ticket key it gives
+ * is known to anyone who reads this file, so the benchmark has its own
+ * DRBG, signs with the certs.c test key rather than the device's, and keeps
+ * its sessions in its own cache; none of it reaches the HTTPS server.
+ */
+static int bench_test_entropy(void *data, unsigned char *output, size_t len)
+{
+    (void)data;
+    memset(output, 0x5A, len);
+    return 0;
+}
+
+static int bench_send(BENCH_PIPE_T *pipe, const unsigned char *buf, size_t len)
+{
+    if (len > sizeof(pipe->buf) - pipe->len)
+        len = sizeof(pipe->buf) - pipe->len;
+    if (len == 0)
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+
+    memcpy(pipe->buf + pipe->len, buf, len);
+    pipe->len += len;
+    return (int)len;
+}
+
+static int bench_recv(BENCH_PIPE_T *pipe, unsigned char *buf, size_t len)
+{
+    if (pipe->len == 0)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    if (len > pipe->len)
+        len = pipe->len;
+
+    memcpy(buf, pipe->buf, len);
+    pipe->len -= len;
+    memmove(pipe->buf, pipe->buf + len, pipe->len);
+    return (int)len;
+}
+
+static int bench_cli_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    return bench_send(&s_sToServer, buf, len);
+}
+
+static int bench_cli_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    return bench_recv(&s_sToClient, buf, len);
+}
+
+static int bench_srv_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    return bench_send(&s_sToClient, buf, len);
+}
+
+static int bench_srv_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    return bench_recv(&s_sToServer, buf, len);
+}
+
+static int bench_handshake(const mbedtls_ssl_session *resume)
+{
+    int ret_c, ret_s, i;
+
+    mbedtls_ssl_session_reset(&s_bench_cli);
+    mbedtls_ssl_session_reset(&s_bench_srv);
+    s_sToServer.len = s_sToClient.len = 0;
+
+    if (resume != NULL && (ret_c = mbedtls_ssl_set_session(&s_bench_cli, resume)) != 0)
+        return ret_c;
+
+    for (i = 0; i < 100; i++)
+    {
+        ret_c = mbedtls_ssl_handshake(&s_bench_cli);
+        if (ret_c != 0 && !tls_want(ret_c))
+            return ret_c;
+        ret_s = mbedtls_ssl_handshake(&s_bench_srv);
+        if (ret_s != 0 && !tls_want(ret_s))
+            return ret_s;
+        if (ret_c == 0 && ret_s == 0)
+            return 0;
+    }
+    return MBEDTLS_ERR_SSL_TIMEOUT;
+}
+
+static int bench_run(const char *name, int tickets, int resume, uint32_t *hits)
+{
+    mbedtls_ssl_session session;
+    uint32_t start, ms, before;
+    int ret, i;
+
+    mbedtls_ssl_session_init(&session);
+    mbedtls_ssl_conf_session_tickets(&s_cli_conf, tickets ? MBEDTLS_SSL_SESSION_TICKETS_ENABLED :
+                                     MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+
+    /* A full handshake provides the session to resume */
+    if (resume)
+    {
+        if ((ret = bench_handshake(NULL)) != 0 ||
+                (ret = mbedtls_ssl_get_session(&s_bench_cli, &session)) != 0)
+            goto exit;
+    }
+
+    before = (hits != NULL) ? *hits : 0;
+    start = sys_now();
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        if ((ret = bench_handshake(resume ? &session : NULL)) != 0)
+            goto exit;
+    }
+    ms = sys_now() - start;
+
+    printf("%-22s %3d in %5d ms, %3d.%d handshakes/s", name, BENCH_ROUNDS, ms,
+           ms ? BENCH_ROUNDS * 1000 / ms : 0, ms ? (BENCH_ROUNDS * 10000 / ms) % 10 : 0);
+    if (hits != NULL)
+        printf(", %d resumed", *hits - before);
+    printf("\n");
+
+exit:
+    mbedtls_ssl_session_free(&session);
+    return ret;
+}
+
+static void bench_handshakes(void)
+{
+    static const char pers[] = "nuc980_https handshake benchmark, TEST ONLY, NOT RANDOM";
+    int ret;
+
+    mbedtls_ctr_drbg_init(&s_bench_drbg);
+    mbedtls_ssl_ticket_init(&s_bench_ticket);
+    mbedtls_x509_crt_init(&s_bench_crt);
+    mbedtls_pk_init(&s_bench_pkey);
+    session_cache_init(&s_bench_cache, HTTPS_SESSION_TIMEOUT_S);
+    mbedtls_ssl_config_init(&s_bench_conf);
+    mbedtls_ssl_config_init(&s_cli_conf);
+    mbedtls_ssl_init(&s_bench_cli);
+    mbedtls_ssl_init(&s_bench_srv);
+
+    if ((ret = mbedtls_ctr_drbg_seed(&s_bench_drbg, bench_test_entropy, NULL,
+                                     (const unsigned char *)pers, sizeof(pers) - 1)) != 0 ||
+            (ret = mbedtls_x509_crt_parse(&s_bench_crt, (const unsigned char *)mbedtls_test_srv_crt_ec,
+                                          mbedtls_test_srv_crt_ec_len)) != 0 ||
+            (ret = mbedtls_pk_parse_key(&s_bench_pkey, (const unsigned char *)mbedtls_test_srv_key_ec,
+                                        mbedtls_test_srv_key_ec_len, NULL, 0)) != 0 ||
+            (ret = mbedtls_ssl_ticket_setup(&s_bench_ticket, mbedtls_ctr_drbg_random, &s_bench_drbg,
+                                            MBEDTLS_CIPHER_AES_128_GCM, HTTPS_TICKET_LIFETIME_S)) != 0 ||
+            (ret = tls_conf_server(&s_bench_conf, &s_bench_drbg, &s_bench_ticket, &s_bench_cache,
+                                   &s_bench_crt, &s_bench_pkey)) != 0)
+        goto exit;
+
+    if ((ret = mbedtls_ssl_config_defaults(&s_cli_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+        goto exit;
+    /* The server's signature is checked, its test certificate is not */
+    mbedtls_ssl_conf_authmode(&s_cli_conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&s_cli_conf, mbedtls_ctr_drbg_random, &s_bench_drbg);
+    mbedtls_ssl_conf_ciphersuites(&s_cli_conf, s_ai32Ciphersuites);
+    mbedtls_ssl_conf_curves(&s_cli_conf, s_aeCurves);
+
+    if ((ret = mbedtls_ssl_setup(&s_bench_cli, &s_cli_conf)) != 0 ||
+            (ret = mbedtls_ssl_setup(&s_bench_srv, &s_bench_conf)) != 0)
+        goto exit;
+    mbedtls_ssl_set_bio(&s_bench_cli, NULL, bench_cli_send, bench_cli_recv, NULL);
+    mbedtls_ssl_set_bio(&s_bench_srv, NULL, bench_srv_send, bench_srv_recv, NULL);
+
+    printf("Handshakes, client and server both on this CPU (%s, test-only DRBG seed):\n",
+           mbedtls_ssl_get_ciphersuite_name(s_ai32Ciphersuites[0]));
+    if ((ret = bench_run("full", 0, 0, NULL)) != 0 ||
+            (ret = bench_run("resumed, session ID", 0, 1, &s_u32CacheHits)) != 0 ||
+            (ret = bench_run("resumed, ticket", 1, 1, &s_u32TicketHits)) != 0)
+        goto exit;
+
+exit:
+    if (ret != 0)
+        printf("Handshake benchmark failed, -0x%04X\n", -ret);
+
+    mbedtls_ssl_free(&s_bench_cli);
+    mbedtls_ssl_free(&s_bench_srv);
+    mbedtls_ssl_config_free(&s_cli_conf);
+    mbedtls_ssl_config_free(&s_bench_conf);
+    mbedtls_ssl_ticket_free(&s_bench_ticket);
+    mbedtls_x509_crt_free(&s_bench_crt);
+    mbedtls_pk_free(&s_bench_pkey);
+    mbedtls_ctr_drbg_free(&s_bench_drbg);
+    session_cache_free(&s_bench_cache);
+
+    /* The server counts its own resumptions */
+    s_u32CacheHits = s_u32TicketHits = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/* HTTPS server. lwIP calls back from the EMAC interrupt handlers, so the
+   callbacks only queue data and the TLS work runs in the main loop, which
+   disables interrupts around its own lwIP calls. */
+
+static int https_bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    HTTPS_CONN_T *c = (HTTPS_CONN_T *)ctx;
+    err_t err = ERR_MEM;
+    u16_t n = 0;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    if (c->pcb == NULL)
+    {
+        SYS_ARCH_UNPROTECT(lev);
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    n = tcp_sndbuf(c->pcb);
+    if (n > len)
+        n = len;
+    if (n > 0)
+        err = tcp_write(c->pcb, buf, n, TCP_WRITE_FLAG_COPY);
+    if (err == ERR_OK)
+        tcp_output(c->pcb);
+    SYS_ARCH_UNPROTECT(lev);
+
+    if (err == ERR_MEM)
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    if (err != ERR_OK)
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    return n;
+}
+
+static int https_bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    HTTPS_CONN_T *c = (HTTPS_CONN_T *)ctx;
+    struct pbuf *q;
+    u16_t n;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    if (c->rx == NULL)
+    {
+        SYS_ARCH_UNPROTECT(lev);
+        if (c->pcb == NULL)
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        return c->rx_eof ? 0 : MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    n = pbuf_copy_partial(c->rx, buf, (len > 0xFFFF) ? 0xFFFF : (u16_t)len, c->rx_off);
+    c->rx_off += n;
+
+    /* Release the pbufs read completely */
+    while (c->rx != NULL && c->rx_off >= c->rx->len)
+    {
+        q = c->rx;
+        c->rx_off -= q->len;
+        c->rx = q->next;
+        q->next = NULL;
+        q->tot_len = q->len;
+        pbuf_free(q);
+    }
+
+    if (c->pcb != NULL)
+        tcp_recved(c->pcb, n);
+    SYS_ARCH_UNPROTECT(lev);
+
+    return n;
+}
+
+static err_t https_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    HTTPS_CONN_T *c = (HTTPS_CONN_T *)arg;
+
+    if (p == NULL)
+    {
+        c->rx_eof = 1;
+        return ERR_OK;
+    }
+
+    if (c->rx == NULL)
+        c->rx = p;
+    else
+        pbuf_cat(c->rx, p);
+    return ERR_OK;
+}
+
+static void https_err(void *arg, err_t err)
+{
+    HTTPS_CONN_T *c = (HTTPS_CONN_T *)arg;
+
+    /* The pcb is already freed */
+    c->pcb = NULL;
+}
+
+static err_t https_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    HTTPS_CONN_T *c;
+    int i;
+
+    for (i = 0; i < HTTPS_MAX_CONN; i++)
+    {
+        c = &s_asConn[i];
+        if (c->eState != CONN_FREE)
+            continue;
+
+        c->pcb = pcb;
+        c->rx = NULL;
+        c->rx_off = 0;
+        c->rx_eof = 0;
+        c->eState = CONN_NEW;
+
+        tcp_arg(pcb, c);
+        tcp_recv(pcb, https_recv);
+        tcp_err(pcb, https_err);
+        return ERR_OK;
+    }
+
+    tcp_abort(pcb);
+    return ERR_ABRT;
+}
+
+static void https_close(HTTPS_CONN_T *c, int abort)
+{
+    struct tcp_pcb *pcb;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    pcb = c->pcb;
+    c->pcb = NULL;
+    if (pcb != NULL)
+    {
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_err(pcb, NULL);
+        if (abort || tcp_close(pcb) != ERR_OK)
+            tcp_abort(pcb);
+    }
+    if (c->rx != NULL)
+    {
+        pbuf_free(c->rx);
+        c->rx = NULL;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    mbedtls_ssl_session_reset(&c->ssl);
+    /* Last, from here on https_accept() may reuse the slot */
+    c->eState = CONN_FREE;
+}
+
+static void https_response(HTTPS_CONN_T *c)
+{
+    static const char * const how[] = { "full", "resumed from the session cache", "resumed from a ticket" };
+
+    if (strncmp(c->req, "GET /index.htm", 14) == 0 || strncmp(c->req, "GET / ", 6) == 0)
+    {
+        c->resp_len = snprintf(c->resp, sizeof(c->resp),
+                               "HTTP/1.0 200 OK\r\nContent-type: text/html\r\nConnection: close\r\n\r\n"
+                               "<HTML>\r\n<BODY>\r\nNUC980 web server demo based on lwIP and mbed TLS<br>\r\n"
+                               "Cipher suite: %s<br>\r\n"
+                               "This handshake: %s, %d ms<br>\r\n"
+                               "Handshakes: %d full, %d from the session cache, %d from tickets<br>\r\n"
+                               "Session cache: %d of %d entries, %d evicted<br>\r\n"
+                               "</BODY>\r\n</HTML>\r\n",
+                               mbedtls_ssl_get_ciphersuite(&c->ssl), how[c->resumed], c->u32HandshakeMs,
+                               s_u32Full, s_u32CacheHits, s_u32TicketHits,
+                               session_cache_count(&s_cache), SESSION_CACHE_ENTRIES, s_cache.u32Evictions);
+    }
+    else
+    {
+        c->resp_len = snprintf(c->resp, sizeof(c->resp),
+                               "HTTP/1.0 404 File not found\r\nContent-type: text/html\r\nConnection: close\r\n\r\n"
+                               "<HTML>\r\n<BODY>\r\nERROR - File not found\r\n</BODY>\r\n</HTML>\r\n");
+    }
+
+    if (c->resp_len >= (int)sizeof(c->resp))
+        c->resp_len = sizeof(c->resp) - 1;
+    c->resp_off = 0;
+}
+
+static void https_serve(HTTPS_CONN_T *c)
+{
+    int ret;
+
+    if (c->eState == CONN_NEW)
+    {
+        c->u32Start = sys_now();
+        c->resumed = 0;
+        c->req_len = 0;
+        mbedtls_ssl_set_bio(&c->ssl, c, https_bio_send, https_bio_recv, NULL);
+        c->eState = CONN_HANDSHAKE;
+    }
+
+    if (c->pcb == NULL || (uint32_t)(sys_now() - c->u32Start) > HTTPS_CONN_TIMEOUT_MS)
+    {
+        https_close(c, 1);
+        return;
+    }
+
+    if (c->eState == CONN_HANDSHAKE)
+    {
+        ret = mbedtls_ssl_handshake(&c->ssl);
+        if (tls_want(ret))
+            return;
+        if (ret != 0)
+        {
+            printf("Handshake failed, -0x%04X\n", -ret);
+            https_close(c, 1);
+            return;
+        }
+        c->u32HandshakeMs = sys_now() - c->u32Start;
+        if (c->resumed == 0)
+            s_u32Full++;
+        c->eState = CONN_REQUEST;
+    }
+
+    if (c->eState == CONN_REQUEST)
+    {
+        ret = mbedtls_ssl_read(&c->ssl, (unsigned char *)c->req + c->req_len, sizeof(c->req) - 1 - c->req_len);
+        if (tls_want(ret))
+            return;
+        if (ret <= 0)
+        {
+            https_close(c, ret != 0 && ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY);
+            return;
+        }
+        c->req_len += ret;
+        c->req[c->req_len] = '\0';
+        if (strstr(c->req, "\r\n\r\n") == NULL && c->req_len < (int)sizeof(c->req) - 1)
+            return;
+
+        https_response(c);
+        c->eState = CONN_RESPONSE;
+    }
+
+    if (c->eState == CONN_RESPONSE)
+    {
+        while (c->resp_off < c->resp_len)
+        {
+            ret = mbedtls_ssl_write(&c->ssl, (const unsigned char *)c->resp + c->resp_off, c->resp_len - c->resp_off);
+            if (tls_want(ret))
+                return;
+            if (ret < 0)
+            {
+                https_close(c, 1);
+                return;
+            }
+            c->resp_off += ret;
+        }
+        c->eState = CONN_CLOSE;
+    }
+
+    if (c->eState == CONN_CLOSE)
+    {
+        ret = mbedtls_ssl_close_notify(&c->ssl);
+        if (tls_want(ret))
+            return;
+        https_close(c, 0);
+    }
+}
+
+static void https_poll(void)
+{
+    int i, busy = 0;
+
+    for (i = 0; i < HTTPS_MAX_CONN; i++)
+    {
+        if (s_asConn[i].eState == CONN_FREE)
+            continue;
+        s_psCurConn = &s_asConn[i];
+        https_serve(s_psCurConn);
+        s_psCurConn = NULL;
+        if (s_asConn[i].eState == CONN_HANDSHAKE)
+            busy = 1;
+    }
+
+    /* Between handshakes only, a ticket being issued or parsed uses the key */
+    if (!busy && (uint32_t)(sys_now() - s_u32TicketKeyTime) > HTTPS_TICKET_LIFETIME_S * 1000)
+    {
+        if (https_ticket_rekey() != 0)
+            printf("Ticket key rotation failed\n");
+    }
+}
+
+/*httpsd initialization function.*/
+static int httpsd_init(void)
+{
+    struct tcp_pcb *pcb, *pcb_listen;
+    int i, ret;
+
+    /* TLS buffers are allocated once per slot, never per connection */
+    for (i = 0; i < HTTPS_MAX_CONN; i++)
+    {
+        mbedtls_ssl_init(&s_asConn[i].ssl);
+        if ((ret = mbedtls_ssl_setup(&s_asConn[i].ssl, &s_conf)) != 0)
+            return ret;
+    }
+
+    pcb = tcp_new();
+    if (tcp_bind(pcb, NULL, HTTPS_PORT) != ERR_OK)
+        printf("bind error\n");
+    pcb_listen = tcp_listen(pcb);
+    tcp_accept(pcb_listen, https_accept);
+    return 0;
+}
+
+
+ip4_addr_t gw0, ipaddr0, netmask0;
+struct netif netif0;
+ip4_addr_t gw1, ipaddr1, netmask1;
+struct netif netif1;
+
+uint32_t sysTick = 0;
+void ETMR0_IRQHandler(void)
+{
+    sysTick++;
+    // clear timer interrupt flag
+    ETIMER_ClearIntFlag(0);
+}
+
+
+/* network initialization function.*/
+static void net_init(void)
+{
+
+#ifdef USE_DHCP
+
+    IP4_ADDR(&gw0, 0, 0, 0, 0);
+    IP4_ADDR(&ipaddr0, 0, 0, 0, 0);
+    IP4_ADDR(&netmask0, 0, 0, 0, 0);
+    IP4_ADDR(&gw1, 192, 168, 5, 1);
+    IP4_ADDR(&ipaddr1, 192, 168, 5, 227);
+    IP4_ADDR(&netmask1, 255, 255, 255, 0);
+#else
+
+    IP4_ADDR(&gw0, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr0, 192, 168, 0, 227);
+    IP4_ADDR(&netmask0, 255, 255, 255, 0);
+    IP4_ADDR(&gw1, 192, 168, 5, 1);
+    IP4_ADDR(&ipaddr1, 192, 168, 5, 227);
+    IP4_ADDR(&netmask1, 255, 255, 255, 0);
+#endif
+
+    lwip_init();
+
+    netif_add(&netif0, &ipaddr0, &netmask0, &gw0, NULL, ethernetif_init0, ethernet_input);
+    netif_add(&netif1, &ipaddr1, &netmask1, &gw1, NULL, ethernetif_init1, ethernet_input);
+    netif_set_default(&netif0);
+
+
+    netif_set_up(&netif0);
+    netif_set_up(&netif1);
+
+
+#ifdef USE_DHCP
+    dhcp_start(&netif0);
+#endif
+
+}
+
+void UART_Init(void)
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000); // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+void TIMER_Init(void)
+{
+    // lwIP needs a timer @ 100Hz. To use another timer source, please modify sys_now() in sys_arch.c as well
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+    // Set timer frequency to 100 Hz
+    ETIMER_Open(0, ETIMER_PERIODIC_MODE, 100);
+    // Enable timer interrupt
+    ETIMER_EnableInt(0);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER0, (PVOID)ETMR0_IRQHandler);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(IRQ_TIMER0);
+
+    // Start Timer 0
+    ETIMER_Start(0);
+}
+
+
+extern void chk_link0(void *arg);
+extern void chk_link1(void *arg);
+int main(void)
+{
+    int ret;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+
+    UART_Init();
+    printf("lwIP httpsd demo\n");
+    TIMER_Init();
+
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (1<<23));   /* Enable Crypto clock */
+
+    /* Needs no seed material, so it runs before the server setup below */
+    bench_handshakes();
+
+    if ((ret = tls_init()) != 0)
+    {
+        if (ret == MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED)
+            printf("No entropy: fill in https_seed_read() with seed material for this device\n");
+        printf("TLS setup failed, -0x%04X\n", -ret);
+        while (1);
+    }
+
+    net_init();
+    if ((ret = httpsd_init()) != 0)
+    {
+        printf("HTTPS setup failed, -0x%04X\n", -ret);
+        while (1);
+    }
+    sys_timeout(2000, chk_link0, NULL);
+    sys_timeout(2000, chk_link1, NULL);
+    while (1)
+    {
+        SYS_ARCH_PROTECT(lev);
+        sys_check_timeouts();
+        SYS_ARCH_UNPROTECT(lev);
+
+        https_poll();
+    }
+}
@@ -0,0 +1,130 @@
+/**************************************************************************//**
+ * @file     session_cache.c
+ * @brief    Bounded LRU TLS session cache for the HTTPS server sample.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <string.h>
+
+#include "lwip/sys.h"
+#include "mbedtls/platform_util.h"
+#include "session_cache.h"
+
+static int session_cache_expired(SESSION_CACHE_T *cache, SESSION_CACHE_ENTRY_T *entry, uint32_t now)
+{
+    return cache->u32TimeoutMs != 0 && (uint32_t)(now - entry->u32Created) > cache->u32TimeoutMs;
+}
+
+static void session_cache_drop(SESSION_CACHE_ENTRY_T *entry)
+{
+    mbedtls_platform_zeroize(entry, sizeof(*entry));
+}
+
+void session_cache_init(SESSION_CACHE_T *cache, uint32_t timeout_s)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->u32TimeoutMs = timeout_s * 1000;
+}
+
+void session_cache_free(SESSION_CACHE_T *cache)
+{
+    mbedtls_platform_zeroize(cache, sizeof(*cache));
+}
+
+uint32_t session_cache_count(SESSION_CACHE_T *cache)
+{
+    uint32_t i, n = 0;
+
+    for (i = 0; i < SESSION_CACHE_ENTRIES; i++)
+        if (cache->asEntry[i].valid)
+            n++;
+    return n;
+}
+
+int session_cache_get(void *data, mbedtls_ssl_session *session)
+{
+    SESSION_CACHE_T *cache = (SESSION_CACHE_T *)data;
+    SESSION_CACHE_ENTRY_T *entry;
+    uint32_t now = sys_now();
+    int i;
+
+    for (i = 0; i < SESSION_CACHE_ENTRIES; i++)
+    {
+        entry = &cache->asEntry[i];
+        if (!entry->valid ||
+                entry->ciphersuite != session->ciphersuite ||
+                entry->compression != session->compression ||
+                entry->id_len != session->id_len ||
+                memcmp(entry->id, session->id, entry->id_len) != 0)
+            continue;
+
+        if (session_cache_expired(cache, entry, now))
+        {
+            session_cache_drop(entry);
+            break;
+        }
+
+        memcpy(session->master, entry->master, sizeof(entry->master));
+        session->verify_result = entry->verify_result;
+        entry->u32LastUsed = now;
+        cache->u32Hits++;
+        return 0;
+    }
+
+    cache->u32Misses++;
+    return 1;
+}
+
+int session_cache_set(void *data, const mbedtls_ssl_session *session)
+{
+    SESSION_CACHE_T *cache = (SESSION_CACHE_T *)data;
+    SESSION_CACHE_ENTRY_T *entry, *slot = NULL;
+    uint32_t now = sys_now();
+    int i;
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    if (session->peer_cert != NULL)
+        return 1;
+#endif
+    if (session->id_len > sizeof(slot->id))
+        return 1;
+
+    /* Same ID, else a free or expired entry, else the least recently used */
+    for (i = 0; i < SESSION_CACHE_ENTRIES; i++)
+    {
+        entry = &cache->asEntry[i];
+        if (entry->valid && entry->id_len == session->id_len &&
+                memcmp(entry->id, session->id, entry->id_len) == 0)
+        {
+            slot = entry;
+            break;
+        }
+        if (!entry->valid || session_cache_expired(cache, entry, now))
+        {
+            if (slot == NULL || slot->valid)
+                slot = entry;
+            entry->valid = 0;
+        }
+        else if (slot == NULL || (slot->valid &&
+                                  (uint32_t)(now - entry->u32LastUsed) > (uint32_t)(now - slot->u32LastUsed)))
+        {
+            slot = entry;
+        }
+    }
+
+    if (slot->valid && (slot->id_len != session->id_len ||
+                        memcmp(slot->id, session->id, slot->id_len) != 0))
+        cache->u32Evictions++;
+
+    session_cache_drop(slot);
+    slot->valid = 1;
+    slot->u32Created = now;
+    slot->u32LastUsed = now;
+    slot->ciphersuite = session->ciphersuite;
+    slot->compression = session->compression;
+    slot->id_len = session->id_len;
+    memcpy(slot->id, session->id, session->id_len);
+    memcpy(slot->master, session->master, sizeof(slot->master));
+    slot->verify_result = session->verify_result;
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**************************************************************************//**
+ * @file     session_cache.h
+ * @brief    Bounded LRU TLS session cache for the HTTPS server sample.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __SESSION_CACHE_H__
+#define __SESSION_CACHE_H__
+
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+
+#ifndef SESSION_CACHE_ENTRIES
+#define SESSION_CACHE_ENTRIES   16      /* about 100 bytes each */
+#endif
+
+/*
+ * Only what a server needs to resume a session is kept, so an entry is a
+ * fraction of a mbedtls_ssl_cache_entry and nothing is allocated. Sessions
+ * that carry a client certificate are not cached and always get a full
+ * handshake.
+ */
+typedef struct
+{
+    int      valid;
+    uint32_t u32Created;                /* sys_now() when stored          */
+    uint32_t u32LastUsed;               /* sys_now() of the last hit      */
+    int      ciphersuite;
+    int      compression;
+    size_t   id_len;
+    unsigned char id[32];
+    unsigned char master[48];
+    uint32_t verify_result;
+} SESSION_CACHE_ENTRY_T;
+
+typedef struct
+{
+    SESSION_CACHE_ENTRY_T asEntry[SESSION_CACHE_ENTRIES];
+    uint32_t u32TimeoutMs;              /* 0 for no timeout               */
+    uint32_t u32Hits;
+    uint32_t u32Misses;
+    uint32_t u32Evictions;              /* live entries dropped for room  */
+} SESSION_CACHE_T;
+
+void session_cache_init(SESSION_CACHE_T *cache, uint32_t timeout_s);
+void session_cache_free(SESSION_CACHE_T *cache);
+uint32_t session_cache_count(SESSION_CACHE_T *cache);
+
+/* Callbacks for mbedtls_ssl_conf_session_cache(), data is the SESSION_CACHE_T */
+int session_cache_get(void *data, mbedtls_ssl_session *session);
+int session_cache_set(void *data, const mbedtls_ssl_session *session);
+
+#endif /* __SESSION_CACHE_H__ */
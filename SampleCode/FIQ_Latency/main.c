@@ -0,0 +1,211 @@
+/**************************************************************************//**
+ * @file     main.c
+ * @brief    Compare the response of a fast FIQ with the IRQ path. ETIMER0 is
+ *           bound to a register-banked FIQ handler with sysInstallFastFiq()
+ *           and ETIMER1 goes through the AIC handler table as usual, while
+ *           the main loop keeps IRQ masked half of the time like a busy
+ *           application. Both timers run in periodic mode at 12 MHz, so the
+ *           counter read first thing in each handler is the latency since
+ *           the interrupt in 83 ns steps. PB0 and PB1 toggle in the FIQ and
+ *           IRQ handlers to watch the jitter on an oscilloscope.
+ *
+ * @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "gpio.h"
+
+#define FIQ_RATE_HZ         1009    /* prime rates so the two interrupts drift past each other */
+#define IRQ_RATE_HZ         997
+#define CLOCK_TIMER         2       /* free running 12 MHz clock of the main loop */
+#define CRITICAL_US         20      /* IRQ masked by the main loop for this long, then unmasked as long */
+
+/* Latency in 12 MHz counts. The FIQ handler relies on this layout. */
+typedef struct
+{
+    UINT32 u32Count;                /* offset 0 */
+    UINT32 u32Max;                  /* offset 4 */
+    UINT32 u32Sum;                  /* offset 8 */
+} LATENCY_T;
+
+static LATENCY_T volatile sFiqLatency, sIrqLatency;
+
+/*
+ * Entered straight from the FIQ vector with banked
+ * r8 = ETIMER0 base, r9 = &sFiqLatency, r10 = PB0 data register.
+ * Only r8 to r12 are used, so nothing is saved.
+ */
+#if defined (__GNUC__) && !(__CC_ARM)
+static void __attribute__ ((naked)) ETMR0_FastFiqHandler(void)
+{
+    asm volatile
+    (
+        "LDR    r12, [r8, #0x14]        \n"    /* ETIMER0 DR, counts since the interrupt */
+        "LDR    r11, [r10]              \n"
+        "EOR    r11, r11, #1            \n"
+        "STR    r11, [r10]              \n"    /* toggle PB0 */
+        "MOV    r11, #1                 \n"
+        "STR    r11, [r8, #0x10]        \n"    /* clear ETIMER0 interrupt flag */
+        "LDR    r11, [r9, #4]           \n"
+        "CMP    r12, r11                \n"
+        "STRHI  r12, [r9, #4]           \n"    /* u32Max */
+        "LDR    r11, [r9, #8]           \n"
+        "ADD    r11, r11, r12           \n"
+        "STR    r11, [r9, #8]           \n"    /* u32Sum */
+        "LDR    r11, [r9]               \n"
+        "ADD    r11, r11, #1            \n"
+        "STR    r11, [r9]               \n"    /* u32Count */
+        "LDR    r11, =0xB0042154        \n"    /* REG_AIC_EOFS */
+        "MOV    r12, #1                 \n"
+        "STR    r12, [r11]              \n"
+        "SUBS   pc, lr, #4              \n"
+        ".ltorg                         \n"
+    );
+}
+#else
+static __asm void ETMR0_FastFiqHandler(void)
+{
+    LDR     r12, [r8, #0x14]            ; ETIMER0 DR, counts since the interrupt
+    LDR     r11, [r10]
+    EOR     r11, r11, #1
+    STR     r11, [r10]                  ; toggle PB0
+    MOV     r11, #1
+    STR     r11, [r8, #0x10]            ; clear ETIMER0 interrupt flag
+    LDR     r11, [r9, #4]
+    CMP     r12, r11
+    STRHI   r12, [r9, #4]               ; u32Max
+    LDR     r11, [r9, #8]
+    ADD     r11, r11, r12
+    STR     r11, [r9, #8]               ; u32Sum
+    LDR     r11, [r9]
+    ADD     r11, r11, #1
+    STR     r11, [r9]                   ; u32Count
+    LDR     r11, =0xB0042154            ; REG_AIC_EOFS
+    MOV     r12, #1
+    STR     r12, [r11]
+    SUBS    pc, lr, #4
+}
+#endif
+
+void ETMR1_IRQHandler(void)
+{
+    UINT32 u32Counts = ETIMER_GetCounter(1);
+
+    PB1 ^= 1;
+    ETIMER_ClearIntFlag(1);
+
+    if (u32Counts > sIrqLatency.u32Max)
+        sIrqLatency.u32Max = u32Counts;
+    sIrqLatency.u32Sum += u32Counts;
+    sIrqLatency.u32Count++;
+}
+
+/*-----------------------------------------------------------------------------*/
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);   // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+static void Delay_us(UINT32 u32Us)
+{
+    UINT32 u32Start = ETIMER_GetCounter(CLOCK_TIMER);
+
+    while (((ETIMER_GetCounter(CLOCK_TIMER) - u32Start) & 0xFFFFFF) < u32Us * 12);
+}
+
+static void PrintLatency(const char *pcName, LATENCY_T volatile *psLatency)
+{
+    LATENCY_T sLatency;
+
+    /* take a consistent copy, FIQ is masked for a few instructions only */
+    sysSetLocalInterrupt(DISABLE_FIQ_IRQ);
+    sLatency = *psLatency;
+    psLatency->u32Count = 0;
+    psLatency->u32Max = 0;
+    psLatency->u32Sum = 0;
+    sysSetLocalInterrupt(ENABLE_FIQ_IRQ);
+
+    if (sLatency.u32Count == 0)
+    {
+        printf("%s: no interrupt\n", pcName);
+        return;
+    }
+
+    printf("%s: %4d interrupts, latency avg %5d ns, max %5d ns\n", pcName, sLatency.u32Count,
+           sLatency.u32Sum / sLatency.u32Count * 1000 / 12, sLatency.u32Max * 1000 / 12);
+}
+
+int main(void)
+{
+    UINT32 au32FiqRegs[5];
+    UINT32 u32LastReport;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+    UART_Init();
+
+    printf("\nETIMER0 on the fast FIQ path at %d Hz, ETIMER1 on the IRQ path at %d Hz\n", FIQ_RATE_HZ, IRQ_RATE_HZ);
+    printf("The main loop masks IRQ for %d us out of every %d us\n\n", CRITICAL_US, CRITICAL_US * 2);
+
+    // PB0 and PB1 are GPIO outputs
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | (1 << 11));
+    outpw(REG_SYS_GPB_MFPL, inpw(REG_SYS_GPB_MFPL) & ~0xFF);
+    GPIO_SetMode(PB, BIT0 | BIT1, GPIO_MODE_OUTPUT);
+
+    // Enable ETIMER0, ETIMER1 and ETIMER2 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8) | (1 << 9) | (1 << (8 + CLOCK_TIMER)));
+
+    ETIMER_Open(CLOCK_TIMER, ETIMER_CONTINUOUS_MODE, 1);
+    ETIMER_Start(CLOCK_TIMER);
+
+    // ETIMER0 on the fast FIQ, its handler state lives in the banked registers
+    au32FiqRegs[0] = ETMR0_BA;
+    au32FiqRegs[1] = (UINT32)&sFiqLatency;
+    au32FiqRegs[2] = (UINT32)&PB0;
+    au32FiqRegs[3] = 0;
+    au32FiqRegs[4] = 0;
+    ETIMER_Open(0, ETIMER_PERIODIC_MODE, FIQ_RATE_HZ);
+    ETIMER_EnableInt(0);
+    sysInstallFastFiq(IRQ_TIMER0, (PVOID)ETMR0_FastFiqHandler, au32FiqRegs);
+    sysEnableInterrupt(IRQ_TIMER0);
+
+    // ETIMER1 on the IRQ path
+    ETIMER_Open(1, ETIMER_PERIODIC_MODE, IRQ_RATE_HZ);
+    ETIMER_EnableInt(1);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER1, (PVOID)ETMR1_IRQHandler);
+    sysEnableInterrupt(IRQ_TIMER1);
+
+    sysSetLocalInterrupt(ENABLE_FIQ_IRQ);
+    ETIMER_Start(0);
+    ETIMER_Start(1);
+
+    u32LastReport = ETIMER_GetCounter(CLOCK_TIMER);
+    while(1)
+    {
+        // Application critical section
+        sysSetLocalInterrupt(DISABLE_IRQ);
+        Delay_us(CRITICAL_US);
+        sysSetLocalInterrupt(ENABLE_IRQ);
+        Delay_us(CRITICAL_US);
+
+        // Report every second, the 24-bit clock wraps every 1.4 s
+        if (((ETIMER_GetCounter(CLOCK_TIMER) - u32LastReport) & 0xFFFFFF) >= 12000000)
+        {
+            u32LastReport = ETIMER_GetCounter(CLOCK_TIMER);
+            PrintLatency("FIQ", &sFiqLatency);
+            PrintLatency("IRQ", &sIrqLatency);
+        }
+    }
+}
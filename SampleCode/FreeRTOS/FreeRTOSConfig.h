@@ -48,14 +48,50 @@
 #define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES        ( 4 )
 #define configMINIMAL_STACK_SIZE    ( ( unsigned short ) 90 )
-#define configTOTAL_HEAP_SIZE       ( ( size_t ) 13 * 1024 )
+#define configTOTAL_HEAP_SIZE       ( ( size_t ) 256 * 1024 )
 #define configMAX_TASK_NAME_LEN     ( 8 )
-#define configUSE_TRACE_FACILITY    0
+#define configUSE_TRACE_FACILITY    1
 #define configUSE_16_BIT_TICKS      0
 #define configIDLE_SHOULD_YIELD     1
 
+/* Stop the tick while the idle task sleeps, see vPortSuppressTicksAndSleep().
+Set configNUC980_TICKLESS_POWER_DOWN to 1 to use power-down instead of idle. */
+#define configUSE_TICKLESS_IDLE             1
+#define configNUC980_TICKLESS_POWER_DOWN    0
+
+/* Let an IRQ of a higher AIC priority level interrupt the handler of a lower
+one.  Handlers then run on a dedicated stack of configNUC980_IRQ_STACK_SIZE
+words. */
+#define configNUC980_NESTED_IRQ             1
+#define configNUC980_IRQ_STACK_SIZE         512
+
+/* Run time of each task, clocked by ETIMER4 at portRUN_TIME_COUNTER_HZ, see
+cpu_stats.c. */
+#define configGENERATE_RUN_TIME_STATS   1
+
+/* Check that the lowest 16 bytes of the stack of the task switched out, and
+of the interrupt stack after each interrupt, still hold the fill pattern; the
+stack margins are printed by cpu_stats.c. */
+#define configCHECK_FOR_STACK_OVERFLOW  2
+
 #define configQUEUE_REGISTRY_SIZE   0
 
+/* The buffer pools of buf_pool.c count their free blocks with a semaphore. */
+#define configUSE_COUNTING_SEMAPHORES   1
+
+/* The crypto engine lock of crypto_queue.c is a recursive mutex, see
+crypto_jobs.c. */
+#define configUSE_MUTEXES               1
+#define configUSE_RECURSIVE_MUTEXES     1
+
+/* heap_tlsf.c returns 32-byte aligned memory, so that any block can be used
+for DMA, and counts the memory taken by each task, see cpu_stats.c. */
+#define configHEAP_TLSF_ALIGNMENT_LOG2  5
+#define configHEAP_TLSF_TASK_SLOTS      16
+
+/* Frees the heap_tlsf.c slot of a deleted task for the next new one. */
+#define portCLEAN_UP_TCB( pxTCB )       vPortHeapTaskDeleted( pxTCB )
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES       0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -73,5 +109,9 @@ to exclude the API function. */
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
 #define INCLUDE_pcTaskGetTaskName               1
 #define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_uxTaskGetStackHighWaterMark     1
+
+/* Record task switches, interrupts and queue operations in a RAM ring. */
+#include "trace_ring.h"
 
 #endif /* FREERTOS_CONFIG_H */
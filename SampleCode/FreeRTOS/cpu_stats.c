@@ -0,0 +1,222 @@
+/*
+ * cpu_stats.c - Print which task uses the CPU, and dump the trace on request
+ *
+ * Every statsPERIOD_MS the task takes a snapshot of uxTaskGetSystemState()
+ * and prints the run time of each task since the previous snapshot as a
+ * share of the run-time clock.  Unlike vTaskGetRunTimeStats(), which
+ * averages since boot, this shows the current load and copes with the
+ * 32-bit run-time counter wrapping.  The state of heap_tlsf.c follows: the
+ * free space, how much of it is in the largest block, which shows how
+ * fragmented the heap is, and the memory held by each task.  Last come the
+ * stack margins: the words each task stack never used, the same for the
+ * interrupt stack of the port, and the deepest use of the processor mode
+ * stacks of the startup code.  With configCHECK_FOR_STACK_OVERFLOW set to 2
+ * the lowest words of all of them are checked as well, see main.c.
+ *
+ * Typing 'd' on the console sends the trace ring of trace_ring.c as binary
+ * on UART0.  Capture the console to a file and run
+ *     python trace_decode.py capture.bin --timeline
+ * to get the CPU time of every task and interrupt and what ran when.
+ */
+
+#include <stdio.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+
+#include "trace_ring.h"
+
+#define statsPERIOD_MS          5000
+#define statsPOLL_MS            100
+#define statsMAX_TASKS          24
+#define statsHEAP_SLOTS         16
+#define statsSTACK_LOW_WORDS    32
+
+static TaskStatus_t xStatus[ 2 ][ statsMAX_TASKS ];
+static HeapTaskStats_t xHeapTasks[ statsHEAP_SLOTS ];
+
+/*-----------------------------------------------------------*/
+
+/* The dump goes to the UART registers rather than through printf(), which
+would turn every 0x0A byte into CR LF. */
+static void prvUartWrite( const void *pvData, size_t xLength )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+
+    while( xLength-- > 0 )
+    {
+        while( inpw( REG_UART0_FSR ) & ( 1 << 23 ) );   /* TX FIFO full */
+        outpw( REG_UART0_THR, *pucData++ );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvDumpTrace( void )
+{
+size_t xBytes;
+
+    printf( "\nTrace dump follows\n" );
+
+    /* Keep the other tasks from printing in the middle of it. */
+    vTaskSuspendAll();
+    xBytes = xTraceRingDump( prvUartWrite );
+    xTaskResumeAll();
+
+    printf( "\nTrace dump done, %u bytes\n", ( unsigned ) xBytes );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintLoad( TaskStatus_t *pxNow, UBaseType_t uxNow, uint32_t ulTotal,
+                          TaskStatus_t *pxBefore, UBaseType_t uxBefore )
+{
+UBaseType_t x, y;
+uint32_t ulTime, ulPermille;
+
+    printf( "CPU usage over the last %u ms:\n", ( unsigned ) ( ulTotal / ( portRUN_TIME_COUNTER_HZ / 1000 ) ) );
+
+    for( x = 0; x < uxNow; x++ )
+    {
+        /* Time since the previous snapshot, or since creation for a new
+        task. */
+        ulTime = pxNow[ x ].ulRunTimeCounter;
+        for( y = 0; y < uxBefore; y++ )
+        {
+            if( pxBefore[ y ].xTaskNumber == pxNow[ x ].xTaskNumber )
+            {
+                ulTime -= pxBefore[ y ].ulRunTimeCounter;
+                break;
+            }
+        }
+
+        ulPermille = ( uint32_t ) ( ( uint64_t ) ulTime * 1000 / ulTotal );
+        printf( "  %-*s %3u.%u%%\n", configMAX_TASK_NAME_LEN, pxNow[ x ].pcTaskName,
+                ( unsigned ) ( ulPermille / 10 ), ( unsigned ) ( ulPermille % 10 ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintHeap( TaskStatus_t *pxNow, UBaseType_t uxNow )
+{
+HeapStats_t xHeap;
+UBaseType_t x, y, uxSlots;
+const char *pcName;
+
+    vPortGetHeapStats( &xHeap );
+    printf( "Heap: %u bytes free in %u blocks, largest %u (%u%% fragmented), lowest ever %u, %u allocs %u frees\n",
+            ( unsigned ) xHeap.xAvailableHeapSpaceInBytes, ( unsigned ) xHeap.xNumberOfFreeBlocks,
+            ( unsigned ) xHeap.xSizeOfLargestFreeBlockInBytes,
+            ( unsigned ) ( ( xHeap.xAvailableHeapSpaceInBytes == 0 ) ? 0 :
+                           100 - ( uint64_t ) xHeap.xSizeOfLargestFreeBlockInBytes * 100 / xHeap.xAvailableHeapSpaceInBytes ),
+            ( unsigned ) xHeap.xMinimumEverFreeBytesRemaining,
+            ( unsigned ) xHeap.xNumberOfSuccessfulAllocations, ( unsigned ) xHeap.xNumberOfSuccessfulFrees );
+
+    /* Only the handles of the snapshot are looked up, a handle in the heap
+    table may belong to a deleted task. */
+    uxSlots = uxPortGetHeapTaskStats( xHeapTasks, statsHEAP_SLOTS );
+    for( x = 0; x < uxSlots; x++ )
+    {
+        if( xHeapTasks[ x ].xBytesInUse == 0 )
+        {
+            continue;
+        }
+
+        pcName = ( xHeapTasks[ x ].pvTask == NULL ) ? "(start)" : "(gone)";
+        for( y = 0; y < uxNow; y++ )
+        {
+            if( ( void * ) pxNow[ y ].xHandle == xHeapTasks[ x ].pvTask )
+            {
+                pcName = pxNow[ y ].pcTaskName;
+                break;
+            }
+        }
+
+        printf( "  %-*s %7u bytes, peak %7u, %u allocs %u frees\n", configMAX_TASK_NAME_LEN, pcName,
+                ( unsigned ) xHeapTasks[ x ].xBytesInUse, ( unsigned ) xHeapTasks[ x ].xPeakBytesInUse,
+                ( unsigned ) xHeapTasks[ x ].xAllocations, ( unsigned ) xHeapTasks[ x ].xFrees );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintStacks( TaskStatus_t *pxNow, UBaseType_t uxNow )
+{
+static const char * const pcModes[ SYS_STACK_NUM ] = { "UND", "ABT", "IRQ", "FIQ", "SYS", "SVC" };
+SYS_STACK_INFO_T xInfo;
+UBaseType_t x;
+uint32_t ulGuards;
+
+    printf( "Stacks, words never used:\n" );
+    for( x = 0; x < uxNow; x++ )
+    {
+        printf( "  %-*s %5u%s\n", configMAX_TASK_NAME_LEN, pxNow[ x ].pcTaskName,
+                ( unsigned ) pxNow[ x ].usStackHighWaterMark,
+                ( pxNow[ x ].usStackHighWaterMark < statsSTACK_LOW_WORDS ) ? " low" : "" );
+    }
+
+    #if configNUC980_NESTED_IRQ == 1
+    {
+        printf( "  %-*s %5u of %u\n", configMAX_TASK_NAME_LEN, "(irq)",
+                ( unsigned ) uxPortGetIrqStackHighWaterMark(), ( unsigned ) configNUC980_IRQ_STACK_SIZE );
+    }
+    #endif
+
+    ulGuards = sysCheckStackGuards();
+    printf( "Mode stacks, bytes used:" );
+    for( x = 0; x < SYS_STACK_NUM; x++ )
+    {
+        sysGetStackInfo( x, &xInfo );
+        printf( " %s %u/%u%s", pcModes[ x ], ( unsigned ) xInfo.u32MaxUsed, ( unsigned ) xInfo.u32Size,
+                ( ulGuards & ( 1UL << x ) ) ? " OVERFLOW" : "" );
+    }
+    printf( "\n" );
+}
+/*-----------------------------------------------------------*/
+
+static void vCpuStatsTask( void *pvParameters )
+{
+UBaseType_t uxCount[ 2 ];
+uint32_t ulTotal[ 2 ];
+BaseType_t xNow = 0;
+TickType_t xLastReport;
+
+    ( void ) pvParameters;
+
+    uxCount[ xNow ] = uxTaskGetSystemState( xStatus[ xNow ], statsMAX_TASKS, &ulTotal[ xNow ] );
+    xLastReport = xTaskGetTickCount();
+
+    for( ;; )
+    {
+        vTaskDelay( statsPOLL_MS / portTICK_PERIOD_MS );
+
+        if( ( inpw( REG_UART0_FSR ) & ( 1 << 14 ) ) == 0 )    /* RX not empty */
+        {
+            if( inpw( REG_UART0_RBR ) == 'd' )
+            {
+                prvDumpTrace();
+            }
+        }
+
+        if( ( xTaskGetTickCount() - xLastReport ) >= statsPERIOD_MS / portTICK_PERIOD_MS )
+        {
+            xLastReport = xTaskGetTickCount();
+            xNow = !xNow;
+            uxCount[ xNow ] = uxTaskGetSystemState( xStatus[ xNow ], statsMAX_TASKS, &ulTotal[ xNow ] );
+
+            prvPrintLoad( xStatus[ xNow ], uxCount[ xNow ], ulTotal[ xNow ] - ulTotal[ !xNow ],
+                          xStatus[ !xNow ], uxCount[ !xNow ] );
+            prvPrintHeap( xStatus[ xNow ], uxCount[ xNow ] );
+            prvPrintStacks( xStatus[ xNow ], uxCount[ xNow ] );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartCpuStatsTask( UBaseType_t uxPriority )
+{
+    vTraceRingStart();
+    xTaskCreate( vCpuStatsTask, "Stats", configMINIMAL_STACK_SIZE * 3, NULL, uxPriority, NULL );
+}
@@ -0,0 +1,233 @@
+/*
+ * crypto_jobs.c - Run queued crypto jobs next to mbed TLS on one engine
+ *
+ * A job task hashes and encrypts a buffer of cjBUFFER_SIZE bytes per round
+ * with CryptoQueueLib SHA-256 and AES-128-CBC jobs, while a second task
+ * hashes and encrypts the same data, rebuilt from the round number, through
+ * mbed TLS.  The mbed TLS hooks take the CryptoQueueLib engine lock, so the
+ * engine switches between the worker and the mbed TLS task at job, AES call
+ * and hash stream granularity.  The hash is fed in several updates with a
+ * yield in between, so a hardware SHA-256 stream is held across calls while
+ * jobs queue up behind it; a stream that finds the engine busy runs in
+ * software.
+ *
+ * The job task sends the digest and the last ciphertext block of each round
+ * to the mbed TLS task, which compares them with its own.  Every cjREPORT
+ * rounds the mbed TLS task prints the rounds done and the mismatches.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+#include "crypto.h"
+
+#include "crypto_queue.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/aes.h"
+
+#define cjBUFFER_SIZE           2048
+#define cjUPDATES               3
+#define cjREPORT                200
+#define cjRESULT_QUEUE_LENGTH   4
+
+typedef struct
+{
+    uint32_t ulRound;
+    uint8_t ucDigest[ 32 ];
+    uint8_t ucLastBlock[ 16 ];
+} CryptoResult_t;
+
+static const uint8_t ucKey[ 16 ] =
+{
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t ucIV[ 16 ] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+/* Set by an application CRYPTO handler for the mbed TLS hooks; the
+CryptoQueueLib handler leaves it alone and the hooks poll the engine. */
+volatile int g_Crypto_Int_done = 0;
+
+static QueueHandle_t xResultQueue;
+static uint32_t ulErrors = 0;
+
+/* Job buffers are DMA buffers in cacheable memory, so whole cache lines. */
+static uint8_t ucJobPlain[ cjBUFFER_SIZE ] __attribute__( ( aligned( 32 ) ) );
+static uint8_t ucJobCipher[ cjBUFFER_SIZE ] __attribute__( ( aligned( 32 ) ) );
+static uint32_t ulJobDigest[ 8 ];
+
+/* mbed TLS side, off the task stack. */
+static uint8_t ucTlsPlain[ cjBUFFER_SIZE ];
+static uint8_t ucTlsCipher[ cjBUFFER_SIZE ];
+static mbedtls_sha256_context xSha;
+static mbedtls_aes_context xAes;
+
+/* Engine words hold the bytes big-endian, as the mbed TLS hooks load them. */
+#define cjGET_BE32( p )         ( ( ( uint32_t ) ( p )[ 0 ] << 24 ) | ( ( uint32_t ) ( p )[ 1 ] << 16 ) | \
+                                  ( ( uint32_t ) ( p )[ 2 ] << 8 ) | ( uint32_t ) ( p )[ 3 ] )
+
+/*-----------------------------------------------------------*/
+
+static void prvFillRound( uint8_t *pucBuffer, uint32_t ulRound )
+{
+uint32_t ulIndex, ulValue;
+
+    ulValue = ulRound * 2654435761UL;
+    for( ulIndex = 0; ulIndex < cjBUFFER_SIZE; ulIndex++ )
+    {
+        ulValue = ulValue * 1103515245UL + 12345UL;
+        pucBuffer[ ulIndex ] = ( uint8_t ) ( ulValue >> 24 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void vCryptoJobTask( void *pvParameters )
+{
+CRYPTOQ_JOB_T xAesJob, xShaJob;
+CryptoResult_t xResult;
+uint32_t ulRound, ulIndex;
+int32_t lAesStatus, lShaStatus;
+
+    ( void ) pvParameters;
+
+    memset( &xAesJob, 0, sizeof( xAesJob ) );
+    xAesJob.u32Type = CRYPTOQ_JOB_AES;
+    xAesJob.u.sAES.u32OpMode = AES_MODE_CBC;
+    xAesJob.u.sAES.u32EncDec = 1;
+    xAesJob.u.sAES.u32KeySize = AES_KEY_SIZE_128;
+    xAesJob.u.sAES.u32SwapType = AES_IN_OUT_SWAP;
+    for( ulIndex = 0; ulIndex < 4; ulIndex++ )
+    {
+        xAesJob.u.sAES.au32Key[ ulIndex ] = cjGET_BE32( &ucKey[ ulIndex * 4 ] );
+        xAesJob.u.sAES.au32IV[ ulIndex ] = cjGET_BE32( &ucIV[ ulIndex * 4 ] );
+    }
+    xAesJob.u.sAES.u32SrcAddr = ( uint32_t ) ucJobPlain;
+    xAesJob.u.sAES.u32DstAddr = ( uint32_t ) ucJobCipher;
+    xAesJob.u.sAES.u32Length = cjBUFFER_SIZE;
+
+    memset( &xShaJob, 0, sizeof( xShaJob ) );
+    xShaJob.u32Type = CRYPTOQ_JOB_SHA;
+    xShaJob.u.sSHA.u32OpMode = SHA_MODE_SHA256;
+    xShaJob.u.sSHA.u32SwapType = SHA_IN_SWAP;
+    xShaJob.u.sSHA.u32SrcAddr = ( uint32_t ) ucJobPlain;
+    xShaJob.u.sSHA.u32Length = cjBUFFER_SIZE;
+    xShaJob.u.sSHA.pu32Digest = ulJobDigest;
+
+    for( ulRound = 0; ; ulRound++ )
+    {
+        prvFillRound( ucJobPlain, ulRound );
+
+        /* Both jobs read the same source, queue them back to back. */
+        lAesStatus = CRYPTOQ_Submit( &xAesJob, portMAX_DELAY );
+        lShaStatus = CRYPTOQ_Submit( &xShaJob, portMAX_DELAY );
+        if( lAesStatus == CRYPTOQ_OK )
+        {
+            lAesStatus = CRYPTOQ_Wait( &xAesJob, portMAX_DELAY );
+        }
+        if( lShaStatus == CRYPTOQ_OK )
+        {
+            lShaStatus = CRYPTOQ_Wait( &xShaJob, portMAX_DELAY );
+        }
+
+        xResult.ulRound = ulRound;
+        if( ( lAesStatus != CRYPTOQ_OK ) || ( lShaStatus != CRYPTOQ_OK ) )
+        {
+            printf( "Crypto jobs: round %u failed, AES %d, SHA %d\n",
+                    ( unsigned ) ulRound, ( int ) lAesStatus, ( int ) lShaStatus );
+            memset( xResult.ucDigest, 0, sizeof( xResult.ucDigest ) );
+            memset( xResult.ucLastBlock, 0, sizeof( xResult.ucLastBlock ) );
+        }
+        else
+        {
+            for( ulIndex = 0; ulIndex < 8; ulIndex++ )
+            {
+                xResult.ucDigest[ ulIndex * 4 ] = ( uint8_t ) ( ulJobDigest[ ulIndex ] >> 24 );
+                xResult.ucDigest[ ulIndex * 4 + 1 ] = ( uint8_t ) ( ulJobDigest[ ulIndex ] >> 16 );
+                xResult.ucDigest[ ulIndex * 4 + 2 ] = ( uint8_t ) ( ulJobDigest[ ulIndex ] >> 8 );
+                xResult.ucDigest[ ulIndex * 4 + 3 ] = ( uint8_t ) ulJobDigest[ ulIndex ];
+            }
+            memcpy( xResult.ucLastBlock, &ucJobCipher[ cjBUFFER_SIZE - 16 ], 16 );
+        }
+
+        xQueueSend( xResultQueue, &xResult, portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void vCryptoTlsTask( void *pvParameters )
+{
+CryptoResult_t xResult;
+uint8_t ucDigest[ 32 ];
+uint8_t ucIVCopy[ 16 ];
+uint32_t ulRound, ulIndex, ulChunk;
+
+    ( void ) pvParameters;
+
+    mbedtls_aes_init( &xAes );
+    mbedtls_aes_setkey_enc( &xAes, ucKey, 128 );
+
+    for( ulRound = 0; ; ulRound++ )
+    {
+        prvFillRound( ucTlsPlain, ulRound );
+
+        /* A stream that got the engine holds it until finish, across the yields. */
+        mbedtls_sha256_init( &xSha );
+        mbedtls_sha256_starts_ret( &xSha, 0 );
+        ulChunk = cjBUFFER_SIZE / cjUPDATES;
+        for( ulIndex = 0; ulIndex < cjBUFFER_SIZE; ulIndex += ulChunk )
+        {
+            if( ulChunk > cjBUFFER_SIZE - ulIndex )
+            {
+                ulChunk = cjBUFFER_SIZE - ulIndex;
+            }
+            mbedtls_sha256_update_ret( &xSha, &ucTlsPlain[ ulIndex ], ulChunk );
+            taskYIELD();
+        }
+        mbedtls_sha256_finish_ret( &xSha, ucDigest );
+        mbedtls_sha256_free( &xSha );
+
+        memcpy( ucIVCopy, ucIV, sizeof( ucIVCopy ) );
+        mbedtls_aes_crypt_cbc( &xAes, MBEDTLS_AES_ENCRYPT, cjBUFFER_SIZE, ucIVCopy, ucTlsPlain, ucTlsCipher );
+
+        xQueueReceive( xResultQueue, &xResult, portMAX_DELAY );
+        if( ( xResult.ulRound != ulRound ) ||
+            ( memcmp( xResult.ucDigest, ucDigest, sizeof( ucDigest ) ) != 0 ) ||
+            ( memcmp( xResult.ucLastBlock, &ucTlsCipher[ cjBUFFER_SIZE - 16 ], 16 ) != 0 ) )
+        {
+            ulErrors++;
+        }
+
+        if( ( ulRound % cjREPORT ) == ( cjREPORT - 1 ) )
+        {
+            printf( "Crypto jobs: %u rounds of %u bytes, %u mismatches\n",
+                    ( unsigned ) ( ulRound + 1 ), ( unsigned ) cjBUFFER_SIZE, ( unsigned ) ulErrors );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartCryptoQueueTest( UBaseType_t uxPriority )
+{
+    /* Enable Crypto clock */
+    outpw( REG_CLK_HCLKEN, inpw( REG_CLK_HCLKEN ) | ( 1 << 23 ) );
+
+    xResultQueue = xQueueCreate( cjRESULT_QUEUE_LENGTH, sizeof( CryptoResult_t ) );
+    if( ( xResultQueue == NULL ) || ( CRYPTOQ_Init( uxPriority + 1 ) != CRYPTOQ_OK ) )
+    {
+        printf( "Crypto jobs test: out of heap\n" );
+        return;
+    }
+
+    xTaskCreate( vCryptoJobTask, "CqJob", configMINIMAL_STACK_SIZE * 3, NULL, uxPriority, NULL );
+    xTaskCreate( vCryptoTlsTask, "CqTls", configMINIMAL_STACK_SIZE * 3, NULL, uxPriority, NULL );
+}
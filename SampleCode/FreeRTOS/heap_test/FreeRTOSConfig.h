@@ -0,0 +1,34 @@
+/*
+ * FreeRTOSConfig.h - Host configuration for heap_tlsf_test.c
+ *
+ * Only what FreeRTOS.h, task.h and heap_tlsf.c need.  The first level stops
+ * at 64 KB so that the test regions are larger than the biggest allocation,
+ * and the task table is small enough to fill up.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configUSE_PREEMPTION        1
+#define configUSE_IDLE_HOOK         0
+#define configUSE_TICK_HOOK         0
+#define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES        ( 4 )
+#define configMINIMAL_STACK_SIZE    ( ( unsigned short ) 90 )
+#define configTOTAL_HEAP_SIZE       ( ( size_t ) 48 * 1024 )
+#define configMAX_TASK_NAME_LEN     ( 8 )
+#define configUSE_16_BIT_TICKS      0
+#define configUSE_CO_ROUTINES       0
+
+#define configHEAP_TLSF_ALIGNMENT_LOG2  5
+#define configHEAP_TLSF_FL_INDEX_MAX    16
+#define configHEAP_TLSF_POOLS           2
+#define configHEAP_TLSF_TASK_SLOTS      4
+
+#define INCLUDE_xTaskGetCurrentTaskHandle   1
+#define INCLUDE_xTaskGetSchedulerState      1
+
+extern void vAssertCalled( const char *pcFile, int iLine );
+#define configASSERT( x )           if( !( x ) ) vAssertCalled( __FILE__, __LINE__ )
+
+#endif /* FREERTOS_CONFIG_H */
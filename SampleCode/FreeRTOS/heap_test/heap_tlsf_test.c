@@ -0,0 +1,525 @@
+/*
+ * heap_tlsf_test.c - Host test of heap_tlsf.c
+ *
+ * Builds heap_tlsf.c into the test, with the FreeRTOSConfig.h and
+ * portmacro.h of this directory and stubs for the few task functions it
+ * calls, so the allocator runs unchanged on a Linux host:
+ *
+ * gcc -g -O1 -Wall -fsanitize=address,undefined -I. \
+ *     -I../../../ThirdParty/FreeRTOS/Source/include \
+ *     -I../../../ThirdParty/FreeRTOS/Source/portable/MemMang \
+ *     heap_tlsf_test.c -o heap_tlsf_test && ./heap_tlsf_test [rounds] [seed]
+ *
+ * Pool 0 gets the static heap and a second region larger than the biggest
+ * allocation, pool 1 a region that does not start on a cache line.  Fake tasks
+ * then allocate, reallocate and free random sizes, every block filled with a
+ * pattern that is checked before it is resized or freed, and every
+ * htCHECK_PERIOD steps the whole heap is walked:
+ *
+ *  - each block follows the one before it, pxPrevPhys points back to it, and
+ *    it belongs to the pool of its region;
+ *  - addresses and sizes are multiples of the cache line, so no returned
+ *    line is shared with a header;
+ *  - no two free blocks are next to each other;
+ *  - each free block is in the list its size maps to, and the bitmaps are set
+ *    exactly for the non-empty lists;
+ *  - the free bytes add up to xPortGetFreeHeapSize(), the allocated ones to
+ *    the bytes in use of the task table;
+ *  - every block is charged to the slot of the task that owns it, or to
+ *    slot 0, and a live task keeps its slot.
+ *
+ * Once everything is freed each region must be back to a single free block.
+ * A first test checks the task table on its own: a live task that holds no
+ * memory keeps its slot, and a deleted task gives it up once its memory is
+ * freed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heap_tlsf.c"
+
+#define htROUNDS                200000UL
+#define htCHECK_PERIOD          64
+#define htLIVE_BLOCKS           256
+#define htTASKS                 6
+#define htLARGE_REGION_SIZE     ( ( size_t ) 100 * 1024 )
+#define htPOOL1_REGION_SIZE     ( ( size_t ) 40 * 1024 )
+
+typedef struct
+{
+    uint8_t *pucData;
+    size_t xSize;
+    uint8_t ucSeed;
+    UBaseType_t uxPool;
+    void *pvOwner;
+} HostBlock_t;
+
+/* A region as prvAddRegion() lays it out: its first block, and its pool. */
+typedef struct
+{
+    TlsfBlock_t *pxFirst;
+    UBaseType_t uxPool;
+} HostRegion_t;
+
+static uint8_t ucLargeRegion[ htLARGE_REGION_SIZE ];
+static uint8_t ucPool1Region[ htPOOL1_REGION_SIZE ];
+static HostRegion_t xRegions[ 3 ];
+static UBaseType_t uxRegions = 0;
+
+static HostBlock_t xLive[ htLIVE_BLOCKS ];
+
+/* Each fake task is a distinct address; a deleted task is replaced by a new
+one at the next address. */
+static uint8_t ucTaskHandles[ 4096 ];
+static UBaseType_t uxNextHandle = 0;
+static void *pvTasks[ htTASKS ];
+static uint8_t ucTaskSlot[ htTASKS ];
+
+static void *pvCurrentTask = NULL;
+static BaseType_t xSchedulerState = taskSCHEDULER_NOT_STARTED;
+static int iSuspendNesting = 0;
+static uint32_t ulRandom;
+
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char *pcFile, int iLine )
+{
+    printf( "FAIL: assert at %s:%d\n", pcFile, iLine );
+    exit( 1 );
+}
+
+void vTaskSuspendAll( void )
+{
+    iSuspendNesting++;
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    configASSERT( iSuspendNesting > 0 );
+    iSuspendNesting--;
+    return pdFALSE;
+}
+
+BaseType_t xTaskGetSchedulerState( void )
+{
+    return xSchedulerState;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle( void )
+{
+    return ( TaskHandle_t ) pvCurrentTask;
+}
+/*-----------------------------------------------------------*/
+
+#define htCHECK( x )            if( !( x ) ) vAssertCalled( __FILE__, __LINE__ )
+
+static uint32_t prvRand( void )
+{
+    ulRandom ^= ulRandom << 13;
+    ulRandom ^= ulRandom >> 17;
+    ulRandom ^= ulRandom << 5;
+    return ulRandom;
+}
+
+static void *prvNewTask( void )
+{
+    htCHECK( uxNextHandle < sizeof( ucTaskHandles ) );
+    return &ucTaskHandles[ uxNextHandle++ ];
+}
+
+static TlsfBlock_t *prvHeader( void *pv )
+{
+    return ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - heapHEADER_SIZE );
+}
+
+static void prvAddRegionFor( UBaseType_t uxPool, uint8_t *pucStart, size_t xSize )
+{
+    vPortAddHeapRegion( uxPool, pucStart, xSize );
+    xRegions[ uxRegions ].pxFirst = ( TlsfBlock_t * ) ( ( ( size_t ) pucStart + heapALIGNMENT_MASK ) & heapSIZE_MASK );
+    xRegions[ uxRegions ].uxPool = uxPool;
+    uxRegions++;
+}
+
+static void prvFill( HostBlock_t *pxLive )
+{
+size_t x;
+
+    for( x = 0; x < pxLive->xSize; x++ )
+    {
+        pxLive->pucData[ x ] = ( uint8_t ) ( pxLive->ucSeed + x * 7 );
+    }
+}
+
+static void prvCheckFill( HostBlock_t *pxLive, size_t xSize )
+{
+size_t x;
+
+    for( x = 0; x < xSize; x++ )
+    {
+        htCHECK( pxLive->pucData[ x ] == ( uint8_t ) ( pxLive->ucSeed + x * 7 ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Walk every region and every free list and check them against each other. */
+static void prvCheckHeap( void )
+{
+TlsfBlock_t *pxBlock, *pxPrev;
+UBaseType_t uxRegion, uxPool, uxFl, uxSl, uxMapFl, uxMapSl, x;
+size_t xPoolFree[ configHEAP_TLSF_POOLS ] = { 0 };
+size_t xWalkFreeBlocks = 0, xListFreeBlocks = 0, xUsed = 0, xInUse = 0, xSize;
+BaseType_t xPrevFree;
+
+    htCHECK( iSuspendNesting == 0 );
+
+    for( uxRegion = 0; uxRegion < uxRegions; uxRegion++ )
+    {
+        pxPrev = NULL;
+        xPrevFree = pdFALSE;
+        for( pxBlock = xRegions[ uxRegion ].pxFirst; ; pxBlock = prvNextPhys( pxBlock ) )
+        {
+            htCHECK( ( ( size_t ) pxBlock & heapALIGNMENT_MASK ) == 0 );
+            htCHECK( pxBlock->pxPrevPhys == pxPrev );
+            htCHECK( pxBlock->ucPool == xRegions[ uxRegion ].uxPool );
+            htCHECK( ( pxBlock->xSize & heapALIGNMENT_MASK & ~heapBLOCK_FREE ) == 0 );
+
+            xSize = pxBlock->xSize & heapSIZE_MASK;
+            if( xSize == 0 )
+            {
+                /* The end marker. */
+                htCHECK( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+                break;
+            }
+
+            if( ( pxBlock->xSize & heapBLOCK_FREE ) != 0 )
+            {
+                htCHECK( xPrevFree == pdFALSE );
+                xPoolFree[ pxBlock->ucPool ] += xSize;
+                xWalkFreeBlocks++;
+                xPrevFree = pdTRUE;
+            }
+            else
+            {
+                htCHECK( pxBlock->ucOwner < configHEAP_TLSF_TASK_SLOTS );
+                xUsed += xSize;
+                xPrevFree = pdFALSE;
+            }
+            pxPrev = pxBlock;
+        }
+    }
+
+    for( uxPool = 0; uxPool < configHEAP_TLSF_POOLS; uxPool++ )
+    {
+        htCHECK( xPools[ uxPool ].xFreeBytes == xPoolFree[ uxPool ] );
+
+        for( uxFl = 0; uxFl < heapFL_COUNT; uxFl++ )
+        {
+            htCHECK( ( ( xPools[ uxPool ].ulFlBitmap >> uxFl ) & 1 ) == ( xPools[ uxPool ].ulSlBitmap[ uxFl ] != 0 ) );
+
+            for( uxSl = 0; uxSl < heapSL_COUNT; uxSl++ )
+            {
+                pxBlock = xPools[ uxPool ].pxFree[ uxFl ][ uxSl ];
+                htCHECK( ( ( xPools[ uxPool ].ulSlBitmap[ uxFl ] >> uxSl ) & 1 ) == ( pxBlock != NULL ) );
+                htCHECK( ( pxBlock == NULL ) || ( pxBlock->pxPrevFree == NULL ) );
+
+                for( ; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+                {
+                    htCHECK( ( pxBlock->xSize & heapBLOCK_FREE ) != 0 );
+                    htCHECK( pxBlock->ucPool == uxPool );
+                    htCHECK( ( pxBlock->pxNextFree == NULL ) || ( pxBlock->pxNextFree->pxPrevFree == pxBlock ) );
+                    prvMappingInsert( pxBlock->xSize & heapSIZE_MASK, &uxMapFl, &uxMapSl );
+                    htCHECK( ( uxMapFl == uxFl ) && ( uxMapSl == uxSl ) );
+                    xListFreeBlocks++;
+                }
+            }
+        }
+    }
+    htCHECK( xListFreeBlocks == xWalkFreeBlocks );
+    htCHECK( xPortGetFreeHeapSize() == xPoolFree[ 0 ] + xPoolFree[ 1 ] );
+    htCHECK( xPortGetMinimumEverFreeHeapSize() <= xPortGetFreeHeapSize() );
+
+    for( x = 0; x < configHEAP_TLSF_TASK_SLOTS; x++ )
+    {
+        xInUse += xTaskStats[ x ].xBytesInUse;
+    }
+    htCHECK( xInUse == xUsed );
+
+    /* Blocks charged to their owner, or to slot 0 when the table was full. */
+    for( x = 0; x < htLIVE_BLOCKS; x++ )
+    {
+        if( xLive[ x ].pucData != NULL )
+        {
+            pxBlock = prvHeader( xLive[ x ].pucData );
+            htCHECK( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+            htCHECK( pxBlock->ucPool == xLive[ x ].uxPool );
+            htCHECK( ( pxBlock->ucOwner == 0 ) || ( xTaskStats[ pxBlock->ucOwner ].pvTask == xLive[ x ].pvOwner ) );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* The slot of a live task that holds nothing is kept, a deleted task's slot
+is given out again once its memory is freed. */
+static void prvTestTaskSlots( void )
+{
+void *pvA, *pvB, *pvC, *pvD, *pvE;
+void *pv1, *pv2, *pv3;
+uint8_t ucSlotA, ucSlotB;
+
+    pvA = prvNewTask();
+    pvB = prvNewTask();
+    pvC = prvNewTask();
+    pvD = prvNewTask();
+    pvE = prvNewTask();
+
+    /* Before the scheduler starts everything goes to slot 0. */
+    pv1 = pvPortMalloc( 100 );
+    htCHECK( prvHeader( pv1 )->ucOwner == 0 );
+    vPortFree( pv1 );
+
+    xSchedulerState = taskSCHEDULER_RUNNING;
+
+    pvCurrentTask = pvA;
+    pv1 = pvPortMalloc( 100 );
+    ucSlotA = prvHeader( pv1 )->ucOwner;
+    htCHECK( ( ucSlotA != 0 ) && ( xTaskStats[ ucSlotA ].pvTask == pvA ) );
+    vPortFree( pv1 );
+    htCHECK( xTaskStats[ ucSlotA ].xBytesInUse == 0 );
+
+    /* A holds nothing now but is alive, B must not take its slot. */
+    pvCurrentTask = pvB;
+    pv2 = pvPortMalloc( 200 );
+    ucSlotB = prvHeader( pv2 )->ucOwner;
+    htCHECK( ( ucSlotB != 0 ) && ( ucSlotB != ucSlotA ) );
+    htCHECK( xTaskStats[ ucSlotA ].pvTask == pvA );
+
+    pvCurrentTask = pvA;
+    pv1 = pvPortMalloc( 100 );
+    htCHECK( prvHeader( pv1 )->ucOwner == ucSlotA );
+    htCHECK( xTaskStats[ ucSlotA ].xAllocations == 2 );
+
+    /* C takes the last slot, D finds the table full. */
+    pvCurrentTask = pvC;
+    pv3 = pvPortMalloc( 300 );
+    htCHECK( prvHeader( pv3 )->ucOwner != 0 );
+    vPortFree( pv3 );
+    pvCurrentTask = pvD;
+    pv3 = pvPortMalloc( 300 );
+    htCHECK( prvHeader( pv3 )->ucOwner == 0 );
+    vPortFree( pv3 );
+
+    /* A is deleted while it still has memory: its slot stays until freed. */
+    vPortHeapTaskDeleted( pvA );
+    pvCurrentTask = pvE;
+    pv3 = pvPortMalloc( 300 );
+    htCHECK( prvHeader( pv3 )->ucOwner == 0 );
+    vPortFree( pv3 );
+
+    vPortFree( pv1 );
+    pv3 = pvPortMalloc( 300 );
+    htCHECK( prvHeader( pv3 )->ucOwner == ucSlotA );
+    htCHECK( xTaskStats[ ucSlotA ].pvTask == pvE );
+    htCHECK( xTaskStats[ ucSlotA ].xAllocations == 1 );
+    htCHECK( xTaskStats[ ucSlotA ].xBytesInUse == prvHeader( pv3 )->xSize );
+
+    /* A new task at the address of a deleted one gets a slot of its own. */
+    vPortHeapTaskDeleted( pvE );
+    pv1 = pvPortMalloc( 100 );
+    htCHECK( prvHeader( pv1 )->ucOwner == 0 );
+    vPortFree( pv1 );
+
+    vPortFree( pv3 );
+    vPortFree( pv2 );
+    vPortHeapTaskDeleted( pvB );
+    vPortHeapTaskDeleted( pvC );
+
+    prvCheckHeap();
+    printf( "task slots: ok\n" );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvRandomSize( void )
+{
+uint32_t ulKind = prvRand() % 100;
+
+    if( ulKind < 70 )
+    {
+        return 1 + prvRand() % 512;
+    }
+    if( ulKind < 95 )
+    {
+        return 1 + prvRand() % 8192;
+    }
+    if( ulKind < 99 )
+    {
+        return 1 + prvRand() % heapMAX_ALLOC_SIZE;
+    }
+    return heapMAX_ALLOC_SIZE + prvRand() % 256;
+}
+
+static void prvCheckNew( HostBlock_t *pxLive, size_t xWanted )
+{
+    htCHECK( ( ( size_t ) pxLive->pucData & heapALIGNMENT_MASK ) == 0 );
+    htCHECK( prvHeader( pxLive->pucData )->xSize >= xWanted );
+    htCHECK( ( prvHeader( pxLive->pucData )->xSize & heapALIGNMENT_MASK ) == 0 );
+}
+
+static void prvRandomStep( void )
+{
+HostBlock_t *pxLive = &xLive[ prvRand() % htLIVE_BLOCKS ];
+UBaseType_t uxTask = prvRand() % htTASKS;
+uint8_t ucOwner;
+size_t xWanted;
+void *pv;
+
+    /* Now and then a task is deleted and another one created. */
+    if( ( prvRand() % 1000 ) == 0 )
+    {
+        vPortHeapTaskDeleted( pvTasks[ uxTask ] );
+        pvTasks[ uxTask ] = prvNewTask();
+        ucTaskSlot[ uxTask ] = 0xff;
+    }
+    pvCurrentTask = pvTasks[ uxTask ];
+
+    if( pxLive->pucData == NULL )
+    {
+        xWanted = prvRandomSize();
+        pxLive->uxPool = prvRand() % configHEAP_TLSF_POOLS;
+        pxLive->pucData = pvPortMallocFromPool( pxLive->uxPool, xWanted );
+        if( xWanted > heapMAX_ALLOC_SIZE )
+        {
+            htCHECK( pxLive->pucData == NULL );
+        }
+        if( pxLive->pucData != NULL )
+        {
+            prvCheckNew( pxLive, xWanted );
+            pxLive->xSize = xWanted;
+            pxLive->ucSeed = ( uint8_t ) prvRand();
+            pxLive->pvOwner = pvCurrentTask;
+            prvFill( pxLive );
+
+            /* A live task keeps its slot once it has one. */
+            ucOwner = prvHeader( pxLive->pucData )->ucOwner;
+            if( ( ucTaskSlot[ uxTask ] == 0xff ) || ( ucTaskSlot[ uxTask ] == 0 ) )
+            {
+                ucTaskSlot[ uxTask ] = ucOwner;
+            }
+            htCHECK( ucOwner == ucTaskSlot[ uxTask ] );
+        }
+    }
+    else if( ( prvRand() % 2 ) == 0 )
+    {
+        prvCheckFill( pxLive, pxLive->xSize );
+        vPortFree( pxLive->pucData );
+        pxLive->pucData = NULL;
+    }
+    else
+    {
+        xWanted = prvRandomSize();
+        pv = pvPortRealloc( pxLive->pucData, xWanted );
+        if( pv == NULL )
+        {
+            /* Failed, the old block is untouched. */
+            prvCheckFill( pxLive, pxLive->xSize );
+        }
+        else
+        {
+            if( pv != pxLive->pucData )
+            {
+                /* Moved, so charged to the task that asked. */
+                pxLive->pvOwner = pvCurrentTask;
+            }
+            pxLive->pucData = pv;
+            prvCheckNew( pxLive, xWanted );
+            prvCheckFill( pxLive, ( xWanted < pxLive->xSize ) ? xWanted : pxLive->xSize );
+            pxLive->xSize = xWanted;
+            prvFill( pxLive );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc, char *argv[] )
+{
+unsigned long ulRounds = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 0 ) : htROUNDS;
+unsigned long ulRound;
+HeapStats_t xStats;
+size_t xInitialFree;
+UBaseType_t x;
+void *pv;
+
+    ulRandom = ( argc > 2 ) ? ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 ) : 0x2545f491UL;
+    if( ulRandom == 0 )
+    {
+        ulRandom = 1;
+    }
+
+    /* The static heap, then a region bigger than any allocation, and one for
+    pool 1 that starts off a cache line. */
+    xRegions[ uxRegions ].pxFirst = ( TlsfBlock_t * ) ( ( ( size_t ) ucHeap + heapALIGNMENT_MASK ) & heapSIZE_MASK );
+    xRegions[ uxRegions ].uxPool = 0;
+    uxRegions++;
+    prvAddRegionFor( 0, ucLargeRegion, sizeof( ucLargeRegion ) );
+    prvAddRegionFor( 1, ucPool1Region + 3, sizeof( ucPool1Region ) - 3 );
+    xInitialFree = xPortGetFreeHeapSize();
+    prvCheckHeap();
+
+    vPortGetHeapStats( &xStats );
+    htCHECK( xStats.xNumberOfFreeBlocks == uxRegions );
+    htCHECK( xStats.xSizeOfLargestFreeBlockInBytes > heapMAX_ALLOC_SIZE );
+
+    prvTestTaskSlots();
+    htCHECK( xPortGetFreeHeapSize() == xInitialFree );
+
+    for( x = 0; x < htTASKS; x++ )
+    {
+        pvTasks[ x ] = prvNewTask();
+        ucTaskSlot[ x ] = 0xff;
+    }
+
+    for( ulRound = 0; ulRound < ulRounds; ulRound++ )
+    {
+        prvRandomStep();
+        if( ( ulRound % htCHECK_PERIOD ) == 0 )
+        {
+            prvCheckHeap();
+        }
+    }
+    prvCheckHeap();
+
+    for( x = 0; x < htLIVE_BLOCKS; x++ )
+    {
+        if( xLive[ x ].pucData != NULL )
+        {
+            prvCheckFill( &xLive[ x ], xLive[ x ].xSize );
+            vPortFree( xLive[ x ].pucData );
+            xLive[ x ].pucData = NULL;
+        }
+    }
+    prvCheckHeap();
+
+    /* Everything merged back, one block per region. */
+    vPortGetHeapStats( &xStats );
+    htCHECK( xPortGetFreeHeapSize() == xInitialFree );
+    htCHECK( xStats.xNumberOfFreeBlocks == uxRegions );
+    htCHECK( xStats.xNumberOfSuccessfulAllocations > 0 );
+
+    /* So the biggest allocation fits again, and shrinks and grows in place. */
+    pv = pvPortMalloc( heapMAX_ALLOC_SIZE );
+    htCHECK( pv != NULL );
+    htCHECK( pvPortRealloc( pv, 1000 ) == pv );
+    htCHECK( pvPortRealloc( pv, heapMAX_ALLOC_SIZE ) == pv );
+    htCHECK( pvPortRealloc( pv, heapMAX_ALLOC_SIZE + 1 ) == NULL );
+    vPortFree( pv );
+    htCHECK( pvPortMalloc( heapMAX_ALLOC_SIZE + 1 ) == NULL );
+    prvCheckHeap();
+    htCHECK( xPortGetFreeHeapSize() == xInitialFree );
+
+    printf( "random: %lu rounds, %u allocations, %u frees, minimum free %u of %u: ok\n",
+            ulRounds, ( unsigned ) xStats.xNumberOfSuccessfulAllocations,
+            ( unsigned ) xStats.xNumberOfSuccessfulFrees,
+            ( unsigned ) xPortGetMinimumEverFreeHeapSize(), ( unsigned ) xInitialFree );
+    return 0;
+}
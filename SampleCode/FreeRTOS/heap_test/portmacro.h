@@ -0,0 +1,35 @@
+/*
+ * portmacro.h - Host port for heap_tlsf_test.c
+ *
+ * Types only, the test has no scheduler and runs on a single thread.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#define portCHAR        char
+#define portFLOAT       float
+#define portDOUBLE      double
+#define portLONG        long
+#define portSHORT       short
+#define portSTACK_TYPE  uint32_t
+#define portBASE_TYPE   long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY               ( TickType_t ) 0xffffffffUL
+
+#define portSTACK_GROWTH            ( -1 )
+#define portTICK_PERIOD_MS          ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT          8
+
+#define portYIELD()
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#endif /* PORTMACRO_H */
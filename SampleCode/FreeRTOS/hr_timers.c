@@ -0,0 +1,167 @@
+/*
+ * hr_timers.c - Run a few hundred microsecond timers on one ETIMER
+ *
+ * The HrTimerLib service multiplexes software timers onto ETIMER0, which
+ * no other test uses.  hrtISR_TIMERS periodic timers of different periods
+ * count their calls in the interrupt handler, and hrtDEFERRED_TIMERS more
+ * run their functions in a task woken by the defer hook.  A one-shot timer
+ * restarted from its own function every hrtONE_SHOT_US measures how far the
+ * real interval is from the requested one with the microsecond timestamp.
+ *
+ * Every hrtPERIOD_MS the task prints the calls against those expected from
+ * the periods, the overruns of the deferred timers, the longest interrupt
+ * lateness and the worst one-shot error.
+ */
+
+#include <stdio.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+
+#include "hr_timer.h"
+
+#define hrtTIMER                0
+#define hrtISR_TIMERS           190
+#define hrtDEFERRED_TIMERS      10
+#define hrtPERIOD_MS            10000
+#define hrtONE_SHOT_US          250
+
+static HRT_TIMER_T xIsrTimers[ hrtISR_TIMERS ];
+static HRT_TIMER_T xDeferredTimers[ hrtDEFERRED_TIMERS ];
+static HRT_TIMER_T xOneShot;
+static TaskHandle_t xHrtTask = NULL;
+
+static volatile uint32_t ulIsrCalls = 0;
+static uint32_t ulDeferredCalls = 0;
+static volatile uint32_t ulOneShotMaxError = 0;
+static uint64_t ullOneShotStart;
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvIsrPeriod( uint32_t ulIndex )
+{
+    /* 2 ms to 194 ms, prime steps so the expiries do not line up. */
+    return 2000UL + ulIndex * 1009UL;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvDeferredPeriod( uint32_t ulIndex )
+{
+    return 10000UL + ulIndex * 7001UL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvIsrTimer( HRT_TIMER_T *pxTimer, void *pvArg )
+{
+    ( void ) pxTimer;
+    ( void ) pvArg;
+
+    ulIsrCalls++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeferredTimer( HRT_TIMER_T *pxTimer, void *pvArg )
+{
+    ( void ) pxTimer;
+    ( void ) pvArg;
+
+    ulDeferredCalls++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvOneShotTimer( HRT_TIMER_T *pxTimer, void *pvArg )
+{
+uint64_t ullNow = HRT_GetTime();
+uint32_t ulError;
+
+    ( void ) pvArg;
+
+    ulError = ( uint32_t ) ( ullNow - ullOneShotStart ) - hrtONE_SHOT_US;
+    if( ulError > ulOneShotMaxError )
+    {
+        ulOneShotMaxError = ulError;
+    }
+
+    ullOneShotStart = ullNow;
+    HRT_Start( pxTimer, hrtONE_SHOT_US, 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeferHook( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    vTaskNotifyGiveFromISR( xHrtTask, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static void vHrTimerTask( void *pvParameters )
+{
+TickType_t xNextReport, xNow;
+uint32_t ulIndex, ulExpected, ulCalls, ulOverruns;
+
+    ( void ) pvParameters;
+
+    HRT_Init( hrtTIMER );
+    HRT_SetDeferHook( prvDeferHook );
+
+    ulExpected = 0;
+    for( ulIndex = 0; ulIndex < hrtISR_TIMERS; ulIndex++ )
+    {
+        HRT_InitTimer( &xIsrTimers[ ulIndex ], prvIsrTimer, NULL, 0 );
+        HRT_Start( &xIsrTimers[ ulIndex ], prvIsrPeriod( ulIndex ), prvIsrPeriod( ulIndex ) );
+        ulExpected += ( hrtPERIOD_MS * 1000UL ) / prvIsrPeriod( ulIndex );
+    }
+    for( ulIndex = 0; ulIndex < hrtDEFERRED_TIMERS; ulIndex++ )
+    {
+        HRT_InitTimer( &xDeferredTimers[ ulIndex ], prvDeferredTimer, NULL, HRT_FLAG_DEFERRED );
+        HRT_Start( &xDeferredTimers[ ulIndex ], prvDeferredPeriod( ulIndex ), prvDeferredPeriod( ulIndex ) );
+    }
+    HRT_InitTimer( &xOneShot, prvOneShotTimer, NULL, 0 );
+    ullOneShotStart = HRT_GetTime();
+    HRT_Start( &xOneShot, hrtONE_SHOT_US, 0 );
+
+    xNextReport = xTaskGetTickCount() + hrtPERIOD_MS / portTICK_PERIOD_MS;
+
+    for( ;; )
+    {
+        xNow = xTaskGetTickCount();
+        if( ( TickType_t ) ( xNow - xNextReport ) < ( hrtPERIOD_MS / portTICK_PERIOD_MS ) )
+        {
+            /* The report time is reached. */
+            ulCalls = ulIsrCalls;
+            ulIsrCalls = 0;
+            ulOverruns = 0;
+            for( ulIndex = 0; ulIndex < hrtDEFERRED_TIMERS; ulIndex++ )
+            {
+                ulOverruns += xDeferredTimers[ ulIndex ].u32Overruns;
+            }
+
+            printf( "HR timers: %u running, %u ISR calls (%u expected), %u deferred, %u overruns, lateness max %u us, %u us one-shot error max %u us\n",
+                    ( unsigned ) HRT_GetActiveCount(), ( unsigned ) ulCalls, ( unsigned ) ulExpected,
+                    ( unsigned ) ulDeferredCalls, ( unsigned ) ulOverruns,
+                    ( unsigned ) HRT_GetMaxLateness(), ( unsigned ) hrtONE_SHOT_US,
+                    ( unsigned ) ulOneShotMaxError );
+
+            ulDeferredCalls = 0;
+            ulOneShotMaxError = 0;
+            xNextReport += hrtPERIOD_MS / portTICK_PERIOD_MS;
+            continue;
+        }
+
+        ulTaskNotifyTake( pdTRUE, xNextReport - xNow );
+        HRT_RunDeferred();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartHrTimerTest( UBaseType_t uxPriority )
+{
+    xTaskCreate( vHrTimerTask, "HrTmr", configMINIMAL_STACK_SIZE * 2, NULL, uxPriority, &xHrtTask );
+}
@@ -0,0 +1,131 @@
+/*
+ * irq_latency.c - Measure the time from a peripheral interrupt to the task it wakes
+ *
+ * ETIMER1 runs in periodic mode, so its counter restarts from zero at the
+ * same moment it raises the interrupt. The ISR gives a notification to the
+ * highest priority task and requests a switch with portYIELD_FROM_ISR(); the
+ * task reads the counter as soon as it runs, which is the wakeup latency
+ * including the interrupt entry. The rate is prime so the interrupt drifts
+ * across the tick period instead of always landing at the same phase.
+ *
+ * The time spent in the ISR itself comes from the interrupt statistics of
+ * the SYS driver, timed with ETIMER3 counting freely at 12 MHz.
+ */
+
+#include <stdio.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define latencyTIMER            1
+#define latencyRATE_HZ          97
+#define latencyCOUNTS_PER_US    12      /* 12 MHz ETIMER clock, no prescaler */
+#define latencySAMPLES          ( latencyRATE_HZ * 10 )
+#define latencySTAT_TIMER       3
+
+static TaskHandle_t xLatencyTask = NULL;
+
+/*-----------------------------------------------------------*/
+
+static void prvLatencyTimerISR( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    ETIMER_ClearIntFlag( latencyTIMER );
+
+    vTaskNotifyGiveFromISR( xLatencyTask, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+static UINT32 prvStatTimestamp( void )
+{
+    return ETIMER_GetCounter( latencySTAT_TIMER );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintCounts( const char *pcName, uint32_t ulCounts )
+{
+    ulCounts = ulCounts * 10 / latencyCOUNTS_PER_US;
+    printf( " %s %u.%u us", pcName, ( unsigned ) ( ulCounts / 10 ), ( unsigned ) ( ulCounts % 10 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void vLatencyTask( void *pvParameters )
+{
+uint32_t ulCount, ulMin, ulMax, ulSamples, ulMissed, ulNotified;
+uint64_t ullSum;
+SYS_IRQ_STAT_T xStat;
+
+    ( void ) pvParameters;
+
+    /* ETIMER3 free runs over its 24 bits to time the ISR. */
+    outpw( REG_CLK_PCLKEN0, inpw( REG_CLK_PCLKEN0 ) | ( 1 << ( 8 + latencySTAT_TIMER ) ) );
+    ETIMER_Open( latencySTAT_TIMER, ETIMER_CONTINUOUS_MODE, 1 );
+    ETIMER_Start( latencySTAT_TIMER );
+    sysSetIrqStatTimer( prvStatTimestamp, 0xFFFFFF );
+
+    /* ETIMER1 clock, the counter ticks at 12 MHz. */
+    outpw( REG_CLK_PCLKEN0, inpw( REG_CLK_PCLKEN0 ) | ( 1 << ( 8 + latencyTIMER ) ) );
+    ETIMER_Open( latencyTIMER, ETIMER_PERIODIC_MODE, latencyRATE_HZ );
+    ETIMER_EnableInt( latencyTIMER );
+    sysInstallISR( IRQ_LEVEL_1, IRQ_TIMER1, ( PVOID ) prvLatencyTimerISR );
+    sysEnableInterrupt( IRQ_TIMER1 );
+    ETIMER_Start( latencyTIMER );
+
+    for( ;; )
+    {
+        sysClearIrqStat();
+        ulMin = 0xFFFFFFFFUL;
+        ulMax = 0;
+        ullSum = 0;
+        ulSamples = 0;
+        ulMissed = 0;
+
+        while( ulSamples < latencySAMPLES )
+        {
+            ulNotified = ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+            ulCount = ETIMER_GetCounter( latencyTIMER );
+
+            /* A second interrupt came before the task ran, the counter no
+            longer refers to the one being measured. */
+            if( ulNotified > 1 )
+            {
+                ulMissed += ulNotified - 1;
+                continue;
+            }
+
+            if( ulCount < ulMin )
+                ulMin = ulCount;
+            if( ulCount > ulMax )
+                ulMax = ulCount;
+            ullSum += ulCount;
+            ulSamples++;
+        }
+
+        /* Nothing to average over if no wakeup or ISR call was counted. */
+        printf( "IRQ to task latency over %u wakeups:", ( unsigned ) ulSamples );
+        prvPrintCounts( "min", ( ulSamples != 0 ) ? ulMin : 0 );
+        prvPrintCounts( "avg", ( ulSamples != 0 ) ? ( uint32_t ) ( ullSum / ulSamples ) : 0 );
+        prvPrintCounts( "max", ulMax );
+        printf( ", %u missed\n", ( unsigned ) ulMissed );
+
+        sysGetIrqStat( IRQ_TIMER1, &xStat );
+        printf( "Time in the ISR over %u calls:", ( unsigned ) xStat.u32Count );
+        prvPrintCounts( "avg", ( xStat.u32Count != 0 ) ? xStat.u32TotalTime / xStat.u32Count : 0 );
+        prvPrintCounts( "max", xStat.u32MaxTime );
+        printf( ", preempted %u times\n", ( unsigned ) xStat.u32Preempted );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartIrqLatencyTest( UBaseType_t uxPriority )
+{
+    xTaskCreate( vLatencyTask, "Latency", configMINIMAL_STACK_SIZE * 2, NULL, uxPriority, &xLatencyTask );
+}
@@ -62,6 +62,12 @@
 #define mainCREATOR_TASK_PRIORITY           ( tskIDLE_PRIORITY + 3UL )
 #define mainFLOP_TASK_PRIORITY              ( tskIDLE_PRIORITY )
 #define mainCHECK_TASK_PRIORITY             ( tskIDLE_PRIORITY + 3UL )
+#define mainLATENCY_TASK_PRIORITY           ( configMAX_PRIORITIES - 1UL )
+#define mainDRIFT_TASK_PRIORITY             ( configMAX_PRIORITIES - 1UL )
+#define mainSTATS_TASK_PRIORITY             ( configMAX_PRIORITIES - 1UL )
+#define mainZERO_COPY_PRIORITY              ( tskIDLE_PRIORITY + 1UL )
+#define mainHR_TIMER_PRIORITY               ( tskIDLE_PRIORITY + 2UL )
+#define mainCRYPTO_QUEUE_PRIORITY           ( tskIDLE_PRIORITY + 1UL )
 
 #define mainCHECK_TASK_STACK_SIZE           ( configMINIMAL_STACK_SIZE )
 
@@ -93,6 +99,30 @@ information. */
 
 #define CHECK_TEST
 
+/* Print the time from a timer interrupt to the task it wakes, see
+irq_latency.c. */
+#define IRQ_LATENCY_TEST
+
+/* Print how far the tick count has drifted from ETIMER2, which checks the
+tick correction of configUSE_TICKLESS_IDLE, see tick_drift.c. */
+#define TICK_DRIFT_TEST
+
+/* Print the CPU usage of each task every 5 s and dump the trace ring when
+'d' is typed, see cpu_stats.c. */
+#define CPU_STATS_TEST
+
+/* Time messages passed by value through a queue against pool buffers passed
+by pointer, see zero_copy.c. */
+#define ZERO_COPY_TEST
+
+/* Run a few hundred microsecond timers on ETIMER0 and print how late they
+fire, see hr_timers.c. */
+#define HR_TIMER_TEST
+
+/* Hash and encrypt with queued crypto jobs and with mbed TLS at the same time
+and compare the results, see crypto_jobs.c. */
+#define CRYPTO_QUEUE_TEST
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -105,6 +135,30 @@ static void prvSetupHardware( void );
 static void vCheckTask( void *pvParameters );
 #endif
 
+#ifdef IRQ_LATENCY_TEST
+extern void vStartIrqLatencyTest( UBaseType_t uxPriority );
+#endif
+
+#ifdef TICK_DRIFT_TEST
+extern void vStartTickDriftTest( UBaseType_t uxPriority );
+#endif
+
+#ifdef CPU_STATS_TEST
+extern void vStartCpuStatsTask( UBaseType_t uxPriority );
+#endif
+
+#ifdef ZERO_COPY_TEST
+extern void vStartZeroCopyTest( UBaseType_t uxPriority );
+#endif
+
+#ifdef HR_TIMER_TEST
+extern void vStartHrTimerTest( UBaseType_t uxPriority );
+#endif
+
+#ifdef CRYPTO_QUEUE_TEST
+extern void vStartCryptoQueueTest( UBaseType_t uxPriority );
+#endif
+
 extern void vPortYieldProcessor(void);
 int main(void)
 {
@@ -120,6 +174,30 @@ int main(void)
 
     vStartPolledQueueTasks( mainQUEUE_POLL_PRIORITY );
 
+#ifdef IRQ_LATENCY_TEST
+    vStartIrqLatencyTest( mainLATENCY_TASK_PRIORITY );
+#endif
+
+#ifdef TICK_DRIFT_TEST
+    vStartTickDriftTest( mainDRIFT_TASK_PRIORITY );
+#endif
+
+#ifdef CPU_STATS_TEST
+    vStartCpuStatsTask( mainSTATS_TASK_PRIORITY );
+#endif
+
+#ifdef ZERO_COPY_TEST
+    vStartZeroCopyTest( mainZERO_COPY_PRIORITY );
+#endif
+
+#ifdef HR_TIMER_TEST
+    vStartHrTimerTest( mainHR_TIMER_PRIORITY );
+#endif
+
+#ifdef CRYPTO_QUEUE_TEST
+    vStartCryptoQueueTest( mainCRYPTO_QUEUE_PRIORITY );
+#endif
+
     /* The following function will only create more tasks and timers if
     mainCREATE_SIMPLE_LED_FLASHER_DEMO_ONLY is set to 0 (at the top of this
     file).  See the comments at the top of this file for more information. */
@@ -193,13 +271,16 @@ void vApplicationIdleHook( void )
 
 void vApplicationStackOverflowHook( xTaskHandle pxTask, signed char *pcTaskName )
 {
-    ( void ) pcTaskName;
     ( void ) pxTask;
 
     /* Run time stack overflow checking is performed if
     configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
-    function is called if a stack overflow is detected. */
+    function is called if a stack overflow is detected, with a NULL task
+    and the name "IRQ" for the interrupt stack of the port.  The memory
+    below the stack may be corrupted, so stop here.  The UART is polled as
+    interrupts are off. */
     taskDISABLE_INTERRUPTS();
+    printf( "\nStack overflow: %s\n", ( char * ) pcTaskName );
     for( ;; );
 }
 
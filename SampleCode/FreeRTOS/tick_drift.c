@@ -0,0 +1,75 @@
+/*
+ * tick_drift.c - Compare the RTOS tick count against an independent timer
+ *
+ * With configUSE_TICKLESS_IDLE the port stops the periodic tick while the
+ * idle task sleeps and adds up the ticks that were missed when the CPU wakes
+ * up, so any error in that calculation shows up as the tick count slowly
+ * running ahead of or behind real time. ETIMER2 in continuous mode counts
+ * the same 12 MHz crystal divided by 256 as the reference, so only errors
+ * in the tick accounting show up, not crystal tolerance; its 24-bit counter
+ * wraps every 358 s, much longer than the sampling period. The task prints
+ * the total drift since it started, which should stay within a tick
+ * whatever the other tasks are doing.
+ */
+
+#include <stdio.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+
+#define driftTIMER              2
+#define driftPRESCALE           256
+#define driftCOUNTER_MASK       0xFFFFFFUL
+#define driftPERIOD_MS          10000
+
+/*-----------------------------------------------------------*/
+
+static void vTickDriftTask( void *pvParameters )
+{
+TickType_t xLastWakeTime, xStartTicks;
+uint32_t ulLastCount, ulCount;
+uint64_t ullRefCounts = 0;
+int64_t llTickUs, llRefUs, llDriftUs;
+
+    ( void ) pvParameters;
+
+    /* ETIMER2 clock, then count up to 0xFFFFFF and wrap at 12 MHz / 256. */
+    outpw( REG_CLK_PCLKEN0, inpw( REG_CLK_PCLKEN0 ) | ( 1 << ( 8 + driftTIMER ) ) );
+    ETIMER_Open( driftTIMER, ETIMER_CONTINUOUS_MODE, 1 );
+    ETIMER_SET_PRESCALE_VALUE( driftTIMER, driftPRESCALE - 1 );
+    ETIMER_Start( driftTIMER );
+
+    xLastWakeTime = xTaskGetTickCount();
+    xStartTicks = xLastWakeTime;
+    ulLastCount = ETIMER_GetCounter( driftTIMER );
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, driftPERIOD_MS / portTICK_PERIOD_MS );
+
+        ulCount = ETIMER_GetCounter( driftTIMER );
+        ullRefCounts += ( ulCount - ulLastCount ) & driftCOUNTER_MASK;
+        ulLastCount = ulCount;
+
+        llTickUs = ( int64_t ) ( xLastWakeTime - xStartTicks ) * 1000000 / configTICK_RATE_HZ;
+        llRefUs = ( int64_t ) ( ullRefCounts * driftPRESCALE / 12 );
+        llDriftUs = llTickUs - llRefUs;
+
+        printf( "Tick drift after %u s: %d us (%d ppm)\n",
+                ( unsigned ) ( llRefUs / 1000000 ),
+                ( int ) llDriftUs,
+                ( int ) ( llDriftUs * 1000000 / llRefUs ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartTickDriftTest( UBaseType_t uxPriority )
+{
+    xTaskCreate( vTickDriftTask, "Drift", configMINIMAL_STACK_SIZE * 2, NULL, uxPriority, NULL );
+}
@@ -0,0 +1,210 @@
+#!/usr/bin/env python
+"""
+trace_decode.py - Decode a trace ring dump of trace_ring.c
+
+Reads a capture of the console that contains the binary block sent by
+xTraceRingDump(), text around it is skipped, and prints the CPU time of
+each task and interrupt over the traced period.  Time between two records
+is charged to the interrupt being handled, or else to the running task, so
+interrupt time is not counted in the task it interrupted; the FreeRTOS tick
+is not recorded and stays in the task.
+
+    python trace_decode.py capture.bin [--timeline] [--json out.json]
+
+--timeline prints every record with its time, --json writes the task and
+interrupt slices in the Chrome trace event format, which chrome://tracing
+and https://ui.perfetto.dev display as a timeline.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"FRTR"
+HEADER = struct.Struct("<HHIIIHH")
+RECORD = struct.Struct("<IBBH")
+
+EVENTS = {
+    1: "TASK_CREATE",
+    2: "TASK_SWITCHED_OUT",
+    3: "TASK_SWITCHED_IN",
+    4: "TASK_DELETE",
+    5: "ISR_ENTER",
+    6: "ISR_EXIT",
+    7: "QUEUE_CREATE",
+    8: "QUEUE_SEND",
+    9: "QUEUE_SEND_FAILED",
+    10: "QUEUE_RECEIVE",
+    11: "QUEUE_RECEIVE_FAILED",
+    12: "QUEUE_BLOCK_SEND",
+    13: "QUEUE_BLOCK_RECEIVE",
+    14: "QUEUE_SEND_FROM_ISR",
+    15: "QUEUE_RECEIVE_FROM_ISR",
+    16: "USER",
+}
+
+QUEUE_TYPES = {
+    0: "queue",
+    1: "mutex",
+    2: "counting semaphore",
+    3: "binary semaphore",
+    4: "recursive mutex",
+}
+
+
+def parse(data):
+    start = data.find(MAGIC)
+    if start < 0:
+        sys.exit("no trace dump found")
+    pos = start + len(MAGIC)
+
+    version, record_size, hz, written, count, max_tasks, name_len = HEADER.unpack_from(data, pos)
+    if version != 1 or record_size != RECORD.size:
+        sys.exit("unsupported dump version %d, record size %d" % (version, record_size))
+
+    names_pos = pos + HEADER.size
+    records_pos = names_pos + max_tasks * name_len
+    end = records_pos + count * RECORD.size
+    if len(data) < end + 4:
+        sys.exit("dump truncated, %d of %d bytes" % (len(data) - start, end + 4 - start))
+
+    (checksum,) = struct.unpack_from("<I", data, end)
+    if sum(bytearray(data[pos:end])) & 0xFFFFFFFF != checksum:
+        sys.exit("checksum mismatch, the capture is corrupted")
+
+    names = {}
+    for i in range(max_tasks):
+        raw = data[names_pos + i * name_len:names_pos + (i + 1) * name_len]
+        name = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+        if name:
+            names[i] = name
+
+    records = [RECORD.unpack_from(data, records_pos + i * RECORD.size) for i in range(count)]
+    return hz, written, names, records
+
+
+def task_name(names, number):
+    return names.get(number, "task %d" % number)
+
+
+def describe(names, event, task, param):
+    name = EVENTS.get(event, "EVENT_%d" % event)
+    if event in (1, 4):
+        return "%s %s" % (name, task_name(names, param))
+    if event == 3:
+        return "%s %s" % (name, task_name(names, task))
+    if event in (5, 6):
+        return "%s IRQ %d" % (name, param)
+    if event == 7:
+        return "%s #%d (%s)" % (name, param, QUEUE_TYPES.get(task, "type %d" % task))
+    if 8 <= event <= 15:
+        return "%s #%d by %s" % (name, param, task_name(names, task))
+    if event == 16:
+        return "%s %d by %s" % (name, param, task_name(names, task))
+    return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a trace_ring.c dump")
+    parser.add_argument("capture", help="console capture holding the binary dump")
+    parser.add_argument("--timeline", action="store_true", help="print every record")
+    parser.add_argument("--json", metavar="FILE", help="write a Chrome trace event file")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        hz, written, names, records = parse(f.read())
+
+    if not records:
+        sys.exit("the dump holds no record")
+
+    us_per_count = 1e6 / hz
+    if written > len(records):
+        print("%d records, the oldest %d were overwritten" % (len(records), written - len(records)))
+    else:
+        print("%d records" % len(records))
+
+    busy = {}           # task or IRQ name -> counts
+    switches = {}       # task name -> times switched in
+    irq_max = {}        # IRQ name -> longest handler, counts
+    irq_count = {}
+    slices = []         # (name, thread, start, length)
+    task = None         # running task, unknown until the first switch
+    task_since = None
+    irq_stack = []      # [irq, entered, time charged to nested IRQs]
+
+    first = records[0][0]
+    now = 0             # counts since the first record, the 32-bit clock may wrap
+    last = first
+    timeline = []
+
+    for timestamp, event, ev_task, param in records:
+        delta = (timestamp - last) & 0xFFFFFFFF
+        last = timestamp
+        if irq_stack:
+            owner = "IRQ %d" % irq_stack[-1][0]
+        elif task is not None:
+            owner = task_name(names, task)
+        else:
+            owner = None
+        if owner is not None:
+            busy[owner] = busy.get(owner, 0) + delta
+        now += delta
+
+        if args.timeline:
+            timeline.append("%12.1f us  %s" % (now * us_per_count, describe(names, event, ev_task, param)))
+
+        if event == 3:
+            if task is not None and task_since is not None:
+                slices.append((task_name(names, task), 1, task_since, now - task_since))
+            task = ev_task
+            task_since = now
+            name = task_name(names, task)
+            switches[name] = switches.get(name, 0) + 1
+        elif event == 5:
+            irq_stack.append([param, now, 0])
+        elif event == 6 and irq_stack and irq_stack[-1][0] == param:
+            irq, entered, nested = irq_stack.pop()
+            name = "IRQ %d" % irq
+            own = now - entered - nested
+            irq_count[name] = irq_count.get(name, 0) + 1
+            irq_max[name] = max(irq_max.get(name, 0), own)
+            slices.append((name, 2, entered, now - entered))
+            if irq_stack:
+                irq_stack[-1][2] += now - entered
+
+    if task is not None:
+        slices.append((task_name(names, task), 1, task_since, now - task_since))
+
+    total = sum(busy.values())
+    span = now
+    print("Traced %.3f ms, %.3f ms attributed\n" % (span * us_per_count / 1000, total * us_per_count / 1000))
+
+    print("%-16s %12s %7s %10s %12s" % ("", "time (us)", "CPU %", "count", "max (us)"))
+    for name, counts in sorted(busy.items(), key=lambda item: -item[1]):
+        if name.startswith("IRQ"):
+            count = irq_count.get(name, 0)
+            longest = "%12.1f" % (irq_max.get(name, 0) * us_per_count)
+        else:
+            count = switches.get(name, 0)
+            longest = ""
+        print("%-16s %12.1f %7.2f %10d %s" % (name, counts * us_per_count,
+                                              100.0 * counts / total if total else 0.0, count, longest))
+
+    if args.timeline:
+        print("")
+        print("\n".join(timeline))
+
+    if args.json:
+        events = [{"name": "thread_name", "ph": "M", "pid": 1, "tid": 1, "args": {"name": "tasks"}},
+                  {"name": "thread_name", "ph": "M", "pid": 1, "tid": 2, "args": {"name": "interrupts"}}]
+        for name, thread, begin, length in slices:
+            events.append({"name": name, "ph": "X", "pid": 1, "tid": thread,
+                           "ts": begin * us_per_count, "dur": length * us_per_count})
+        with open(args.json, "w") as f:
+            json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, f)
+        print("\nWrote %d slices to %s" % (len(slices), args.json))
+
+
+if __name__ == "__main__":
+    main()
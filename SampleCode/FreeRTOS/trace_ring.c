@@ -0,0 +1,202 @@
+/*
+ * trace_ring.c - Binary trace of task switches, interrupts and queues
+ *
+ * See trace_ring.h.  A record is reserved and filled with IRQ masked, which
+ * is a handful of instructions; most trace macros are already called from
+ * inside a critical section or an interrupt.  Without LDREX/STREX on the
+ * ARM926EJ-S this is the cheapest way to let tasks and nested interrupts
+ * write the same ring, and the FIQ is never held off.
+ *
+ * Dump layout, little-endian:
+ *   "FRTR", TraceRingHeader_t, ringMAX_TASKS names of
+ *   configMAX_TASK_NAME_LEN bytes indexed by task number, the records from
+ *   the oldest on, then the 32-bit sum of all the bytes after "FRTR".
+ */
+
+#include <string.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+
+#include "trace_ring.h"
+
+#if ( configUSE_TRACE_FACILITY != 1 ) || ( configGENERATE_RUN_TIME_STATS != 1 )
+	#error trace_ring.c needs configUSE_TRACE_FACILITY and configGENERATE_RUN_TIME_STATS
+#endif
+
+#if ( ringRECORDS & ( ringRECORDS - 1 ) ) != 0
+	#error ringRECORDS must be a power of two
+#endif
+
+#define ringVERSION				1
+
+typedef struct
+{
+	uint16_t usVersion;
+	uint16_t usRecordSize;
+	uint32_t ulTimestampHz;
+	uint32_t ulWritten;			/* Records written since the start, more than ulRecords once the ring wrapped. */
+	uint32_t ulRecords;			/* Records in this dump. */
+	uint16_t usMaxTasks;
+	uint16_t usNameLength;
+} TraceRingHeader_t;
+
+static TraceRingRecord_t xRing[ ringRECORDS ];
+static volatile uint32_t ulWritten = 0;
+static volatile BaseType_t xRecording = pdFALSE;
+static char acTaskNames[ ringMAX_TASKS ][ configMAX_TASK_NAME_LEN ];
+static uint32_t ulQueueCount = 0;
+
+volatile uint8_t ucTraceRingCurrentTask = 0;
+
+/*-----------------------------------------------------------*/
+
+void vTraceRingWrite( uint8_t ucEvent, uint8_t ucTask, uint16_t usParam )
+{
+UBaseType_t uxSavedStatus;
+TraceRingRecord_t *pxRecord;
+
+	if( xRecording == pdFALSE )
+	{
+		return;
+	}
+
+	uxSavedStatus = uxPortSetInterruptMask();
+	pxRecord = &xRing[ ulWritten & ( ringRECORDS - 1 ) ];
+	ulWritten++;
+	pxRecord->ulTimestamp = portGET_RUN_TIME_COUNTER_VALUE();
+	pxRecord->ucEvent = ucEvent;
+	pxRecord->ucTask = ucTask;
+	pxRecord->usParam = usParam;
+	vPortClearInterruptMask( uxSavedStatus );
+}
+/*-----------------------------------------------------------*/
+
+static void prvIsrEnter( UINT32 u32IrqNum )
+{
+	vTraceRingWrite( ringEVENT_ISR_ENTER, ucTraceRingCurrentTask, ( uint16_t ) u32IrqNum );
+}
+/*-----------------------------------------------------------*/
+
+static void prvIsrExit( UINT32 u32IrqNum )
+{
+	vTraceRingWrite( ringEVENT_ISR_EXIT, ucTraceRingCurrentTask, ( uint16_t ) u32IrqNum );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRingStart( void )
+{
+	ulWritten = 0;
+	xRecording = pdTRUE;
+	sysSetIrqHook( prvIsrEnter, prvIsrExit );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRingStop( void )
+{
+	sysSetIrqHook( NULL, NULL );
+	xRecording = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRingTaskCreate( uint32_t ulTaskNumber, const char *pcName )
+{
+	/* Names are kept even when not recording, the tasks are usually created
+	before the trace starts. */
+	if( ulTaskNumber < ringMAX_TASKS )
+	{
+		strncpy( acTaskNames[ ulTaskNumber ], pcName, configMAX_TASK_NAME_LEN );
+	}
+
+	vTraceRingWrite( ringEVENT_TASK_CREATE, ucTraceRingCurrentTask, ( uint16_t ) ulTaskNumber );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRingTaskSwitchedIn( uint32_t ulTaskNumber )
+{
+	ucTraceRingCurrentTask = ( uint8_t ) ulTaskNumber;
+	vTraceRingWrite( ringEVENT_TASK_SWITCHED_IN, ( uint8_t ) ulTaskNumber, 0 );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceRingQueueCreate( uint8_t ucQueueType )
+{
+UBaseType_t uxSavedStatus;
+uint32_t ulQueueNumber;
+
+	uxSavedStatus = uxPortSetInterruptMask();
+	ulQueueNumber = ++ulQueueCount;
+	vPortClearInterruptMask( uxSavedStatus );
+
+	vTraceRingWrite( ringEVENT_QUEUE_CREATE, ucQueueType, ( uint16_t ) ulQueueNumber );
+
+	return ulQueueNumber;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceRingUserEvent( uint16_t usValue )
+{
+	vTraceRingWrite( ringEVENT_USER, ucTraceRingCurrentTask, usValue );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDumpWrite( void ( *pfnWrite )( const void *pvData, size_t xLength ),
+						  const void *pvData, size_t xLength, uint32_t *pulSum )
+{
+const uint8_t *pucData = ( const uint8_t * ) pvData;
+size_t x;
+
+	for( x = 0; x < xLength; x++ )
+	{
+		*pulSum += pucData[ x ];
+	}
+	pfnWrite( pvData, xLength );
+}
+/*-----------------------------------------------------------*/
+
+size_t xTraceRingDump( void ( *pfnWrite )( const void *pvData, size_t xLength ) )
+{
+TraceRingHeader_t xHeader;
+BaseType_t xWasRecording;
+uint32_t ulFirst, ulSum = 0;
+
+	/* Records are only written with IRQ masked, so once the flag is clear
+	and this task runs again none is half written. */
+	xWasRecording = xRecording;
+	xRecording = pdFALSE;
+
+	xHeader.usVersion = ringVERSION;
+	xHeader.usRecordSize = sizeof( TraceRingRecord_t );
+	xHeader.ulTimestampHz = portRUN_TIME_COUNTER_HZ;
+	xHeader.ulWritten = ulWritten;
+	xHeader.ulRecords = ( ulWritten < ringRECORDS ) ? ulWritten : ringRECORDS;
+	xHeader.usMaxTasks = ringMAX_TASKS;
+	xHeader.usNameLength = configMAX_TASK_NAME_LEN;
+
+	pfnWrite( "FRTR", 4 );
+	prvDumpWrite( pfnWrite, &xHeader, sizeof( xHeader ), &ulSum );
+	prvDumpWrite( pfnWrite, acTaskNames, sizeof( acTaskNames ), &ulSum );
+
+	/* Oldest first: after a wrap the oldest record is the next to be
+	overwritten. */
+	ulFirst = ( ulWritten - xHeader.ulRecords ) & ( ringRECORDS - 1 );
+	if( ulFirst + xHeader.ulRecords > ringRECORDS )
+	{
+		prvDumpWrite( pfnWrite, &xRing[ ulFirst ], ( ringRECORDS - ulFirst ) * sizeof( TraceRingRecord_t ), &ulSum );
+		prvDumpWrite( pfnWrite, &xRing[ 0 ], ulFirst * sizeof( TraceRingRecord_t ), &ulSum );
+	}
+	else
+	{
+		prvDumpWrite( pfnWrite, &xRing[ ulFirst ], xHeader.ulRecords * sizeof( TraceRingRecord_t ), &ulSum );
+	}
+	pfnWrite( &ulSum, sizeof( ulSum ) );
+
+	xRecording = xWasRecording;
+
+	return 4 + sizeof( xHeader ) + sizeof( acTaskNames ) + xHeader.ulRecords * sizeof( TraceRingRecord_t ) + sizeof( ulSum );
+}
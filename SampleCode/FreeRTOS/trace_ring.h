@@ -0,0 +1,92 @@
+/*
+ * trace_ring.h - Binary trace of task switches, interrupts and queues
+ *
+ * The FreeRTOS trace macros below write 8-byte records into a RAM ring,
+ * each stamped with the run-time statistics clock of the port (1 us).  The
+ * oldest records are overwritten, so the ring always holds the latest
+ * activity, and xTraceRingDump() sends it in one binary block that
+ * trace_decode.py turns into CPU time per task and interrupt and a
+ * timeline.  Interrupts are recorded through sysSetIrqHook(), so every IRQ
+ * handler dispatched by the SYS driver shows up, nested or not; the tick
+ * does not.
+ *
+ * Included at the end of FreeRTOSConfig.h, so only the standard types may be
+ * used here.  Needs configUSE_TRACE_FACILITY and
+ * configGENERATE_RUN_TIME_STATS.
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Records kept in the ring, a power of two. */
+#ifndef ringRECORDS
+	#define ringRECORDS					4096
+#endif
+
+/* Task names are kept for task numbers below this. */
+#ifndef ringMAX_TASKS
+	#define ringMAX_TASKS				32
+#endif
+
+/* Record types, with the meaning of ucTask and usParam. */
+#define ringEVENT_TASK_CREATE			1	/* usParam: new task number */
+#define ringEVENT_TASK_SWITCHED_OUT		2
+#define ringEVENT_TASK_SWITCHED_IN		3
+#define ringEVENT_TASK_DELETE			4	/* usParam: deleted task number */
+#define ringEVENT_ISR_ENTER				5	/* usParam: AIC interrupt number */
+#define ringEVENT_ISR_EXIT				6	/* usParam: AIC interrupt number */
+#define ringEVENT_QUEUE_CREATE			7	/* ucTask: queue type, usParam: queue number */
+#define ringEVENT_QUEUE_SEND			8	/* usParam: queue number */
+#define ringEVENT_QUEUE_SEND_FAILED		9
+#define ringEVENT_QUEUE_RECEIVE			10
+#define ringEVENT_QUEUE_RECEIVE_FAILED	11
+#define ringEVENT_QUEUE_BLOCK_SEND		12
+#define ringEVENT_QUEUE_BLOCK_RECEIVE	13
+#define ringEVENT_QUEUE_SEND_FROM_ISR	14
+#define ringEVENT_QUEUE_RECEIVE_FROM_ISR 15
+#define ringEVENT_USER					16	/* usParam: value given to vTraceRingUserEvent() */
+
+typedef struct
+{
+	uint32_t ulTimestamp;		/* portGET_RUN_TIME_COUNTER_VALUE() */
+	uint8_t ucEvent;			/* ringEVENT_... */
+	uint8_t ucTask;				/* Number of the running task, unless noted. */
+	uint16_t usParam;
+} TraceRingRecord_t;
+
+/* Number of the task running now, kept by traceTASK_SWITCHED_IN(). */
+extern volatile uint8_t ucTraceRingCurrentTask;
+
+void vTraceRingStart( void );
+void vTraceRingStop( void );
+void vTraceRingWrite( uint8_t ucEvent, uint8_t ucTask, uint16_t usParam );
+void vTraceRingTaskCreate( uint32_t ulTaskNumber, const char *pcName );
+void vTraceRingTaskSwitchedIn( uint32_t ulTaskNumber );
+uint32_t ulTraceRingQueueCreate( uint8_t ucQueueType );
+void vTraceRingUserEvent( uint16_t usValue );
+
+/* Sends the ring through pfnWrite, which must write the bytes unchanged, and
+returns the number of bytes sent.  Recording pauses meanwhile. */
+size_t xTraceRingDump( void ( *pfnWrite )( const void *pvData, size_t xLength ) );
+
+/* FreeRTOS trace macros.  The task macros expand in tasks.c, where the TCB
+is visible, and the queue macros in queue.c. */
+#define traceTASK_CREATE( pxNewTCB )			vTraceRingTaskCreate( ( pxNewTCB )->uxTCBNumber, ( pxNewTCB )->pcTaskName )
+#define traceTASK_DELETE( pxTCB )				vTraceRingWrite( ringEVENT_TASK_DELETE, ucTraceRingCurrentTask, ( uint16_t ) ( pxTCB )->uxTCBNumber )
+#define traceTASK_SWITCHED_OUT()				vTraceRingWrite( ringEVENT_TASK_SWITCHED_OUT, ucTraceRingCurrentTask, 0 )
+#define traceTASK_SWITCHED_IN()					vTraceRingTaskSwitchedIn( pxCurrentTCB->uxTCBNumber )
+
+#define traceQUEUE_CREATE( pxNewQueue )			( pxNewQueue )->uxQueueNumber = ulTraceRingQueueCreate( ( pxNewQueue )->ucQueueType )
+#define traceQUEUE_SEND( pxQueue )				vTraceRingWrite( ringEVENT_QUEUE_SEND, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_SEND_FAILED( pxQueue )		vTraceRingWrite( ringEVENT_QUEUE_SEND_FAILED, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_RECEIVE( pxQueue )			vTraceRingWrite( ringEVENT_QUEUE_RECEIVE, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_RECEIVE_FAILED( pxQueue )	vTraceRingWrite( ringEVENT_QUEUE_RECEIVE_FAILED, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )	vTraceRingWrite( ringEVENT_QUEUE_BLOCK_SEND, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) vTraceRingWrite( ringEVENT_QUEUE_BLOCK_RECEIVE, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )		vTraceRingWrite( ringEVENT_QUEUE_SEND_FROM_ISR, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )	vTraceRingWrite( ringEVENT_QUEUE_RECEIVE_FROM_ISR, ucTraceRingCurrentTask, ( uint16_t ) ( pxQueue )->uxQueueNumber )
+
+#endif /* TRACE_RING_H */
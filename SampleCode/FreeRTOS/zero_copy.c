@@ -0,0 +1,161 @@
+/*
+ * zero_copy.c - Compare passing messages by value with passing pool buffers
+ *
+ * A producer task sends zcMESSAGES messages of zcMESSAGE_SIZE bytes to a
+ * consumer task of higher priority, first through a plain queue that holds
+ * the messages themselves, then as buffers of a BUFPOOL pool sent through a
+ * BUFQ pointer queue.  A plain queue copies every message twice, into the
+ * queue storage and out of it; the pointer queue copies 4 bytes and the
+ * consumer gives the buffer back to the pool.  Only the sequence number in
+ * the first word is written and checked, so the figures are the cost of the
+ * hand over itself, context switches included, timed with the run-time
+ * statistics clock.
+ */
+
+#include <stdio.h>
+
+/* Scheduler include files. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* Hardware includes. */
+#include "nuc980.h"
+#include "sys.h"
+
+#include "buf_pool.h"
+
+#define zcMESSAGE_SIZE          1024
+#define zcQUEUE_LENGTH          4
+#define zcPOOL_BUFFERS          ( zcQUEUE_LENGTH + 2 )
+#define zcMESSAGES              2000
+#define zcPERIOD_MS             10000
+
+#define zcMODE_COPY             1
+#define zcMODE_POINTER          2
+
+static QueueHandle_t xCopyQueue, xBufferQueue;
+static BUFPOOL_T xPool;
+static TaskHandle_t xProducer, xConsumer;
+static volatile uint32_t ulErrors = 0;
+
+/* Message storage of each side for the copy path, not on the small stacks. */
+static uint32_t ulSendMessage[ zcMESSAGE_SIZE / sizeof( uint32_t ) ];
+static uint32_t ulReceiveMessage[ zcMESSAGE_SIZE / sizeof( uint32_t ) ];
+
+/*-----------------------------------------------------------*/
+
+static void vZeroCopyConsumer( void *pvParameters )
+{
+uint32_t ulMode, ulCount;
+BUFPOOL_BUF_T *pxBuf;
+
+    ( void ) pvParameters;
+
+    for( ;; )
+    {
+        /* The producer sets the mode before each run. */
+        xTaskNotifyWait( 0, 0xFFFFFFFFUL, &ulMode, portMAX_DELAY );
+
+        for( ulCount = 0; ulCount < zcMESSAGES; ulCount++ )
+        {
+            if( ulMode == zcMODE_COPY )
+            {
+                xQueueReceive( xCopyQueue, ulReceiveMessage, portMAX_DELAY );
+                if( ulReceiveMessage[ 0 ] != ulCount )
+                {
+                    ulErrors++;
+                }
+            }
+            else
+            {
+                pxBuf = BUFQ_Receive( xBufferQueue, portMAX_DELAY );
+                if( ( pxBuf->u32Length != zcMESSAGE_SIZE ) || ( *( uint32_t * ) pxBuf->pu8Data != ulCount ) )
+                {
+                    ulErrors++;
+                }
+                BUFPOOL_Release( pxBuf );
+            }
+        }
+
+        xTaskNotifyGive( xProducer );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Returns the run time of one pass in counts of the run-time clock. */
+static uint32_t prvRun( uint32_t ulMode )
+{
+uint32_t ulStart, ulCount;
+BUFPOOL_BUF_T *pxBuf;
+
+    ulStart = portGET_RUN_TIME_COUNTER_VALUE();
+    xTaskNotify( xConsumer, ulMode, eSetValueWithOverwrite );
+
+    for( ulCount = 0; ulCount < zcMESSAGES; ulCount++ )
+    {
+        if( ulMode == zcMODE_COPY )
+        {
+            ulSendMessage[ 0 ] = ulCount;
+            xQueueSend( xCopyQueue, ulSendMessage, portMAX_DELAY );
+        }
+        else
+        {
+            pxBuf = BUFPOOL_Alloc( &xPool, portMAX_DELAY );
+            *( uint32_t * ) pxBuf->pu8Data = ulCount;
+            pxBuf->u32Length = zcMESSAGE_SIZE;
+            BUFQ_Send( xBufferQueue, pxBuf, portMAX_DELAY );
+        }
+    }
+
+    ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+    return portGET_RUN_TIME_COUNTER_VALUE() - ulStart;
+}
+/*-----------------------------------------------------------*/
+
+static void vZeroCopyTask( void *pvParameters )
+{
+TickType_t xLastWakeTime;
+uint32_t ulCopyTime, ulPointerTime;
+
+    ( void ) pvParameters;
+
+    xLastWakeTime = xTaskGetTickCount();
+
+    for( ;; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, zcPERIOD_MS / portTICK_PERIOD_MS );
+
+        ulCopyTime = prvRun( zcMODE_COPY );
+        ulPointerTime = prvRun( zcMODE_POINTER );
+
+        /* Hundredths of a microsecond per message. */
+        ulCopyTime = ( uint32_t ) ( ( uint64_t ) ulCopyTime * 100000000ULL / portRUN_TIME_COUNTER_HZ / zcMESSAGES );
+        ulPointerTime = ( uint32_t ) ( ( uint64_t ) ulPointerTime * 100000000ULL / portRUN_TIME_COUNTER_HZ / zcMESSAGES );
+
+        printf( "Zero copy, %u-byte messages: by value %u.%02u us, by pointer %u.%02u us, min free %u of %u, %u errors\n",
+                ( unsigned ) zcMESSAGE_SIZE,
+                ( unsigned ) ( ulCopyTime / 100 ), ( unsigned ) ( ulCopyTime % 100 ),
+                ( unsigned ) ( ulPointerTime / 100 ), ( unsigned ) ( ulPointerTime % 100 ),
+                ( unsigned ) BUFPOOL_GetMinFree( &xPool ), ( unsigned ) zcPOOL_BUFFERS,
+                ( unsigned ) ulErrors );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vStartZeroCopyTest( UBaseType_t uxPriority )
+{
+    xCopyQueue = xQueueCreate( zcQUEUE_LENGTH, zcMESSAGE_SIZE );
+    xBufferQueue = BUFQ_Create( zcQUEUE_LENGTH );
+    if( ( xCopyQueue == NULL ) || ( xBufferQueue == NULL ) ||
+        ( BUFPOOL_Create( &xPool, zcMESSAGE_SIZE, zcPOOL_BUFFERS, 0 ) != BUFPOOL_OK ) )
+    {
+        printf( "Zero copy test: out of heap\n" );
+        return;
+    }
+
+    /* The consumer runs as soon as a message arrives, like a driver task. */
+    xTaskCreate( vZeroCopyConsumer, "ZcRx", configMINIMAL_STACK_SIZE * 2, NULL, uxPriority + 1, &xConsumer );
+    xTaskCreate( vZeroCopyTask, "ZcTx", configMINIMAL_STACK_SIZE * 3, NULL, uxPriority, &xProducer );
+}
@@ -0,0 +1,180 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Access QSPI NOR flash through the qspi_flash driver with PDMA,
+*           quad I/O read and the LRU sector read cache
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "qspi_flash.h"
+
+#define TEST_ADDR           0x10000     /* flash address used by the test */
+#define TEST_LENGTH         0x10000     /* 64 KB */
+
+#define QSPI_FLASH_PORT     QSPI0
+#define FLASH_TX_DMA_CH     0
+#define FLASH_RX_DMA_CH     1
+
+QSPI_FLASH_T g_sFlash;
+
+uint8_t SrcArray[TEST_LENGTH] __attribute__((aligned(32)));
+uint8_t DestArray[TEST_LENGTH] __attribute__((aligned(32)));
+
+/*******************************************************************************/
+volatile uint32_t _timer_tick;
+
+void ETMR0_IRQHandler(void)
+{
+    _timer_tick ++;
+    // clear timer interrupt flag
+    ETIMER_ClearIntFlag(0);
+}
+
+uint32_t get_ticks(void)
+{
+    return _timer_tick;
+}
+
+void Start_ETIMER0(void)
+{
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Set timer frequency to 1000 HZ
+    ETIMER_Open(0, ETIMER_PERIODIC_MODE, 1000);
+
+    // Enable timer interrupt
+    ETIMER_EnableInt(0);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER0, (PVOID)ETMR0_IRQHandler);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(IRQ_TIMER0);
+
+    _timer_tick = 0;
+
+    // Start Timer 0
+    ETIMER_Start(0);
+}
+
+/*-----------------------------------------------------------------------------*/
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);  // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+static uint32_t Compare(uint8_t *pu8Src, uint8_t *pu8Dest, uint32_t u32Len)
+{
+    uint32_t i, nError = 0;
+
+    for(i = 0; i < u32Len; i++)
+    {
+        if(pu8Src[i] != pu8Dest[i])
+            nError ++;
+    }
+    return nError;
+}
+
+int32_t main(void)
+{
+    QSPI_FLASH_CACHE_STATS_T sStats;
+    uint32_t u32ByteCount, u32Ticks, u32Ret, i;
+    uint32_t nError = 0;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+
+    UART_Init();
+    Start_ETIMER0();
+
+    /* enable PDMA0 clock */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x1000);
+
+    /* enable QSPI0 clock */
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | 0x10);
+
+    /* Configure multi function pins to QSPI0, including D2/D3 for quad mode */
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFFFFFF00) | 0x11111100);
+
+    /* Configure QSPI_FLASH_PORT as a master, MSB first, 8-bit transaction, QSPI Mode-0 timing, clock is 30MHz */
+    QSPI_Open(QSPI_FLASH_PORT, QSPI_MASTER, QSPI_MODE_0, 8, 30000000);
+
+    /* Disable auto SS function, control SS signal manually. */
+    QSPI_DisableAutoSS(QSPI_FLASH_PORT);
+
+    printf("\n+------------------------------------------------------------------------+\n");
+    printf("|                NUC980 QSPI NOR Flash Driver Sample Code                 |\n");
+    printf("+------------------------------------------------------------------------+\n");
+
+    u32Ret = QSPI_FLASH_Open(&g_sFlash, QSPI_FLASH_PORT, PDMA0, FLASH_TX_DMA_CH, FLASH_RX_DMA_CH, QSPI_FLASH_FLAG_QUAD);
+    if(u32Ret != QSPI_FLASH_OK)
+    {
+        printf("Flash not found, 0x%x\n", u32Ret);
+        while(1);
+    }
+
+    printf("JEDEC ID      : 0x%06x\n", g_sFlash.u32JedecID);
+    printf("Size          : %d KB\n", g_sFlash.u32Size / 1024);
+    printf("Page/Sector   : %d / %d bytes\n", g_sFlash.u32PageSize, g_sFlash.u32SectorSize);
+    printf("Parameters    : %s\n", g_sFlash.u8SFDP ? "SFDP" : "default");
+    printf("Read command  : %02Xh (%s)\n", g_sFlash.u8ReadCmd, g_sFlash.u8Quad ? "quad I/O" : "single");
+
+    printf("Erase %d KB ...", TEST_LENGTH / 1024);
+    u32Ticks = get_ticks();
+    QSPI_FLASH_Erase(&g_sFlash, TEST_ADDR, TEST_LENGTH);
+    printf("[OK] %d ms\n", get_ticks() - u32Ticks);
+
+    /* init source data buffer */
+    for(u32ByteCount=0; u32ByteCount<TEST_LENGTH; u32ByteCount++)
+    {
+        SrcArray[u32ByteCount] = (u32ByteCount >> 8) ^ u32ByteCount;
+    }
+
+    printf("Program %d KB ...", TEST_LENGTH / 1024);
+    u32Ticks = get_ticks();
+    QSPI_FLASH_Write(&g_sFlash, TEST_ADDR, SrcArray, TEST_LENGTH);
+    printf("[OK] %d ms\n", get_ticks() - u32Ticks);
+
+    printf("Bulk read %d KB ...", TEST_LENGTH / 1024);
+    memset(DestArray, 0, TEST_LENGTH);
+    u32Ticks = get_ticks();
+    QSPI_FLASH_Read(&g_sFlash, TEST_ADDR, DestArray, TEST_LENGTH);
+    u32Ticks = get_ticks() - u32Ticks;
+    nError += Compare(SrcArray, DestArray, TEST_LENGTH);
+    printf("%s %d ms\n", nError ? "[FAIL]" : "[OK]", u32Ticks);
+
+    /* Small unaligned reads inside a few sectors, mostly served by the cache */
+    printf("Random small reads ...");
+    memset(DestArray, 0, TEST_LENGTH);
+    u32Ticks = get_ticks();
+    for(i = 0; i < 4096; i++)
+    {
+        uint32_t u32Off = (i * 37) % (QSPI_FLASH_CACHE_LINE_SIZE * 4 - 16);
+
+        QSPI_FLASH_Read(&g_sFlash, TEST_ADDR + u32Off, &DestArray[u32Off], 13);
+        nError += Compare(&SrcArray[u32Off], &DestArray[u32Off], 13);
+    }
+    u32Ticks = get_ticks() - u32Ticks;
+    printf("%s %d ms\n", nError ? "[FAIL]" : "[OK]", u32Ticks);
+
+    QSPI_FLASH_GetCacheStats(&sStats);
+    printf("Cache hit %d, miss %d, bypass %d, evict %d\n", sStats.u32Hit, sStats.u32Miss, sStats.u32Bypass, sStats.u32Evict);
+
+    if(nError == 0)
+        printf("Test [OK]\n");
+    else
+        printf("Test [FAIL]\n");
+
+    while(1);
+}
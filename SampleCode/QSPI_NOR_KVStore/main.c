@@ -0,0 +1,305 @@
+/**************************************************************************//**
+* @file     main.c
+* @brief    Keep settings in a wear-leveled key-value store on QSPI NOR flash.
+*           The same store is first exercised on a RAM flash simulator to show
+*           update rate, erase distribution and power loss recovery.
+*
+* @copyright (C) 2018 Nuvoton Technology Corp. All rights reserved.
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "nuc980.h"
+#include "sys.h"
+#include "etimer.h"
+#include "qspi_flash.h"
+#include "nor_kv.h"
+
+#define QSPI_FLASH_PORT     QSPI0
+#define FLASH_TX_DMA_CH     0
+#define FLASH_RX_DMA_CH     1
+
+#define KV_FLASH_BASE       0x100000    /* flash address of the store */
+#define KV_SECTOR_COUNT     16          /* 64 KB with 4 KB sectors */
+#define KV_INDEX_SIZE       128         /* power of 2, larger than the number of keys */
+
+#define SIM_SECTOR_SIZE     4096
+#define SIM_SECTOR_COUNT    16
+#define SIM_KEYS            40
+#define SIM_UPDATES         20000
+#define SIM_POWER_FAILS     200
+
+QSPI_FLASH_T g_sFlash;
+
+NORKV_T g_sKV;
+NORKV_INDEX_T g_asIndex[KV_INDEX_SIZE];
+
+NORKV_SIM_T g_sSim;
+uint8_t g_au8SimMem[SIM_SECTOR_SIZE * SIM_SECTOR_COUNT] __attribute__((aligned(32)));
+uint32_t g_au32SimErase[SIM_SECTOR_COUNT];
+uint32_t g_au32Expect[SIM_KEYS];
+
+/*******************************************************************************/
+volatile uint32_t _timer_tick;
+
+void ETMR0_IRQHandler(void)
+{
+    _timer_tick ++;
+    // clear timer interrupt flag
+    ETIMER_ClearIntFlag(0);
+}
+
+uint32_t get_ticks(void)
+{
+    return _timer_tick;
+}
+
+void Start_ETIMER0(void)
+{
+    // Enable ETIMER0 engine clock
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 8));
+
+    // Set timer frequency to 1000 HZ
+    ETIMER_Open(0, ETIMER_PERIODIC_MODE, 1000);
+
+    // Enable timer interrupt
+    ETIMER_EnableInt(0);
+    sysInstallISR(IRQ_LEVEL_1, IRQ_TIMER0, (PVOID)ETMR0_IRQHandler);
+    sysSetLocalInterrupt(ENABLE_IRQ);
+    sysEnableInterrupt(IRQ_TIMER0);
+
+    _timer_tick = 0;
+
+    // Start Timer 0
+    ETIMER_Start(0);
+}
+
+/*-----------------------------------------------------------------------------*/
+void UART_Init()
+{
+    /* enable UART0 clock */
+    outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | 0x10000);
+
+    /* GPF11, GPF12 */
+    outpw(REG_SYS_GPF_MFPH, (inpw(REG_SYS_GPF_MFPH) & 0xfff00fff) | 0x11000);  // UART0 multi-function
+
+    /* UART0 line configuration for (115200,n,8,1) */
+    outpw(REG_UART0_LCR, inpw(REG_UART0_LCR) | 0x07);
+    outpw(REG_UART0_BAUD, 0x30000066); /* 12MHz reference clock input, 115200 */
+}
+
+/*-----------------------------------------------------------------------------*/
+/* NORKV flash callbacks on top of the qspi_flash driver                       */
+/*-----------------------------------------------------------------------------*/
+static int32_t KV_FlashRead(void *pvCtx, uint32_t u32Addr, void *pvBuf, uint32_t u32Len)
+{
+    return (QSPI_FLASH_Read((QSPI_FLASH_T *)pvCtx, u32Addr, (uint8_t *)pvBuf, u32Len) == QSPI_FLASH_OK) ? 0 : -1;
+}
+
+static int32_t KV_FlashProg(void *pvCtx, uint32_t u32Addr, const void *pvBuf, uint32_t u32Len)
+{
+    return (QSPI_FLASH_Write((QSPI_FLASH_T *)pvCtx, u32Addr, (const uint8_t *)pvBuf, u32Len) == QSPI_FLASH_OK) ? 0 : -1;
+}
+
+static int32_t KV_FlashErase(void *pvCtx, uint32_t u32Addr)
+{
+    QSPI_FLASH_T *flash = (QSPI_FLASH_T *)pvCtx;
+
+    return (QSPI_FLASH_Erase(flash, u32Addr, flash->u32SectorSize) == QSPI_FLASH_OK) ? 0 : -1;
+}
+
+/*-----------------------------------------------------------------------------*/
+static uint32_t SimCheck(void)
+{
+    uint32_t i, u32Value, nError = 0;
+    char key[16];
+    int32_t i32Ret;
+
+    for(i = 0; i < SIM_KEYS; i++)
+    {
+        sprintf(key, "sim/%d", i);
+        i32Ret = NORKV_Get(&g_sKV, key, &u32Value, sizeof(u32Value), NULL);
+        if(g_au32Expect[i] == 0xFFFFFFFF)
+        {
+            if(i32Ret != NORKV_ERR_NOT_FOUND)
+                nError++;
+        }
+        else if((i32Ret != NORKV_OK) || (u32Value != g_au32Expect[i]))
+        {
+            nError++;
+        }
+    }
+    return nError;
+}
+
+static uint32_t SimBenchmark(void)
+{
+    NORKV_FLASH_T sFlash;
+    NORKV_STATS_T sStats;
+    uint32_t i, u32Ticks, u32Key, u32Value, u32Seed = 1, u32MinErase;
+    uint32_t nError = 0;
+    char key[16];
+    int32_t i32Ret;
+
+    NORKV_SimInit(&g_sSim, g_au8SimMem, sizeof(g_au8SimMem), SIM_SECTOR_SIZE, g_au32SimErase);
+    NORKV_SimBind(&g_sSim, &sFlash);
+    NORKV_Format(&g_sKV, &sFlash, g_asIndex, KV_INDEX_SIZE);
+    memset(g_au32Expect, 0xFF, sizeof(g_au32Expect));
+
+    printf("Simulator: %d updates on %d keys ...", SIM_UPDATES, SIM_KEYS);
+    u32Ticks = get_ticks();
+    for(i = 0; i < SIM_UPDATES; i++)
+    {
+        u32Seed = u32Seed * 1103515245 + 12345;
+        u32Key = (u32Seed >> 16) % SIM_KEYS;
+        u32Value = i;
+        sprintf(key, "sim/%d", u32Key);
+
+        if(NORKV_Set(&g_sKV, key, &u32Value, sizeof(u32Value)) != NORKV_OK)
+            nError++;
+        g_au32Expect[u32Key] = u32Value;
+
+        /* Background compaction keeps the write path free of erases */
+        if(NORKV_NeedCompact(&g_sKV))
+            NORKV_Compact(&g_sKV, 4);
+    }
+    u32Ticks = get_ticks() - u32Ticks;
+    printf("%s %d ms\n", nError ? "[FAIL]" : "[OK]", u32Ticks);
+
+    NORKV_GetStats(&g_sKV, &sStats);
+    u32MinErase = 0xFFFFFFFF;
+    for(i = 0; i < SIM_SECTOR_COUNT; i++)
+    {
+        if(g_au32SimErase[i] < u32MinErase)
+            u32MinErase = g_au32SimErase[i];
+    }
+    printf("  programmed %d bytes in %d ops, %d erases, %d compactions\n",
+           g_sSim.u32ProgBytes, g_sSim.u32ProgOps, g_sSim.u32EraseOps, sStats.u32Compactions);
+    printf("  sector erase count min %d max %d, program violations %d\n", u32MinErase, g_sSim.u32MaxSectorErase, g_sSim.u32Violations);
+    nError += g_sSim.u32Violations;
+
+    printf("Simulator: remount ...");
+    NORKV_Mount(&g_sKV, &sFlash, g_asIndex, KV_INDEX_SIZE);
+    i32Ret = SimCheck();
+    printf("%s\n", i32Ret ? "[FAIL]" : "[OK]");
+    nError += i32Ret;
+
+    /* Cut the power in the middle of a write, the key keeps either its old or its new value */
+    printf("Simulator: %d power losses ...", SIM_POWER_FAILS);
+    for(i = 0; i < SIM_POWER_FAILS; i++)
+    {
+        u32Seed = u32Seed * 1103515245 + 12345;
+        u32Key = (u32Seed >> 16) % SIM_KEYS;
+        u32Value = SIM_UPDATES + i;
+        sprintf(key, "sim/%d", u32Key);
+
+        g_sSim.u32PowerFail = 1 + (u32Seed % 64);
+        i32Ret = NORKV_Set(&g_sKV, key, &u32Value, sizeof(u32Value));
+        if((i32Ret == NORKV_OK) && g_sSim.u32PowerFail)
+            g_au32Expect[u32Key] = u32Value;
+        g_sSim.u32PowerFail = 0;
+
+        NORKV_Mount(&g_sKV, &sFlash, g_asIndex, KV_INDEX_SIZE);
+        if(i32Ret != NORKV_OK)
+        {
+            uint32_t u32Read;
+
+            if((NORKV_Get(&g_sKV, key, &u32Read, sizeof(u32Read), NULL) == NORKV_OK) && (u32Read == u32Value))
+                g_au32Expect[u32Key] = u32Value;
+        }
+        nError += SimCheck();
+    }
+    printf("%s\n", nError ? "[FAIL]" : "[OK]");
+
+    return nError;
+}
+
+/*-----------------------------------------------------------------------------*/
+int32_t main(void)
+{
+    NORKV_FLASH_T sFlash;
+    NORKV_STATS_T sStats;
+    uint32_t u32Ticks, u32Ret, u32Boot, i;
+    uint32_t nError = 0;
+
+    sysDisableCache();
+    sysFlushCache(I_D_CACHE);
+    sysEnableCache(CACHE_WRITE_BACK);
+
+    UART_Init();
+    Start_ETIMER0();
+
+    /* enable PDMA0 clock */
+    outpw(REG_CLK_HCLKEN, inpw(REG_CLK_HCLKEN) | 0x1000);
+
+    /* enable QSPI0 clock */
+    outpw(REG_CLK_PCLKEN1, inpw(REG_CLK_PCLKEN1) | 0x10);
+
+    /* Configure multi function pins to QSPI0, including D2/D3 for quad mode */
+    outpw(REG_SYS_GPD_MFPL, (inpw(REG_SYS_GPD_MFPL) & ~0xFFFFFF00) | 0x11111100);
+
+    /* Configure QSPI_FLASH_PORT as a master, MSB first, 8-bit transaction, QSPI Mode-0 timing, clock is 30MHz */
+    QSPI_Open(QSPI_FLASH_PORT, QSPI_MASTER, QSPI_MODE_0, 8, 30000000);
+
+    /* Disable auto SS function, control SS signal manually. */
+    QSPI_DisableAutoSS(QSPI_FLASH_PORT);
+
+    printf("\n+------------------------------------------------------------------------+\n");
+    printf("|              NUC980 QSPI NOR Flash Key-Value Store Sample Code          |\n");
+    printf("+------------------------------------------------------------------------+\n");
+
+    nError += SimBenchmark();
+
+    u32Ret = QSPI_FLASH_Open(&g_sFlash, QSPI_FLASH_PORT, PDMA0, FLASH_TX_DMA_CH, FLASH_RX_DMA_CH, QSPI_FLASH_FLAG_QUAD);
+    if(u32Ret != QSPI_FLASH_OK)
+    {
+        printf("Flash not found, 0x%x\n", u32Ret);
+        while(1);
+    }
+
+    sFlash.read = KV_FlashRead;
+    sFlash.prog = KV_FlashProg;
+    sFlash.erase = KV_FlashErase;
+    sFlash.pvCtx = &g_sFlash;
+    sFlash.u32Base = KV_FLASH_BASE;
+    sFlash.u32SectorSize = g_sFlash.u32SectorSize;
+    sFlash.u32SectorCount = KV_SECTOR_COUNT;
+
+    printf("Mount store at 0x%x, %d sectors ...", KV_FLASH_BASE, KV_SECTOR_COUNT);
+    u32Ticks = get_ticks();
+    if(NORKV_Mount(&g_sKV, &sFlash, g_asIndex, KV_INDEX_SIZE) != NORKV_OK)
+    {
+        printf("[FAIL]\n");
+        while(1);
+    }
+    printf("[OK] %d ms\n", get_ticks() - u32Ticks);
+
+    /* The boot counter survives resets and power cycles */
+    if(NORKV_Get(&g_sKV, "boot_count", &u32Boot, sizeof(u32Boot), NULL) != NORKV_OK)
+        u32Boot = 0;
+    u32Boot++;
+    NORKV_Set(&g_sKV, "boot_count", &u32Boot, sizeof(u32Boot));
+    printf("Boot count    : %d\n", u32Boot);
+
+    printf("1000 updates on flash ...");
+    u32Ticks = get_ticks();
+    for(i = 0; i < 1000; i++)
+    {
+        if(NORKV_Set(&g_sKV, (i & 1) ? "counter/a" : "counter/b", &i, sizeof(i)) != NORKV_OK)
+            nError++;
+        if(NORKV_NeedCompact(&g_sKV))
+            NORKV_Compact(&g_sKV, 4);
+    }
+    u32Ticks = get_ticks() - u32Ticks;
+    printf("%s %d ms\n", nError ? "[FAIL]" : "[OK]", u32Ticks);
+
+    NORKV_GetStats(&g_sKV, &sStats);
+    printf("Keys %d, free sectors %d, live %d / used %d bytes, %d erases\n",
+           sStats.u32Keys, sStats.u32FreeSectors, sStats.u32LiveBytes, sStats.u32UsedBytes, sStats.u32Erases);
+
+    if(nError == 0)
+        printf("Test [OK]\n");
+    else
+        printf("Test [FAIL]\n");
+
+    while(1);
+}
@@ -12,6 +12,7 @@
 #include "sdh.h"
 #include "ff.h"
 #include "diskio.h"
+#include "blkdev.h"
 
 extern int sd0_ok;
 extern int sd1_ok;
@@ -19,6 +20,9 @@ extern int sd1_ok;
 FATFS  _FatfsVolSd0;
 FATFS  _FatfsVolSd1;
 
+static BLKDEV_T _BlkDevSd0;
+static BLKDEV_T _BlkDevSd1;
+
 static TCHAR  _Path[3] = { '0', ':', 0 };
 
 void SDH_Open_Disk(SDH_T *sdh, uint32_t u32CardDetSrc)
@@ -35,11 +39,13 @@ void SDH_Open_Disk(SDH_T *sdh, uint32_t u32CardDetSrc)
     if (sdh == SDH0)
     {
         _Path[0] = '0';
+        BLKDEV_Register(0, &_BlkDevSd0, &g_sBlkDevSdOps, SDH0, 0);
         f_mount(&_FatfsVolSd0, _Path, 1);
     }
     else
     {
         _Path[0] = '1';
+        BLKDEV_Register(1, &_BlkDevSd1, &g_sBlkDevSdOps, SDH1, 0);
         f_mount(&_FatfsVolSd1, _Path, 1);
     }
 
@@ -51,6 +57,7 @@ void SDH_Close_Disk(SDH_T *sdh)
     {
         _Path[0]='0';
         memset(&SD0, 0, sizeof(SDH_INFO_T));
+        BLKDEV_Unregister(0);
         f_mount(NULL, _Path, 1);
         memset(&_FatfsVolSd0, 0, sizeof(FATFS));
     }
@@ -58,6 +65,7 @@ void SDH_Close_Disk(SDH_T *sdh)
     {
         _Path[0]='1';
         memset(&SD1, 0, sizeof(SDH_INFO_T));
+        BLKDEV_Unregister(1);
         f_mount(NULL, _Path, 1);
         memset(&_FatfsVolSd1, 0, sizeof(FATFS));
     }
@@ -12,6 +12,7 @@
 #include "sdh.h"
 #include "ff.h"
 #include "diskio.h"
+#include "blkdev.h"
 
 
 #define BUFF_SIZE       (64*1024)
@@ -408,6 +409,7 @@ int32_t main(void)
     UINT s1, s2, cnt;
     static const BYTE ft[] = {0, 12, 16, 32};
     DWORD ofs = 0, sect = 0;
+    BLKDEV_STATS_T sStats;
 
     *(volatile unsigned int *)(CLK_BA+0x18) |= (1<<16); /* Enable UART0 */
     UART_Init();
@@ -478,6 +480,18 @@ int32_t main(void)
                     put_dump(buf, ofs, 16);
                 break;
 
+            case 's' :  /* ds <pd#> - Show disk cache statistics */
+                if (!xatoi(&ptr, &p1)) break;
+                if (BLKDEV_GetStats(p1, &sStats) != BLKDEV_OK)
+                {
+                    printf("Drive %d not registered\n", p1);
+                    break;
+                }
+                printf("Read hit %d, miss %d, read-ahead %d\n", sStats.u32ReadHit, sStats.u32ReadMiss, sStats.u32ReadAhead);
+                printf("Write cached %d, written back %d, bypass %d, evict %d\n",
+                       sStats.u32WriteCached, sStats.u32WriteBack, sStats.u32Bypass, sStats.u32Evict);
+                printf("Device reads %d, writes %d\n", sStats.u32DevRead, sStats.u32DevWrite);
+                break;
             }
             break;
 
@@ -832,7 +846,7 @@ int32_t main(void)
             printf(
                 _T("n: - Change default drive (SD drive is 0~1)\n")
                 _T("dd [<lba>] - Dump sector\n")
-                //_T("ds <pd#> - Show disk status\n")
+                _T("ds <pd#> - Show disk cache statistics\n")
                 _T("\n")
                 _T("bd <ofs> - Dump working buffer\n")
                 _T("be <ofs> [<data>] ... - Edit working buffer\n")
@@ -18,6 +18,7 @@
 #include "usbh_lib.h"
 #include "ff.h"
 #include "diskio.h"
+#include "blkdev.h"
 
 
 #define BUFF_SIZE       (64*1024)
@@ -36,6 +37,11 @@ BYTE Buff_Pool[BUFF_SIZE*2] __attribute__((aligned(32)));       /* Working buffe
 
 BYTE  *Buff, *Buff2;
 
+#define USB_DRIVE_FIRST 3                   /* USB host library assigns drives 3 to 9 */
+#define USB_DRIVE_NUM   7
+
+BLKDEV_T  g_BlkDevUsb[USB_DRIVE_NUM];
+
 static FIL file1, file2;        /* File objects */
 
 volatile uint32_t  _timer_tick;
@@ -367,6 +373,8 @@ int32_t main(void)
     UINT s1, s2, cnt;
     static const BYTE ft[] = {0, 12, 16, 32};
     DWORD ofs = 0, sect = 0;
+    BLKDEV_STATS_T sStats;
+    int i;
 
     sysDisableCache();
     sysFlushCache(I_D_CACHE);
@@ -405,6 +413,11 @@ int32_t main(void)
     Buff2 = (BYTE *)((UINT32)&Buff_Pool[BUFF_SIZE] | 0x80000000);   /* use non-cache buffer */
 
     usbh_core_init();
+    /* Route the USB disk drives through the block device cache. Disks can be unplugged
+       at any time, so write through and only keep read data cached. */
+    for (i = 0; i < USB_DRIVE_NUM; i++)
+        BLKDEV_Register(USB_DRIVE_FIRST + i, &g_BlkDevUsb[i], &g_sBlkDevUmasOps, (void *)(USB_DRIVE_FIRST + i), BLKDEV_FLAG_WRITE_THROUGH);
+
     usbh_umas_init();
     usbh_pooling_hubs();
 
@@ -478,6 +491,18 @@ int32_t main(void)
                     put_dump(buf, ofs, 16);
                 break;
 
+            case 's' :  /* ds <pd#> - Show disk cache statistics */
+                if (!xatoi(&ptr, &p1)) break;
+                if (BLKDEV_GetStats(p1, &sStats) != BLKDEV_OK)
+                {
+                    printf("Drive %d not registered\n", p1);
+                    break;
+                }
+                printf("Read hit %d, miss %d, read-ahead %d\n", sStats.u32ReadHit, sStats.u32ReadMiss, sStats.u32ReadAhead);
+                printf("Write cached %d, written back %d, bypass %d, evict %d\n",
+                       sStats.u32WriteCached, sStats.u32WriteBack, sStats.u32Bypass, sStats.u32Evict);
+                printf("Device reads %d, writes %d\n", sStats.u32DevRead, sStats.u32DevWrite);
+                break;
             }
             break;
 
@@ -920,7 +945,7 @@ int32_t main(void)
             printf(
                 _T("n: - Change default drive (USB drive is 3~7)\n")
                 _T("dd [<lba>] - Dump sector\n")
-                //_T("ds <pd#> - Show disk status\n")
+                _T("ds <pd#> - Show disk cache statistics\n")
                 _T("\n")
                 _T("bd <ofs> - Dump working buffer\n")
                 _T("be <ofs> [<data>] ... - Edit working buffer\n")
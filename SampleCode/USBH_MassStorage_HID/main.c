@@ -18,6 +18,7 @@
 #include "usbh_hid.h"
 #include "ff.h"
 #include "diskio.h"
+#include "blkdev.h"
 
 
 #define BUFF_SIZE       (256*1024)
@@ -35,6 +36,11 @@ BYTE Buff_Pool[BUFF_SIZE] __attribute__((aligned(32)));       /* Working buffer
 
 BYTE  *Buff;
 
+#define USB_DRIVE_FIRST 3                   /* USB host library assigns drives 3 to 9 */
+#define USB_DRIVE_NUM   7
+
+BLKDEV_T  g_BlkDevUsb[USB_DRIVE_NUM];
+
 
 uint32_t   g_hid_buff_pool[1024] __attribute__((aligned(32)));
 
@@ -240,6 +246,7 @@ int32_t main(void)
     HID_DEV_T   *hdev;
     TCHAR       usb_path[] = { '3', ':', 0 };    /* USB drive started from 3 */
     int         sector;
+    int         i;
     FRESULT     res;
 
     Buff = (BYTE *)((UINT32)&Buff_Pool[0] | 0x80000000);     /* use non-cache buffer */
@@ -270,6 +277,11 @@ int32_t main(void)
     Start_ETIMER0();
 
     usbh_core_init();
+    /* Route the USB disk drives through the block device cache. Disks can be unplugged
+       at any time, so write through and only keep read data cached. */
+    for (i = 0; i < USB_DRIVE_NUM; i++)
+        BLKDEV_Register(USB_DRIVE_FIRST + i, &g_BlkDevUsb[i], &g_sBlkDevUmasOps, (void *)(USB_DRIVE_FIRST + i), BLKDEV_FLAG_WRITE_THROUGH);
+
     usbh_umas_init();
     usbh_hid_init();
     memset(g_hid_list, 0, sizeof(g_hid_list));
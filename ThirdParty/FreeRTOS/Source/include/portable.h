@@ -123,6 +123,28 @@ typedef struct HeapRegion
  */
 void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEGED_FUNCTION;
 
+/* Used to pass information about the heap out of vPortGetHeapStats(). */
+typedef struct xHeapStats
+{
+	size_t xAvailableHeapSpaceInBytes;		/* The total heap size currently available - this is the sum of all the free blocks, not the largest block that can be allocated. */
+	size_t xSizeOfLargestFreeBlockInBytes; 	/* The maximum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xSizeOfSmallestFreeBlockInBytes; /* The minimum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xNumberOfFreeBlocks;				/* The number of free memory blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xMinimumEverFreeBytesRemaining;	/* The minimum amount of total free memory (sum of all free blocks) there has been in the heap since the system booted. */
+	size_t xNumberOfSuccessfulAllocations;	/* The number of calls to pvPortMalloc() that have returned a valid memory block. */
+	size_t xNumberOfSuccessfulFrees;		/* The number of calls to vPortFree() that has successfully freed a block of memory. */
+} HeapStats_t;
+
+/* Memory allocated by one task, passed out of uxPortGetHeapTaskStats(). */
+typedef struct xHeapTaskStats
+{
+	void *pvTask;							/* Handle of the task, NULL for the entry that holds the memory taken before the scheduler started or by tasks beyond the table. */
+	size_t xBytesInUse;						/* Bytes allocated by the task and not freed yet, by any task. */
+	size_t xPeakBytesInUse;					/* The most xBytesInUse has been. */
+	size_t xAllocations;					/* The number of blocks allocated by the task. */
+	size_t xFrees;							/* The number of those blocks freed. */
+} HeapTaskStats_t;
+
 
 /*
  * Map to the memory management routines required for the port.
@@ -133,6 +155,17 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Only provided by heap_tlsf.c, which can manage several pools of memory.
+ * pvPortMalloc() allocates from pool 0.
+ */
+void *pvPortMallocFromPool( UBaseType_t uxPool, size_t xSize ) PRIVILEGED_FUNCTION;
+void *pvPortRealloc( void *pv, size_t xWantedSize ) PRIVILEGED_FUNCTION;
+void vPortAddHeapRegion( UBaseType_t uxPool, uint8_t *pucStartAddress, size_t xSizeInBytes ) PRIVILEGED_FUNCTION;
+void vPortGetHeapStats( HeapStats_t *pxHeapStats ) PRIVILEGED_FUNCTION;
+UBaseType_t uxPortGetHeapTaskStats( HeapTaskStats_t *pxTaskStats, UBaseType_t uxMaxStats ) PRIVILEGED_FUNCTION;
+void vPortHeapTaskDeleted( void *pvTask ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
@@ -95,6 +95,14 @@
 #define portNO_CRITICAL_NESTING		( ( uint32_t ) 0 )
 volatile uint32_t ulCriticalNesting = 9999UL;
 
+/* Set by portYIELD_FROM_ISR() in any interrupt handler.  The IRQ entry
+switches tasks once the handler has returned. */
+volatile uint32_t ulPortYieldRequired = pdFALSE;
+
+/* Depth of interrupt handlers running with IRQ enabled, see
+vPortDispatchIrqNested().  Stays 0 unless configNUC980_NESTED_IRQ is set. */
+volatile uint32_t ulPortIrqNesting = 0;
+
 /*-----------------------------------------------------------*/
 
 /* ISR to handle manual context switches (from a call to taskYIELD()). */
@@ -180,6 +188,20 @@ extern void systemIrqHandler(UINT32 num);
 	//void __attribute__ ((interrupt ("IRQ"))) vPreemptiveTick( void )
 	void  __attribute__((naked)) vPreemptiveTick( void )
 	{
+		#if configNUC980_NESTED_IRQ == 1
+		{
+			/* An IRQ taken while a handler runs nested interrupted that
+			handler, not a task. */
+			asm volatile (
+				"STMDB	SP!, {R0}					\n\t"
+				"LDR	R0, =ulPortIrqNesting		\n\t"
+				"LDR	R0, [R0]					\n\t"
+				"CMP	R0, #0						\n\t"
+				"LDMIA	SP!, {R0}					\n\t"
+				"BNE	vPortNestedIrq				\n\t" );
+		}
+		#endif
+
 		/* Save the context of the interrupted task. */
 		portSAVE_CONTEXT();
 
@@ -195,11 +217,11 @@ extern void systemIrqHandler(UINT32 num);
 		else
 		{
 			//*(unsigned int volatile *)(0xb0070000) = 'T';
-			/* Increment the RTOS tick count, then look for the highest priority
-			task that is ready to run. */
+			/* Increment the RTOS tick count, this may make a delayed task
+			ready to run. */
 			if( xTaskIncrementTick() != pdFALSE )
 			{
-				vTaskSwitchContext();
+				ulPortYieldRequired = pdTRUE;
 			}
 
 			// clear TIF1
@@ -208,6 +230,15 @@ extern void systemIrqHandler(UINT32 num);
 			outpw(REG_AIC_EOIS, 0x01);
 		}
 
+		/* The context of the interrupted task is saved, so whichever handler
+		woke a higher priority task, the switch happens here on the way out
+		rather than at the next tick. */
+		if( ulPortYieldRequired != pdFALSE )
+		{
+			ulPortYieldRequired = pdFALSE;
+			vTaskSwitchContext();
+		}
+
 		/* Restore the context of the new task. */
 		portRESTORE_CONTEXT();
 
@@ -216,6 +247,134 @@ extern void systemIrqHandler(UINT32 num);
 #endif
 /*-----------------------------------------------------------*/
 
+#if configNUC980_NESTED_IRQ == 1
+
+	/*
+	 * vPortDispatchIrqNested() is called by systemIrqHandler() in IRQ mode
+	 * once the task context is saved.  It runs the handler in system mode with
+	 * IRQ enabled, on the dedicated IRQ stack rather than the task stack; the
+	 * task SP is restored with the rest of its context.  Reading IRQNUM has
+	 * made the AIC hold off this priority level and lower until EOIS, so only
+	 * a higher level can interrupt the handler.  Such an IRQ enters
+	 * vPreemptiveTick() again and is sent to vPortNestedIrq(), which keeps LR
+	 * and SPSR of IRQ mode on the IRQ stack and runs the handler on top of
+	 * the interrupted one.  Context switches requested by nested handlers
+	 * happen when the outermost IRQ returns.
+	 */
+	void vPortDispatchIrqNested( UINT32 num ) __attribute__ ((naked));
+	void vPortNestedIrq( void ) __attribute__ ((naked));
+	void vPortTickFromNestedIrq( void );
+
+	void vPortDispatchIrqNested( UINT32 num )
+	{
+		asm volatile (
+			"STMFD	SP!, {R4, LR}				\n\t"	/* R0 holds the IRQ number.			*/
+			"LDR	R1, =ulPortIrqNesting		\n\t"
+			"MOV	R2, #1						\n\t"
+			"STR	R2, [R1]					\n\t"
+			"MRS	R4, CPSR					\n\t"	/* System mode, IRQ still masked,	*/
+			"ORR	R1, R4, #0x1F				\n\t"	/* on the dedicated stack.			*/
+			"MSR	CPSR_c, R1					\n\t"
+			"LDR	R1, =pxPortIrqStackTop		\n\t"
+			"LDR	SP, [R1]					\n\t"
+			"MOV	R1, #1						\n\t"	/* sysIrqDispatch(num, TRUE).		*/
+			"BL		sysIrqDispatch				\n\t"
+			"MSR	CPSR_c, R4					\n\t"	/* Back to IRQ mode.				*/
+			"LDR	R1, =ulPortIrqNesting		\n\t"
+			"MOV	R2, #0						\n\t"
+			"STR	R2, [R1]					\n\t"
+			"LDMFD	SP!, {R4, PC}				\n\t"
+			".ltorg								\n\t" );
+	}
+
+	void vPortNestedIrq( void )
+	{
+		asm volatile (
+			"SUB	LR, LR, #4					\n\t"
+			"STMFD	SP!, {R0-R3, R12, LR}		\n\t"	/* Keep the return state of IRQ mode.	*/
+			"MRS	R0, SPSR					\n\t"
+			"STMFD	SP!, {R0, R4}				\n\t"
+			"LDR	R0, =0xB0042120				\n\t"	/* REG_AIC_IRQNUM						*/
+			"LDR	R0, [R0]					\n\t"
+			"CMP	R0, #34						\n\t"	/* IRQ_TIMER5, run with IRQ masked.		*/
+			"BNE	1f							\n\t"
+			"BL		vPortTickFromNestedIrq		\n\t"
+			"B		2f							\n\t"
+			"1:									\n\t"
+			"LDR	R1, =ulPortIrqNesting		\n\t"
+			"LDR	R2, [R1]					\n\t"
+			"ADD	R2, R2, #1					\n\t"
+			"STR	R2, [R1]					\n\t"
+			"MRS	R4, CPSR					\n\t"	/* System mode, IRQ still masked, and	*/
+			"ORR	R1, R4, #0x1F				\n\t"	/* align the stack of the interrupted	*/
+			"MSR	CPSR_c, R1					\n\t"	/* handler.								*/
+			"MOV	R2, SP						\n\t"
+			"BIC	SP, SP, #7					\n\t"
+			"STMFD	SP!, {R2, LR}				\n\t"
+			"MOV	R1, #1						\n\t"
+			"BL		sysIrqDispatch				\n\t"
+			"LDMFD	SP!, {R2, LR}				\n\t"
+			"MOV	SP, R2						\n\t"
+			"MSR	CPSR_c, R4					\n\t"	/* Back to IRQ mode.					*/
+			"LDR	R1, =ulPortIrqNesting		\n\t"
+			"LDR	R2, [R1]					\n\t"
+			"SUB	R2, R2, #1					\n\t"
+			"STR	R2, [R1]					\n\t"
+			"2:									\n\t"
+			"LDR	R0, =0xB0042150				\n\t"	/* REG_AIC_EOIS							*/
+			"MOV	R1, #1						\n\t"
+			"STR	R1, [R0]					\n\t"
+			"LDMFD	SP!, {R0, R4}				\n\t"
+			"MSR	SPSR_cxsf, R0				\n\t"
+			"LDMFD	SP!, {R0-R3, R12, PC}^		\n\t"
+			".ltorg								\n\t" );
+	}
+
+	/* The tick taken while a nested handler runs.  IRQ is masked, as in the
+	tick path of vPreemptiveTick(), and the context switch waits for the
+	outermost IRQ to return. */
+	void vPortTickFromNestedIrq( void )
+	{
+		if( xTaskIncrementTick() != pdFALSE )
+		{
+			ulPortYieldRequired = pdTRUE;
+		}
+		outpw(REG_ETMR5_ISR, 0x1);
+	}
+
+#endif /* configNUC980_NESTED_IRQ */
+/*-----------------------------------------------------------*/
+
+/* Mask IRQ and restore the previous state.  With configNUC980_NESTED_IRQ
+handlers run with IRQ enabled, so the FreeRTOS API functions called from them
+use these around their critical sections; the run-time statistics clock in
+port.c uses them in any context. */
+UBaseType_t uxPortSetInterruptMask( void )
+{
+UBaseType_t uxSavedStatus;
+
+	asm volatile (
+		"MRS	%0, CPSR			\n\t"
+		"ORR	R1, %0, #0x80		\n\t"	/* Disable IRQ.	*/
+		"MSR	CPSR_c, R1			\n\t"
+		: "=r" ( uxSavedStatus ) : : "r1", "memory" );
+
+	return uxSavedStatus;
+}
+
+void vPortClearInterruptMask( UBaseType_t uxSavedStatus )
+{
+	if( ( uxSavedStatus & 0x80 ) == 0 )
+	{
+		asm volatile (
+			"MRS	R1, CPSR			\n\t"
+			"BIC	R1, R1, #0x80		\n\t"	/* Enable IRQ.	*/
+			"MSR	CPSR_c, R1			\n\t"
+			: : : "r1", "memory" );
+	}
+}
+/*-----------------------------------------------------------*/
+
 /*
  * The interrupt management utilities can only be called from ARM mode.  When
  * THUMB_INTERWORK is defined the utilities are defined as functions here to
@@ -232,7 +391,7 @@ extern void systemIrqHandler(UINT32 num);
 		asm volatile (
 			"STMDB	SP!, {R0}		\n\t"	/* Push R0.									*/
 			"MRS	R0, CPSR		\n\t"	/* Get CPSR.								*/
-			"ORR	R0, R0, #0xC0	\n\t"	/* Disable IRQ, FIQ.						*/
+			"ORR	R0, R0, #0x80	\n\t"	/* Disable IRQ.						*/
 			"MSR	CPSR, R0		\n\t"	/* Write back modified value.				*/
 			"LDMIA	SP!, {R0}		\n\t"	/* Pop R0.									*/
 			"BX		R14" );					/* Return back to thumb.					*/
@@ -243,7 +402,7 @@ extern void systemIrqHandler(UINT32 num);
 		asm volatile (
 			"STMDB	SP!, {R0}		\n\t"	/* Push R0.									*/
 			"MRS	R0, CPSR		\n\t"	/* Get CPSR.								*/
-			"BIC	R0, R0, #0xC0	\n\t"	/* Enable IRQ, FIQ.							*/
+			"BIC	R0, R0, #0x80	\n\t"	/* Enable IRQ.							*/
 			"MSR	CPSR, R0		\n\t"	/* Write back modified value.				*/
 			"LDMIA	SP!, {R0}		\n\t"	/* Pop R0.									*/
 			"BX		R14" );					/* Return back to thumb.					*/
@@ -261,7 +420,7 @@ void vPortEnterCritical( void )
 	asm volatile (
 		"STMDB	SP!, {R0}			\n\t"	/* Push R0.								*/
 		"MRS	R0, CPSR			\n\t"	/* Get CPSR.							*/
-		"ORR	R0, R0, #0xC0		\n\t"	/* Disable IRQ, FIQ.					*/
+		"ORR	R0, R0, #0x80		\n\t"	/* Disable IRQ.					*/
 		"MSR	CPSR, R0			\n\t"	/* Write back modified value.			*/
 		"LDMIA	SP!, {R0}" );				/* Pop R0.								*/
 
@@ -286,7 +445,7 @@ void vPortExitCritical( void )
 			asm volatile (
 				"STMDB	SP!, {R0}		\n\t"	/* Push R0.						*/
 				"MRS	R0, CPSR		\n\t"	/* Get CPSR.					*/
-				"BIC	R0, R0, #0xC0	\n\t"	/* Enable IRQ, FIQ.				*/
+				"BIC	R0, R0, #0x80	\n\t"	/* Enable IRQ.				*/
 				"MSR	CPSR, R0		\n\t"	/* Write back modified value.	*/
 				"LDMIA	SP!, {R0}" );			/* Pop R0.						*/
 		}
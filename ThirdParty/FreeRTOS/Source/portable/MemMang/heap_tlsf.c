@@ -0,0 +1,814 @@
+/*
+ * FreeRTOS Kernel V10.0.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software. If you wish to use our Amazon
+ * FreeRTOS name, please do so in a fair use way that does not cause confusion.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() based on the Two-Level
+ * Segregated Fit allocator, where allocating and freeing take the same time
+ * whatever the state of the heap.  Free blocks are kept in lists by size
+ * class, a first level for each power of two and heapSL_COUNT linear
+ * subdivisions of it, and two bitmaps find the smallest non-empty class that
+ * fits with a count leading zeros instead of walking a list as heap_2 and
+ * heap_4 do.  Adjacent free blocks are merged as they are freed.
+ *
+ * Every block starts with a header that fills whole cache lines, and every
+ * size is rounded up to configHEAP_TLSF_ALIGNMENT, so the memory returned is
+ * cache line aligned and never shares a line with a header or another
+ * allocation; it can be given to a DMA engine after the usual cache
+ * maintenance.
+ *
+ * The heap is made of one or more pools, each with its own free lists.
+ * pvPortMalloc() uses pool 0, pvPortMallocFromPool() another one, so for
+ * example internal SRAM can be kept for the buffers that need it while DDR
+ * holds everything else.  Memory is added to a pool with vPortAddHeapRegion()
+ * or, for pool 0, vPortDefineHeapRegions(), on top of the configTOTAL_HEAP_SIZE
+ * bytes of ucHeap[] unless configHEAP_TLSF_STATIC_HEAP is 0.
+ *
+ * pvPortRealloc() grows a block into the free block after it, or shrinks it
+ * in place, and only moves it when neither is possible.
+ *
+ * Each allocation is charged to the task that made it, in a table of
+ * configHEAP_TLSF_TASK_SLOTS entries read with uxPortGetHeapTaskStats(), and
+ * vPortGetHeapStats() reports the free space, the number of free blocks and
+ * the largest one, which together show how fragmented the heap is.  The slot
+ * of a task is only given to another one once the task has been deleted and
+ * its memory freed, which heap_tlsf.c learns from vPortHeapTaskDeleted():
+ * define portCLEAN_UP_TCB( pxTCB ) as vPortHeapTaskDeleted( pxTCB ) in
+ * FreeRTOSConfig.h.  Without it slots are never reused, and once the table is
+ * full the memory of new tasks is charged to slot 0.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ */
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+#if( ( INCLUDE_xTaskGetCurrentTaskHandle != 1 ) || ( INCLUDE_xTaskGetSchedulerState != 1 ) )
+	#error heap_tlsf.c needs INCLUDE_xTaskGetCurrentTaskHandle and INCLUDE_xTaskGetSchedulerState
+#endif
+
+/* Log2 of the alignment of the returned memory, 5 for the 32-byte cache lines
+of the ARM926EJ-S. */
+#ifndef configHEAP_TLSF_ALIGNMENT_LOG2
+	#define configHEAP_TLSF_ALIGNMENT_LOG2	5
+#endif
+
+/* Allocations are smaller than 2 ^ configHEAP_TLSF_FL_INDEX_MAX bytes.  Free
+blocks larger than that, such as a whole region, all go in the last list.  Each
+unit costs heapSL_COUNT list heads per pool. */
+#ifndef configHEAP_TLSF_FL_INDEX_MAX
+	#define configHEAP_TLSF_FL_INDEX_MAX	26
+#endif
+
+#ifndef configHEAP_TLSF_POOLS
+	#define configHEAP_TLSF_POOLS			1
+#endif
+
+/* Tasks whose allocations are counted apart, slot 0 holds the rest. */
+#ifndef configHEAP_TLSF_TASK_SLOTS
+	#define configHEAP_TLSF_TASK_SLOTS		16
+#endif
+
+#ifndef configHEAP_TLSF_STATIC_HEAP
+	#define configHEAP_TLSF_STATIC_HEAP		1
+#endif
+
+#define heapALIGNMENT			( ( size_t ) 1 << configHEAP_TLSF_ALIGNMENT_LOG2 )
+#define heapALIGNMENT_MASK		( heapALIGNMENT - 1 )
+
+/* Second level subdivisions of each power of two. */
+#define heapSL_LOG2				4
+#define heapSL_COUNT			( 1 << heapSL_LOG2 )
+
+/* Sizes below heapSMALL_BLOCK_SIZE all go in first level 0, in classes of
+heapALIGNMENT bytes. */
+#define heapFL_SHIFT			( heapSL_LOG2 + configHEAP_TLSF_ALIGNMENT_LOG2 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_SHIFT )
+#define heapFL_COUNT			( configHEAP_TLSF_FL_INDEX_MAX - heapFL_SHIFT + 1 )
+#define heapLARGE_BLOCK_SIZE	( ( size_t ) 1 << configHEAP_TLSF_FL_INDEX_MAX )
+#define heapMAX_ALLOC_SIZE		( heapLARGE_BLOCK_SIZE - heapALIGNMENT )
+
+/* Set in xSize while the block is free.  Sizes are multiples of
+heapALIGNMENT, so the low bits are not used. */
+#define heapBLOCK_FREE			( ( size_t ) 1 )
+#define heapSIZE_MASK			( ~heapALIGNMENT_MASK )
+
+#if( heapFL_COUNT > 32 ) || ( heapFL_COUNT < 2 )
+	#error configHEAP_TLSF_FL_INDEX_MAX out of range
+#endif
+
+#if( configHEAP_TLSF_POOLS > 255 ) || ( configHEAP_TLSF_TASK_SLOTS > 255 )
+	#error configHEAP_TLSF_POOLS and configHEAP_TLSF_TASK_SLOTS must fit in a byte
+#endif
+
+/* Index of the most significant bit set, x must not be 0.  The ARM926EJ-S
+has CLZ. */
+#if defined( __GNUC__ ) && !defined( __CC_ARM )
+	#define heapFLS( x )		( 31 - __builtin_clz( x ) )
+#else
+	#define heapFLS( x )		( 31 - __clz( x ) )
+#endif
+#define heapFFS( x )			heapFLS( ( x ) & ( 0U - ( x ) ) )
+
+/* Allocate the memory for the heap. */
+#if( configHEAP_TLSF_STATIC_HEAP == 1 )
+	#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+		/* The application writer has already defined the array used for the RTOS
+		heap - probably so it can be placed in a special segment or address. */
+		extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+	#else
+		static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+	#endif /* configAPPLICATION_ALLOCATED_HEAP */
+#endif /* configHEAP_TLSF_STATIC_HEAP */
+
+/* Header at the start of every block, free or not.  The list links are only
+used while the block is free.  A region ends with a header of size 0 that is
+never free, so the block after any real block can always be looked at. */
+typedef struct TLSF_BLOCK
+{
+	size_t xSize;							/*<< Bytes after the header, with heapBLOCK_FREE. */
+	struct TLSF_BLOCK *pxPrevPhys;			/*<< The block just below in memory, NULL for the first of a region. */
+	struct TLSF_BLOCK *pxNextFree;
+	struct TLSF_BLOCK *pxPrevFree;
+	uint8_t ucPool;
+	uint8_t ucOwner;						/*<< Slot of xTaskStats charged with the block. */
+} TlsfBlock_t;
+
+/* The header takes whole cache lines, so the memory after it is aligned. */
+#define heapHEADER_SIZE			( ( sizeof( TlsfBlock_t ) + heapALIGNMENT_MASK ) & heapSIZE_MASK )
+
+typedef struct TLSF_POOL
+{
+	uint32_t ulFlBitmap;					/*<< Bit n set when some list of first level n is not empty. */
+	uint32_t ulSlBitmap[ heapFL_COUNT ];	/*<< Bit n set when list n of that first level is not empty. */
+	TlsfBlock_t *pxFree[ heapFL_COUNT ][ heapSL_COUNT ];
+	size_t xFreeBytes;
+} TlsfPool_t;
+
+/*-----------------------------------------------------------*/
+
+static TlsfPool_t xPools[ configHEAP_TLSF_POOLS ];
+static HeapTaskStats_t xTaskStats[ configHEAP_TLSF_TASK_SLOTS ];
+static uint8_t ucSlotTaskDeleted[ configHEAP_TLSF_TASK_SLOTS ];
+static BaseType_t xHeapInitialised = pdFALSE;
+
+/* Keeps track of the number of free bytes remaining, in all the pools. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xNumberOfSuccessfulAllocations = 0U;
+static size_t xNumberOfSuccessfulFrees = 0U;
+
+/*-----------------------------------------------------------*/
+
+/* First and second level lists for a free block of xSize bytes. */
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+UBaseType_t uxFl;
+
+	if( xSize >= heapLARGE_BLOCK_SIZE )
+	{
+		*puxFl = heapFL_COUNT - 1;
+		*puxSl = heapSL_COUNT - 1;
+	}
+	else if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		*puxFl = 0;
+		*puxSl = ( UBaseType_t ) ( xSize >> configHEAP_TLSF_ALIGNMENT_LOG2 );
+	}
+	else
+	{
+		uxFl = ( UBaseType_t ) heapFLS( xSize );
+		*puxSl = ( UBaseType_t ) ( xSize >> ( uxFl - heapSL_LOG2 ) ) ^ ( 1U << heapSL_LOG2 );
+		*puxFl = uxFl - ( heapFL_SHIFT - 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* First and second level of the smallest lists where every block holds
+xSize bytes, so the head of any of them will do.  pdFALSE if that is past the
+last list. */
+static BaseType_t prvMappingSearch( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+	if( xSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSize += ( ( size_t ) 1 << ( heapFLS( xSize ) - heapSL_LOG2 ) ) - 1;
+	}
+	if( xSize >= heapLARGE_BLOCK_SIZE )
+	{
+		return pdFALSE;
+	}
+	prvMappingInsert( xSize, puxFl, puxSl );
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static TlsfBlock_t *prvNextPhys( TlsfBlock_t *pxBlock )
+{
+	return ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE + ( pxBlock->xSize & heapSIZE_MASK ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfPool_t *pxPool, TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+TlsfBlock_t *pxHead;
+
+	prvMappingInsert( pxBlock->xSize & heapSIZE_MASK, &uxFl, &uxSl );
+
+	pxHead = pxPool->pxFree[ uxFl ][ uxSl ];
+	pxBlock->xSize |= heapBLOCK_FREE;
+	pxBlock->pxPrevFree = NULL;
+	pxBlock->pxNextFree = pxHead;
+	if( pxHead != NULL )
+	{
+		pxHead->pxPrevFree = pxBlock;
+	}
+	pxPool->pxFree[ uxFl ][ uxSl ] = pxBlock;
+	pxPool->ulFlBitmap |= 1UL << uxFl;
+	pxPool->ulSlBitmap[ uxFl ] |= 1UL << uxSl;
+
+	pxPool->xFreeBytes += pxBlock->xSize & heapSIZE_MASK;
+	xFreeBytesRemaining += pxBlock->xSize & heapSIZE_MASK;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfPool_t *pxPool, TlsfBlock_t *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+
+	prvMappingInsert( pxBlock->xSize & heapSIZE_MASK, &uxFl, &uxSl );
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+	}
+	if( pxBlock->pxPrevFree != NULL )
+	{
+		pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+	}
+	else
+	{
+		pxPool->pxFree[ uxFl ][ uxSl ] = pxBlock->pxNextFree;
+		if( pxBlock->pxNextFree == NULL )
+		{
+			pxPool->ulSlBitmap[ uxFl ] &= ~( 1UL << uxSl );
+			if( pxPool->ulSlBitmap[ uxFl ] == 0 )
+			{
+				pxPool->ulFlBitmap &= ~( 1UL << uxFl );
+			}
+		}
+	}
+	pxBlock->xSize &= ~heapBLOCK_FREE;
+
+	pxPool->xFreeBytes -= pxBlock->xSize;
+	xFreeBytesRemaining -= pxBlock->xSize;
+}
+/*-----------------------------------------------------------*/
+
+/* Head of the first non-empty list at or above the given one. */
+static TlsfBlock_t *prvFindSuitableBlock( TlsfPool_t *pxPool, UBaseType_t uxFl, UBaseType_t uxSl )
+{
+uint32_t ulMap;
+
+	ulMap = pxPool->ulSlBitmap[ uxFl ] & ( ~0UL << uxSl );
+	if( ulMap == 0 )
+	{
+		/* Nothing big enough at this first level, take the smallest list of
+		the next non-empty one. */
+		ulMap = ( uxFl + 1 < heapFL_COUNT ) ? ( pxPool->ulFlBitmap & ( ~0UL << ( uxFl + 1 ) ) ) : 0;
+		if( ulMap == 0 )
+		{
+			return NULL;
+		}
+		uxFl = ( UBaseType_t ) heapFFS( ulMap );
+		ulMap = pxPool->ulSlBitmap[ uxFl ];
+	}
+	uxSl = ( UBaseType_t ) heapFFS( ulMap );
+
+	return pxPool->pxFree[ uxFl ][ uxSl ];
+}
+/*-----------------------------------------------------------*/
+
+/* Add a region to a pool as one free block closed by a header of size 0. */
+static void prvAddRegion( UBaseType_t uxPool, uint8_t *pucStart, size_t xSize )
+{
+size_t xAddress, xEnd;
+TlsfBlock_t *pxBlock, *pxEndMarker;
+
+	xAddress = ( ( size_t ) pucStart + heapALIGNMENT_MASK ) & heapSIZE_MASK;
+	xEnd = ( ( size_t ) pucStart + xSize ) & heapSIZE_MASK;
+	if( ( xEnd <= xAddress ) || ( ( xEnd - xAddress ) < ( 2 * heapHEADER_SIZE + heapALIGNMENT ) ) )
+	{
+		return;
+	}
+
+	pxBlock = ( TlsfBlock_t * ) xAddress;
+	pxBlock->xSize = xEnd - xAddress - 2 * heapHEADER_SIZE;
+	pxBlock->pxPrevPhys = NULL;
+	pxBlock->ucPool = ( uint8_t ) uxPool;
+	pxBlock->ucOwner = 0;
+
+	pxEndMarker = prvNextPhys( pxBlock );
+	pxEndMarker->xSize = 0;
+	pxEndMarker->pxPrevPhys = pxBlock;
+	pxEndMarker->ucPool = ( uint8_t ) uxPool;
+	pxEndMarker->ucOwner = 0;
+
+	prvInsertFreeBlock( &xPools[ uxPool ], pxBlock );
+
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+	xHeapInitialised = pdTRUE;
+
+	#if( configHEAP_TLSF_STATIC_HEAP == 1 )
+	{
+		prvAddRegion( 0, ucHeap, configTOTAL_HEAP_SIZE );
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+/* Slot of xTaskStats for the calling task, 0 before the scheduler starts or
+when the table is full.  A slot is only reused once its task has been deleted,
+see vPortHeapTaskDeleted(), and all it held freed. */
+static uint8_t prvOwnerSlot( void )
+{
+void *pvTask;
+UBaseType_t ux, uxFree = 0;
+
+	if( xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED )
+	{
+		return 0;
+	}
+	pvTask = ( void * ) xTaskGetCurrentTaskHandle();
+
+	for( ux = 1; ux < configHEAP_TLSF_TASK_SLOTS; ux++ )
+	{
+		if( ucSlotTaskDeleted[ ux ] == 0 )
+		{
+			if( xTaskStats[ ux ].pvTask == pvTask )
+			{
+				return ( uint8_t ) ux;
+			}
+			if( ( uxFree == 0 ) && ( xTaskStats[ ux ].pvTask == NULL ) )
+			{
+				uxFree = ux;
+			}
+		}
+		else if( ( uxFree == 0 ) && ( xTaskStats[ ux ].xBytesInUse == 0 ) )
+		{
+			uxFree = ux;
+		}
+	}
+
+	if( uxFree != 0 )
+	{
+		memset( &xTaskStats[ uxFree ], 0, sizeof( HeapTaskStats_t ) );
+		xTaskStats[ uxFree ].pvTask = pvTask;
+		ucSlotTaskDeleted[ uxFree ] = 0;
+	}
+	return ( uint8_t ) uxFree;
+}
+/*-----------------------------------------------------------*/
+
+/* Cut an allocated block down to xSize bytes and give back the rest, merged
+with the block after it if that one is free.  The rest is kept in the block
+when it cannot hold a block of its own. */
+static void prvTrimBlock( TlsfPool_t *pxPool, TlsfBlock_t *pxBlock, size_t xSize )
+{
+TlsfBlock_t *pxRemainder, *pxNext;
+
+	if( pxBlock->xSize >= xSize + heapHEADER_SIZE + heapALIGNMENT )
+	{
+		pxNext = prvNextPhys( pxBlock );
+		pxRemainder = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE + xSize );
+		pxRemainder->xSize = pxBlock->xSize - xSize - heapHEADER_SIZE;
+		pxRemainder->pxPrevPhys = pxBlock;
+		pxRemainder->ucPool = pxBlock->ucPool;
+		pxRemainder->ucOwner = 0;
+		pxBlock->xSize = xSize;
+
+		if( ( pxNext->xSize & heapBLOCK_FREE ) != 0 )
+		{
+			prvRemoveFreeBlock( pxPool, pxNext );
+			pxRemainder->xSize += heapHEADER_SIZE + pxNext->xSize;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+		prvNextPhys( pxRemainder )->pxPrevPhys = pxRemainder;
+		prvInsertFreeBlock( pxPool, pxRemainder );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMallocFromPool( UBaseType_t uxPool, size_t xWantedSize )
+{
+TlsfPool_t *pxPool;
+TlsfBlock_t *pxBlock = NULL;
+UBaseType_t uxFl, uxSl;
+HeapTaskStats_t *pxStats;
+void *pvReturn = NULL;
+
+	configASSERT( uxPool < configHEAP_TLSF_POOLS );
+	pxPool = &xPools[ uxPool ];
+
+	vTaskSuspendAll();
+	{
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+
+		if( ( xWantedSize > 0 ) && ( xWantedSize <= heapMAX_ALLOC_SIZE ) )
+		{
+			xWantedSize = ( xWantedSize + heapALIGNMENT_MASK ) & heapSIZE_MASK;
+			if( prvMappingSearch( xWantedSize, &uxFl, &uxSl ) != pdFALSE )
+			{
+				pxBlock = prvFindSuitableBlock( pxPool, uxFl, uxSl );
+			}
+			else
+			{
+				/* Only the last list can hold a block this big, try its head. */
+				pxBlock = pxPool->pxFree[ heapFL_COUNT - 1 ][ heapSL_COUNT - 1 ];
+				if( ( pxBlock != NULL ) && ( ( pxBlock->xSize & heapSIZE_MASK ) < xWantedSize ) )
+				{
+					pxBlock = NULL;
+				}
+			}
+
+			if( pxBlock != NULL )
+			{
+				/* Give back what is left if it can hold a block of its own. */
+				prvRemoveFreeBlock( pxPool, pxBlock );
+				prvTrimBlock( pxPool, pxBlock, xWantedSize );
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+				xNumberOfSuccessfulAllocations++;
+
+				pxBlock->ucOwner = prvOwnerSlot();
+				pxStats = &xTaskStats[ pxBlock->ucOwner ];
+				pxStats->xBytesInUse += pxBlock->xSize;
+				if( pxStats->xBytesInUse > pxStats->xPeakBytesInUse )
+				{
+					pxStats->xPeakBytesInUse = pxStats->xBytesInUse;
+				}
+				pxStats->xAllocations++;
+
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & heapALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+	return pvPortMallocFromPool( 0, xWantedSize );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+TlsfBlock_t *pxBlock, *pxNeighbour;
+TlsfPool_t *pxPool;
+HeapTaskStats_t *pxStats;
+
+	if( pv == NULL )
+	{
+		return;
+	}
+
+	pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - heapHEADER_SIZE );
+	configASSERT( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+	configASSERT( pxBlock->ucPool < configHEAP_TLSF_POOLS );
+	configASSERT( pxBlock->ucOwner < configHEAP_TLSF_TASK_SLOTS );
+	pxPool = &xPools[ pxBlock->ucPool ];
+
+	vTaskSuspendAll();
+	{
+		traceFREE( pv, pxBlock->xSize );
+
+		pxStats = &xTaskStats[ pxBlock->ucOwner ];
+		pxStats->xBytesInUse -= pxBlock->xSize;
+		pxStats->xFrees++;
+		xNumberOfSuccessfulFrees++;
+
+		/* Merge with the free neighbours, so a heap with nothing allocated is
+		back to one free block per region. */
+		pxNeighbour = prvNextPhys( pxBlock );
+		if( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 )
+		{
+			prvRemoveFreeBlock( pxPool, pxNeighbour );
+			pxBlock->xSize += heapHEADER_SIZE + pxNeighbour->xSize;
+			prvNextPhys( pxBlock )->pxPrevPhys = pxBlock;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		pxNeighbour = pxBlock->pxPrevPhys;
+		if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 ) )
+		{
+			prvRemoveFreeBlock( pxPool, pxNeighbour );
+			pxNeighbour->xSize += heapHEADER_SIZE + pxBlock->xSize;
+			pxBlock = pxNeighbour;
+			prvNextPhys( pxBlock )->pxPrevPhys = pxBlock;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		pxBlock->ucOwner = 0;
+		prvInsertFreeBlock( pxPool, pxBlock );
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortRealloc( void *pv, size_t xWantedSize )
+{
+TlsfBlock_t *pxBlock, *pxNext;
+TlsfPool_t *pxPool;
+HeapTaskStats_t *pxStats;
+size_t xOldSize;
+void *pvReturn = NULL;
+
+	if( pv == NULL )
+	{
+		return pvPortMalloc( xWantedSize );
+	}
+	if( xWantedSize == 0 )
+	{
+		vPortFree( pv );
+		return NULL;
+	}
+	if( xWantedSize > heapMAX_ALLOC_SIZE )
+	{
+		return NULL;
+	}
+
+	pxBlock = ( TlsfBlock_t * ) ( ( ( uint8_t * ) pv ) - heapHEADER_SIZE );
+	configASSERT( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+	configASSERT( pxBlock->ucPool < configHEAP_TLSF_POOLS );
+	configASSERT( pxBlock->ucOwner < configHEAP_TLSF_TASK_SLOTS );
+	pxPool = &xPools[ pxBlock->ucPool ];
+	xWantedSize = ( xWantedSize + heapALIGNMENT_MASK ) & heapSIZE_MASK;
+
+	vTaskSuspendAll();
+	{
+		xOldSize = pxBlock->xSize;
+
+		/* Grow into the block after it when that one is free and big enough. */
+		pxNext = prvNextPhys( pxBlock );
+		if( ( xWantedSize > xOldSize ) && ( ( pxNext->xSize & heapBLOCK_FREE ) != 0 ) &&
+			( xOldSize + heapHEADER_SIZE + ( pxNext->xSize & heapSIZE_MASK ) >= xWantedSize ) )
+		{
+			prvRemoveFreeBlock( pxPool, pxNext );
+			pxBlock->xSize += heapHEADER_SIZE + pxNext->xSize;
+			prvNextPhys( pxBlock )->pxPrevPhys = pxBlock;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		if( pxBlock->xSize >= xWantedSize )
+		{
+			prvTrimBlock( pxPool, pxBlock, xWantedSize );
+			if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+			{
+				xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+			}
+
+			pxStats = &xTaskStats[ pxBlock->ucOwner ];
+			pxStats->xBytesInUse = pxStats->xBytesInUse - xOldSize + pxBlock->xSize;
+			if( pxStats->xBytesInUse > pxStats->xPeakBytesInUse )
+			{
+				pxStats->xPeakBytesInUse = pxStats->xBytesInUse;
+			}
+			pvReturn = pv;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	/* Otherwise move it, within the same pool. */
+	if( pvReturn == NULL )
+	{
+		pvReturn = pvPortMallocFromPool( pxBlock->ucPool, xWantedSize );
+		if( pvReturn != NULL )
+		{
+			memcpy( pvReturn, pv, xOldSize );
+			vPortFree( pv );
+		}
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortHeapTaskDeleted( void *pvTask )
+{
+UBaseType_t ux;
+
+	vTaskSuspendAll();
+	{
+		for( ux = 1; ux < configHEAP_TLSF_TASK_SLOTS; ux++ )
+		{
+			if( ( xTaskStats[ ux ].pvTask == pvTask ) && ( ucSlotTaskDeleted[ ux ] == 0 ) )
+			{
+				ucSlotTaskDeleted[ ux ] = 1;
+				break;
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortAddHeapRegion( UBaseType_t uxPool, uint8_t *pucStart, size_t xSize )
+{
+	configASSERT( uxPool < configHEAP_TLSF_POOLS );
+
+	vTaskSuspendAll();
+	{
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+		prvAddRegion( uxPool, pucStart, xSize );
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+const HeapRegion_t *pxRegion;
+
+	for( pxRegion = pxHeapRegions; pxRegion->xSizeInBytes > 0; pxRegion++ )
+	{
+		vPortAddHeapRegion( 0, pxRegion->pucStartAddress, pxRegion->xSizeInBytes );
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+TlsfBlock_t *pxBlock;
+UBaseType_t uxPool, uxFl, uxSl;
+size_t xSize, xLargest = 0, xSmallest = ~( ( size_t ) 0 ), xBlocks = 0;
+
+	/* Walks every free block, for reports rather than time critical code. */
+	vTaskSuspendAll();
+	{
+		for( uxPool = 0; uxPool < configHEAP_TLSF_POOLS; uxPool++ )
+		{
+			for( uxFl = 0; uxFl < heapFL_COUNT; uxFl++ )
+			{
+				for( uxSl = 0; uxSl < heapSL_COUNT; uxSl++ )
+				{
+					for( pxBlock = xPools[ uxPool ].pxFree[ uxFl ][ uxSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+					{
+						xSize = pxBlock->xSize & heapSIZE_MASK;
+						xLargest = ( xSize > xLargest ) ? xSize : xLargest;
+						xSmallest = ( xSize < xSmallest ) ? xSize : xSmallest;
+						xBlocks++;
+					}
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xLargest;
+		pxHeapStats->xSizeOfSmallestFreeBlockInBytes = ( xBlocks != 0 ) ? xSmallest : 0;
+		pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortGetHeapTaskStats( HeapTaskStats_t *pxTaskStats, UBaseType_t uxMaxStats )
+{
+UBaseType_t ux, uxCount = 0;
+
+	vTaskSuspendAll();
+	{
+		for( ux = 0; ( ux < configHEAP_TLSF_TASK_SLOTS ) && ( uxCount < uxMaxStats ); ux++ )
+		{
+			/* Slot 0 is always reported, the others once used. */
+			if( ( ux == 0 ) || ( xTaskStats[ ux ].pvTask != NULL ) )
+			{
+				pxTaskStats[ uxCount++ ] = xTaskStats[ ux ];
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	return uxCount;
+}
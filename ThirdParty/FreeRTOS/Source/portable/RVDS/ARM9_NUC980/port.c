@@ -29,6 +29,7 @@
 
 /* Standard includes. */
 #include <stdlib.h>
+#include <string.h>
 
 /* Scheduler includes. */
 #include "FreeRTOS.h"
@@ -38,6 +39,21 @@
 #include "nuc980.h"
 #include "sys.h"
 
+/* ETIMER5 runs from the 12 MHz crystal.  In power-down that clock stops, so
+the tickless idle power-down mode moves ETIMER5 to the 32.768 kHz LXT, which
+keeps running and can wake the CPU.  Pick a configTICK_RATE_HZ that divides
+32768 (1024, 512, ...) in that case or the tick period will be rounded. */
+#if ( configUSE_TICKLESS_IDLE == 1 ) && ( configNUC980_TICKLESS_POWER_DOWN == 1 )
+	#define portTIMER_CLOCK_HZ			( 32768UL )
+	#define portTIMER_CTL				( 0x15UL )	/* Enable, periodic, wake-up. */
+#else
+	#define portTIMER_CLOCK_HZ			( 12000000UL )
+	#define portTIMER_CTL				( 0x11UL )	/* Enable, periodic. */
+#endif
+
+/* ETIMER counters are 24 bits wide. */
+#define portMAX_24_BIT_NUMBER		( 0xffffffUL )
+
 /* Constants required to setup the initial task context. */
 #define portINITIAL_SPSR				( ( StackType_t ) 0x1f ) /* System mode, ARM mode, interrupts enabled. */
 #define portTHUMB_MODE_BIT				( ( StackType_t ) 0x20 )
@@ -55,11 +71,54 @@ as part of the task context and must be initialised to a non zero value. */
 #define portNO_CRITICAL_NESTING		( ( uint32_t ) 0 )
 volatile uint32_t ulCriticalNesting = 9999UL;
 
+/* Set by portYIELD_FROM_ISR() in any interrupt handler.  vPreemptiveTick()
+switches tasks once the handler has returned. */
+volatile uint32_t ulPortYieldRequired = pdFALSE;
+
+/* Depth of interrupt handlers running with IRQ enabled, see
+vPortDispatchIrqNested() in portASM.s.  Stays 0 unless configNUC980_NESTED_IRQ
+is set. */
+volatile uint32_t ulPortIrqNesting = 0;
+
+/* With configNUC980_NESTED_IRQ the handlers run in system mode, whose stack
+is the stack of the interrupted task.  They are moved to this stack instead,
+so task stacks need no room for interrupt handlers. */
+#if configNUC980_NESTED_IRQ == 1
+	static uint64_t ullIrqStack[ configNUC980_IRQ_STACK_SIZE / 2 ];
+	StackType_t * const pxPortIrqStackTop = ( StackType_t * ) &ullIrqStack[ configNUC980_IRQ_STACK_SIZE / 2 ];
+
+	/* Filled by xPortStartScheduler(), as the task stacks are filled. */
+	#define portIRQ_STACK_FILL	( 0xa5a5a5a5a5a5a5a5ULL )
+
+	#if configCHECK_FOR_STACK_OVERFLOW > 1
+		extern void vApplicationStackOverflowHook( TaskHandle_t xTask, char *pcTaskName );
+	#endif
+#else
+	StackType_t * const pxPortIrqStackTop = NULL;
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Setup the timer to generate the tick interrupts. */
 static void prvSetupTimerInterrupt( void );
 
+#if configUSE_TICKLESS_IDLE == 1
+
+	/* Counts of ETIMER5 that make up one tick period, and the most ticks a
+	single sleep can cover before the 24-bit compare value overflows. */
+	static uint32_t ulTimerCountsForOneTick = 0;
+	static TickType_t xMaximumPossibleSuppressedTicks = 0;
+
+	/* Counts that have elapsed since the last tick the kernel was told
+	about, in addition to the ETIMER5 counter.  A sleep rarely ends on a
+	tick boundary, and ETIMER5 is restarted from zero on wake-up, so the
+	part of a tick left over is carried here into the next sleep instead of
+	being lost.  Without it the tick count would drift behind real time by
+	up to a tick on every sleep. */
+	static uint32_t ulTickFraction = 0;
+
+#endif /* configUSE_TICKLESS_IDLE */
+
 /* 
  * The scheduler can only be started from ARM mode, so 
  * vPortStartFirstSTask() is defined in portISR.c. 
@@ -148,6 +207,13 @@ StackType_t *pxOriginalTOS;
 
 BaseType_t xPortStartScheduler( void )
 {
+	#if configNUC980_NESTED_IRQ == 1
+	{
+		/* For uxPortGetIrqStackHighWaterMark() and the overflow check. */
+		memset( ullIrqStack, 0xa5, sizeof( ullIrqStack ) );
+	}
+	#endif
+
 	/* Start the timer that generates the tick ISR. */
 	prvSetupTimerInterrupt();
 
@@ -168,13 +234,72 @@ void vPortEndScheduler( void )
 }
 /*-----------------------------------------------------------*/
 
+extern void vPortDispatchIrqNested( UINT32 irq );
+
 void systemIrqHandler(UINT32 irq)
 {
-
-	if (irq != 0)
-		(*sysIrqHandlerTable[irq])();
+#if configNUC980_NESTED_IRQ == 1
+	vPortDispatchIrqNested(irq);
+#else
+	sysIrqDispatch(irq, FALSE);
+#endif
 
 	outpw(REG_AIC_EOIS, 1);
+
+#if ( configNUC980_NESTED_IRQ == 1 ) && ( configCHECK_FOR_STACK_OVERFLOW > 1 )
+	/* The task stacks are checked on each switch; check the lowest words of
+	the interrupt stack when each interrupt is done. */
+	if( ( ullIrqStack[ 0 ] != portIRQ_STACK_FILL ) || ( ullIrqStack[ 1 ] != portIRQ_STACK_FILL ) )
+	{
+		vApplicationStackOverflowHook( NULL, "IRQ" );
+	}
+#endif
+}
+
+#if configNUC980_NESTED_IRQ == 1
+/* Smallest number of words that remained unused on the interrupt stack since
+the scheduler started. */
+UBaseType_t uxPortGetIrqStackHighWaterMark( void )
+{
+const uint32_t *pulWord = ( const uint32_t * ) ullIrqStack;
+UBaseType_t uxFree = 0;
+
+	while( ( uxFree < configNUC980_IRQ_STACK_SIZE ) && ( pulWord[ uxFree ] == 0xa5a5a5a5UL ) )
+	{
+		uxFree++;
+	}
+
+	return uxFree;
+}
+#endif
+
+/* The tick taken while a nested handler runs.  IRQ is masked, as in the tick
+path of vPreemptiveTick(), and the context switch waits for the outermost
+IRQ to return. */
+void vPortTickFromNestedIrq( void )
+{
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		ulPortYieldRequired = pdTRUE;
+	}
+	outpw(REG_ETMR5_ISR, 1);
+}
+
+/* Mask IRQ and restore the previous state.  With configNUC980_NESTED_IRQ
+handlers run with IRQ enabled, so the FreeRTOS API functions called from them
+use these around their critical sections; the run-time statistics clock uses
+them in any context. */
+UBaseType_t uxPortSetInterruptMask( void )
+{
+	return ( UBaseType_t ) __disable_irq();
+}
+
+void vPortClearInterruptMask( UBaseType_t uxSavedStatus )
+{
+	if( uxSavedStatus == 0 )
+	{
+		__enable_irq();
+	}
 }
 
 
@@ -226,7 +351,7 @@ uint32_t ulCompareMatch;
 	// enable timer5 clock
 	outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 13));
 	/* Calculate the match value required for our wanted tick rate. */
-	ulCompareMatch = 12000000 / configTICK_RATE_HZ;
+	ulCompareMatch = portTIMER_CLOCK_HZ / configTICK_RATE_HZ;
 
 	/* Protect against divide by zero.  Using an if() statement still results
 	in a warning - hence the #if. */
@@ -249,14 +374,150 @@ uint32_t ulCompareMatch;
 	#endif
 	_sys_bIsAICInitial = TRUE;
 
+	#if configUSE_TICKLESS_IDLE == 1
+	{
+		ulTimerCountsForOneTick = ulCompareMatch;
+		xMaximumPossibleSuppressedTicks = portMAX_24_BIT_NUMBER / ulTimerCountsForOneTick;
+
+		#if configNUC980_TICKLESS_POWER_DOWN == 1
+		{
+			/* ETIMER5 clock source is bits 27:26 of CLK_DIVCTL8, 3 is LXT. */
+			outpw(REG_CLK_DIVCTL8, inpw(REG_CLK_DIVCTL8) | (0x3 << 26));
+		}
+		#endif
+	}
+	#endif
+
 	// set up timer and enable timer 5 interrupt
 	outpw(REG_ETMR5_CMPR, ulCompareMatch);
-	outpw(REG_ETMR5_CTL, 0x11);
+	outpw(REG_ETMR5_CTL, portTIMER_CTL);
 	outpw(REG_ETMR5_IER, 0x1);
 	sysEnableInterrupt(IRQ_TIMER5);
 }
 /*-----------------------------------------------------------*/
 
+#if configUSE_TICKLESS_IDLE == 1
+
+	static __asm void prvWaitForInterrupt( void )
+	{
+		/* Wait for interrupt, CP15 c7 c0 4.  The core wakes up on an IRQ
+		even when the I bit in CPSR masks it. */
+		MOV	R0, #0
+		MCR	p15, 0, R0, c7, c0, 4
+		BX	LR
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+	{
+	uint32_t ulElapsedBefore, ulReloadValue, ulElapsed, ulPMCON;
+	TickType_t xModifiableIdleTime, xCompleteTickPeriods, xStepTicks;
+
+		/* Make sure the ETIMER5 compare value does not overflow. */
+		if( xExpectedIdleTime > xMaximumPossibleSuppressedTicks )
+		{
+			xExpectedIdleTime = xMaximumPossibleSuppressedTicks;
+		}
+
+		/* Interrupts stay masked from here until the tick count has been
+		corrected.  An IRQ that arrives still ends the sleep, as WFI does not
+		look at the CPSR mask, and is serviced once interrupts are
+		re-enabled at the end of this function. */
+		portDISABLE_INTERRUPTS();
+
+		/* Counts already elapsed towards the next tick. */
+		ulElapsedBefore = ulTickFraction + inpw(REG_ETMR5_DR);
+		ulReloadValue = ( ulTimerCountsForOneTick * xExpectedIdleTime );
+
+		/* A tick interrupt is already pending, a context switch is pending
+		or a task was readied while the scheduler was suspended, or the next
+		tick is too close to be worth it: abandon the sleep and let the tick
+		interrupt run as normal. */
+		if( ( ( inpw(REG_ETMR5_ISR) & 0x1 ) != 0 ) ||
+			( eTaskConfirmSleepModeStatus() == eAbortSleep ) ||
+			( ulReloadValue <= ulElapsedBefore + ulTimerCountsForOneTick / 2 ) )
+		{
+			portENABLE_INTERRUPTS();
+			return;
+		}
+
+		/* Restart ETIMER5 so it matches when the expected idle time is up.
+		Writing the control register stops the counter, enabling it again
+		counts from zero; the few PCLK cycles in between are not
+		accounted. */
+		ulReloadValue -= ulElapsedBefore;
+		outpw(REG_ETMR5_CTL, 0);
+		outpw(REG_ETMR5_CMPR, ulReloadValue);
+		outpw(REG_ETMR5_CTL, portTIMER_CTL);
+
+		/* Allow the application to define some pre-sleep processing.  It
+		may set xModifiableIdleTime to 0 to skip the WFI below. */
+		xModifiableIdleTime = xExpectedIdleTime;
+		configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+		if( xModifiableIdleTime > 0 )
+		{
+			/* Bit 0 of CLK_PMCON selects what WFI does: set for idle, where
+			only the CPU clock stops, clear for power-down, the sequence
+			used by the GPIO_PowerDown sample. */
+			ulPMCON = inpw(REG_CLK_PMCON);
+			#if configNUC980_TICKLESS_POWER_DOWN == 1
+				outpw(REG_CLK_PMCON, ulPMCON & ~0x1UL);
+			#else
+				outpw(REG_CLK_PMCON, ulPMCON | 0x1UL);
+			#endif
+
+			prvWaitForInterrupt();
+
+			outpw(REG_CLK_PMCON, ulPMCON);
+			#if configNUC980_TICKLESS_POWER_DOWN == 1
+				outpw(REG_ETMR5_ISR, 0x10);	/* Clear the wake-up flag. */
+			#endif
+		}
+		configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+		/* ETIMER5 is in periodic mode, so if it matched, the counter started
+		again from zero at that moment. */
+		ulElapsed = inpw(REG_ETMR5_DR);
+		if( ( inpw(REG_ETMR5_ISR) & 0x1 ) != 0 )
+		{
+			/* The whole period passed.  The tick interrupt is cleared here
+			and accounted below, not by vPreemptiveTick(). */
+			ulElapsed += ulReloadValue;
+			outpw(REG_ETMR5_ISR, 0x1);
+		}
+
+		/* Restart the tick from now, carrying the part of a tick that has
+		already passed. */
+		outpw(REG_ETMR5_CTL, 0);
+		outpw(REG_ETMR5_CMPR, ulTimerCountsForOneTick);
+		outpw(REG_ETMR5_CTL, portTIMER_CTL);
+
+		ulElapsed += ulElapsedBefore;
+		xCompleteTickPeriods = ulElapsed / ulTimerCountsForOneTick;
+		ulTickFraction = ulElapsed % ulTimerCountsForOneTick;
+
+		/* vTaskStepTick() must not move the tick count up to the time the
+		next task unblocks, as only xTaskIncrementTick() unblocks tasks.
+		The scheduler is suspended here, so the remaining ticks are pended
+		and processed by xTaskResumeAll() when the idle task resumes it. */
+		xStepTicks = xCompleteTickPeriods;
+		if( xStepTicks > xExpectedIdleTime - 1 )
+		{
+			xStepTicks = xExpectedIdleTime - 1;
+		}
+		vTaskStepTick( xStepTicks );
+		while( xCompleteTickPeriods > xStepTicks )
+		{
+			( void ) xTaskIncrementTick();
+			xCompleteTickPeriods--;
+		}
+
+		portENABLE_INTERRUPTS();
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
 void vPortEnterCritical( void )
 {
 	/* Disable interrupts as per portDISABLE_INTERRUPTS(); 							*/
@@ -287,4 +548,64 @@ void vPortExitCritical( void )
 }
 /*-----------------------------------------------------------*/
 
+#if configGENERATE_RUN_TIME_STATS == 1
+
+	/* The run-time statistics clock is ETIMER4 in continuous mode, divided
+	down to portRUN_TIME_COUNTER_HZ.  Its 24-bit counter wraps every 16.7 s
+	and is extended to 32 bits by noting each wrap when the counter is read.
+	The compare interrupt reads it every half period, so no wrap is missed
+	when no task switch happens for a long time. */
+	static uint32_t ulRunTimeHigh = 0;
+	static uint32_t ulRunTimeLast = 0;
+
+	uint32_t ulPortGetRunTimeCounterValue( void )
+	{
+	UBaseType_t uxSavedStatus;
+	uint32_t ulCount;
+
+		uxSavedStatus = uxPortSetInterruptMask();
+		ulCount = inpw(REG_ETMR4_DR);
+		if( ulCount < ulRunTimeLast )
+		{
+			ulRunTimeHigh += portMAX_24_BIT_NUMBER + 1UL;
+		}
+		ulRunTimeLast = ulCount;
+		ulCount += ulRunTimeHigh;
+		vPortClearInterruptMask( uxSavedStatus );
+
+		return ulCount;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRunTimeStatsTimerISR( void )
+	{
+		/* Move the compare point on by half a period.  It alternates between
+		0x400000 and 0xC00000, which the continuous mode allows changing while
+		the counter runs. */
+		outpw(REG_ETMR4_CMPR, ( inpw(REG_ETMR4_CMPR) + 0x800000UL ) & portMAX_24_BIT_NUMBER);
+		outpw(REG_ETMR4_ISR, 0x1);
+
+		( void ) ulPortGetRunTimeCounterValue();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortConfigureTimerForRunTimeStats( void )
+	{
+		// enable timer4 clock
+		outpw(REG_CLK_PCLKEN0, inpw(REG_CLK_PCLKEN0) | (1 << 12));
+		outpw(REG_ETMR4_CTL, 0);
+		outpw(REG_ETMR4_PRECNT, ( 12000000UL / portRUN_TIME_COUNTER_HZ ) - 1UL);
+		outpw(REG_ETMR4_CMPR, 0x400000UL);
+
+		/* The lowest level, the interrupt only has to run once per half
+		period. */
+		sysInstallISR(IRQ_LEVEL_7, IRQ_TIMER4, (PVOID)prvRunTimeStatsTimerISR);
+		outpw(REG_ETMR4_IER, 0x1);
+		outpw(REG_ETMR4_CTL, 0x31);	/* Enable, continuous. */
+		sysEnableInterrupt(IRQ_TIMER4);
+	}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
+/*-----------------------------------------------------------*/
+
 
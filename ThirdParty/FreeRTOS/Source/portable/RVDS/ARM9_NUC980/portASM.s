@@ -31,17 +31,24 @@
 	IMPORT	vTaskSwitchContext
 	IMPORT	xTaskIncrementTick
 	IMPORT	systemIrqHandler
+	IMPORT	ulPortYieldRequired
+	IMPORT	ulPortIrqNesting
+	IMPORT	pxPortIrqStackTop
+	IMPORT	sysIrqDispatch
+	IMPORT	vPortTickFromNestedIrq
 
 	EXPORT	vPortYieldProcessor
 	EXPORT	vPortStartFirstTask
 	EXPORT	vPreemptiveTick
 	EXPORT	vPortYield
+	EXPORT	vPortDispatchIrqNested
 
 
 REG_AIC_IRQNUM	EQU	0xB0042120
 REG_AIC_EOIS	EQU	0xB0042150
 REG_ETMR5_ISR	EQU	0xB0052110
 IRQ_TIMER5		EQU	0x00000022
+SYS_MODE		EQU	0x1F
 
 	ARM
 	AREA	PORT_ASM, CODE, READONLY
@@ -102,6 +109,13 @@ vPreemptiveTick
 
 	PRESERVE8
 
+	STMFD SP!, {R0}						; An IRQ taken while a handler runs
+	LDR R0, =ulPortIrqNesting			; nested interrupted that handler, not
+	LDR R0, [R0]						; a task.  ulPortIrqNesting is only
+	CMP R0, #0							; set with configNUC980_NESTED_IRQ.
+	LDMFD SP!, {R0}
+	BNE vPortNestedIrq
+
 	portSAVE_CONTEXT					; Save the context of the current task.
 
 	LDR R0, =REG_AIC_IRQNUM				;
@@ -113,7 +127,7 @@ vPreemptiveTick
 	MOV LR, PC							;
 	BX  R1								;
 
-	B RestoreContext
+	B CheckYieldRequired
 
 SkipIrqHandler
 	LDR R0, =xTaskIncrementTick			; Increment the tick count.  
@@ -121,12 +135,9 @@ SkipIrqHandler
 	BX R0								; to run.
 
 	CMP R0, #0
-	BEQ SkipContextSwitch
-	LDR R0, =vTaskSwitchContext			; Find the highest priority task that 
-	MOV LR, PC							; is ready to run.
-	BX R0
+	LDRNE R1, =ulPortYieldRequired		; If so, request a context switch.
+	STRNE R0, [R1]
 
-SkipContextSwitch
 	LDR R0, =REG_ETMR5_ISR				; Clear the timer interrupt.
 	LDR R1, =1
 	STR R1, [R0] 
@@ -134,8 +145,112 @@ SkipContextSwitch
 	LDR R0, =REG_AIC_EOIS				; Acknowledge end of IRQ handler.
 	STR R1,[R0]
 
+CheckYieldRequired
+	LDR R1, =ulPortYieldRequired		; Switch once if the tick or any of the
+	LDR R0, [R1]						; handlers called portYIELD_FROM_ISR().
+	CMP R0, #0
+	BEQ RestoreContext
+	MOV R0, #0
+	STR R0, [R1]
+	LDR R0, =vTaskSwitchContext			; Find the highest priority task that 
+	MOV LR, PC							; is ready to run.
+	BX R0
+
 RestoreContext
 	portRESTORE_CONTEXT					; Restore the context of the highest 
 										; priority task that is ready to run.
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Interrupt nesting, used when configNUC980_NESTED_IRQ is set to 1.
+;
+; vPortDispatchIrqNested() is called by systemIrqHandler() in IRQ mode once
+; the task context is saved.  It runs the handler in system mode with IRQ
+; enabled, on the dedicated IRQ stack rather than the task stack; the task SP
+; is restored with the rest of its context.  Reading IRQNUM has made the AIC
+; hold off this priority level and lower until EOIS, so only a higher level
+; can interrupt the handler.  Such an IRQ enters vPreemptiveTick() again and
+; is sent to vPortNestedIrq, which keeps LR and SPSR of IRQ mode on the IRQ
+; stack and runs the handler on top of the interrupted one.  Context switches
+; requested by nested handlers happen when the outermost IRQ returns.
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+vPortDispatchIrqNested
+
+	PRESERVE8
+
+	STMFD SP!, {R4, LR}					; R0 holds the IRQ number.
+	LDR R1, =ulPortIrqNesting
+	MOV R2, #1
+	STR R2, [R1]
+
+	MRS R4, CPSR						; Switch to system mode, IRQ still
+	ORR R1, R4, #SYS_MODE				; masked, on the dedicated stack.
+	MSR CPSR_c, R1
+	LDR R1, =pxPortIrqStackTop
+	LDR SP, [R1]
+
+	MOV R1, #1							; sysIrqDispatch(num, TRUE) enables
+	LDR R2, =sysIrqDispatch				; IRQ around the handler.
+	MOV LR, PC
+	BX R2
+
+	MSR CPSR_c, R4						; Back to IRQ mode.
+	LDR R1, =ulPortIrqNesting
+	MOV R2, #0
+	STR R2, [R1]
+	LDMFD SP!, {R4, PC}
+
+vPortNestedIrq
+
+	SUB LR, LR, #4
+	STMFD SP!, {R0-R3, R12, LR}			; Keep the return state of IRQ mode.
+	MRS R0, SPSR
+	STMFD SP!, {R0, R4}
+
+	LDR R0, =REG_AIC_IRQNUM
+	LDR R0, [R0]
+	CMP R0, #IRQ_TIMER5
+	BNE NestedHandler
+
+	LDR R0, =vPortTickFromNestedIrq		; The tick runs with IRQ masked.
+	MOV LR, PC
+	BX R0
+	B NestedExit
+
+NestedHandler
+	LDR R1, =ulPortIrqNesting
+	LDR R2, [R1]
+	ADD R2, R2, #1
+	STR R2, [R1]
+
+	MRS R4, CPSR						; Switch to system mode, IRQ still
+	ORR R1, R4, #SYS_MODE				; masked, and align the stack of the
+	MSR CPSR_c, R1						; interrupted handler.
+	MOV R2, SP
+	BIC SP, SP, #7
+	STMFD SP!, {R2, LR}
+
+	MOV R1, #1
+	LDR R2, =sysIrqDispatch
+	MOV LR, PC
+	BX R2
+
+	LDMFD SP!, {R2, LR}
+	MOV SP, R2
+	MSR CPSR_c, R4						; Back to IRQ mode.
+
+	LDR R1, =ulPortIrqNesting
+	LDR R2, [R1]
+	SUB R2, R2, #1
+	STR R2, [R1]
+
+NestedExit
+	LDR R0, =REG_AIC_EOIS				; Acknowledge end of IRQ handler.
+	MOV R1, #1
+	STR R1, [R0]
+
+	LDMFD SP!, {R0, R4}
+	MSR SPSR_cxsf, R0
+	LDMFD SP!, {R0-R3, R12, PC}^
 	END
 
@@ -80,19 +80,23 @@ typedef unsigned long UBaseType_t;
  * is required from an ISR.
  *----------------------------------------------------------*/
 
-/* If a switch is required then we just need to call */
-/* vTaskSwitchContext() as the context has already been */
-/* saved. */
-
-#define portEXIT_SWITCHING_ISR(SwitchRequired)				 \
-{															 \
-extern void vTaskSwitchContext(void);						 \
-															 \
-		if(SwitchRequired)									 \
+/* Every IRQ enters through vPreemptiveTick(), which saves the context of */
+/* the interrupted task.  A handler only flags that a switch is required */
+/* and vPreemptiveTick() calls vTaskSwitchContext() after the handler */
+/* returns, before it restores a context. */
+
+extern volatile uint32_t ulPortYieldRequired;
+
+#define portYIELD_FROM_ISR(SwitchRequired)					 \
+do {														 \
+		if((SwitchRequired) != pdFALSE)						 \
 		{													 \
-			vTaskSwitchContext();							 \
+			ulPortYieldRequired = pdTRUE;					 \
 		}													 \
-}															 \
+} while(0)
+
+#define portEND_SWITCHING_ISR(SwitchRequired)	portYIELD_FROM_ISR(SwitchRequired)
+#define portEXIT_SWITCHING_ISR(SwitchRequired)	portYIELD_FROM_ISR(SwitchRequired)
 
 extern void vPortYield( void );
 #define portYIELD() vPortYield()
@@ -129,6 +133,61 @@ extern void vPortExitCritical( void );
 #define portEXIT_CRITICAL()			vPortExitCritical();
 /*-----------------------------------------------------------*/
 
+/* Tickless idle, see vPortSuppressTicksAndSleep() in port.c.  Set
+configNUC980_TICKLESS_POWER_DOWN to 1 to enter power-down rather than idle
+while the tick is suppressed; ETIMER5 is then clocked from the LXT and the
+application must enable the wake-up sources it needs in SYS_WKUPSER0/1. */
+#ifndef configNUC980_TICKLESS_POWER_DOWN
+	#define configNUC980_TICKLESS_POWER_DOWN	0
+#endif
+
+#if configUSE_TICKLESS_IDLE == 1
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )	vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
+/*-----------------------------------------------------------*/
+
+/* Interrupt nesting.  Set configNUC980_NESTED_IRQ to 1 to let an IRQ of a
+higher AIC priority level interrupt the handler of a lower one; the handlers
+then run on a dedicated stack of configNUC980_IRQ_STACK_SIZE words rather than
+the task stack.  The tick stays non-nested. */
+#ifndef configNUC980_NESTED_IRQ
+	#define configNUC980_NESTED_IRQ			0
+#endif
+
+#ifndef configNUC980_IRQ_STACK_SIZE
+	#define configNUC980_IRQ_STACK_SIZE		512
+#endif
+
+extern UBaseType_t uxPortSetInterruptMask( void );
+extern void vPortClearInterruptMask( UBaseType_t uxSavedStatus );
+
+#if configNUC980_NESTED_IRQ == 1
+	#define portSET_INTERRUPT_MASK_FROM_ISR()		uxPortSetInterruptMask()
+	#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vPortClearInterruptMask( x )
+
+	/* Words of the interrupt stack never used since the scheduler started.
+	With configCHECK_FOR_STACK_OVERFLOW set to 2 its lowest words are also
+	checked after each interrupt, and vApplicationStackOverflowHook() is
+	called with a NULL task and the name "IRQ" when they changed. */
+	extern UBaseType_t uxPortGetIrqStackHighWaterMark( void );
+#endif
+/*-----------------------------------------------------------*/
+
+/* Run-time statistics clock.  With configGENERATE_RUN_TIME_STATS the port
+counts ETIMER4 at portRUN_TIME_COUNTER_HZ, extended to 32 bits, so the counter
+wraps after about 71 minutes; compare two readings rather than absolute
+values.  ETIMER4 is then reserved, and stops in tickless power-down. */
+#define portRUN_TIME_COUNTER_HZ		( 1000000UL )
+
+#if configGENERATE_RUN_TIME_STATS == 1
+	extern void vPortConfigureTimerForRunTimeStats( void );
+	extern uint32_t ulPortGetRunTimeCounterValue( void );
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	vPortConfigureTimerForRunTimeStats()
+	#define portGET_RUN_TIME_COUNTER_VALUE()			ulPortGetRunTimeCounterValue()
+#endif
+/*-----------------------------------------------------------*/
+
 /* Compiler specifics. */
 #define inline
 #define register
@@ -91,6 +91,9 @@ typedef struct mbedtls_aes_context
                                      <li>Simplifying key expansion in the 256-bit
                                          case by generating an extra round key.
                                          </li></ul> */
+#ifdef NUVOTON_ENABLE_AES
+    uint32_t hw_key[8];         /*!< Cipher key words for the crypto engine. */
+#endif
 }
 mbedtls_aes_context;
 
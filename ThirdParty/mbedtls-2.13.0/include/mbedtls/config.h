@@ -45,12 +45,37 @@ extern void print_hex(uint8_t *hex, int len);
 
 
 /**
- *  Nuvoton Crypto hardware engine enable
+ *  Nuvoton Crypto hardware engine enable. Define NUVOTON_CRYPTO_SW_ONLY in the
+ *  project to build the software implementations instead, e.g. to compare them.
+ *
+ *  The PRNG is not a true random source and is not enabled here. Define
+ *  NUVOTON_ENABLE_PRNG in the project to add it as a weak entropy source,
+ *  see nvt_entropy.h.
  */
+#ifndef NUVOTON_CRYPTO_SW_ONLY
 #define NUVOTON_ENABLE_AES
 #define NUVOTON_ENABLE_SHA
 #define NUVOTON_ENABLE_ECC
 #define NUVOTON_ENABLE_RSA
+#endif
+
+/**
+ *  Define NUVOTON_CRYPTO_QUEUE in the project when CryptoQueueLib runs jobs on the
+ *  engine next to mbed TLS. The hooks then hold the CryptoQueueLib engine lock while
+ *  they program the engine, and a hardware SHA context holds it from its first block
+ *  until it is finished or freed. The lock is recursive, so the hooks may nest in one
+ *  task, but such a task must not wait for a queued job.
+ */
+#ifdef NUVOTON_CRYPTO_QUEUE
+#include "crypto_queue.h"
+#define NVT_CRYPTO_LOCK()       ( (void) CRYPTOQ_Lock( portMAX_DELAY ) )
+#define NVT_CRYPTO_TRYLOCK()    ( CRYPTOQ_Lock( 0 ) != CRYPTOQ_ERR_TIMEOUT )
+#define NVT_CRYPTO_UNLOCK()     CRYPTOQ_Unlock()
+#else
+#define NVT_CRYPTO_LOCK()       ( (void) 0 )
+#define NVT_CRYPTO_TRYLOCK()    ( 1 )
+#define NVT_CRYPTO_UNLOCK()     ( (void) 0 )
+#endif
 
 
 extern volatile int g_Crypto_Int_done;
@@ -478,7 +503,9 @@ extern void RSA_claim_bit_length(int bit_len);
  * Requires MBEDTLS_ENTROPY_C, MBEDTLS_NO_DEFAULT_ENTROPY_SOURCES
  *
  */
+#ifndef NUVOTON_ENABLE_PRNG
 #define MBEDTLS_TEST_NULL_ENTROPY
+#endif
 
 /**
  * \def MBEDTLS_ENTROPY_HARDWARE_ALT
@@ -493,6 +520,11 @@ extern void RSA_claim_bit_length(int bit_len);
  */
 //#define MBEDTLS_ENTROPY_HARDWARE_ALT
 
+/* Pre-generated CRPT PRNG output, a weak source, see nvt_entropy.h */
+#ifdef NUVOTON_ENABLE_PRNG
+#define MBEDTLS_ENTROPY_HARDWARE_ALT
+#endif
+
 /**
  * \def MBEDTLS_AES_ROM_TABLES
  *
@@ -535,6 +567,34 @@ extern void RSA_claim_bit_length(int bit_len);
  */
 //#define MBEDTLS_AES_FEWER_TABLES
 
+/**
+ * \def NUVOTON_AES_CT
+ *
+ * Use the constant-time bitsliced AES of nvt_aes_ct.c for the software
+ * AES, i.e. for everything the crypto engine does not run.
+ *
+ * The AES tables are left out, which saves their ~8kb of RAM or ROM and
+ * keeps them from evicting application data from the D-cache. The
+ * bitsliced cipher has no key or data dependent memory accesses, at the
+ * cost of a few times the cycles of the table version.
+ *
+ * Module:  library/nvt_aes_ct.c
+ *
+ * Uncomment this macro to use the constant-time AES.
+ */
+//#define NUVOTON_AES_CT
+
+/**
+ * \def NUVOTON_GCM_CT
+ *
+ * Compute GHASH bit by bit with masks instead of the 4-bit tables of
+ * gcm.c, whose lookups depend on the hashed data. GHASH gets several
+ * times slower.
+ *
+ * Uncomment this macro to use the constant-time GHASH.
+ */
+//#define NUVOTON_GCM_CT
+
 /**
  * \def MBEDTLS_CAMELLIA_SMALL_MEMORY
  *
@@ -2375,6 +2435,19 @@ extern void RSA_claim_bit_length(int bit_len);
  */
 //#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
 
+/**
+ * \def NUVOTON_ENABLE_TLS_POOL
+ *
+ * Size-class memory pool with per-connection accounting for TLS sessions,
+ * see nvt_tls_pool.h.
+ *
+ * Module:  library/nvt_tls_pool.c
+ *
+ * Requires: MBEDTLS_PLATFORM_C
+ *           MBEDTLS_PLATFORM_MEMORY (to use it within mbed TLS)
+ */
+//#define NUVOTON_ENABLE_TLS_POOL
+
 /**
  * \def MBEDTLS_NET_C
  *
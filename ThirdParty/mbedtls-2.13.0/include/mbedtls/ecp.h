@@ -762,12 +762,6 @@ extern char  tmp_str[MBEDTLS_ECP_MAX_PT_LEN];
 
 #ifdef NUVOTON_ENABLE_ECC
 
-extern char  tmp_x_str[MBEDTLS_ECP_MAX_PT_LEN];
-extern char  tmp_y_str[MBEDTLS_ECP_MAX_PT_LEN];
-extern char  tmp_1_str[MBEDTLS_ECP_MAX_PT_LEN];
-extern char  tmp_2_str[MBEDTLS_ECP_MAX_PT_LEN];
-extern char  tmp_3_str[MBEDTLS_ECP_MAX_PT_LEN];
-
 struct curve_map  {
 	mbedtls_ecp_group_id  id;
 	E_ECC_CURVE           curve;
@@ -792,6 +786,22 @@ static const struct curve_map curve_map_tbl[] =
 
 
 extern E_ECC_CURVE nuvoton_get_curve(mbedtls_ecp_group_id id);
+
+/**
+ * \brief           Write an MPI to the word array format of the ECC
+ *                  engine, \p count words, least significant word first.
+ *
+ * \return          \c 0 on success, or MBEDTLS_ERR_ECP_BAD_INPUT_DATA if
+ *                  \p X is negative or does not fit.
+ */
+int nuvoton_mpi_to_words( const mbedtls_mpi *X, uint32_t w[], int count );
+
+/**
+ * \brief           Read an MPI from \p count words of the ECC engine.
+ *
+ * \return          \c 0 on success, or MBEDTLS_ERR_MPI_ALLOC_FAILED.
+ */
+int nuvoton_words_to_mpi( mbedtls_mpi *X, const uint32_t w[], int count );
 #endif  // NUVOTON_ENABLE_ECC
 
 
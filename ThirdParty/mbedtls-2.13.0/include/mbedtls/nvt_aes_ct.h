@@ -0,0 +1,90 @@
+/**
+ * \file nvt_aes_ct.h
+ *
+ * \brief Constant-time bitsliced software AES.
+ *
+ * The software fallback of aes.c looks up 4 KB to 8 KB of T-tables with
+ * secret indexes. On the ARM926EJ-S with its 16 KB D-cache, those tables
+ * compete with the application for cache lines, and the time of a block
+ * depends on which lines were hit, which leaks the key. This cipher keeps
+ * a block as eight 32-bit bit planes and computes the S-box as a boolean
+ * circuit, so it has no tables, no secret-dependent loads or branches and
+ * no multiplications; shifts and rotations fold into the ARM data
+ * processing instructions for free.
+ *
+ * The round keys are kept compressed in the 68 words of the AES context
+ * and expanded on the stack for each block.
+ *
+ * The functions are used by aes.c when NUVOTON_AES_CT is defined and are
+ * not meant to be called directly.
+ */
+/*
+ *  Copyright (C) 2006-2018, Arm Limited (or its affiliates), All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of Mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_NVT_AES_CT_H
+#define MBEDTLS_NVT_AES_CT_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stdint.h>
+
+#ifdef NUVOTON_AES_CT
+
+/* Words of compressed round keys, 4 per round key */
+#define NVT_AES_CT_RK_WORDS     60
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Compute the compressed round keys, used for both
+ *                 encryption and decryption.
+ *
+ * \param rk       On entry, the cipher key as little-endian words in the
+ *                 first 4, 6 or 8 words. On return, the round keys, up to
+ *                 NVT_AES_CT_RK_WORDS words.
+ * \param nr       Number of rounds, 10, 12 or 14.
+ */
+void nvt_aes_ct_setkey( uint32_t *rk, int nr );
+
+/**
+ * \brief          Encrypt one 16-byte block. input and output may overlap.
+ */
+void nvt_aes_ct_encrypt( const uint32_t *rk, int nr,
+                         const unsigned char input[16],
+                         unsigned char output[16] );
+
+/**
+ * \brief          Decrypt one 16-byte block. input and output may overlap.
+ */
+void nvt_aes_ct_decrypt( const uint32_t *rk, int nr,
+                         const unsigned char input[16],
+                         unsigned char output[16] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUVOTON_AES_CT */
+
+#endif /* nvt_aes_ct.h */
@@ -0,0 +1,107 @@
+/**
+ * \file nvt_entropy.h
+ *
+ * \brief Hardware entropy source on the NUC980 crypto engine PRNG.
+ *
+ * mbedtls_hardware_poll() hands out bytes from a pool of pre-generated
+ * PRNG output, so seeding a CTR_DRBG or HMAC_DRBG does not wait for the
+ * engine. The pool is refilled one PRNG block at a time from the PRNG
+ * interrupt, from nvt_entropy_refill() called by the application (an idle
+ * hook for example), and by mbedtls_hardware_poll() itself.
+ *
+ * The PRNG is deterministic for a given 32-bit seed. The output is only
+ * as unpredictable as the seeds passed to nvt_entropy_init() and
+ * nvt_entropy_reseed(), which should come from a real noise source or
+ * from a seed stored and updated across resets. It is therefore added as
+ * a weak source, and is only built when the project defines
+ * NUVOTON_ENABLE_PRNG. The application must add a strong source of its
+ * own with mbedtls_entropy_add_source(), mbedtls_entropy_func() fails
+ * without one.
+ */
+/*
+ *  Copyright (C) 2006-2018, Arm Limited (or its affiliates), All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of Mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_NVT_ENTROPY_H
+#define MBEDTLS_NVT_ENTROPY_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef NUVOTON_ENABLE_PRNG
+
+/*
+ * Size of the pool of pre-generated output in bytes, a power of two and a
+ * multiple of the 32-byte PRNG block.
+ */
+#ifndef NVT_ENTROPY_POOL_SIZE
+#define NVT_ENTROPY_POOL_SIZE   256
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Seed the PRNG and start filling the pool.
+ *
+ * \param seed     Seed of the PRNG.
+ * \param use_irq  Non-zero to refill from the PRNG interrupt. The
+ *                 application's CRYPTO interrupt handler must then call
+ *                 nvt_entropy_irq_handler().
+ *
+ * \note           Until this is called, mbedtls_hardware_poll() fails with
+ *                 MBEDTLS_ERR_ENTROPY_SOURCE_FAILED.
+ */
+void nvt_entropy_init( uint32_t seed, int use_irq );
+
+/**
+ * \brief          Load a new seed for the next PRNG block. Output already
+ *                 in the pool is kept.
+ */
+void nvt_entropy_reseed( uint32_t seed );
+
+/**
+ * \brief          Collect a finished PRNG block into the pool and start the
+ *                 next one if there is room. Never waits for the engine.
+ *                 Call it from task context, e.g. an idle hook.
+ */
+void nvt_entropy_refill( void );
+
+/**
+ * \brief          PRNG part of the CRYPTO interrupt handler.
+ */
+void nvt_entropy_irq_handler( void );
+
+/**
+ * \brief          Bytes currently in the pool.
+ */
+size_t nvt_entropy_available( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUVOTON_ENABLE_PRNG */
+
+#endif /* nvt_entropy.h */
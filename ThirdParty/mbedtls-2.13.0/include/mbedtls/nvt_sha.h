@@ -0,0 +1,140 @@
+/**
+ * \file nvt_sha.h
+ *
+ * \brief Streaming SHA-1/SHA-2 on the NUC980 crypto engine.
+ *
+ * A SHA context moves to the engine when it is fed a large enough chunk
+ * while all of its data is still buffered, and then streams every later
+ * update to the engine as a DMA cascade until the digest is read out. The
+ * engine keeps one hash in flight and its digest registers cannot be
+ * loaded, so a running hash cannot be swapped out: while one context owns
+ * the engine, other contexts hash in software, and a copy of an engine
+ * context made with clone() cannot be continued.
+ */
+/*
+ *  Copyright (C) 2006-2018, Arm Limited (or its affiliates), All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of Mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_NVT_SHA_H
+#define MBEDTLS_NVT_SHA_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef NUVOTON_ENABLE_SHA
+
+/*
+ * Smallest update() that moves a context to the engine. Shorter messages
+ * are faster in software than the DMA setup and cache maintenance.
+ */
+#ifndef NVT_SHA_HW_THRESHOLD
+#define NVT_SHA_HW_THRESHOLD    512
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Engine state kept in each SHA context.
+ */
+typedef struct
+{
+    uint32_t hw;                /*!< The context owns the engine.           */
+    uint32_t started;           /*!< The first DMA transfer has been issued. */
+    uint32_t pending;           /*!< Bytes in the context buffer not yet
+                                     sent to the engine.                    */
+    uint32_t held;              /*!< Software: the first block is in the
+                                     buffer and not yet compressed.         */
+    uint32_t keep_sw;           /*!< Never move to the engine, see
+                                     nvt_sha_keep_sw().                     */
+}
+mbedtls_nvt_sha_state;
+
+/**
+ * \brief          Move a context to the engine.
+ *
+ * \param st       Engine state of the context.
+ * \param owner    The SHA context.
+ * \param opmode   Engine mode, SHA_MODE_xxx.
+ * \param pending  Bytes already in the context buffer, not yet compressed.
+ *
+ * \return         \c 0 on success, \c -1 if another context or another
+ *                 task owns the engine or the context is kept in software.
+ *
+ * \note           With NUVOTON_CRYPTO_QUEUE the engine lock is held from
+ *                 here until nvt_sha_hw_release(), so the context must be
+ *                 finished or freed by the task that started it.
+ */
+int nvt_sha_hw_start( mbedtls_nvt_sha_state *st, const void *owner,
+                      uint32_t opmode, size_t pending );
+
+/**
+ * \brief          Feed data to an engine context. Whole blocks go to the
+ *                 engine, the tail stays in the context buffer so that
+ *                 finish() always has data for the last transfer.
+ *
+ * \return         \c 0 on success, \c -1 if the context does not own the
+ *                 engine or the DMA failed.
+ */
+int nvt_sha_hw_update( mbedtls_nvt_sha_state *st, const void *owner,
+                       unsigned char *buffer, size_t block_size,
+                       const unsigned char *input, size_t ilen );
+
+/**
+ * \brief          Send the buffered tail, read \p olen bytes of digest and
+ *                 release the engine.
+ *
+ * \return         \c 0 on success, \c -1 if the context does not own the
+ *                 engine or the DMA failed.
+ */
+int nvt_sha_hw_finish( mbedtls_nvt_sha_state *st, const void *owner,
+                       const unsigned char *buffer,
+                       unsigned char *output, size_t olen );
+
+/**
+ * \brief          Release the engine if the context owns it and return the
+ *                 context to software.
+ */
+void nvt_sha_hw_release( mbedtls_nvt_sha_state *st, const void *owner );
+
+/**
+ * \brief          Keep a context in software for its whole life.
+ *
+ *                 The engine digest cannot be read back in the middle of a
+ *                 message, so a context on the engine cannot be cloned: the
+ *                 clone returns MBEDTLS_ERR_SHAxxx_HW_ACCEL_FAILED. Call this
+ *                 after init() for a context that will be cloned, such as
+ *                 the TLS handshake checksums. Clones inherit the setting.
+ *
+ * \param st       Engine state of the context.
+ */
+void nvt_sha_keep_sw( mbedtls_nvt_sha_state *st );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUVOTON_ENABLE_SHA */
+
+#endif /* nvt_sha.h */
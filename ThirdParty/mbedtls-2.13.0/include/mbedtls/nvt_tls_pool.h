@@ -0,0 +1,214 @@
+/**
+ * \file nvt_tls_pool.h
+ *
+ * \brief Size-class memory pool for mbedtls TLS sessions.
+ *
+ * The pool is carved once into fixed-size blocks of a few classes matched
+ * to what mbedtls allocates: small MPI limbs and ASN.1 nodes, X.509 and
+ * handshake structures, and the record buffers of each session. A block
+ * only ever returns to its own class, so a long running device with many
+ * connections opened and closed does not fragment the way a first-fit heap
+ * does. When a class runs out, the request spills into the next larger
+ * classes before it fails.
+ *
+ * Every allocation is charged to the current owner, normally the
+ * mbedtls_ssl_context doing the work, which gives the live and peak bytes
+ * of each connection. nvt_tls_pool_report() prints the class usage, the
+ * waste inside blocks and the owners.
+ *
+ * To route mbedtls allocations through the pool, enable
+ * MBEDTLS_PLATFORM_C and MBEDTLS_PLATFORM_MEMORY and call
+ * mbedtls_platform_set_calloc_free( nvt_tls_pool_calloc, nvt_tls_pool_free )
+ * after nvt_tls_pool_init().
+ *
+ * The pool does no locking of its own. When several tasks run TLS
+ * sessions, define NVT_TLS_POOL_ENTER() and NVT_TLS_POOL_EXIT(), e.g. to
+ * taskENTER_CRITICAL() and taskEXIT_CRITICAL(), and define
+ * NVT_TLS_POOL_OWNER() to fetch the owner of the running task, e.g. from
+ * a thread local storage pointer.
+ */
+/*
+ *  Copyright (C) 2006-2018, Arm Limited (or its affiliates), All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of Mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_NVT_TLS_POOL_H
+#define MBEDTLS_NVT_TLS_POOL_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef NUVOTON_ENABLE_TLS_POOL
+
+/*
+ * Blocks in each class. The defaults fit 8 concurrent TLS 1.2 sessions
+ * with RSA-2048 or P-256 certificates, about 740 KB in total. Watch the
+ * peak column of nvt_tls_pool_report() under load to tune them.
+ */
+#ifndef NVT_TLS_POOL_COUNT_32
+#define NVT_TLS_POOL_COUNT_32       512     /* MPI limbs, ASN.1 sequences */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_64
+#define NVT_TLS_POOL_COUNT_64       512
+#endif
+#ifndef NVT_TLS_POOL_COUNT_128
+#define NVT_TLS_POOL_COUNT_128      256
+#endif
+#ifndef NVT_TLS_POOL_COUNT_256
+#define NVT_TLS_POOL_COUNT_256      256     /* RSA-2048 MPIs              */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_512
+#define NVT_TLS_POOL_COUNT_512      128     /* x509_crt, ssl_session      */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_1K
+#define NVT_TLS_POOL_COUNT_1K       64
+#endif
+#ifndef NVT_TLS_POOL_COUNT_2K
+#define NVT_TLS_POOL_COUNT_2K       32      /* raw certificates, transform */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_4K
+#define NVT_TLS_POOL_COUNT_4K       16      /* handshake params           */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_8K
+#define NVT_TLS_POOL_COUNT_8K       8       /* certificate chains, PEM    */
+#endif
+#ifndef NVT_TLS_POOL_COUNT_RECORD
+#define NVT_TLS_POOL_COUNT_RECORD   16      /* two record buffers a session */
+#endif
+
+/*
+ * Size of the record buffer class. The default is the larger of the
+ * input and output buffers of ssl_tls.c with the current configuration.
+ */
+/* #define NVT_TLS_POOL_RECORD_SIZE */
+
+/* Larger classes a request may spill into when its own class is empty */
+#ifndef NVT_TLS_POOL_SPILL
+#define NVT_TLS_POOL_SPILL          2
+#endif
+
+/* Owners tracked at once; further owners are charged as unowned memory */
+#ifndef NVT_TLS_POOL_MAX_OWNERS
+#define NVT_TLS_POOL_MAX_OWNERS     8
+#endif
+
+#define NVT_TLS_POOL_CLASSES        10
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Usage of one block class.
+ */
+typedef struct
+{
+    size_t block_size;      /*!< payload bytes of each block            */
+    size_t total;           /*!< blocks in the class                    */
+    size_t used;            /*!< blocks allocated now                   */
+    size_t peak;            /*!< most blocks ever allocated at once     */
+    size_t requested;       /*!< bytes asked for by the blocks in use   */
+    size_t spilled;         /*!< requests served by a larger class      */
+    size_t failed;          /*!< requests that found no block at all    */
+}
+nvt_tls_pool_class_stats;
+
+/**
+ * \brief          Memory charged to one owner.
+ */
+typedef struct
+{
+    const void *owner;      /*!< the owner, NULL for unowned memory     */
+    size_t bytes;           /*!< bytes allocated now                    */
+    size_t peak;            /*!< most bytes ever allocated at once      */
+    size_t blocks;          /*!< blocks allocated now                   */
+    size_t failed;          /*!< allocations that failed                */
+}
+nvt_tls_pool_owner_stats;
+
+/**
+ * \brief          Bytes of memory nvt_tls_pool_init() needs.
+ */
+size_t nvt_tls_pool_size( void );
+
+/**
+ * \brief          Carve buf into the block classes. Must not be called
+ *                 while blocks are allocated.
+ *
+ * \param buf      Memory of the pool, 8-byte aligned.
+ * \param len      Length of buf, at least nvt_tls_pool_size().
+ *
+ * \return         0 on success, -1 if buf is too small.
+ */
+int nvt_tls_pool_init( void *buf, size_t len );
+
+/**
+ * \brief          calloc() for mbedtls_platform_set_calloc_free().
+ */
+void *nvt_tls_pool_calloc( size_t n, size_t size );
+
+/**
+ * \brief          free() for mbedtls_platform_set_calloc_free(). Pointers
+ *                 outside the pool are counted and ignored.
+ */
+void nvt_tls_pool_free( void *ptr );
+
+/**
+ * \brief          Charge the following allocations to owner, typically the
+ *                 mbedtls_ssl_context about to be set up, handshaken, read,
+ *                 written or freed. NULL stops charging.
+ */
+void nvt_tls_pool_set_owner( const void *owner );
+
+/**
+ * \brief          Forget an owner, e.g. after mbedtls_ssl_free(). Blocks it
+ *                 still holds, which are leaks, move to unowned memory.
+ */
+void nvt_tls_pool_release_owner( const void *owner );
+
+/**
+ * \brief          Usage of block class idx, 0 to NVT_TLS_POOL_CLASSES - 1.
+ *
+ * \return         0 on success, -1 if idx is out of range.
+ */
+int nvt_tls_pool_class_info( int idx, nvt_tls_pool_class_stats *stats );
+
+/**
+ * \brief          Memory charged to owner.
+ *
+ * \return         0 on success, -1 if owner is not tracked.
+ */
+int nvt_tls_pool_owner_info( const void *owner, nvt_tls_pool_owner_stats *stats );
+
+/**
+ * \brief          Print the usage of each class, the bytes lost inside
+ *                 blocks and the memory of each owner.
+ */
+void nvt_tls_pool_report( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUVOTON_ENABLE_TLS_POOL */
+
+#endif /* nvt_tls_pool.h */
@@ -40,6 +40,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "nvt_sha.h"
+
 #define MBEDTLS_ERR_SHA1_HW_ACCEL_FAILED                  -0x0035  /**< SHA-1 hardware accelerator failed */
 
 #ifdef __cplusplus
@@ -63,6 +65,9 @@ typedef struct mbedtls_sha1_context
     uint32_t total[2];          /*!< The number of Bytes processed.  */
     uint32_t state[5];          /*!< The intermediate digest state.  */
     unsigned char buffer[64];   /*!< The data block being processed. */
+#ifdef NUVOTON_ENABLE_SHA
+    mbedtls_nvt_sha_state nvt;  /*!< Crypto engine streaming state. */
+#endif
 }
 mbedtls_sha1_context;
 
@@ -36,6 +36,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "nvt_sha.h"
+
 #define MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED                -0x0037  /**< SHA-256 hardware accelerator failed */
 
 #ifdef __cplusplus
@@ -60,6 +62,9 @@ typedef struct mbedtls_sha256_context
     unsigned char buffer[64];   /*!< The data block being processed. */
     int is224;                  /*!< Determines which function to use:
                                      0: Use SHA-256, or 1: Use SHA-224. */
+#ifdef NUVOTON_ENABLE_SHA
+    mbedtls_nvt_sha_state nvt;  /*!< Crypto engine streaming state. */
+#endif
 }
 mbedtls_sha256_context;
 
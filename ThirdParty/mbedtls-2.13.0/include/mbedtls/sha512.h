@@ -35,6 +35,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "nvt_sha.h"
+
 #define MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED                -0x0039  /**< SHA-512 hardware accelerator failed */
 
 #ifdef __cplusplus
@@ -59,6 +61,9 @@ typedef struct mbedtls_sha512_context
     unsigned char buffer[128];  /*!< The data block being processed. */
     int is384;                  /*!< Determines which function to use:
                                      0: Use SHA-512, or 1: Use SHA-384. */
+#ifdef NUVOTON_ENABLE_SHA
+    mbedtls_nvt_sha_state nvt;  /*!< Crypto engine streaming state. */
+#endif
 }
 mbedtls_sha512_context;
 
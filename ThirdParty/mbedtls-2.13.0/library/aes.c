@@ -53,9 +53,19 @@
 #endif /* MBEDTLS_PLATFORM_C */
 #endif /* MBEDTLS_SELF_TEST */
 
+#if defined(NUVOTON_AES_CT)
+#include "mbedtls/nvt_aes_ct.h"
+#endif
+
 #ifdef NUVOTON_ENABLE_AES
-static uint8_t src_dma_buff[16] __attribute__((aligned (32)));
-static uint8_t dst_dma_buff[16] __attribute__((aligned (32)));
+/*
+ * Bounce buffers for data that cannot be handed to the crypto DMA directly.
+ * Longer buffers go through in chunks with the engine cascading the IV.
+ */
+#define NVT_AES_BOUNCE_SIZE     1024
+
+static uint8_t src_dma_buff[NVT_AES_BOUNCE_SIZE] __attribute__((aligned (32)));
+static uint8_t dst_dma_buff[NVT_AES_BOUNCE_SIZE] __attribute__((aligned (32)));
 
 #define GET_UINT32_BE(n,b,i)                            \
 {                                                       \
@@ -96,6 +106,9 @@ static uint8_t dst_dma_buff[16] __attribute__((aligned (32)));
 static int aes_padlock_ace = -1;
 #endif
 
+/* The bitsliced cipher of nvt_aes_ct.c needs none of the tables */
+#if !defined(NUVOTON_AES_CT)
+
 #if defined(MBEDTLS_AES_ROM_TABLES)
 /*
  * Forward S-box
@@ -521,70 +534,129 @@ static void aes_gen_tables( void )
 
 #endif /* MBEDTLS_AES_FEWER_TABLES */
 
+#endif /* !NUVOTON_AES_CT */
+
 #ifdef NUVOTON_ENABLE_AES
-static int nvt_aes_setkey(const unsigned char *key,  int nr)
+static uint32_t nvt_aes_setkey( const mbedtls_aes_context *ctx )
 {
     int        i;
     uint32_t   *aes_key = (uint32_t *)&CRPT->AES0_KEY[0];
 
-    CRPT->AES_CTL |= ( ((nr-10)/2) << CRPT_AES_CTL_KEYSZ_Pos); 
-
     for( i = 0; i < 8; i++ )
+        aes_key[i] = ctx->hw_key[i];
+
+    return( ( (uint32_t)( ctx->nr - 10 ) / 2 ) << CRPT_AES_CTL_KEYSZ_Pos );
+}
+
+static void nvt_aes_set_iv( const unsigned char iv[16] )
+{
+    int        i;
+    uint32_t   *aes_iv = (uint32_t *)&CRPT->AES0_IV[0];
+
+    for( i = 0; i < 4; i++ )
     {
-        GET_UINT32_BE( aes_key[i], key, i << 2 );
+        GET_UINT32_BE( aes_iv[i], iv, i << 2 );
     }
-    return( 0 );
+}
+
+/*
+ * Run one DMA transfer through the engine and wait for it to finish.
+ */
+static void nvt_aes_run( uint32_t ctl, uint32_t dma_mode,
+                         const void *src, void *dst, size_t length )
+{
+    CRPT->AES0_SADDR = (uint32_t)src;
+    CRPT->AES0_DADDR = (uint32_t)dst;
+    CRPT->AES0_CNT = length;
+
+    CRPT->AES_CTL = ctl | CRPT_AES_CTL_START_Msk | ( dma_mode << CRPT_AES_CTL_DMALAST_Pos );
+    while ((CRPT->INTSTS & (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk)) == 0);
+    CRPT->INTSTS = (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk);
+}
+
+/*
+ * The engine can DMA straight from a caller buffer if it is non-cacheable,
+ * or if it covers whole cache lines so that flushing the D-cache first
+ * cannot lose neighbouring data.
+ */
+static int nvt_aes_dma_capable( const void *buf, size_t length )
+{
+    if( (uint32_t)buf & 0x80000000 )
+        return( ( ( (uint32_t)buf | length ) & 0x3 ) == 0 );
+    return( ( ( (uint32_t)buf | length ) & 0x1F ) == 0 );
+}
+
+/*
+ * Encrypt or decrypt a multiple of 16 bytes in one of the engine's
+ * block modes. The whole buffer is one DMA transfer when possible,
+ * otherwise it is staged through the bounce buffers and the engine
+ * carries the chaining state from chunk to chunk in cascade mode.
+ */
+static void nvt_aes_crypt_dma( mbedtls_aes_context *ctx, uint32_t op_mode, int mode,
+                               const unsigned char iv[16],
+                               const unsigned char *input,
+                               unsigned char *output,
+                               size_t length )
+{
+    uint32_t   ctl, dma_mode;
+    size_t     len;
+
+    NVT_CRYPTO_LOCK();
+    ctl = nvt_aes_setkey( ctx );
+    if( iv != NULL )
+        nvt_aes_set_iv( iv );
+
+    ctl |= ( op_mode << CRPT_AES_CTL_OPMODE_Pos ) | CRPT_AES_CTL_DMAEN_Msk |
+           CRPT_AES_CTL_INSWAP_Msk | CRPT_AES_CTL_OUTSWAP_Msk;
+    if( mode == MBEDTLS_AES_ENCRYPT )
+        ctl |= CRPT_AES_CTL_ENCRPT_Msk;
+
+    if( nvt_aes_dma_capable( input, length ) && nvt_aes_dma_capable( output, length ) )
+    {
+        if( ( ( ( (uint32_t)input & (uint32_t)output ) & 0x80000000 ) == 0 ) && sysGetCacheState() )
+            sysFlushCache( D_CACHE );
+        nvt_aes_run( ctl, CRYPTO_DMA_ONE_SHOT, input, output, length );
+        NVT_CRYPTO_UNLOCK();
+        return;
+    }
+
+    dma_mode = CRYPTO_DMA_FIRST;
+    while( length > 0 )
+    {
+        len = ( length < NVT_AES_BOUNCE_SIZE ) ? length : NVT_AES_BOUNCE_SIZE;
+
+        memcpy( (uint8_t *)((uint32_t)src_dma_buff | 0x80000000), input, len );
+        nvt_aes_run( ctl, dma_mode, src_dma_buff, dst_dma_buff, len );
+        memcpy( output, (uint8_t *)((uint32_t)dst_dma_buff | 0x80000000), len );
+
+        dma_mode = CRYPTO_DMA_CONTINUE;
+        input  += len;
+        output += len;
+        length -= len;
+    }
+    NVT_CRYPTO_UNLOCK();
 }
 
 int nvt_mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
                                   const unsigned char input[16],
                                   unsigned char output[16] )
 {
-	nvt_aes_setkey((uint8_t *)ctx->rk, ctx->nr);
-	
-	CRPT->AES0_SADDR = (uint32_t)src_dma_buff;
-	CRPT->AES0_DADDR = (uint32_t)dst_dma_buff;
-	CRPT->AES0_CNT = 16;
-	
-	memcpy((uint8_t *)((uint32_t)src_dma_buff | 0x80000000), input, 16);
-	CRPT->AES_CTL |= CRPT_AES_CTL_INSWAP_Msk | CRPT_AES_CTL_OUTSWAP_Msk;
-	CRPT->AES_CTL |= CRPT_AES_CTL_ENCRPT_Msk | CRPT_AES_CTL_DMAEN_Msk | CRPT_AES_CTL_DMACSCAD_Msk | CRPT_AES_CTL_START_Msk;
-	while ((CRPT->INTSTS & (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk)) == 0);
-	CRPT->INTSTS = (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk);
-	
-	memcpy(output, (uint8_t *)((uint32_t)dst_dma_buff | 0x80000000), 16);
-	return 0;
+    nvt_aes_crypt_dma( ctx, AES_MODE_ECB, MBEDTLS_AES_ENCRYPT, NULL, input, output, 16 );
+    return 0;
 }
 
 int nvt_mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
                                   const unsigned char input[16],
                                   unsigned char output[16] )
 {
-	nvt_aes_setkey((uint8_t *)ctx->rk, ctx->nr);
-
-	CRPT->AES0_SADDR = (uint32_t)src_dma_buff;
-	CRPT->AES0_DADDR = (uint32_t)dst_dma_buff;
-	CRPT->AES0_CNT = 16;
-	
-	memcpy((uint8_t *)((uint32_t)src_dma_buff | 0x80000000), input, 16);
-
-    CRPT->AES_CTL |= CRPT_AES_CTL_INSWAP_Msk | CRPT_AES_CTL_OUTSWAP_Msk;	
-	CRPT->AES_CTL &= ~CRPT_AES_CTL_ENCRPT_Msk;
-	CRPT->AES_CTL |=  CRPT_AES_CTL_DMAEN_Msk | CRPT_AES_CTL_DMACSCAD_Msk | CRPT_AES_CTL_START_Msk;
-	while ((CRPT->INTSTS & (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk)) == 0);
-	CRPT->INTSTS = (CRPT_INTSTS_AESIF_Msk | CRPT_INTSTS_AESEIF_Msk);
-	
-	memcpy(output, (uint8_t *)((uint32_t)dst_dma_buff | 0x80000000), 16);
-	return 0;
+    nvt_aes_crypt_dma( ctx, AES_MODE_ECB, MBEDTLS_AES_DECRYPT, NULL, input, output, 16 );
+    return 0;
 }
 #endif
 
 void mbedtls_aes_init( mbedtls_aes_context *ctx )
 {
     memset( ctx, 0, sizeof( mbedtls_aes_context ) );
-#ifdef NUVOTON_ENABLE_AES
-	CRPT->AES_CTL = 0;
-#endif	
 }
 
 void mbedtls_aes_free( mbedtls_aes_context *ctx )
@@ -621,7 +693,7 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
     unsigned int i;
     uint32_t *RK;
 
-#if !defined(MBEDTLS_AES_ROM_TABLES)
+#if !defined(MBEDTLS_AES_ROM_TABLES) && !defined(NUVOTON_AES_CT)
     if( aes_init_done == 0 )
     {
         aes_gen_tables();
@@ -658,6 +730,19 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
         GET_UINT32_LE( RK[i], key, i << 2 );
     }
 
+#ifdef NUVOTON_ENABLE_AES
+    /* The engine takes the cipher key itself for both directions */
+    memset( ctx->hw_key, 0, sizeof( ctx->hw_key ) );
+    for( i = 0; i < ( keybits >> 5 ); i++ )
+    {
+        GET_UINT32_BE( ctx->hw_key[i], key, i << 2 );
+    }
+#endif
+
+#if defined(NUVOTON_AES_CT)
+    nvt_aes_ct_setkey( RK, ctx->nr );
+    return( 0 );
+#else
     switch( ctx->nr )
     {
         case 10:
@@ -722,6 +807,7 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
     }
 
     return( 0 );
+#endif /* NUVOTON_AES_CT */
 }
 
 #endif /* !MBEDTLS_AES_SETKEY_ENC_ALT */
@@ -731,6 +817,14 @@ int mbedtls_aes_setkey_enc( mbedtls_aes_context *ctx, const unsigned char *key,
  */
 #if !defined(MBEDTLS_AES_SETKEY_DEC_ALT)
 
+#if defined(NUVOTON_AES_CT)
+int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
+                    unsigned int keybits )
+{
+    /* The bitsliced rounds decrypt with the encryption key schedule */
+    return( mbedtls_aes_setkey_enc( ctx, key, keybits ) );
+}
+#else
 int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
                     unsigned int keybits )
 {
@@ -756,6 +850,9 @@ int mbedtls_aes_setkey_dec( mbedtls_aes_context *ctx, const unsigned char *key,
         goto exit;
 
     ctx->nr = cty.nr;
+#ifdef NUVOTON_ENABLE_AES
+    memcpy( ctx->hw_key, cty.hw_key, sizeof( ctx->hw_key ) );
+#endif
 
 #if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
     if( mbedtls_aesni_has_support( MBEDTLS_AESNI_AES ) )
@@ -794,6 +891,7 @@ exit:
 
     return( ret );
 }
+#endif /* NUVOTON_AES_CT */
 
 #if defined(MBEDTLS_CIPHER_MODE_XTS)
 static int mbedtls_aes_xts_decode_keys( const unsigned char *key,
@@ -919,6 +1017,16 @@ int mbedtls_aes_xts_setkey_dec( mbedtls_aes_xts_context *ctx,
  * AES-ECB block encryption
  */
 #if !defined(MBEDTLS_AES_ENCRYPT_ALT)
+#if defined(NUVOTON_AES_CT)
+int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    nvt_aes_ct_encrypt( ctx->rk, ctx->nr, input, output );
+
+    return( 0 );
+}
+#else
 int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
                                   const unsigned char input[16],
                                   unsigned char output[16] )
@@ -972,6 +1080,7 @@ int mbedtls_internal_aes_encrypt( mbedtls_aes_context *ctx,
 
     return( 0 );
 }
+#endif /* NUVOTON_AES_CT */
 #endif /* !MBEDTLS_AES_ENCRYPT_ALT */
 
 #if !defined(MBEDTLS_DEPRECATED_REMOVED)
@@ -987,6 +1096,16 @@ void mbedtls_aes_encrypt( mbedtls_aes_context *ctx,
  * AES-ECB block decryption
  */
 #if !defined(MBEDTLS_AES_DECRYPT_ALT)
+#if defined(NUVOTON_AES_CT)
+int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
+                                  const unsigned char input[16],
+                                  unsigned char output[16] )
+{
+    nvt_aes_ct_decrypt( ctx->rk, ctx->nr, input, output );
+
+    return( 0 );
+}
+#else
 int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
                                   const unsigned char input[16],
                                   unsigned char output[16] )
@@ -1040,6 +1159,7 @@ int mbedtls_internal_aes_decrypt( mbedtls_aes_context *ctx,
 
     return( 0 );
 }
+#endif /* NUVOTON_AES_CT */
 #endif /* !MBEDTLS_AES_DECRYPT_ALT */
 
 
@@ -1078,7 +1198,6 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
 #endif
 
 #ifdef NUVOTON_ENABLE_AES
-    CRPT->AES_CTL |= (AES_MODE_ECB << CRPT_AES_CTL_OPMODE_Pos);
     if( mode == MBEDTLS_AES_ENCRYPT )
         return( nvt_mbedtls_internal_aes_encrypt( ctx, input, output ) );
     else
@@ -1120,6 +1239,23 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
     }
 #endif
 
+#ifdef NUVOTON_ENABLE_AES
+    if( length == 0 )
+        return( 0 );
+
+    /* Keep the last ciphertext block as the next IV, input may be overwritten */
+    if( mode == MBEDTLS_AES_DECRYPT )
+        memcpy( temp, input + length - 16, 16 );
+
+    nvt_aes_crypt_dma( ctx, AES_MODE_CBC, mode, iv, input, output, length );
+
+    if( mode == MBEDTLS_AES_DECRYPT )
+        memcpy( iv, temp, 16 );
+    else
+        memcpy( iv, output + length - 16, 16 );
+    return( 0 );
+#endif
+
     if( mode == MBEDTLS_AES_DECRYPT )
     {
         while( length > 0 )
@@ -1448,6 +1584,37 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
     if ( n > 0x0F )
         return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
 
+#ifdef NUVOTON_ENABLE_AES
+    /* Use up the rest of the current stream block first */
+    while( n != 0 && length > 0 )
+    {
+        *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+        n = ( n + 1 ) & 0x0F;
+        length--;
+    }
+
+    /* Whole blocks in the engine's counter mode, then advance the counter by as many blocks */
+    if( length >= 16 )
+    {
+        size_t blocks = length >> 4;
+        uint32_t carry;
+
+        nvt_aes_crypt_dma( ctx, AES_MODE_CTR, MBEDTLS_AES_ENCRYPT, nonce_counter,
+                           input, output, blocks << 4 );
+
+        for( i = 16; i > 0 && blocks != 0; i-- )
+        {
+            carry = (uint32_t)nonce_counter[i - 1] + ( blocks & 0xFF );
+            nonce_counter[i - 1] = (unsigned char) carry;
+            blocks = ( blocks >> 8 ) + ( carry >> 8 );
+        }
+
+        input  += length & ~(size_t)0x0F;
+        output += length & ~(size_t)0x0F;
+        length &= 0x0F;
+    }
+#endif
+
     while( length-- )
     {
         if( n == 0 ) {
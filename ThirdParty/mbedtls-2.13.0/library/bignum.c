@@ -1541,279 +1541,158 @@ int mbedtls_mpi_mod_int( mbedtls_mpi_uint *r, const mbedtls_mpi *A, mbedtls_mpi_
 
 #ifdef NUVOTON_ENABLE_RSA
 
-#include "bigdigits.c"
+/*
+ * Modular exponentiation on the CRPT RSA engine. The engine takes 32-bit
+ * words, up to RSA_MAX_KLEN bits, and a Montgomery constant
+ * C = 2^(2 * (L + 2)) mod N for an L-bit operation. C for the length of N
+ * is kept in the _RR cache that callers such as rsa.c hold per key, the
+ * way the software code keeps R^2 mod N there. Moduli the engine cannot
+ * take use the software code below.
+ */
 
-#define Hardware_length   (RSA_MAX_KLEN)
+#define NVT_RSA_WORDS   ( RSA_MAX_KLEN / 32 )
 
-uint32_t  C_t[(2096*2)/32];
-uint32_t  N_t[(2096*2)/32];
+/* 32-bit words per MPI limb */
+#define NVT_WPL         ( sizeof( mbedtls_mpi_uint ) / 4 )
 
-char      C[RSA_KBUF_BLEN], N[RSA_KBUF_BLEN];
+static uint32_t  rsa_m[NVT_RSA_WORDS], rsa_e[NVT_RSA_WORDS];
+static uint32_t  rsa_n[NVT_RSA_WORDS], rsa_c[NVT_RSA_WORDS];
 
-static int  g_rsa_len = 1024;
+static int mpi_exp_mod_sw( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E,
+                           const mbedtls_mpi *N, mbedtls_mpi *_RR );
 
+/*
+ * The engine length follows the operands, this is kept for existing
+ * applications.
+ */
 void RSA_claim_bit_length(int bit_len)
 {
-    g_rsa_len = bit_len;
+    (void) bit_len;
 }
 
-
-void RSA_Hex2Binary(char * input, char *output)
+/* X must be non-negative and fit in count words */
+static void mpi_to_words( const mbedtls_mpi *X, uint32_t w[], size_t count )
 {
-    int    i, j, idx, n, klen;
-    char   *p = (char *)input;
+    size_t i;
 
-    if (strlen(input)+3 > RSA_KBUF_HLEN)
+    for( i = 0; i < count; i++ )
     {
-        printf("Hex2Binary overflow!!  %d > %d\n", klen+3, RSA_KBUF_HLEN);
-        return;
-    }
-    
-    klen = strlen(input)*4;
-    
-    memset(output, 0, RSA_KBUF_BLEN);
-    output[klen] = 0;
-    output[klen+1] = 0;
-    
-    idx = klen-1;
-
-    for (i = 0; *p != 0; i++, p++) 
-    {
-        if (input[i] <= '9')
-            n = input[i] - '0';
-        else if (input[i] >= 'a')
-            n = input[i] - 'a' + 10;
+        if( i / NVT_WPL < X->n )
+            w[i] = (uint32_t)( X->p[i / NVT_WPL] >> ( 32 * ( i % NVT_WPL ) ) );
         else
-            n = input[i] - 'A' + 10;
-        
-        for (j = 3; j >= 0; j--)
-            output[idx--] = (n >> j) & 0x1;
-    }
-    
-    if (idx != -1)
-    {
-        printf("RSA_Hex2Binary unexpected error!!\n");
-        while (1);
+            w[i] = 0;
     }
 }
 
-void RSA_Binary2Hex(int length, char *input, char *output)
+static int mpi_from_words( mbedtls_mpi *X, const uint32_t w[], size_t count )
 {
-    int    i, idx, n, slen;
-    
-    memset(output, 0, RSA_KBUF_HLEN);
-    
-    slen = length / 4;
-    
-    idx  = slen - 1;
-    
-    for (i=0; i<length; i+=4) 
-    {
-        n = (input[i]) | (input[i+1]<<1) | (input[i+2]<<2) | (input[i+3]<<3);
-        if (n >= 10)
-            output[idx] = n - 10 + 'A';
-        else
-            output[idx] = n + '0'; 
-        idx--;
-    }
-    
-    if (idx != -1)
-    {
-        printf("RSA_Binary2Hex unecpected error! %d\n", idx);
-        while (1);
-    }
-}
+    int ret;
+    size_t i;
 
-void RSA_Hex2Reg(char *input, uint32_t *reg, int hex_len)
-{
-    int        i, si, slen;
-    uint32_t   val32;
-    char       sbuf[RSA_KBUF_HLEN];
-    
-    slen = strlen(input);
-    
-    if ((slen > hex_len) || (hex_len > RSA_MAX_KLEN/4))
-    {
-        printf("RSA_Hex2Reg - wrong input!! %d %d\n", slen, hex_len);
-        return;
-    }
-    
-    memset(sbuf, '0', hex_len); 
-    sbuf[hex_len] = 0;
-    
-    strcpy(&sbuf[hex_len - slen], input);
-        
-    si = hex_len - 1;
-    while (si >= 0)
-    {
-        val32 = 0;
-        for (i = 0; (i < 8) && (si >= 0); i++)
-        {
-            if (sbuf[si] <= '9')
-                val32 |= (sbuf[si] - '0') << (i * 4);
-            else if ((sbuf[si] <= 'z') && (sbuf[si] >= 'a'))
-                val32 |= (sbuf[si] - 'a' + 10) << (i * 4);
-            else
-                val32 |= (sbuf[si] - 'A' + 10) << (i * 4);
-            si--;
-        }
-        *reg++ = val32;
-    }
-}
+    MBEDTLS_MPI_CHK( mbedtls_mpi_grow( X, ( count + NVT_WPL - 1 ) / NVT_WPL ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( X, 0 ) );
 
-void RSA_Reg2Hex(int count, uint32_t *reg, char *output)
-{
-    int  idx, i, ri, n;
+    for( i = 0; i < count; i++ )
+        X->p[i / NVT_WPL] |= (mbedtls_mpi_uint) w[i] << ( 32 * ( i % NVT_WPL ) );
 
-    output[count] = 0;
-    idx = count - 1;
-    
-    for (ri = 0; ; ri++)
-    {
-        for (i = 0; i <= 28; i += 4)
-        {
-            n = (reg[ri] >> i) & 0xf;
-            
-            if (n >= 10)
-                output[idx] = n + 'a' - 10;
-            else
-                output[idx] = n + '0';
-                
-            idx --;
-            
-            if (idx < 0)
-                return;
-        }
-    }
+cleanup:
+    return( ret );
 }
 
-void RSA_CS(int length, char *rsa_N, char *rsa_C)
+int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E, const mbedtls_mpi *N, mbedtls_mpi *_RR )
 {
-    int        i, v, nbits;
-    uint32_t   j;
-    int        scale = (length+2)*2;
-    size_t     word_size = (scale/32)+1;
+    int ret;
+    size_t nlen, len;
+    mbedtls_mpi C, T;
+
+    if( mbedtls_mpi_cmp_int( N, 0 ) <= 0 || ( N->p[0] & 1 ) == 0 ||
+        mbedtls_mpi_cmp_int( E, 0 ) < 0 )
+        return( MBEDTLS_ERR_MPI_BAD_INPUT_DATA );
 
-    memset(rsa_C, 0, length/4+2);
-    RSA_Hex2Binary(rsa_N, N);  
+    /* Operation length: N and E rounded up to words */
+    nlen = ( ( mbedtls_mpi_bitlen( N ) + 31 ) / 32 ) * 32;
+    len  = ( ( mbedtls_mpi_bitlen( E ) + 31 ) / 32 ) * 32;
+    if( len < nlen )
+        len = nlen;
 
-    memset(C_t, 0, sizeof(C_t));
-    C_t[word_size-1] = (uint32_t)(1 << scale-(32*(word_size-1)));
+    if( nlen > RSA_MAX_KLEN )
+        return( mpi_exp_mod_sw( X, A, E, N, _RR ) );
 
-    // convert char to uint32_t
-    memset(N_t, 0, sizeof(N_t));
-    j = 0;
-    for (i = 0; i < length; i++)
+    /*
+     * _RR of this modulus holds the engine constant, so the software code
+     * must not use it. Blinded private exponents without CRT get here.
+     */
+    if( len > RSA_MAX_KLEN || mbedtls_mpi_cmp_int( E, 0 ) == 0 )
+        return( mpi_exp_mod_sw( X, A, E, N, NULL ) );
+
+    mbedtls_mpi_init( &C ); mbedtls_mpi_init( &T );
+
+    /*
+     * If 1st call, pre-compute C for the length of N
+     */
+    if( _RR == NULL || _RR->p == NULL )
     {
-        if (N[i])
-        {
-            j += 1 << (i%32);
-        }
+        MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &C, 1 ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shift_l( &C, 2 * ( nlen + 2 ) ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &C, &C, N ) );
 
-        if ((i % 32) == 31)
-        {
-            N_t[(i/32)] = j;
-            j = 0;
-        }
+        if( _RR != NULL )
+            MBEDTLS_MPI_CHK( mbedtls_mpi_copy( _RR, &C ) );
     }
-    mpModulo(C_t, C_t, word_size, N_t, word_size);
+    else
+        MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &C, _RR ) );
 
-    // convert uint32_t to char
-    nbits = (int)mpBitLength(C_t, word_size);
+    /*
+     * An exponent longer than N, such as a blinded CRT exponent, needs a
+     * longer operation: C = C * 2^(2 * (len - nlen)) mod N
+     */
+    if( len > nlen )
+    {
+        MBEDTLS_MPI_CHK( mbedtls_mpi_shift_l( &C, 2 * ( len - nlen ) ) );
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &C, &C, N ) );
+    }
 
-    for (i = Hardware_length; i >= 0; i--) 
+    /* The engine needs 0 <= A < N */
+    if( A->s < 0 || mbedtls_mpi_cmp_mpi( A, N ) >= 0 )
     {
-        if (i > nbits) 
-            C[i] = 0;
-        else
-        {
-            v = mpGetBit(C_t, word_size, i);
-            C[i] = v ? 1 : 0;
-        }
+        MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( &T, A, N ) );
+        A = &T;
     }
 
-    RSA_Binary2Hex(length, C, rsa_C);
-    return;
-}
+    /*
+     * The operand words are shared by every caller, so the engine lock is
+     * held from staging them until the result is read and the secrets wiped
+     */
+    NVT_CRYPTO_LOCK();
 
+    mpi_to_words( A, rsa_m, len / 32 );
+    mpi_to_words( E, rsa_e, len / 32 );
+    mpi_to_words( N, rsa_n, len / 32 );
+    mpi_to_words( &C, rsa_c, len / 32 );
 
-void RSA_dump_registers()
-{
-    int   i;
-    
-    printf("\n RSA_CTL = 0x%x", CRPT->RSA_CTL);
-    printf("\n RSA_STS = 0x%x", CRPT->RSA_STS);
-    printf("\n RSA_M   = ");
-    for (i = 0; i < 64; i++) printf("%x ", CRPT->RSA_M[i]);
-    printf("\n RSA_E   = ");
-    for (i = 0; i < 64; i++) printf("%x ", CRPT->RSA_E[i]);
-    printf("\n RSA_N   = ");
-    for (i = 0; i < 64; i++) printf("%x ", CRPT->RSA_N[i]);
-    printf("\n RSA_C   = ");
-    for (i = 0; i < 64; i++) printf("%x ", CRPT->RSA_C[i]);
-    printf("\n");
-}
+    ret = RSA_ExpMod_u32( CRPT, len, rsa_m, rsa_e, rsa_n, rsa_c, rsa_m );
+    if( ret == 0 )
+        ret = mpi_from_words( X, rsa_m, len / 32 );
+    else
+        ret = MBEDTLS_ERR_MPI_BAD_INPUT_DATA;
 
-int mbedtls_mpi_exp_mod(mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E, const mbedtls_mpi *N, mbedtls_mpi *_RR )
-{
-    char     str_buff[520];
-    size_t   wlen;
-    char     str_C[520];
-    int      hex_len;   /* hex length */
-    int      i;
-
-    for (i = 0; i < 64; i++)
-    {
-        CRPT->RSA_M[i] = 0;
-        CRPT->RSA_E[i] = 0;
-        CRPT->RSA_N[i] = 0;
-        CRPT->RSA_C[i] = 0;
-    }
-
-    //printf("X len = %d\n", (( mbedtls_mpi_bitlen( X ) + 7 )/8) * 8);
-    //printf("A len = %d\n", (( mbedtls_mpi_bitlen( A ) + 7 )/8) * 8);
-    //printf("E len = %d\n", (( mbedtls_mpi_bitlen( E ) + 7 )/8) * 8);
-    //printf("N len = %d\n", (( mbedtls_mpi_bitlen( N ) + 7 )/8) * 8);
-    
-    //printf("g_rsa_len = %d\n", g_rsa_len);
-
-    hex_len = g_rsa_len / 4;
-    
-    memset(str_buff, 0, sizeof(str_buff));
-    mbedtls_mpi_write_string(A, 16, str_buff, 516, &wlen);
-    //printf("M = %s\n", str_buff);
-    RSA_Hex2Reg(str_buff, (uint32_t *)&CRPT->RSA_M[0], hex_len);
-
-    mbedtls_mpi_write_string(E, 16, str_buff, 516, &wlen);
-    RSA_Hex2Reg(str_buff, (uint32_t *)&CRPT->RSA_E[0], hex_len);
-    //printf("E = %s [%d]\n", str_buff, wlen);
-    
-    mbedtls_mpi_write_string(N, 16, str_buff, 516, &wlen);
-    RSA_Hex2Reg(str_buff, (uint32_t *)&CRPT->RSA_N[0], hex_len);
-    //printf("N = %s [%d]\n", str_buff, wlen);
-
-    RSA_CS(g_rsa_len, str_buff, str_C);
-
-    //printf("str_C = %s\n", str_C);
-    
-    RSA_Hex2Reg(str_C, (uint32_t *)&CRPT->RSA_C[0], hex_len);
-    
-    // RSA_dump_registers();
-    CRPT->RSA_CTL = (g_rsa_len << CRPT_RSA_CTL_KEYLEN_Pos) | CRPT_RSA_CTL_START_Msk;
-    while (CRPT->RSA_STS & CRPT_RSA_STS_BUSY_Msk) ;
-
-    RSA_Reg2Hex(hex_len, (uint32_t *)CRPT->RSA_M, str_buff);
-
-    mbedtls_mpi_read_string(X, 16, str_buff);
-
-    //printf("X = %s\n", str_buff);
-    return 0;
+    mbedtls_platform_zeroize( rsa_e, sizeof( rsa_e ) );
+    mbedtls_platform_zeroize( rsa_m, sizeof( rsa_m ) );
+
+    NVT_CRYPTO_UNLOCK();
+
+cleanup:
+    mbedtls_mpi_free( &C ); mbedtls_mpi_free( &T );
+
+    return( ret );
 }
 
 #else
 
 void RSA_claim_bit_length(int bit_len) {};
 
+#endif  // NUVOTON_ENABLE_RSA
+
 /*
  * Fast Montgomery initialization (thanks to Tom St Denis)
  */
@@ -1891,7 +1770,12 @@ static int mpi_montred( mbedtls_mpi *A, const mbedtls_mpi *N, mbedtls_mpi_uint m
 /*
  * Sliding-window exponentiation: X = A^E mod N  (HAC 14.85)
  */
+#ifdef NUVOTON_ENABLE_RSA
+static int mpi_exp_mod_sw( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E,
+                           const mbedtls_mpi *N, mbedtls_mpi *_RR )
+#else
 int mbedtls_mpi_exp_mod( mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *E, const mbedtls_mpi *N, mbedtls_mpi *_RR )
+#endif
 {
     int ret;
     size_t wbits, wsize, one = 1;
@@ -2096,8 +1980,6 @@ cleanup:
     return( ret );
 }
 
-#endif  // NUVOTON_ENABLE_RSA
-
 /*
  * Greatest common divisor: G = gcd(A, B)  (HAC 14.54)
  */
@@ -35,6 +35,7 @@
 
 #include "mbedtls/ecdsa.h"
 #include "mbedtls/asn1write.h"
+#include "mbedtls/platform_util.h"
 
 #include <string.h>
 
@@ -83,6 +84,10 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
 
 #ifdef NUVOTON_ENABLE_ECC
 	E_ECC_CURVE   ecc_curve;
+    int words;
+    size_t n_size;
+    uint32_t  ew[ECC_MAX_WORDS], dw[ECC_MAX_WORDS], kw[ECC_MAX_WORDS];
+    uint32_t  rw[ECC_MAX_WORDS], sw[ECC_MAX_WORDS];
 
 	ecc_curve = nuvoton_get_curve(grp->id);
 	if (ecc_curve == CURVE_UNDEF)
@@ -100,6 +105,58 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
     mbedtls_ecp_point_init( &R );
     mbedtls_mpi_init( &k ); mbedtls_mpi_init( &e ); mbedtls_mpi_init( &t );
 
+#ifdef NUVOTON_ENABLE_ECC
+    /*
+     * The engine computes k * G, r and s in one call, so only k is
+     * generated here, the same way mbedtls_ecp_gen_keypair() does
+     */
+    words = ECC_KEY_WORDS( grp->pbits );
+    n_size = ( grp->nbits + 7 ) / 8;
+
+    MBEDTLS_MPI_CHK( derive_mpi( grp, &e, buf, blen ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &e, ew, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( d, dw, words ) );
+
+    sign_tries = 0;
+    do
+    {
+        if( sign_tries++ > 10 )
+        {
+            ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+            goto cleanup;
+        }
+
+        key_tries = 0;
+        do
+        {
+            MBEDTLS_MPI_CHK( mbedtls_mpi_fill_random( &k, n_size, f_rng, p_rng ) );
+            MBEDTLS_MPI_CHK( mbedtls_mpi_shift_r( &k, 8 * n_size - grp->nbits ) );
+
+            if( ++key_tries > 30 )
+            {
+                ret = MBEDTLS_ERR_ECP_RANDOM_FAILED;
+                goto cleanup;
+            }
+        }
+        while( mbedtls_mpi_cmp_int( &k, 1 ) < 0 ||
+               mbedtls_mpi_cmp_mpi( &k, &grp->N ) >= 0 );
+
+        MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &k, kw, words ) );
+
+        NVT_CRYPTO_LOCK();
+        ret = ECC_GenerateSignature_u32( CRPT, ecc_curve, ew, dw, kw, rw, sw );
+        NVT_CRYPTO_UNLOCK();
+        if( ret != 0 )
+        {
+            ret = MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+            goto cleanup;
+        }
+
+        MBEDTLS_MPI_CHK( nuvoton_words_to_mpi( r, rw, words ) );
+        MBEDTLS_MPI_CHK( nuvoton_words_to_mpi( s, sw, words ) );
+    }
+    while( mbedtls_mpi_cmp_int( r, 0 ) == 0 || mbedtls_mpi_cmp_int( s, 0 ) == 0 );
+#else
     sign_tries = 0;
     do
     {
@@ -126,19 +183,6 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
          */
         MBEDTLS_MPI_CHK( derive_mpi( grp, &e, buf, blen ) );
 
-#ifdef NUVOTON_ENABLE_ECC
-
-        mbedtls_mpi_write_string(&e, 16, tmp_1_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-        mbedtls_mpi_write_string(&k, 16, tmp_2_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-        mbedtls_mpi_write_string(d,  16, tmp_3_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-
-        if (ECC_GenerateSignature(CRPT, ecc_curve, tmp_1_str, tmp_3_str, tmp_2_str, tmp_x_str, tmp_y_str) == 0)
-        {
-			mbedtls_mpi_read_string(r, 16, tmp_x_str);
-			mbedtls_mpi_read_string(s, 16, tmp_y_str);
-			break;
-    	}
-#else
         /*
          * Generate a random value to blind inv_mod in next step,
          * avoiding a potential timing leak.
@@ -167,7 +211,6 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
         MBEDTLS_MPI_CHK( mbedtls_mpi_inv_mod( s, &k, &grp->N ) );
         MBEDTLS_MPI_CHK( mbedtls_mpi_mul_mpi( s, s, &e ) );
         MBEDTLS_MPI_CHK( mbedtls_mpi_mod_mpi( s, s, &grp->N ) );
-#endif  // NUVOTON_ENABLE_ECC
 
         if( sign_tries++ > 10 )
         {
@@ -176,8 +219,13 @@ int mbedtls_ecdsa_sign( mbedtls_ecp_group *grp, mbedtls_mpi *r, mbedtls_mpi *s,
         }
     }
     while( mbedtls_mpi_cmp_int( s, 0 ) == 0 );
+#endif  // NUVOTON_ENABLE_ECC
 
 cleanup:
+#ifdef NUVOTON_ENABLE_ECC
+    mbedtls_platform_zeroize( dw, sizeof( dw ) );
+    mbedtls_platform_zeroize( kw, sizeof( kw ) );
+#endif
     mbedtls_ecp_point_free( &R );
     mbedtls_mpi_free( &k ); mbedtls_mpi_free( &e ); mbedtls_mpi_free( &t );
 
@@ -237,6 +285,9 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
     mbedtls_ecp_point R;
 #ifdef NUVOTON_ENABLE_ECC
 	E_ECC_CURVE   ecc_curve;
+    int words;
+    uint32_t  ew[ECC_MAX_WORDS], rw[ECC_MAX_WORDS], sw[ECC_MAX_WORDS];
+    uint32_t  qx[ECC_MAX_WORDS], qy[ECC_MAX_WORDS];
 
 	ecc_curve = nuvoton_get_curve(grp->id);
 	if (ecc_curve == CURVE_UNDEF)
@@ -271,23 +322,24 @@ int mbedtls_ecdsa_verify( mbedtls_ecp_group *grp,
     MBEDTLS_MPI_CHK( derive_mpi( grp, &e, buf, blen ) );
 
 #ifdef NUVOTON_ENABLE_ECC
-
-    mbedtls_mpi_write_string(&e, 16, tmp_1_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(r,  16, tmp_2_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(s,  16, tmp_3_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(&Q->X,  16, tmp_x_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(&Q->Y,  16, tmp_y_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-
-    if (ECC_VerifySignature(CRPT, ecc_curve, tmp_1_str, tmp_x_str, tmp_y_str, tmp_2_str, tmp_3_str) != 0)
+    words = ECC_KEY_WORDS( grp->pbits );
+
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &e, ew, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( r, rw, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( s, sw, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &Q->X, qx, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &Q->Y, qy, words ) );
+
+    /* Steps 4-8 on the engine, which compares x1' (mod n) with r itself */
+    NVT_CRYPTO_LOCK();
+    ret = ECC_VerifySignature_u32( CRPT, ecc_curve, ew, qx, qy, rw, sw );
+    NVT_CRYPTO_UNLOCK();
+    if( ret != 0 )
     {
-    	ret = MBEDTLS_ERR_ECP_VERIFY_FAILED;
-    	goto cleanup;
+        ret = ( ret == -2 ) ? MBEDTLS_ERR_ECP_VERIFY_FAILED : MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+        goto cleanup;
     }
-    else
-    {
-    	mbedtls_mpi_read_string(&R.X, 16, tmp_2_str);
-    	mbedtls_mpi_read_string(&R.Y, 16, tmp_3_str);
-	}
+    MBEDTLS_MPI_CHK( mbedtls_mpi_copy( &R.X, r ) );
 #else
     /*
      * Step 4: u1 = e / s mod n, u2 = r / s mod n
@@ -171,12 +171,6 @@ char  tmp_str[MBEDTLS_ECP_MAX_PT_LEN];
 
 #ifdef NUVOTON_ENABLE_ECC
 
-char  tmp_x_str[MBEDTLS_ECP_MAX_PT_LEN];
-char  tmp_y_str[MBEDTLS_ECP_MAX_PT_LEN];
-char  tmp_1_str[MBEDTLS_ECP_MAX_PT_LEN];
-char  tmp_2_str[MBEDTLS_ECP_MAX_PT_LEN];
-char  tmp_3_str[MBEDTLS_ECP_MAX_PT_LEN];
-
 E_ECC_CURVE  nuvoton_get_curve(mbedtls_ecp_group_id id)
 {
     int  i;	
@@ -188,6 +182,41 @@ E_ECC_CURVE  nuvoton_get_curve(mbedtls_ecp_group_id id)
 	}
 	return CURVE_UNDEF;
 }
+
+/* 32-bit words per MPI limb */
+#define NVT_WPL     ( sizeof( mbedtls_mpi_uint ) / 4 )
+
+int nuvoton_mpi_to_words( const mbedtls_mpi *X, uint32_t w[], int count )
+{
+    size_t  i;
+
+    if( X->s < 0 || mbedtls_mpi_size( X ) > (size_t) count * 4 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    for( i = 0; i < (size_t) count; i++ )
+    {
+        if( i / NVT_WPL < X->n )
+            w[i] = (uint32_t)( X->p[i / NVT_WPL] >> ( 32 * ( i % NVT_WPL ) ) );
+        else
+            w[i] = 0;
+    }
+    return( 0 );
+}
+
+int nuvoton_words_to_mpi( mbedtls_mpi *X, const uint32_t w[], int count )
+{
+    int ret;
+    size_t  i;
+
+    MBEDTLS_MPI_CHK( mbedtls_mpi_grow( X, ( count + NVT_WPL - 1 ) / NVT_WPL ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( X, 0 ) );
+
+    for( i = 0; i < (size_t) count; i++ )
+        X->p[i / NVT_WPL] |= (mbedtls_mpi_uint) w[i] << ( 32 * ( i % NVT_WPL ) );
+
+cleanup:
+    return( ret );
+}
 #endif
 
 /*
@@ -1714,24 +1743,45 @@ int mbedtls_ecp_mul( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
              const mbedtls_mpi *m, const mbedtls_ecp_point *P,
              int (*f_rng)(void *, unsigned char *, size_t), void *p_rng )
 {
+    int ret;
 	E_ECC_CURVE   ecc_curve;
+    int words;
+    uint32_t  x[ECC_MAX_WORDS], y[ECC_MAX_WORDS], k[ECC_MAX_WORDS];
 
 	ecc_curve = nuvoton_get_curve(grp->id);
 	if (ecc_curve == CURVE_UNDEF)
 	    return MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
 
-    mbedtls_mpi_write_string(m, 16, tmp_1_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(&P->X, 16, tmp_x_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
-    mbedtls_mpi_write_string(&P->Y, 16, tmp_y_str, MBEDTLS_ECP_MAX_PT_LEN, &tmp_len);
+    /* Common sanity checks, P may be a peer's public key in ECDH */
+    if( mbedtls_mpi_cmp_int( &P->Z, 1 ) != 0 )
+        return( MBEDTLS_ERR_ECP_BAD_INPUT_DATA );
+
+    if( ( ret = mbedtls_ecp_check_privkey( grp, m ) ) != 0 ||
+        ( ret = mbedtls_ecp_check_pubkey( grp, P ) ) != 0 )
+        return( ret );
+
+    words = ECC_KEY_WORDS( grp->pbits );
 
-    ECC_Mutiply(CRPT, ecc_curve, tmp_x_str, tmp_y_str, tmp_1_str, tmp_2_str, tmp_3_str);
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( m, k, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &P->X, x, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_mpi_to_words( &P->Y, y, words ) );
 
-    // printf("ECC mbedtls_ecp_mul success.\n");
+    NVT_CRYPTO_LOCK();
+    ret = ECC_PointMul_u32( CRPT, ecc_curve, x, y, k, x, y );
+    NVT_CRYPTO_UNLOCK();
+    if( ret != 0 )
+    {
+        ret = MBEDTLS_ERR_ECP_HW_ACCEL_FAILED;
+        goto cleanup;
+    }
 
-	mbedtls_mpi_read_string(&R->X, 16, tmp_2_str);
-	mbedtls_mpi_read_string(&R->Y, 16, tmp_3_str);
-	mbedtls_mpi_lset( &R->Z, 1);
-	return 0;
+    MBEDTLS_MPI_CHK( nuvoton_words_to_mpi( &R->X, x, words ) );
+    MBEDTLS_MPI_CHK( nuvoton_words_to_mpi( &R->Y, y, words ) );
+    MBEDTLS_MPI_CHK( mbedtls_mpi_lset( &R->Z, 1 ) );
+
+cleanup:
+    mbedtls_platform_zeroize( k, sizeof( k ) );
+    return( ret );
 }
 #else
 
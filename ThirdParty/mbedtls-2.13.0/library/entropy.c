@@ -89,6 +89,14 @@ void mbedtls_entropy_init( mbedtls_entropy_context *ctx )
                                 1, MBEDTLS_ENTROPY_SOURCE_STRONG );
 #endif
 
+#if defined(MBEDTLS_NO_DEFAULT_ENTROPY_SOURCES) && defined(NUVOTON_ENABLE_PRNG)
+    /* The CRPT PRNG is deterministic for its 32-bit seed, the application
+     * adds the strong source */
+    mbedtls_entropy_add_source( ctx, mbedtls_hardware_poll, NULL,
+                                MBEDTLS_ENTROPY_MIN_HARDWARE,
+                                MBEDTLS_ENTROPY_SOURCE_WEAK );
+#endif
+
 #if !defined(MBEDTLS_NO_DEFAULT_ENTROPY_SOURCES)
 #if !defined(MBEDTLS_NO_PLATFORM_ENTROPY)
     mbedtls_entropy_add_source( ctx, mbedtls_platform_entropy_poll, NULL,
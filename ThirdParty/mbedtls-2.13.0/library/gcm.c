@@ -46,6 +46,11 @@
 #include "mbedtls/aesni.h"
 #endif
 
+#if defined(NUVOTON_ENABLE_AES) && defined(MBEDTLS_CIPHER_MODE_CTR)
+#include "mbedtls/aes.h"
+#include "mbedtls/cipher_internal.h"
+#endif
+
 #if defined(MBEDTLS_SELF_TEST) && defined(MBEDTLS_AES_C)
 #include "mbedtls/aes.h"
 #if defined(MBEDTLS_PLATFORM_C)
@@ -99,7 +104,10 @@ void mbedtls_gcm_init( mbedtls_gcm_context *ctx )
  */
 static int gcm_gen_table( mbedtls_gcm_context *ctx )
 {
-    int ret, i, j;
+    int ret;
+#if !defined(NUVOTON_GCM_CT)
+    int i, j;
+#endif
     uint64_t hi, lo;
     uint64_t vl, vh;
     unsigned char h[16];
@@ -122,6 +130,10 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
     ctx->HL[8] = vl;
     ctx->HH[8] = vh;
 
+#if defined(NUVOTON_GCM_CT)
+    /* The bit-serial multiplication needs only h */
+    return( 0 );
+#else
 #if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64)
     /* With CLMUL support, we need only h, not the rest of the table */
     if( mbedtls_aesni_has_support( MBEDTLS_AESNI_CLMUL ) )
@@ -155,6 +167,7 @@ static int gcm_gen_table( mbedtls_gcm_context *ctx )
     }
 
     return( 0 );
+#endif /* NUVOTON_GCM_CT */
 }
 
 int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
@@ -189,6 +202,53 @@ int mbedtls_gcm_setkey( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(NUVOTON_GCM_CT)
+/*
+ * Sets output to x times H one bit of x at a time, as in algorithm 1 of
+ * [MGV]. Table lookups indexed by x would leak it through the cache and
+ * multiply instructions take a data dependent time on the ARM926, so
+ * only masks, shifts and XORs are used. This is several times slower
+ * than the table method below.
+ */
+static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
+                      unsigned char output[16] )
+{
+    int i, j;
+    uint32_t xi, m;
+    uint32_t v0, v1, v2, v3;
+    uint32_t z0 = 0, z1 = 0, z2 = 0, z3 = 0;
+
+    v0 = (uint32_t)( ctx->HH[8] >> 32 );
+    v1 = (uint32_t)( ctx->HH[8]       );
+    v2 = (uint32_t)( ctx->HL[8] >> 32 );
+    v3 = (uint32_t)( ctx->HL[8]       );
+
+    for( i = 0; i < 16; i++ )
+    {
+        xi = x[i];
+        for( j = 7; j >= 0; j-- )
+        {
+            m = (uint32_t) 0 - ( ( xi >> j ) & 1 );
+            z0 ^= v0 & m;
+            z1 ^= v1 & m;
+            z2 ^= v2 & m;
+            z3 ^= v3 & m;
+
+            /* V times P, reduced by R = 11100001 || 0^120 */
+            m = (uint32_t) 0 - ( v3 & 1 );
+            v3 = ( v3 >> 1 ) | ( v2 << 31 );
+            v2 = ( v2 >> 1 ) | ( v1 << 31 );
+            v1 = ( v1 >> 1 ) | ( v0 << 31 );
+            v0 = ( v0 >> 1 ) ^ ( 0xE1000000 & m );
+        }
+    }
+
+    PUT_UINT32_BE( z0, output, 0 );
+    PUT_UINT32_BE( z1, output, 4 );
+    PUT_UINT32_BE( z2, output, 8 );
+    PUT_UINT32_BE( z3, output, 12 );
+}
+#else
 /*
  * Shoup's method for multiplication use this table with
  *      last4[x] = x times P^128
@@ -261,6 +321,7 @@ static void gcm_mult( mbedtls_gcm_context *ctx, const unsigned char x[16],
     PUT_UINT32_BE( zl >> 32, output, 8 );
     PUT_UINT32_BE( zl, output, 12 );
 }
+#endif /* NUVOTON_GCM_CT */
 
 int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
                 int mode,
@@ -345,6 +406,78 @@ int mbedtls_gcm_starts( mbedtls_gcm_context *ctx,
     return( 0 );
 }
 
+#if defined(NUVOTON_ENABLE_AES) && defined(MBEDTLS_CIPHER_MODE_CTR)
+static void gcm_ghash_blocks( mbedtls_gcm_context *ctx,
+                              const unsigned char *p,
+                              size_t blocks )
+{
+    size_t i;
+
+    while( blocks-- > 0 )
+    {
+        for( i = 0; i < 16; i++ )
+            ctx->buf[i] ^= p[i];
+        gcm_mult( ctx, ctx->buf, ctx->buf );
+        p += 16;
+    }
+}
+
+/*
+ * Run the counter mode part of GCM over whole blocks in one go on the
+ * crypto engine. GCM only increments the low 32 bits of the counter
+ * while the engine carries into the upper bits, so the run is cut short
+ * before the low word would wrap. Returns the number of bytes done.
+ */
+static size_t gcm_nvt_crypt_blocks( mbedtls_gcm_context *ctx,
+                                    size_t length,
+                                    const unsigned char *input,
+                                    unsigned char *output )
+{
+    unsigned char ctr[16];
+    unsigned char stream[16];
+    size_t nc_off = 0;
+    size_t blocks;
+    uint32_t low;
+
+    if( ctx->cipher_ctx.cipher_info->base->cipher != MBEDTLS_CIPHER_ID_AES )
+        return( 0 );
+
+    low = ( (uint32_t) ctx->y[12] << 24 ) | ( (uint32_t) ctx->y[13] << 16 ) |
+          ( (uint32_t) ctx->y[14] <<  8 ) | ( (uint32_t) ctx->y[15]       );
+
+    blocks = length >> 4;
+    if( blocks > (size_t)( 0xFFFFFFFFul - low ) )
+        blocks = (size_t)( 0xFFFFFFFFul - low );
+    if( blocks == 0 )
+        return( 0 );
+
+    /* GHASH covers the ciphertext, read it before an in-place decrypt overwrites it */
+    if( ctx->mode == MBEDTLS_GCM_DECRYPT )
+        gcm_ghash_blocks( ctx, input, blocks );
+
+    memcpy( ctr, ctx->y, 12 );
+    ctr[12] = (unsigned char)( ( low + 1 ) >> 24 );
+    ctr[13] = (unsigned char)( ( low + 1 ) >> 16 );
+    ctr[14] = (unsigned char)( ( low + 1 ) >>  8 );
+    ctr[15] = (unsigned char)( ( low + 1 )       );
+
+    mbedtls_aes_crypt_ctr( (mbedtls_aes_context *) ctx->cipher_ctx.cipher_ctx,
+                           blocks << 4, &nc_off, ctr, stream, input, output );
+
+    if( ctx->mode == MBEDTLS_GCM_ENCRYPT )
+        gcm_ghash_blocks( ctx, output, blocks );
+
+    low += (uint32_t) blocks;
+    ctx->y[12] = (unsigned char)( low >> 24 );
+    ctx->y[13] = (unsigned char)( low >> 16 );
+    ctx->y[14] = (unsigned char)( low >>  8 );
+    ctx->y[15] = (unsigned char)( low       );
+
+    mbedtls_platform_zeroize( stream, sizeof( stream ) );
+    return( blocks << 4 );
+}
+#endif /* NUVOTON_ENABLE_AES && MBEDTLS_CIPHER_MODE_CTR */
+
 int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
                 size_t length,
                 const unsigned char *input,
@@ -373,6 +506,16 @@ int mbedtls_gcm_update( mbedtls_gcm_context *ctx,
     p = input;
     while( length > 0 )
     {
+#if defined(NUVOTON_ENABLE_AES) && defined(MBEDTLS_CIPHER_MODE_CTR)
+        if( length >= 16 &&
+            ( use_len = gcm_nvt_crypt_blocks( ctx, length, p, out_p ) ) != 0 )
+        {
+            length -= use_len;
+            p += use_len;
+            out_p += use_len;
+            continue;
+        }
+#endif
         use_len = ( length < 16 ) ? length : 16;
 
         for( i = 16; i > 12; i-- )
@@ -0,0 +1,546 @@
+/*
+ *  Constant-time bitsliced software AES
+ *
+ *  Copyright (C) 2006-2018, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+/*
+ *  The bit plane layout, the S-box circuit of Boyar and Peralta and the
+ *  linear layers follow the "aes_ct" implementation of BearSSL by Thomas
+ *  Pornin (MIT license).
+ *
+ *  http://www.cs.yale.edu/homes/peralta/CircuitStuff/SLP_AES_113.txt
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/nvt_aes_ct.h"
+
+#ifdef NUVOTON_AES_CT
+
+/*
+ * 32-bit integer manipulation macros (little endian)
+ */
+#ifndef GET_UINT32_LE
+#define GET_UINT32_LE(n,b,i)                            \
+{                                                       \
+    (n) = ( (uint32_t) (b)[(i)    ]       )             \
+        | ( (uint32_t) (b)[(i) + 1] <<  8 )             \
+        | ( (uint32_t) (b)[(i) + 2] << 16 )             \
+        | ( (uint32_t) (b)[(i) + 3] << 24 );            \
+}
+#endif
+
+#ifndef PUT_UINT32_LE
+#define PUT_UINT32_LE(n,b,i)                                    \
+{                                                               \
+    (b)[(i)    ] = (unsigned char) ( ( (n)       ) & 0xFF );    \
+    (b)[(i) + 1] = (unsigned char) ( ( (n) >>  8 ) & 0xFF );    \
+    (b)[(i) + 2] = (unsigned char) ( ( (n) >> 16 ) & 0xFF );    \
+    (b)[(i) + 3] = (unsigned char) ( ( (n) >> 24 ) & 0xFF );    \
+}
+#endif
+
+/*
+ * A state of eight words holds two blocks as bit planes: after ortho(),
+ * bit j of byte i of a block is in word j. Words 0, 2, 4, 6 carry the
+ * block that is processed, words 1, 3, 5, 7 a second block which is left
+ * zero. ortho() is its own inverse.
+ */
+#define SWAPN(cl, ch, s, x, y)                          \
+{                                                       \
+    uint32_t a_ = (x), b_ = (y);                        \
+    (x) = ( a_ & (cl) ) | ( ( b_ & (cl) ) << (s) );     \
+    (y) = ( ( a_ & (ch) ) >> (s) ) | ( b_ & (ch) );     \
+}
+
+#define SWAP2(x, y)     SWAPN( 0x55555555, 0xAAAAAAAA, 1, x, y )
+#define SWAP4(x, y)     SWAPN( 0x33333333, 0xCCCCCCCC, 2, x, y )
+#define SWAP8(x, y)     SWAPN( 0x0F0F0F0F, 0xF0F0F0F0, 4, x, y )
+
+static void aes_ct_ortho( uint32_t *q )
+{
+    SWAP2( q[0], q[1] );
+    SWAP2( q[2], q[3] );
+    SWAP2( q[4], q[5] );
+    SWAP2( q[6], q[7] );
+
+    SWAP4( q[0], q[2] );
+    SWAP4( q[1], q[3] );
+    SWAP4( q[4], q[6] );
+    SWAP4( q[5], q[7] );
+
+    SWAP8( q[0], q[4] );
+    SWAP8( q[1], q[5] );
+    SWAP8( q[2], q[6] );
+    SWAP8( q[3], q[7] );
+}
+
+/*
+ * S-box on all 32 bytes of the state: 113 gates, no lookups.
+ */
+static void aes_ct_sbox( uint32_t *q )
+{
+    uint32_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint32_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    uint32_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    uint32_t y20, y21;
+    uint32_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    uint32_t z10, z11, z12, z13, z14, z15, z16, z17;
+    uint32_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    uint32_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    uint32_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    uint32_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    uint32_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    uint32_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    uint32_t t60, t61, t62, t63, t64, t65, t66, t67;
+    uint32_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    /* Top linear transformation */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* Non-linear section */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* Bottom linear transformation */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/*
+ * Inverse S-box: the inverse of the affine map of the S-box around the
+ * forward circuit, which leaves just the field inversion.
+ */
+static void aes_ct_inv_affine( uint32_t *q )
+{
+    uint32_t q0, q1, q2, q3, q4, q5, q6, q7;
+
+    q0 = ~q[0];
+    q1 = ~q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = ~q[5];
+    q6 = ~q[6];
+    q7 = q[7];
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+static void aes_ct_inv_sbox( uint32_t *q )
+{
+    aes_ct_inv_affine( q );
+    aes_ct_sbox( q );
+    aes_ct_inv_affine( q );
+}
+
+static void aes_ct_add_round_key( uint32_t *q, const uint32_t *sk )
+{
+    q[0] ^= sk[0];
+    q[1] ^= sk[1];
+    q[2] ^= sk[2];
+    q[3] ^= sk[3];
+    q[4] ^= sk[4];
+    q[5] ^= sk[5];
+    q[6] ^= sk[6];
+    q[7] ^= sk[7];
+}
+
+static void aes_ct_shift_rows( uint32_t *q )
+{
+    int i;
+    uint32_t x;
+
+    for( i = 0; i < 8; i++ )
+    {
+        x = q[i];
+        q[i] = ( x & 0x000000FF )
+             | ( ( x & 0x0000FC00 ) >> 2 ) | ( ( x & 0x00000300 ) << 6 )
+             | ( ( x & 0x00F00000 ) >> 4 ) | ( ( x & 0x000F0000 ) << 4 )
+             | ( ( x & 0xC0000000 ) >> 6 ) | ( ( x & 0x3F000000 ) << 2 );
+    }
+}
+
+static void aes_ct_inv_shift_rows( uint32_t *q )
+{
+    int i;
+    uint32_t x;
+
+    for( i = 0; i < 8; i++ )
+    {
+        x = q[i];
+        q[i] = ( x & 0x000000FF )
+             | ( ( x & 0x00003F00 ) << 2 ) | ( ( x & 0x0000C000 ) >> 6 )
+             | ( ( x & 0x000F0000 ) << 4 ) | ( ( x & 0x00F00000 ) >> 4 )
+             | ( ( x & 0x03000000 ) << 6 ) | ( ( x & 0xFC000000 ) >> 2 );
+    }
+}
+
+#define ROTR8(x)    ( ( (x) >>  8 ) | ( (x) << 24 ) )
+#define ROTR16(x)   ( ( (x) >> 16 ) | ( (x) << 16 ) )
+
+static void aes_ct_mix_columns( uint32_t *q )
+{
+    uint32_t q0, q1, q2, q3, q4, q5, q6, q7;
+    uint32_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0]; r0 = ROTR8( q0 );
+    q1 = q[1]; r1 = ROTR8( q1 );
+    q2 = q[2]; r2 = ROTR8( q2 );
+    q3 = q[3]; r3 = ROTR8( q3 );
+    q4 = q[4]; r4 = ROTR8( q4 );
+    q5 = q[5]; r5 = ROTR8( q5 );
+    q6 = q[6]; r6 = ROTR8( q6 );
+    q7 = q[7]; r7 = ROTR8( q7 );
+
+    q[0] = q7 ^ r7 ^ r0 ^ ROTR16( q0 ^ r0 );
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ROTR16( q1 ^ r1 );
+    q[2] = q1 ^ r1 ^ r2 ^ ROTR16( q2 ^ r2 );
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ROTR16( q3 ^ r3 );
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ROTR16( q4 ^ r4 );
+    q[5] = q4 ^ r4 ^ r5 ^ ROTR16( q5 ^ r5 );
+    q[6] = q5 ^ r5 ^ r6 ^ ROTR16( q6 ^ r6 );
+    q[7] = q6 ^ r6 ^ r7 ^ ROTR16( q7 ^ r7 );
+}
+
+static void aes_ct_inv_mix_columns( uint32_t *q )
+{
+    uint32_t q0, q1, q2, q3, q4, q5, q6, q7;
+    uint32_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0]; r0 = ROTR8( q0 );
+    q1 = q[1]; r1 = ROTR8( q1 );
+    q2 = q[2]; r2 = ROTR8( q2 );
+    q3 = q[3]; r3 = ROTR8( q3 );
+    q4 = q[4]; r4 = ROTR8( q4 );
+    q5 = q[5]; r5 = ROTR8( q5 );
+    q6 = q[6]; r6 = ROTR8( q6 );
+    q7 = q[7]; r7 = ROTR8( q7 );
+
+    q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ ROTR16( q0 ^ q5 ^ q6 ^ r0 ^ r5 );
+    q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ ROTR16( q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6 );
+    q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ ROTR16( q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7 );
+    q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5
+         ^ ROTR16( q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7 );
+    q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7
+         ^ ROTR16( q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6 );
+    q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7
+         ^ ROTR16( q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7 );
+    q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7
+         ^ ROTR16( q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7 );
+    q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ ROTR16( q4 ^ q5 ^ q7 ^ r4 ^ r7 );
+}
+
+/*
+ * S-box on the four bytes of a key schedule word
+ */
+static uint32_t aes_ct_sub_word( uint32_t x )
+{
+    uint32_t q[8];
+    int i;
+
+    for( i = 0; i < 8; i++ )
+        q[i] = x;
+    aes_ct_ortho( q );
+    aes_ct_sbox( q );
+    aes_ct_ortho( q );
+
+    return( q[0] );
+}
+
+static const unsigned char RCON[10] =
+{
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+};
+
+/*
+ * Round key i is bitsliced like a state holding it twice. Both copies are
+ * the same, so every even bit of the second copy and every odd bit of the
+ * first are dropped, which halves the round keys to 4 words each.
+ */
+void nvt_aes_ct_setkey( uint32_t *rk, int nr )
+{
+    uint32_t skey[2 * NVT_AES_CT_RK_WORDS];
+    uint32_t tmp;
+    int i, j, k, nk, nkf;
+
+    nk = nr - 6;
+    nkf = ( nr + 1 ) << 2;
+
+    for( i = 0; i < nk; i++ )
+    {
+        tmp = rk[i];
+        skey[( i << 1 )    ] = tmp;
+        skey[( i << 1 ) + 1] = tmp;
+    }
+
+    for( i = nk, j = 0, k = 0; i < nkf; i++ )
+    {
+        if( j == 0 )
+        {
+            tmp = ( tmp << 24 ) | ( tmp >> 8 );
+            tmp = aes_ct_sub_word( tmp ) ^ RCON[k];
+        }
+        else if( nk > 6 && j == 4 )
+        {
+            tmp = aes_ct_sub_word( tmp );
+        }
+        tmp ^= skey[( i - nk ) << 1];
+        skey[( i << 1 )    ] = tmp;
+        skey[( i << 1 ) + 1] = tmp;
+        if( ++j == nk )
+        {
+            j = 0;
+            k++;
+        }
+    }
+
+    for( i = 0; i < nkf; i += 4 )
+        aes_ct_ortho( skey + ( i << 1 ) );
+
+    for( i = 0, j = 0; i < nkf; i++, j += 2 )
+        rk[i] = ( skey[j] & 0x55555555 ) | ( skey[j + 1] & 0xAAAAAAAA );
+}
+
+static void aes_ct_skey_expand( uint32_t *skey, const uint32_t *rk, int nr )
+{
+    int i, n;
+    uint32_t x, y;
+
+    n = ( nr + 1 ) << 2;
+    for( i = 0; i < n; i++, skey += 2 )
+    {
+        x = rk[i] & 0x55555555;
+        y = rk[i] & 0xAAAAAAAA;
+        skey[0] = x | ( x << 1 );
+        skey[1] = y | ( y >> 1 );
+    }
+}
+
+static void aes_ct_load( uint32_t *q, const unsigned char input[16] )
+{
+    GET_UINT32_LE( q[0], input,  0 );
+    GET_UINT32_LE( q[2], input,  4 );
+    GET_UINT32_LE( q[4], input,  8 );
+    GET_UINT32_LE( q[6], input, 12 );
+    q[1] = q[3] = q[5] = q[7] = 0;
+    aes_ct_ortho( q );
+}
+
+static void aes_ct_store( uint32_t *q, unsigned char output[16] )
+{
+    aes_ct_ortho( q );
+    PUT_UINT32_LE( q[0], output,  0 );
+    PUT_UINT32_LE( q[2], output,  4 );
+    PUT_UINT32_LE( q[4], output,  8 );
+    PUT_UINT32_LE( q[6], output, 12 );
+}
+
+void nvt_aes_ct_encrypt( const uint32_t *rk, int nr,
+                         const unsigned char input[16],
+                         unsigned char output[16] )
+{
+    uint32_t skey[2 * NVT_AES_CT_RK_WORDS];
+    uint32_t q[8];
+    int i;
+
+    aes_ct_skey_expand( skey, rk, nr );
+    aes_ct_load( q, input );
+
+    aes_ct_add_round_key( q, skey );
+    for( i = 1; i < nr; i++ )
+    {
+        aes_ct_sbox( q );
+        aes_ct_shift_rows( q );
+        aes_ct_mix_columns( q );
+        aes_ct_add_round_key( q, skey + ( i << 3 ) );
+    }
+    aes_ct_sbox( q );
+    aes_ct_shift_rows( q );
+    aes_ct_add_round_key( q, skey + ( nr << 3 ) );
+
+    aes_ct_store( q, output );
+}
+
+void nvt_aes_ct_decrypt( const uint32_t *rk, int nr,
+                         const unsigned char input[16],
+                         unsigned char output[16] )
+{
+    uint32_t skey[2 * NVT_AES_CT_RK_WORDS];
+    uint32_t q[8];
+    int i;
+
+    aes_ct_skey_expand( skey, rk, nr );
+    aes_ct_load( q, input );
+
+    aes_ct_add_round_key( q, skey + ( nr << 3 ) );
+    for( i = nr - 1; i > 0; i-- )
+    {
+        aes_ct_inv_shift_rows( q );
+        aes_ct_inv_sbox( q );
+        aes_ct_add_round_key( q, skey + ( i << 3 ) );
+        aes_ct_inv_mix_columns( q );
+    }
+    aes_ct_inv_shift_rows( q );
+    aes_ct_inv_sbox( q );
+    aes_ct_add_round_key( q, skey );
+
+    aes_ct_store( q, output );
+}
+
+#endif /* NUVOTON_AES_CT */
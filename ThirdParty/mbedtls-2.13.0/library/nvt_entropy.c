@@ -0,0 +1,191 @@
+/*
+ *  Hardware entropy source on the NUC980 crypto engine PRNG
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/nvt_entropy.h"
+
+#ifdef NUVOTON_ENABLE_PRNG
+
+#include <string.h>
+#include "mbedtls/entropy.h"
+#include "mbedtls/entropy_poll.h"
+#include "mbedtls/platform_util.h"
+
+/* One 256-bit PRNG key per generation */
+#define NVT_PRNG_BLOCK          32
+
+#if ( NVT_ENTROPY_POOL_SIZE & ( NVT_ENTROPY_POOL_SIZE - 1 ) ) || \
+    ( NVT_ENTROPY_POOL_SIZE % NVT_PRNG_BLOCK )
+#error "NVT_ENTROPY_POOL_SIZE must be a power of two and a multiple of 32"
+#endif
+
+/*
+ * Ring of pre-generated output. The producer, nvt_entropy_step(), only
+ * moves head and the consumer, mbedtls_hardware_poll(), only moves tail.
+ * Producers are serialized by masking the PRNG interrupt in task context.
+ */
+static uint8_t           nvt_pool[NVT_ENTROPY_POOL_SIZE];
+static volatile uint32_t nvt_head, nvt_tail;
+static volatile int      nvt_ready;         /* nvt_entropy_init() was called   */
+static volatile int      nvt_running;       /* a PRNG generation is in flight  */
+static volatile int      nvt_reseed;        /* load nvt_seed before the next one */
+static volatile uint32_t nvt_seed;
+
+static void nvt_entropy_step( void )
+{
+    uint32_t   key[NVT_PRNG_BLOCK / 4];
+
+    if( nvt_running )
+    {
+        if( CRPT->PRNG_CTL & CRPT_PRNG_CTL_BUSY_Msk )
+            return;
+
+        /* A generation is only started with room for its output */
+        PRNG_Read( CRPT, key );
+        memcpy( &nvt_pool[nvt_head & ( NVT_ENTROPY_POOL_SIZE - 1 )], key, NVT_PRNG_BLOCK );
+        mbedtls_platform_zeroize( key, sizeof( key ) );
+        nvt_head += NVT_PRNG_BLOCK;
+        nvt_running = 0;
+    }
+
+    if( NVT_ENTROPY_POOL_SIZE - ( nvt_head - nvt_tail ) >= NVT_PRNG_BLOCK )
+    {
+        if( nvt_reseed )
+        {
+            nvt_reseed = 0;
+            PRNG_Open( CRPT, PRNG_KEY_SIZE_256, PRNG_SEED_RELOAD, nvt_seed );
+        }
+        nvt_running = 1;
+        PRNG_Start( CRPT );
+    }
+}
+
+/*
+ * Step from task context. The caller holds the engine lock.
+ */
+static void nvt_entropy_step_task( void )
+{
+    uint32_t   irq = CRPT->INTEN & CRPT_INTEN_PRNGIEN_Msk;
+
+    PRNG_DISABLE_INT( CRPT );
+    nvt_entropy_step();
+    CRPT->INTEN |= irq;
+}
+
+void nvt_entropy_init( uint32_t seed, int use_irq )
+{
+    NVT_CRYPTO_LOCK();
+    PRNG_DISABLE_INT( CRPT );
+    while( CRPT->PRNG_CTL & CRPT_PRNG_CTL_BUSY_Msk );
+    PRNG_CLR_INT_FLAG( CRPT );
+
+    nvt_head = nvt_tail = 0;
+    nvt_running = 0;
+    nvt_reseed = 1;
+    nvt_seed = seed;
+    nvt_ready = 1;
+
+    nvt_entropy_step();
+    if( use_irq )
+        PRNG_ENABLE_INT( CRPT );
+    NVT_CRYPTO_UNLOCK();
+}
+
+void nvt_entropy_reseed( uint32_t seed )
+{
+    uint32_t   irq;
+
+    NVT_CRYPTO_LOCK();
+    irq = CRPT->INTEN & CRPT_INTEN_PRNGIEN_Msk;
+    PRNG_DISABLE_INT( CRPT );
+    nvt_seed = seed;
+    nvt_reseed = 1;
+    CRPT->INTEN |= irq;
+    NVT_CRYPTO_UNLOCK();
+}
+
+void nvt_entropy_refill( void )
+{
+    /* Called from idle hooks, so skip the step rather than wait for the engine */
+    if( nvt_ready && NVT_CRYPTO_TRYLOCK() )
+    {
+        nvt_entropy_step_task();
+        NVT_CRYPTO_UNLOCK();
+    }
+}
+
+void nvt_entropy_irq_handler( void )
+{
+    if( PRNG_GET_INT_FLAG( CRPT ) )
+    {
+        PRNG_CLR_INT_FLAG( CRPT );
+        if( nvt_ready )
+            nvt_entropy_step();
+    }
+}
+
+size_t nvt_entropy_available( void )
+{
+    return( nvt_head - nvt_tail );
+}
+
+int mbedtls_hardware_poll( void *data, unsigned char *output,
+                           size_t len, size_t *olen )
+{
+    size_t     n;
+
+    (void) data;
+
+    /* Nothing to guess a seed from, the application must supply one */
+    if( !nvt_ready )
+    {
+        *olen = 0;
+        return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+    }
+
+    NVT_CRYPTO_LOCK();
+
+    /* Only waits for the block in flight when the pool ran dry */
+    do
+        nvt_entropy_step_task();
+    while( nvt_head == nvt_tail );
+
+    for( n = 0; n < len && nvt_head != nvt_tail; n++ )
+    {
+        output[n] = nvt_pool[nvt_tail & ( NVT_ENTROPY_POOL_SIZE - 1 )];
+        nvt_pool[nvt_tail & ( NVT_ENTROPY_POOL_SIZE - 1 )] = 0;
+        nvt_tail++;
+    }
+
+    /* Start refilling what was taken */
+    nvt_entropy_step_task();
+    NVT_CRYPTO_UNLOCK();
+
+    *olen = n;
+    return( 0 );
+}
+
+#endif /* NUVOTON_ENABLE_PRNG */
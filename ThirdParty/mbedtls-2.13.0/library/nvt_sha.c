@@ -0,0 +1,220 @@
+/*
+ *  Streaming SHA-1/SHA-2 on the NUC980 crypto engine
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/nvt_sha.h"
+
+#ifdef NUVOTON_ENABLE_SHA
+
+#include <string.h>
+
+/*
+ * Bounce buffer for unaligned input and for short transfers, where a copy
+ * is cheaper than flushing the D-cache. A multiple of the largest block.
+ */
+#define NVT_SHA_BOUNCE_SIZE     1024
+
+static uint8_t sha_dma_buff[NVT_SHA_BOUNCE_SIZE] __attribute__((aligned (32)));
+
+/* The context streaming through the engine, NULL when the engine is free */
+static const void *nvt_sha_owner;
+
+/*
+ * Run one DMA transfer and wait for it. The finish flag is polled so that
+ * this works with or without an application CRYPTO interrupt handler; one
+ * that clears the flag sets g_Crypto_Int_done instead.
+ */
+static int nvt_sha_run( uint32_t dma_mode, const void *src, size_t length )
+{
+    g_Crypto_Int_done = 0;
+
+    SHA_SetDMATransfer( CRPT, (uint32_t)src, length );
+    SHA_Start( CRPT, dma_mode );
+
+    while( g_Crypto_Int_done == 0 &&
+           ( CRPT->INTSTS & ( CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk ) ) == 0 );
+    CRPT->INTSTS = ( CRPT_INTSTS_HMACIF_Msk | CRPT_INTSTS_HMACEIF_Msk );
+
+    return( ( CRPT->HMAC_STS & CRPT_HMAC_STS_DMAERR_Msk ) ? -1 : 0 );
+}
+
+/*
+ * Send length bytes as part of the cascade. Every transfer but the last
+ * one of a message must be a multiple of the block size.
+ */
+static int nvt_sha_feed( mbedtls_nvt_sha_state *st, const unsigned char *input,
+                         size_t length, int last )
+{
+    uint32_t   dma_mode;
+    size_t     len;
+
+    if( ( ( (uint32_t)input & 0x3 ) == 0 ) &&
+        ( ( (uint32_t)input & 0x80000000 ) || length > NVT_SHA_BOUNCE_SIZE ) )
+    {
+        /* The engine only reads, so cleaning the cache is enough and safe */
+        if( ( ( (uint32_t)input & 0x80000000 ) == 0 ) && sysGetCacheState() )
+            sysFlushCache( D_CACHE );
+
+        if( st->started )
+            dma_mode = last ? CRYPTO_DMA_LAST : CRYPTO_DMA_CONTINUE;
+        else
+            dma_mode = last ? CRYPTO_DMA_ONE_SHOT : CRYPTO_DMA_FIRST;
+        st->started = 1;
+        return( nvt_sha_run( dma_mode, input, length ) );
+    }
+
+    while( length > 0 )
+    {
+        len = ( length < NVT_SHA_BOUNCE_SIZE ) ? length : NVT_SHA_BOUNCE_SIZE;
+        memcpy( (uint8_t *)((uint32_t)sha_dma_buff | 0x80000000), input, len );
+
+        if( st->started )
+            dma_mode = ( last && len == length ) ? CRYPTO_DMA_LAST : CRYPTO_DMA_CONTINUE;
+        else
+            dma_mode = ( last && len == length ) ? CRYPTO_DMA_ONE_SHOT : CRYPTO_DMA_FIRST;
+        st->started = 1;
+        if( nvt_sha_run( dma_mode, sha_dma_buff, len ) != 0 )
+            return( -1 );
+
+        input  += len;
+        length -= len;
+    }
+    return( 0 );
+}
+
+int nvt_sha_hw_start( mbedtls_nvt_sha_state *st, const void *owner,
+                      uint32_t opmode, size_t pending )
+{
+    if( st->keep_sw || !NVT_CRYPTO_TRYLOCK() )
+        return( -1 );
+    if( nvt_sha_owner != NULL )
+    {
+        NVT_CRYPTO_UNLOCK();
+        return( -1 );
+    }
+    nvt_sha_owner = owner;
+
+    SHA_Open( CRPT, opmode, SHA_IN_SWAP, 0 );
+
+    st->hw = 1;
+    st->started = 0;
+    st->pending = pending;
+    st->held = 0;
+    return( 0 );
+}
+
+int nvt_sha_hw_update( mbedtls_nvt_sha_state *st, const void *owner,
+                       unsigned char *buffer, size_t block_size,
+                       const unsigned char *input, size_t ilen )
+{
+    size_t     fill, n;
+
+    if( nvt_sha_owner != owner )
+        return( -1 );
+
+    if( st->pending + ilen <= block_size )
+    {
+        memcpy( buffer + st->pending, input, ilen );
+        st->pending += ilen;
+        return( 0 );
+    }
+
+    if( st->pending )
+    {
+        fill = block_size - st->pending;
+        memcpy( buffer + st->pending, input, fill );
+        if( nvt_sha_feed( st, buffer, block_size, 0 ) != 0 )
+            return( -1 );
+        input += fill;
+        ilen  -= fill;
+    }
+
+    /* Keep 1 to block_size bytes back for the last transfer */
+    n = ( ( ilen - 1 ) / block_size ) * block_size;
+    if( n > 0 )
+    {
+        if( nvt_sha_feed( st, input, n, 0 ) != 0 )
+            return( -1 );
+        input += n;
+        ilen  -= n;
+    }
+
+    memcpy( buffer, input, ilen );
+    st->pending = ilen;
+    return( 0 );
+}
+
+int nvt_sha_hw_finish( mbedtls_nvt_sha_state *st, const void *owner,
+                       const unsigned char *buffer,
+                       unsigned char *output, size_t olen )
+{
+    int        ret;
+    size_t     i;
+    uint32_t   *digest = (uint32_t *)&CRPT->HMAC_DGST[0];
+
+    if( nvt_sha_owner != owner )
+        return( -1 );
+
+    ret = nvt_sha_feed( st, buffer, st->pending, 1 );
+    if( ret == 0 )
+    {
+        st->started = 0;
+        for( i = 0; i < olen; i += 4, output += 4, digest++ )
+        {
+            output[0] = (*digest>>24) & 0xff;
+            output[1] = (*digest>>16) & 0xff;
+            output[2] = (*digest>>8) & 0xff;
+            output[3] = *digest & 0xff;
+        }
+    }
+
+    nvt_sha_hw_release( st, owner );
+    return( ret );
+}
+
+void nvt_sha_hw_release( mbedtls_nvt_sha_state *st, const void *owner )
+{
+    if( st->hw && nvt_sha_owner == owner )
+    {
+        /* Abandoned in the middle of a cascade */
+        if( st->started )
+            CRPT->HMAC_CTL = CRPT_HMAC_CTL_STOP_Msk;
+        nvt_sha_owner = NULL;
+        NVT_CRYPTO_UNLOCK();
+    }
+
+    st->hw = 0;
+    st->started = 0;
+    st->pending = 0;
+    st->held = 0;
+}
+
+void nvt_sha_keep_sw( mbedtls_nvt_sha_state *st )
+{
+    st->keep_sw = 1;
+}
+
+#endif /* NUVOTON_ENABLE_SHA */
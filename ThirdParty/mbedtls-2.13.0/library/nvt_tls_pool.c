@@ -0,0 +1,394 @@
+/*
+ *  Size-class memory pool for mbedtls TLS sessions
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/nvt_tls_pool.h"
+
+#ifdef NUVOTON_ENABLE_TLS_POOL
+
+#include <string.h>
+
+#if defined(MBEDTLS_PLATFORM_C)
+#include "mbedtls/platform.h"
+#else
+#include <stdio.h>
+#define mbedtls_printf     printf
+#endif
+
+#if !defined(NVT_TLS_POOL_RECORD_SIZE)
+#if defined(MBEDTLS_SSL_TLS_C)
+#include "mbedtls/ssl_internal.h"
+#define NVT_TLS_POOL_RECORD_SIZE                                    \
+    ( ( ( MBEDTLS_SSL_IN_BUFFER_LEN > MBEDTLS_SSL_OUT_BUFFER_LEN ?  \
+          MBEDTLS_SSL_IN_BUFFER_LEN : MBEDTLS_SSL_OUT_BUFFER_LEN ) + 7 ) & ~7 )
+#else
+#define NVT_TLS_POOL_RECORD_SIZE    16384
+#endif
+#endif
+
+#ifndef NVT_TLS_POOL_ENTER
+#define NVT_TLS_POOL_ENTER()
+#define NVT_TLS_POOL_EXIT()
+#endif
+
+#ifndef NVT_TLS_POOL_OWNER
+#define NVT_TLS_POOL_OWNER()        ( nvt_pool_owner )
+#endif
+
+#define NVT_BLOCK_USED              0x5AA5
+#define NVT_BLOCK_FREE              0xA55A
+
+/* In front of every block. The payload of a free block links the free list. */
+typedef struct
+{
+    uint16_t magic;
+    uint8_t  cls;
+    uint8_t  owner;
+    uint32_t len;
+}
+nvt_block_hdr;
+
+typedef struct
+{
+    uint8_t *base;
+    uint8_t *end;
+    size_t stride;
+    void *free_list;
+    nvt_tls_pool_class_stats st;
+}
+nvt_pool_class;
+
+static const size_t nvt_class_size[NVT_TLS_POOL_CLASSES] =
+{
+    32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, NVT_TLS_POOL_RECORD_SIZE
+};
+
+static const size_t nvt_class_count[NVT_TLS_POOL_CLASSES] =
+{
+    NVT_TLS_POOL_COUNT_32, NVT_TLS_POOL_COUNT_64, NVT_TLS_POOL_COUNT_128,
+    NVT_TLS_POOL_COUNT_256, NVT_TLS_POOL_COUNT_512, NVT_TLS_POOL_COUNT_1K,
+    NVT_TLS_POOL_COUNT_2K, NVT_TLS_POOL_COUNT_4K, NVT_TLS_POOL_COUNT_8K,
+    NVT_TLS_POOL_COUNT_RECORD
+};
+
+static nvt_pool_class nvt_class[NVT_TLS_POOL_CLASSES];
+
+/* Slot 0 is unowned memory */
+static nvt_tls_pool_owner_stats nvt_owner[NVT_TLS_POOL_MAX_OWNERS + 1];
+
+static const void *nvt_pool_owner;
+static uint8_t *nvt_pool_start, *nvt_pool_end;
+static size_t nvt_pool_in_use, nvt_pool_peak, nvt_pool_bad_free;
+
+static int nvt_owner_slot( const void *owner )
+{
+    int        i, empty = 0;
+
+    if( owner == NULL )
+        return( 0 );
+
+    for( i = 1; i <= NVT_TLS_POOL_MAX_OWNERS; i++ )
+    {
+        if( nvt_owner[i].owner == owner )
+            return( i );
+        if( nvt_owner[i].owner == NULL && empty == 0 )
+            empty = i;
+    }
+
+    if( empty )
+    {
+        memset( &nvt_owner[empty], 0, sizeof( nvt_owner[empty] ) );
+        nvt_owner[empty].owner = owner;
+    }
+    return( empty );
+}
+
+size_t nvt_tls_pool_size( void )
+{
+    size_t     i, len = 0;
+
+    for( i = 0; i < NVT_TLS_POOL_CLASSES; i++ )
+        len += ( sizeof( nvt_block_hdr ) + nvt_class_size[i] ) * nvt_class_count[i];
+    return( len );
+}
+
+int nvt_tls_pool_init( void *buf, size_t len )
+{
+    uint8_t    *p = (uint8_t *)buf;
+    size_t     i, j;
+
+    if( buf == NULL || ( (uint32_t)buf & 0x7 ) || len < nvt_tls_pool_size() )
+        return( -1 );
+
+    memset( nvt_class, 0, sizeof( nvt_class ) );
+    memset( nvt_owner, 0, sizeof( nvt_owner ) );
+    nvt_pool_in_use = nvt_pool_peak = nvt_pool_bad_free = 0;
+    nvt_pool_start = p;
+
+    for( i = 0; i < NVT_TLS_POOL_CLASSES; i++ )
+    {
+        nvt_pool_class *c = &nvt_class[i];
+
+        c->stride = sizeof( nvt_block_hdr ) + nvt_class_size[i];
+        c->base = p;
+        c->end = p + c->stride * nvt_class_count[i];
+        c->st.block_size = nvt_class_size[i];
+        c->st.total = nvt_class_count[i];
+
+        /* Lowest addresses are handed out first */
+        for( j = nvt_class_count[i]; j > 0; j-- )
+        {
+            nvt_block_hdr *hdr = (nvt_block_hdr *)( p + c->stride * ( j - 1 ) );
+
+            hdr->magic = NVT_BLOCK_FREE;
+            hdr->cls = i;
+            hdr->owner = 0;
+            hdr->len = 0;
+            *(void **)( hdr + 1 ) = c->free_list;
+            c->free_list = hdr + 1;
+        }
+        p = c->end;
+    }
+
+    nvt_pool_end = p;
+    return( 0 );
+}
+
+void *nvt_tls_pool_calloc( size_t n, size_t size )
+{
+    nvt_block_hdr *hdr;
+    void       *ptr = NULL;
+    size_t     len, i, k;
+    int        o;
+
+    if( n == 0 || size == 0 || n > (size_t)-1 / size )
+        return( NULL );
+    len = n * size;
+
+    NVT_TLS_POOL_ENTER();
+
+    o = nvt_owner_slot( NVT_TLS_POOL_OWNER() );
+
+    for( i = 0; i < NVT_TLS_POOL_CLASSES && nvt_class_size[i] < len; i++ );
+
+    for( k = i; k < NVT_TLS_POOL_CLASSES && k <= i + NVT_TLS_POOL_SPILL; k++ )
+    {
+        if( nvt_class[k].free_list != NULL )
+        {
+            ptr = nvt_class[k].free_list;
+            nvt_class[k].free_list = *(void **)ptr;
+            break;
+        }
+    }
+
+    if( ptr == NULL )
+    {
+        if( i < NVT_TLS_POOL_CLASSES )
+            nvt_class[i].st.failed++;
+        nvt_owner[o].failed++;
+        NVT_TLS_POOL_EXIT();
+        return( NULL );
+    }
+
+    if( k != i )
+        nvt_class[i].st.spilled++;
+
+    hdr = (nvt_block_hdr *)ptr - 1;
+    hdr->magic = NVT_BLOCK_USED;
+    hdr->owner = o;
+    hdr->len = len;
+
+    nvt_class[k].st.requested += len;
+    if( ++nvt_class[k].st.used > nvt_class[k].st.peak )
+        nvt_class[k].st.peak = nvt_class[k].st.used;
+
+    nvt_owner[o].blocks++;
+    nvt_owner[o].bytes += nvt_class_size[k];
+    if( nvt_owner[o].bytes > nvt_owner[o].peak )
+        nvt_owner[o].peak = nvt_owner[o].bytes;
+
+    nvt_pool_in_use += nvt_class_size[k];
+    if( nvt_pool_in_use > nvt_pool_peak )
+        nvt_pool_peak = nvt_pool_in_use;
+
+    NVT_TLS_POOL_EXIT();
+
+    memset( ptr, 0, len );
+    return( ptr );
+}
+
+void nvt_tls_pool_free( void *ptr )
+{
+    nvt_block_hdr *hdr;
+    nvt_pool_class *c;
+
+    if( ptr == NULL )
+        return;
+
+    NVT_TLS_POOL_ENTER();
+
+    hdr = (nvt_block_hdr *)ptr - 1;
+    if( (uint8_t *)ptr < nvt_pool_start || (uint8_t *)ptr >= nvt_pool_end ||
+        hdr->magic != NVT_BLOCK_USED || hdr->cls >= NVT_TLS_POOL_CLASSES ||
+        ( (uint8_t *)hdr - nvt_class[hdr->cls].base ) % nvt_class[hdr->cls].stride )
+    {
+        nvt_pool_bad_free++;
+        NVT_TLS_POOL_EXIT();
+        return;
+    }
+
+    c = &nvt_class[hdr->cls];
+    c->st.used--;
+    c->st.requested -= hdr->len;
+
+    nvt_owner[hdr->owner].blocks--;
+    nvt_owner[hdr->owner].bytes -= c->st.block_size;
+    nvt_pool_in_use -= c->st.block_size;
+
+    hdr->magic = NVT_BLOCK_FREE;
+    *(void **)ptr = c->free_list;
+    c->free_list = ptr;
+
+    NVT_TLS_POOL_EXIT();
+}
+
+void nvt_tls_pool_set_owner( const void *owner )
+{
+    nvt_pool_owner = owner;
+}
+
+void nvt_tls_pool_release_owner( const void *owner )
+{
+    nvt_block_hdr *hdr;
+    uint8_t    *p;
+    size_t     i;
+    int        o;
+
+    if( owner == NULL )
+        return;
+
+    NVT_TLS_POOL_ENTER();
+
+    for( o = 1; o <= NVT_TLS_POOL_MAX_OWNERS && nvt_owner[o].owner != owner; o++ );
+    if( o > NVT_TLS_POOL_MAX_OWNERS )
+    {
+        NVT_TLS_POOL_EXIT();
+        return;
+    }
+
+    /* Leaked blocks must not be charged to the next owner of the slot */
+    if( nvt_owner[o].blocks )
+    {
+        for( i = 0; i < NVT_TLS_POOL_CLASSES; i++ )
+        {
+            for( p = nvt_class[i].base; p < nvt_class[i].end; p += nvt_class[i].stride )
+            {
+                hdr = (nvt_block_hdr *)p;
+                if( hdr->magic == NVT_BLOCK_USED && hdr->owner == o )
+                    hdr->owner = 0;
+            }
+        }
+        nvt_owner[0].blocks += nvt_owner[o].blocks;
+        nvt_owner[0].bytes += nvt_owner[o].bytes;
+        if( nvt_owner[0].bytes > nvt_owner[0].peak )
+            nvt_owner[0].peak = nvt_owner[0].bytes;
+    }
+
+    memset( &nvt_owner[o], 0, sizeof( nvt_owner[o] ) );
+    if( nvt_pool_owner == owner )
+        nvt_pool_owner = NULL;
+
+    NVT_TLS_POOL_EXIT();
+}
+
+int nvt_tls_pool_class_info( int idx, nvt_tls_pool_class_stats *stats )
+{
+    if( idx < 0 || idx >= NVT_TLS_POOL_CLASSES )
+        return( -1 );
+
+    NVT_TLS_POOL_ENTER();
+    *stats = nvt_class[idx].st;
+    NVT_TLS_POOL_EXIT();
+    return( 0 );
+}
+
+int nvt_tls_pool_owner_info( const void *owner, nvt_tls_pool_owner_stats *stats )
+{
+    int        o;
+
+    NVT_TLS_POOL_ENTER();
+    for( o = 0; o <= NVT_TLS_POOL_MAX_OWNERS; o++ )
+    {
+        if( nvt_owner[o].owner == owner && ( o == 0 || owner != NULL ) )
+        {
+            *stats = nvt_owner[o];
+            NVT_TLS_POOL_EXIT();
+            return( 0 );
+        }
+    }
+    NVT_TLS_POOL_EXIT();
+    return( -1 );
+}
+
+void nvt_tls_pool_report( void )
+{
+    nvt_tls_pool_class_stats st;
+    nvt_tls_pool_owner_stats ow;
+    size_t     waste = 0;
+    int        i;
+
+    mbedtls_printf( "TLS pool: %u bytes, in use %u, peak %u, bad frees %u\n",
+                    (unsigned)( nvt_pool_end - nvt_pool_start ),
+                    (unsigned)nvt_pool_in_use, (unsigned)nvt_pool_peak,
+                    (unsigned)nvt_pool_bad_free );
+    mbedtls_printf( "  block  total   used   peak  waste  spill   fail\n" );
+    for( i = 0; i < NVT_TLS_POOL_CLASSES; i++ )
+    {
+        nvt_tls_pool_class_info( i, &st );
+        mbedtls_printf( "  %5u  %5u  %5u  %5u  %5u  %5u  %5u\n",
+                        (unsigned)st.block_size, (unsigned)st.total,
+                        (unsigned)st.used, (unsigned)st.peak,
+                        (unsigned)( st.used * st.block_size - st.requested ),
+                        (unsigned)st.spilled, (unsigned)st.failed );
+        waste += st.used * st.block_size - st.requested;
+    }
+    mbedtls_printf( "  unused bytes inside allocated blocks: %u\n", (unsigned)waste );
+
+    mbedtls_printf( "  owner       bytes   peak blocks   fail\n" );
+    for( i = 0; i <= NVT_TLS_POOL_MAX_OWNERS; i++ )
+    {
+        NVT_TLS_POOL_ENTER();
+        ow = nvt_owner[i];
+        NVT_TLS_POOL_EXIT();
+        if( i != 0 && ow.owner == NULL )
+            continue;
+        mbedtls_printf( "  %08x %7u %7u %6u %6u\n", (unsigned)(uint32_t)ow.owner,
+                        (unsigned)ow.bytes, (unsigned)ow.peak,
+                        (unsigned)ow.blocks, (unsigned)ow.failed );
+    }
+}
+
+#endif /* NUVOTON_ENABLE_TLS_POOL */
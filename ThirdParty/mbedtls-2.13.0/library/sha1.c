@@ -81,12 +81,20 @@ void mbedtls_sha1_free( mbedtls_sha1_context *ctx )
     if( ctx == NULL )
         return;
 
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_hw_release( &ctx->nvt, ctx );
+#endif
+
     mbedtls_platform_zeroize( ctx, sizeof( mbedtls_sha1_context ) );
 }
 
 void mbedtls_sha1_clone( mbedtls_sha1_context *dst,
                          const mbedtls_sha1_context *src )
 {
+#ifdef NUVOTON_ENABLE_SHA
+    /* A copy of an engine context cannot be continued, see nvt_sha_keep_sw() */
+    nvt_sha_hw_release( &dst->nvt, dst );
+#endif
     *dst = *src;
 }
 
@@ -95,6 +103,10 @@ void mbedtls_sha1_clone( mbedtls_sha1_context *dst,
  */
 int mbedtls_sha1_starts_ret( mbedtls_sha1_context *ctx )
 {
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_hw_release( &ctx->nvt, ctx );
+#endif
+
     ctx->total[0] = 0;
     ctx->total[1] = 0;
 
@@ -283,6 +295,51 @@ void mbedtls_sha1_process( mbedtls_sha1_context *ctx,
 #endif
 #endif /* !MBEDTLS_SHA1_PROCESS_ALT */
 
+#ifdef NUVOTON_ENABLE_SHA
+/*
+ * Offer an update to the crypto engine. Returns 1 if the data has been
+ * taken, 0 to hash it in software, or an error code.
+ */
+static int nvt_sha1_update( mbedtls_sha1_context *ctx,
+                            const unsigned char *input, size_t ilen )
+{
+    int ret;
+
+    /* Only while nothing has been compressed yet */
+    if( ctx->nvt.hw == 0 && ilen >= NVT_SHA_HW_THRESHOLD &&
+        ctx->total[1] == 0 && ( ctx->total[0] < 64 || ctx->nvt.held ) )
+    {
+        nvt_sha_hw_start( &ctx->nvt, ctx, SHA_MODE_SHA1,
+                          (size_t) ctx->total[0] );
+    }
+
+    if( ctx->nvt.hw )
+    {
+        if( nvt_sha_hw_update( &ctx->nvt, ctx, ctx->buffer, 64, input, ilen ) != 0 )
+            return( MBEDTLS_ERR_SHA1_HW_ACCEL_FAILED );
+        return( 1 );
+    }
+
+    if( ctx->nvt.held )
+    {
+        ctx->nvt.held = 0;
+        if( ( ret = mbedtls_internal_sha1_process( ctx, ctx->buffer ) ) != 0 )
+            return( ret );
+    }
+    else if( ctx->total[0] == 0 && ctx->total[1] == 0 && ilen == 64 )
+    {
+        /* Keep a lone first block, e.g. the HMAC inner pad, in case
+           a large update follows */
+        memcpy( ctx->buffer, input, 64 );
+        ctx->total[0] = 64;
+        ctx->nvt.held = 1;
+        return( 1 );
+    }
+
+    return( 0 );
+}
+#endif
+
 /*
  * SHA-1 process buffer
  */
@@ -297,6 +354,11 @@ int mbedtls_sha1_update_ret( mbedtls_sha1_context *ctx,
     if( ilen == 0 )
         return( 0 );
 
+#ifdef NUVOTON_ENABLE_SHA
+    if( ( ret = nvt_sha1_update( ctx, input, ilen ) ) != 0 )
+        return( ret < 0 ? ret : 0 );
+#endif
+
     left = ctx->total[0] & 0x3F;
     fill = 64 - left;
 
@@ -352,6 +414,22 @@ int mbedtls_sha1_finish_ret( mbedtls_sha1_context *ctx,
     uint32_t used;
     uint32_t high, low;
 
+#ifdef NUVOTON_ENABLE_SHA
+    if( ctx->nvt.hw )
+    {
+        if( nvt_sha_hw_finish( &ctx->nvt, ctx, ctx->buffer, output,
+                               20 ) != 0 )
+            return( MBEDTLS_ERR_SHA1_HW_ACCEL_FAILED );
+        return( 0 );
+    }
+    if( ctx->nvt.held )
+    {
+        ctx->nvt.held = 0;
+        if( ( ret = mbedtls_internal_sha1_process( ctx, ctx->buffer ) ) != 0 )
+            return( ret );
+    }
+#endif
+
     /*
      * Add padding: 0x80 then 0x00 until 8 bytes remain for the length
      */
@@ -437,59 +515,12 @@ exit:
     return( ret );
 }
 
-#ifdef NUVOTON_ENABLE_SHA
-static void mbedtls_sha1_nuvoton( const unsigned char *input, size_t ilen, unsigned char output[20] )
-{
-    int        i;
-    uint8_t    remain[4] = {0,0,0,0};
-    uint32_t   *digest = (uint32_t *)&CRPT->HMAC_DGST[0];
-
-	g_Crypto_Int_done = 0;
-
-	CRPT->HMAC_DMACNT = ilen;
-    CRPT->HMAC_CTL = (SHA_MODE_SHA1 << CRPT_HMAC_CTL_OPMODE_Pos) | CRPT_HMAC_CTL_START_Msk;
-    for ( ; ilen>=4; input+=4, ilen-=4)
-    {
-    	while (!(CRPT->HMAC_STS & CRPT_HMAC_STS_DATINREQ_Msk));
-    	
-    	if (ilen == 4)
-    		CRPT->HMAC_CTL |= CRPT_HMAC_CTL_DMALAST_Msk | CRPT_HMAC_CTL_START_Msk;
-    	
-    	CRPT->HMAC_DATIN = (input[0]<<24) | (input[1]<<16) | (input[2]<<8) | input[3];
-	}
-	if (ilen > 0)
-	{
-		memcpy(remain, input, ilen);
-		while (!(CRPT->HMAC_STS & CRPT_HMAC_STS_DATINREQ_Msk));
-		CRPT->HMAC_CTL |= CRPT_HMAC_CTL_DMALAST_Msk | CRPT_HMAC_CTL_START_Msk;
-		CRPT->HMAC_DATIN = (remain[0]<<24) | (remain[1]<<16) | (remain[2]<<8) | remain[3];
-	} 
-	
-	while (g_Crypto_Int_done == 0);
-	
-	for (i = 0; i < 5; i++, output+=4, digest++)
-	{
-		output[0] = (*digest>>24) & 0xff;
-		output[1] = (*digest>>16) & 0xff;
-		output[2] = (*digest>>8) & 0xff;
-		output[3] = *digest & 0xff;
-	}
-}
-#endif
-
 
 #if !defined(MBEDTLS_DEPRECATED_REMOVED)
 void mbedtls_sha1( const unsigned char *input,
                    size_t ilen,
                    unsigned char output[20] )
 {
-#ifdef NUVOTON_ENABLE_SHA
-	if (ilen > 0)
-	{
-		mbedtls_sha1_nuvoton(input, ilen, output);
-		return;
-	}	
-#endif    
     mbedtls_sha1_ret( input, ilen, output );
 }
 #endif
@@ -98,12 +98,20 @@ void mbedtls_sha512_free( mbedtls_sha512_context *ctx )
     if( ctx == NULL )
         return;
 
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_hw_release( &ctx->nvt, ctx );
+#endif
+
     mbedtls_platform_zeroize( ctx, sizeof( mbedtls_sha512_context ) );
 }
 
 void mbedtls_sha512_clone( mbedtls_sha512_context *dst,
                            const mbedtls_sha512_context *src )
 {
+#ifdef NUVOTON_ENABLE_SHA
+    /* A copy of an engine context cannot be continued, see nvt_sha_keep_sw() */
+    nvt_sha_hw_release( &dst->nvt, dst );
+#endif
     *dst = *src;
 }
 
@@ -112,6 +120,10 @@ void mbedtls_sha512_clone( mbedtls_sha512_context *dst,
  */
 int mbedtls_sha512_starts_ret( mbedtls_sha512_context *ctx, int is384 )
 {
+#ifdef NUVOTON_ENABLE_SHA
+    nvt_sha_hw_release( &ctx->nvt, ctx );
+#endif
+
     ctx->total[0] = 0;
     ctx->total[1] = 0;
 
@@ -283,6 +295,52 @@ void mbedtls_sha512_process( mbedtls_sha512_context *ctx,
 #endif
 #endif /* !MBEDTLS_SHA512_PROCESS_ALT */
 
+#ifdef NUVOTON_ENABLE_SHA
+/*
+ * Offer an update to the crypto engine. Returns 1 if the data has been
+ * taken, 0 to hash it in software, or an error code.
+ */
+static int nvt_sha512_update( mbedtls_sha512_context *ctx,
+                              const unsigned char *input, size_t ilen )
+{
+    int ret;
+
+    /* Only while nothing has been compressed yet */
+    if( ctx->nvt.hw == 0 && ilen >= NVT_SHA_HW_THRESHOLD &&
+        ctx->total[1] == 0 && ( ctx->total[0] < 128 || ctx->nvt.held ) )
+    {
+        nvt_sha_hw_start( &ctx->nvt, ctx,
+                          ctx->is384 ? SHA_MODE_SHA384 : SHA_MODE_SHA512,
+                          (size_t) ctx->total[0] );
+    }
+
+    if( ctx->nvt.hw )
+    {
+        if( nvt_sha_hw_update( &ctx->nvt, ctx, ctx->buffer, 128, input, ilen ) != 0 )
+            return( MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED );
+        return( 1 );
+    }
+
+    if( ctx->nvt.held )
+    {
+        ctx->nvt.held = 0;
+        if( ( ret = mbedtls_internal_sha512_process( ctx, ctx->buffer ) ) != 0 )
+            return( ret );
+    }
+    else if( ctx->total[0] == 0 && ctx->total[1] == 0 && ilen == 128 )
+    {
+        /* Keep a lone first block, e.g. the HMAC inner pad, in case
+           a large update follows */
+        memcpy( ctx->buffer, input, 128 );
+        ctx->total[0] = 128;
+        ctx->nvt.held = 1;
+        return( 1 );
+    }
+
+    return( 0 );
+}
+#endif
+
 /*
  * SHA-512 process buffer
  */
@@ -297,6 +355,11 @@ int mbedtls_sha512_update_ret( mbedtls_sha512_context *ctx,
     if( ilen == 0 )
         return( 0 );
 
+#ifdef NUVOTON_ENABLE_SHA
+    if( ( ret = nvt_sha512_update( ctx, input, ilen ) ) != 0 )
+        return( ret < 0 ? ret : 0 );
+#endif
+
     left = (unsigned int) (ctx->total[0] & 0x7F);
     fill = 128 - left;
 
@@ -351,6 +414,22 @@ int mbedtls_sha512_finish_ret( mbedtls_sha512_context *ctx,
     unsigned used;
     uint64_t high, low;
 
+#ifdef NUVOTON_ENABLE_SHA
+    if( ctx->nvt.hw )
+    {
+        if( nvt_sha_hw_finish( &ctx->nvt, ctx, ctx->buffer, output,
+                               ctx->is384 ? 48 : 64 ) != 0 )
+            return( MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED );
+        return( 0 );
+    }
+    if( ctx->nvt.held )
+    {
+        ctx->nvt.held = 0;
+        if( ( ret = mbedtls_internal_sha512_process( ctx, ctx->buffer ) ) != 0 )
+            return( ret );
+    }
+#endif
+
     /*
      * Add padding: 0x80 then 0x00 until 16 bytes remain for the length
      */
@@ -446,70 +525,11 @@ exit:
 
 #if !defined(MBEDTLS_DEPRECATED_REMOVED)
 
-#ifdef NUVOTON_ENABLE_SHA
-static void mbedtls_sha512_nuvoton( const unsigned char *input, size_t ilen,
-             unsigned char output[32], int is384 )
-{
-    int        i, wcnt;
-    uint8_t    remain[4] = {0,0,0,0};
-    uint32_t   *digest = (uint32_t *)&CRPT->HMAC_DGST[0];
-    
-    g_Crypto_Int_done = 0;
-
-	CRPT->HMAC_DMACNT = ilen;
-	if (is384)
-	{
-    	CRPT->HMAC_CTL = (SHA_MODE_SHA384 << CRPT_HMAC_CTL_OPMODE_Pos) | CRPT_HMAC_CTL_START_Msk;
-    	wcnt = 12;
-    }
-	else
-	{    	
-		CRPT->HMAC_CTL = (SHA_MODE_SHA512 << CRPT_HMAC_CTL_OPMODE_Pos) | CRPT_HMAC_CTL_START_Msk;
-		wcnt = 16;
-	}
-    
-    for ( ; ilen>=4; input+=4, ilen-=4)
-    {
-    	while (!(CRPT->HMAC_STS & CRPT_HMAC_STS_DATINREQ_Msk));
-    	
-    	if (ilen == 4)
-    		CRPT->HMAC_CTL |= CRPT_HMAC_CTL_DMALAST_Msk | CRPT_HMAC_CTL_START_Msk;
-    	
-    	CRPT->HMAC_DATIN = (input[0]<<24) | (input[1]<<16) | (input[2]<<8) | input[3];
-	}
-	if (ilen > 0)
-	{
-		memcpy(remain, input, ilen);
-		while (!(CRPT->HMAC_STS & CRPT_HMAC_STS_DATINREQ_Msk));
-		CRPT->HMAC_CTL |= CRPT_HMAC_CTL_DMALAST_Msk | CRPT_HMAC_CTL_START_Msk;
-		CRPT->HMAC_DATIN = (remain[0]<<24) | (remain[1]<<16) | (remain[2]<<8) | remain[3];
-	} 
-	
-	while (g_Crypto_Int_done == 0);
-	
-	for (i = 0; i < wcnt; i++, output+=4, digest++)
-	{
-		output[0] = (*digest>>24) & 0xff;
-		output[1] = (*digest>>16) & 0xff;
-		output[2] = (*digest>>8) & 0xff;
-		output[3] = *digest & 0xff;
-	}
-}
-#endif
-
 void mbedtls_sha512( const unsigned char *input,
                      size_t ilen,
                      unsigned char output[64],
                      int is384 )
 {
-#ifdef NUVOTON_ENABLE_SHA
-	if (ilen > 0)
-	{
-		mbedtls_sha512_nuvoton(input, ilen, output, is384);
-		return;
-	}	
-#endif    
-
     mbedtls_sha512_ret( input, ilen, output, is384 );
 }
 #endif
@@ -6549,16 +6549,27 @@ static void ssl_handshake_params_init( mbedtls_ssl_handshake_params *handshake )
     defined(MBEDTLS_SSL_PROTO_TLS1_1)
      mbedtls_md5_init(   &handshake->fin_md5  );
     mbedtls_sha1_init(   &handshake->fin_sha1 );
+#if defined(NUVOTON_ENABLE_SHA)
+    /* The checksums are cloned for each Finished and CertificateVerify
+       message, which the crypto engine cannot do */
+    nvt_sha_keep_sw( &handshake->fin_sha1.nvt );
+#endif
      mbedtls_md5_starts_ret( &handshake->fin_md5  );
     mbedtls_sha1_starts_ret( &handshake->fin_sha1 );
 #endif
 #if defined(MBEDTLS_SSL_PROTO_TLS1_2)
 #if defined(MBEDTLS_SHA256_C)
     mbedtls_sha256_init(   &handshake->fin_sha256    );
+#if defined(NUVOTON_ENABLE_SHA)
+    nvt_sha_keep_sw( &handshake->fin_sha256.nvt );
+#endif
     mbedtls_sha256_starts_ret( &handshake->fin_sha256, 0 );
 #endif
 #if defined(MBEDTLS_SHA512_C)
     mbedtls_sha512_init(   &handshake->fin_sha512    );
+#if defined(NUVOTON_ENABLE_SHA)
+    nvt_sha_keep_sw( &handshake->fin_sha512.nvt );
+#endif
     mbedtls_sha512_starts_ret( &handshake->fin_sha512, 1 );
 #endif
 #endif /* MBEDTLS_SSL_PROTO_TLS1_2 */
@@ -42,6 +42,25 @@ int nand_register(int devnum, struct mtd_info *mtd);
 extern int board_nand_init(struct nand_chip *nand);
 #endif
 
+/*
+ * Nuvoton FMI NAND BCH error-correction statistics, for wear monitoring.
+ * au32Histogram[n] counts the page reads that needed n bits corrected;
+ * the last entry collects every page with NUVOTON_ECC_HIST_SIZE-1 or more.
+ */
+#define NUVOTON_ECC_HIST_SIZE	33
+
+struct nuvoton_ecc_stats {
+	u32 u32PageRead;		/* page reads with H/W ECC enabled */
+	u32 u32PageCorrected;		/* page reads with at least one bit corrected */
+	u32 u32BitCorrected;		/* total corrected bits */
+	u32 u32Uncorrectable;		/* page reads failed with uncorrectable error */
+	u32 u32MaxFieldBits;		/* worst corrected bits seen in one field */
+	u32 au32Histogram[NUVOTON_ECC_HIST_SIZE];
+};
+
+void nuvoton_nand_get_ecc_stats(struct nuvoton_ecc_stats *stats);
+void nuvoton_nand_clear_ecc_stats(void);
+
 typedef struct mtd_info nand_info_t;
 
 extern int nand_curr_device;
@@ -55,6 +55,13 @@ struct nuvoton_nand_info {
     struct nand_chip        chip;
     int                     eBCHAlgo;
     int                     m_i32SMRASize;
+    u32                     m_u32FieldLen;      /* BCH field geometry of eBCHAlgo */
+    u32                     m_u32PaddingLen;
+    u32                     m_u32ParityLen;
+    u32                     m_u32FieldNum;
+    u32                     m_u32ParityBase;    /* first parity byte of first field in SMRA */
+    u32                     m_u32PageBits;      /* corrected bits of the page being read */
+    struct nuvoton_ecc_stats m_sEccStats;
 };
 struct nuvoton_nand_info g_nuvoton_nand;
 struct nuvoton_nand_info *nuvoton_nand;
@@ -67,6 +74,10 @@ static const int g_i32ParityNum[3][3] = {
     { 120,    184,    180 },  // For 4K
     { 240,    368,    360 },  // For 8K
 };
+static const u32 g_u32BCHFieldLen[3]   = { 512, 512, 1024 };
+static const u32 g_u32BCHPaddingLen[3] = { BCH_PADDING_LEN_512, BCH_PADDING_LEN_512, BCH_PADDING_LEN_1024 };
+static const u32 g_u32BCHParityLen[3]  = { BCH_PARITY_LEN_T8, BCH_PARITY_LEN_T12, BCH_PARITY_LEN_T24 };
+static const u8  g_u8NibbleBits[16]    = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
 
 extern uint32_t get_ticks(void);
 void udelay(unsigned int tick)
@@ -288,137 +299,112 @@ static int nuvoton_nand_correct_data(struct mtd_info *mtd, u_char *dat,
 /*-----------------------------------------------------------------------------
  * Correct data by BCH alrogithm.
  *      Support 8K page size NAND and BCH T4/8/12/15/24.
+ *
+ *      All BCH_ECC_DATAx / BCH_ECC_ADDRx registers of the field are fetched
+ *      in one batch, then errors in the data area are fixed with word-wide
+ *      XORs (errors falling in the same word are merged into one access).
+ *      Returns the number of corrected bits.
  *---------------------------------------------------------------------------*/
-void fmiSM_CorrectData_BCH(u8 ucFieidIndex, u8 ucErrorCnt, u8* pDAddr)
+u32 fmiSM_CorrectData_BCH(u8 ucFieidIndex, u8 ucErrorCnt, u8* pDAddr)
 {
-    u32 uaData[24], uaAddr[24];
-    u32 uaErrorData[6];
-    u8  ii, jj;
-    u32 uPageSize;
-    u32 field_len, padding_len, parity_len;
-    u32 total_field_num;
+    struct nuvoton_nand_info *nand = nuvoton_nand;
+    u32 uaErrorData[6], uaErrorAddr[12];
+    u32 uAddr, uData, uBits = 0;
+    u32 uWordOff = 0xFFFFFFFF, uWordMask = 0;
+    u32 field_len, parity_len, parity_off;
     u8  *smra_index;
-
-    //--- assign some parameters for different BCH and page size
-    switch (inpw(REG_NANDCTL) & 0x007C0000)
-    {
-        case BCH_T24:
-            field_len   = 1024;
-            padding_len = BCH_PADDING_LEN_1024;
-            parity_len  = BCH_PARITY_LEN_T24;
-            break;
-        case BCH_T12:
-            field_len   = 512;
-            padding_len = BCH_PADDING_LEN_512;
-            parity_len  = BCH_PARITY_LEN_T12;
-            break;
-        case BCH_T8:
-            field_len   = 512;
-            padding_len = BCH_PADDING_LEN_512;
-            parity_len  = BCH_PARITY_LEN_T8;
-            break;
-        default:
-            return;
-    }
-
-    uPageSize = inpw(REG_NANDCTL) & 0x00030000;
-    switch (uPageSize)
-    {
-        case 0x30000: total_field_num = 8192 / field_len; break;
-        case 0x20000: total_field_num = 4096 / field_len; break;
-        case 0x10000: total_field_num = 2048 / field_len; break;
-        case 0x00000: total_field_num =  512 / field_len; break;
-        default:
-            return;
-    }
-
-    //--- got valid BCH_ECC_DATAx and parse them to uaData[]
-    // got the valid register number of BCH_ECC_DATAx since one register include 4 error bytes
-    jj = ucErrorCnt/4;
-    jj ++;
-    if (jj > 6)
-        jj = 6;     // there are 6 BCH_ECC_DATAx registers to support BCH T24
-
-    for(ii=0; ii<jj; ii++)
-    {
+    int ii, jj;
+
+    field_len = nand->m_u32FieldLen;
+    if (field_len == 0)
+        return 0;
+    parity_len = nand->m_u32ParityLen;
+
+    // BCH_ERR_ADDRx = [data in field] + [3 bytes] + [xx] + [parity code]
+    //                                   |<--     padding bytes      -->|
+    // The BCH_ERR_ADDRx for last parity code always = field size + padding size.
+    // So, the first parity code = field size + padding size - parity code length.
+    // For example, for BCH T12, the first parity code = 512 + 32 - 23 = 521.
+    parity_off = field_len + nand->m_u32PaddingLen - parity_len;
+
+    if (ucErrorCnt > 24)
+        ucErrorCnt = 24;    // BCH T24 is the strongest algorithm
+
+    //--- one register include 4 error bytes
+    jj = (ucErrorCnt + 3) / 4;
+    for (ii = 0; ii < jj; ii++)
         uaErrorData[ii] = inpw(REG_NANDECCED0 + ii*4);
-    }
-
-    for(ii=0; ii<jj; ii++)
-    {
-        uaData[ii*4+0] = uaErrorData[ii] & 0xff;
-        uaData[ii*4+1] = (uaErrorData[ii]>>8) & 0xff;
-        uaData[ii*4+2] = (uaErrorData[ii]>>16) & 0xff;
-        uaData[ii*4+3] = (uaErrorData[ii]>>24) & 0xff;
-    }
-
-    //--- got valid REG_BCH_ECC_ADDRx and parse them to uaAddr[]
-    // got the valid register number of REG_BCH_ECC_ADDRx since one register include 2 error addresses
-    jj = ucErrorCnt/2;
-    jj ++;
-    if (jj > 12)
-        jj = 12;    // there are 12 REG_BCH_ECC_ADDRx registers to support BCH T24
 
-    for(ii=0; ii<jj; ii++)
-    {
-        uaAddr[ii*2+0] = inpw(REG_NANDECCEA0 + ii*4) & 0x07ff;   // 11 bits for error address
-        uaAddr[ii*2+1] = (inpw(REG_NANDECCEA0 + ii*4)>>16) & 0x07ff;
-    }
+    //--- one register include 2 error addresses
+    jj = (ucErrorCnt + 1) / 2;
+    for (ii = 0; ii < jj; ii++)
+        uaErrorAddr[ii] = inpw(REG_NANDECCEA0 + ii*4);
 
     //--- pointer to begin address of field that with data error
     pDAddr += (ucFieidIndex-1) * field_len;
 
     //--- correct each error bytes
-    for(ii=0; ii<ucErrorCnt; ii++)
+    for (ii = 0; ii < ucErrorCnt; ii++)
     {
+        uAddr = (uaErrorAddr[ii >> 1] >> ((ii & 1) << 4)) & 0x07ff;   // 11 bits for error address
+        uData = (uaErrorData[ii >> 2] >> ((ii & 3) << 3)) & 0xff;
+        uBits += g_u8NibbleBits[uData & 0xf] + g_u8NibbleBits[uData >> 4];
+
         // for wrong data in field
-        if (uaAddr[ii] < field_len)
+        if (uAddr < field_len)
         {
-            *(pDAddr+uaAddr[ii]) ^= uaData[ii];
+            if ((u32)pDAddr & 0x3)
+            {
+                *(pDAddr + uAddr) ^= uData;
+                continue;
+            }
+            if ((uAddr & ~0x3) != uWordOff)
+            {
+                if (uWordMask)
+                    *(u32 *)(pDAddr + uWordOff) ^= uWordMask;
+                uWordOff  = uAddr & ~0x3;
+                uWordMask = 0;
+            }
+            uWordMask |= uData << ((uAddr & 0x3) << 3);
         }
         // for wrong first-3-bytes in redundancy area
-        else if (uaAddr[ii] < (field_len+3))
+        else if (uAddr < (field_len+3))
         {
-            uaAddr[ii] -= field_len;
-            uaAddr[ii] += (parity_len*(ucFieidIndex-1));    // field offset
-            *((u8 *)REG_NANDRA0 + uaAddr[ii]) ^= uaData[ii];
+            uAddr -= field_len;
+            uAddr += (parity_len*(ucFieidIndex-1));    // field offset
+            *((u8 *)REG_NANDRA0 + uAddr) ^= uData;
         }
         // for wrong parity code in redundancy area
         else
         {
-            // BCH_ERR_ADDRx = [data in field] + [3 bytes] + [xx] + [parity code]
-            //                                   |<--     padding bytes      -->|
-            // The BCH_ERR_ADDRx for last parity code always = field size + padding size.
-            // So, the first parity code = field size + padding size - parity code length.
-            // For example, for BCH T12, the first parity code = 512 + 32 - 23 = 521.
-            // That is, error byte address offset within field is
-            uaAddr[ii] = uaAddr[ii] - (field_len + padding_len - parity_len);
-
             // smra_index point to the first parity code of first field in register SMRA0~n
-            smra_index = (u8 *)
-                         (REG_NANDRA0 + (inpw(REG_NANDRACTL) & 0x1ff) - // bottom of all parity code -
-                          (parity_len * total_field_num)                             // byte count of all parity code
-                         );
+            smra_index = (u8 *)(REG_NANDRA0 + nand->m_u32ParityBase);
 
             // final address = first parity code of first field +
             //                 offset of fields +
             //                 offset within field
-            *((u8 *)smra_index + (parity_len * (ucFieidIndex-1)) + uaAddr[ii]) ^= uaData[ii];
+            *(smra_index + (parity_len * (ucFieidIndex-1)) + (uAddr - parity_off)) ^= uData;
         }
     }   // end of for (ii<ucErrorCnt)
+
+    if (uWordMask)
+        *(u32 *)(pDAddr + uWordOff) ^= uWordMask;
+
+    if (uBits > nand->m_sEccStats.u32MaxFieldBits)
+        nand->m_sEccStats.u32MaxFieldBits = uBits;
+
+    return uBits;
 }
 
 int fmiSMCorrectData (struct mtd_info *mtd, unsigned long uDAddr )
 {
+    struct nuvoton_nand_info *nand = nuvoton_nand;
     int uStatus, ii, jj, i32FieldNum=0;
     volatile int uErrorCnt = 0;
 
     if ( inpw ( REG_NANDINTSTS ) & 0x4 )
     {
-        if ( ( inpw(REG_NANDCTL) & 0x7C0000) == BCH_T24 )
-            i32FieldNum = mtd->writesize / 1024;    // Block=1024 for BCH
-        else
-            i32FieldNum = mtd->writesize / 512;
+        i32FieldNum = nand->m_u32FieldNum;
 
         if ( i32FieldNum < 4 )
             i32FieldNum  = 1;
@@ -441,7 +427,7 @@ int fmiSMCorrectData (struct mtd_info *mtd, unsigned long uDAddr )
                 } else if ( (uStatus & 0x03)==0x01 ) { // Correctable error
 
                     uErrorCnt = (uStatus >> 2) & 0x1F;
-                    fmiSM_CorrectData_BCH(jj*4+ii, uErrorCnt, (u8 *)uDAddr);
+                    nand->m_u32PageBits += fmiSM_CorrectData_BCH(jj*4+ii, uErrorCnt, (u8 *)uDAddr);
 
                     break;
                 } else // uncorrectable error or ECC error
@@ -454,6 +440,74 @@ int fmiSMCorrectData (struct mtd_info *mtd, unsigned long uDAddr )
     return uErrorCnt;
 }
 
+/*-----------------------------------------------------------------------------
+ * Cache the BCH field geometry of current BCH algorithm and page size, so
+ * the correction path does not decode REG_NANDCTL on every error.
+ *---------------------------------------------------------------------------*/
+static void nuvoton_nand_bch_geometry(struct mtd_info *mtd)
+{
+    struct nuvoton_nand_info *nand = nuvoton_nand;
+    int idx = nand->eBCHAlgo;
+
+    if ( idx < 0 || idx > 2 ) {
+        nand->m_u32FieldLen = 0;
+        return;
+    }
+
+    nand->m_u32FieldLen   = g_u32BCHFieldLen[idx];
+    nand->m_u32PaddingLen = g_u32BCHPaddingLen[idx];
+    nand->m_u32ParityLen  = g_u32BCHParityLen[idx];
+    nand->m_u32FieldNum   = mtd->writesize / nand->m_u32FieldLen;
+    if ( nand->m_u32FieldNum == 0 )
+        nand->m_u32FieldNum = 1;
+
+    // bottom of all parity code - byte count of all parity code
+    nand->m_u32ParityBase = (nand->m_i32SMRASize & 0x1ff) - (nand->m_u32ParityLen * nand->m_u32FieldNum);
+}
+
+/*-----------------------------------------------------------------------------
+ * Account the corrected bits of one page read into the ECC statistics.
+ *---------------------------------------------------------------------------*/
+static void nuvoton_nand_ecc_account(struct nuvoton_nand_info *nand, int failed)
+{
+    struct nuvoton_ecc_stats *stats = &nand->m_sEccStats;
+    u32 bits = nand->m_u32PageBits;
+
+    stats->u32PageRead++;
+    if ( failed ) {
+        stats->u32Uncorrectable++;
+    } else if ( bits ) {
+        stats->u32PageCorrected++;
+        stats->u32BitCorrected += bits;
+    }
+
+    if ( bits >= NUVOTON_ECC_HIST_SIZE )
+        bits = NUVOTON_ECC_HIST_SIZE - 1;
+    stats->au32Histogram[bits]++;
+
+    nand->m_u32PageBits = 0;
+}
+
+/**
+  * @brief    Get the BCH error-correction statistics for wear monitoring.
+  * @param[out] stats  Copy of the counters. au32Histogram[n] is the number of page reads that
+  *                    needed n bits corrected (last entry collects n and above).
+  * @return   None
+  */
+void nuvoton_nand_get_ecc_stats(struct nuvoton_ecc_stats *stats)
+{
+    memcpy(stats, &g_nuvoton_nand.m_sEccStats, sizeof(struct nuvoton_ecc_stats));
+}
+
+/**
+  * @brief    Reset all BCH error-correction statistics.
+  * @return   None
+  */
+void nuvoton_nand_clear_ecc_stats(void)
+{
+    memset(&g_nuvoton_nand.m_sEccStats, 0, sizeof(struct nuvoton_ecc_stats));
+}
+
 
 static __inline int _nuvoton_nand_dma_transfer(struct mtd_info *mtd, const u_char *addr, unsigned int len, int is_write)
 {
@@ -521,11 +575,14 @@ static __inline int _nuvoton_nand_dma_transfer(struct mtd_info *mtd, const u_cha
         outpw(REG_NANDCTL, inpw(REG_NANDCTL) | 0x2);
 
         if (inpw(REG_NANDCTL) & 0x80) {
+            int failed = 0;
+            nand->m_u32PageBits = 0;
             do {
                 int stat=0;
                 if ( (stat=fmiSMCorrectData ( mtd,  (unsigned long)addr)) < 0 )
                 {
                     mtd->ecc_stats.failed++;
+                    failed = 1;
                     outpw(REG_NANDINTSTS, 0x4);
                     outpw(REG_FMI_DMACTL, 0x3);          // reset DMAC
                     outpw(REG_NANDCTL, inpw(REG_NANDCTL)|0x1);
@@ -537,6 +594,7 @@ static __inline int _nuvoton_nand_dma_transfer(struct mtd_info *mtd, const u_cha
                 }
 
             } while (!(inpw(REG_NANDINTSTS) & 0x1) || (inpw(REG_NANDINTSTS) & 0x4));
+            nuvoton_nand_ecc_account(nand, failed);
         } else
             while (!(inpw(REG_NANDINTSTS) & 0x1));
     }
@@ -795,6 +853,8 @@ int board_nand_init(struct nand_chip *nand)
     // Enable H/W ECC, ECC parity check enable bit during read page
     outpw(REG_NANDCTL, inpw(REG_NANDCTL) | 0x00800080);
 
+    nuvoton_nand_bch_geometry(mtd);
+
     return 0;
 }
 